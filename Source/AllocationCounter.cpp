@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationcounter.cpp
+// ============
+// count the heap allocations made by the threads that build the frames
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// declaration of global variables
+namespace
+{
+	// counts of every tracked thread, added to without ordering
+	// since they are only read between frames
+	std::atomic<uint64_t> g_allocationCount(0);
+	std::atomic<uint64_t> g_allocatedBytes(0);
+
+	// set on the threads whose allocations are counted
+	thread_local bool g_bThreadTracked = false;
+
+	/***********************************************************
+	 *  AllocateMemory()
+	 *
+	 *  Allocates memory for the replaced operator new, calling
+	 *  the new handler until the allocation succeeds or there
+	 *  is no handler left.
+	 ***********************************************************/
+	void* AllocateMemory(size_t bytes)
+	{
+		if (bytes == 0)
+		{
+			bytes = 1;
+		}
+
+		for (;;)
+		{
+			void* pMemory = malloc(bytes);
+			if (NULL != pMemory)
+			{
+				return(pMemory);
+			}
+
+			std::new_handler handler = std::get_new_handler();
+			if (NULL == handler)
+			{
+				return(NULL);
+			}
+			handler();
+		}
+	}
+}
+
+/***********************************************************
+ *  SetThreadTracked()
+ *
+ *  This method is used for starting or stopping the counting
+ *  of the allocations made by the calling thread.
+ ***********************************************************/
+void AllocationCounter::SetThreadTracked(bool bTracked)
+{
+	g_bThreadTracked = bTracked;
+}
+
+/***********************************************************
+ *  IsThreadTracked()
+ *
+ *  This method is used for checking if the allocations of
+ *  the calling thread are counted.
+ ***********************************************************/
+bool AllocationCounter::IsThreadTracked()
+{
+	return(g_bThreadTracked);
+}
+
+/***********************************************************
+ *  GetAllocationCount()
+ *
+ *  This method is used for getting the number of allocations
+ *  the tracked threads have made so far.
+ ***********************************************************/
+uint64_t AllocationCounter::GetAllocationCount()
+{
+	return(g_allocationCount.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  GetAllocatedBytes()
+ *
+ *  This method is used for getting the bytes the tracked
+ *  threads have allocated so far.
+ ***********************************************************/
+uint64_t AllocationCounter::GetAllocatedBytes()
+{
+	return(g_allocatedBytes.load(std::memory_order_relaxed));
+}
+
+/***********************************************************
+ *  RecordAllocation()
+ *
+ *  This method is used for counting an allocation when the
+ *  calling thread is tracked.
+ ***********************************************************/
+void AllocationCounter::RecordAllocation(size_t bytes)
+{
+	if (g_bThreadTracked)
+	{
+		g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+		g_allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+	}
+}
+
+/***********************************************************
+ *  operator new()
+ *
+ *  The replaced global allocation functions, which count
+ *  the allocation and then allocate from the C runtime heap.
+ ***********************************************************/
+void* operator new(size_t bytes)
+{
+	AllocationCounter::RecordAllocation(bytes);
+	void* pMemory = AllocateMemory(bytes);
+	if (NULL == pMemory)
+	{
+		throw std::bad_alloc();
+	}
+
+	return(pMemory);
+}
+
+void* operator new[](size_t bytes)
+{
+	return(operator new(bytes));
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept
+{
+	AllocationCounter::RecordAllocation(bytes);
+	return(AllocateMemory(bytes));
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept
+{
+	return(operator new(bytes, std::nothrow));
+}
+
+/***********************************************************
+ *  operator delete()
+ *
+ *  The replaced global deallocation functions, which match
+ *  the replaced allocation functions.
+ ***********************************************************/
+void operator delete(void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete(void* pMemory, const std::nothrow_t&) noexcept
+{
+	free(pMemory);
+}
+
+void operator delete[](void* pMemory, const std::nothrow_t&) noexcept
+{
+	free(pMemory);
+}
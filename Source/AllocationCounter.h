@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////
+// allocationcounter.h
+// ============
+// count the heap allocations made by the threads that build the frames
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/***********************************************************
+ *  AllocationCounter
+ *
+ *  This class contains the counts of the global operator new
+ *  calls, which are replaced to add to them.  Only threads
+ *  that are marked as tracked are counted, which are the
+ *  OpenGL thread and the job workers that prepare the frames,
+ *  so the texture decoding, file watching and image writing
+ *  threads can allocate freely.  Memory the OpenGL driver
+ *  allocates on its own heap is not counted.
+ ***********************************************************/
+class AllocationCounter
+{
+public:
+	// start or stop counting the allocations of the calling thread
+	static void SetThreadTracked(bool bTracked);
+	static bool IsThreadTracked();
+
+	// get the allocations and their bytes counted so far
+	static uint64_t GetAllocationCount();
+	static uint64_t GetAllocatedBytes();
+
+	// count an allocation of the calling thread, if it is tracked
+	static void RecordAllocation(size_t bytes);
+};
@@ -0,0 +1,241 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+// ============
+// measure the frame times of a scripted camera flight through the scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// frame rate the camera path is recorded and played back at
+	const float PATH_FRAME_RATE = 60.0f;
+	// mouse movement of the camera path at its fastest turn
+	const float PATH_TURN_SPEED = 3.0f;
+	const float PATH_PITCH_SPEED = 0.5f;
+	const float TWO_PI = 6.28318530718f;
+
+	// get a percentile between 0 and 100 of sorted values
+	float GetSortedPercentile(const std::vector<float>& sorted, float percentile)
+	{
+		size_t rank = (size_t)((percentile / 100.0f) * (float)(sorted.size() - 1) + 0.5f);
+
+		return(sorted[std::min(rank, sorted.size() - 1)]);
+	}
+}
+
+/***********************************************************
+ *  Benchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+Benchmark::Benchmark(const BENCHMARK_SETTINGS& settings)
+{
+	m_settings = settings;
+	m_recordedFrames = 0;
+	m_lastGPUSampleTotal = 0;
+	BuildCameraPath();
+}
+
+/***********************************************************
+ *  ~Benchmark()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+Benchmark::~Benchmark()
+{
+}
+
+/***********************************************************
+ *  GetPathFrameTime()
+ *
+ *  This method is used for getting the fixed time step the
+ *  camera moves by in every frame of the camera path.
+ ***********************************************************/
+float Benchmark::GetPathFrameTime() const
+{
+	return(1.0f / PATH_FRAME_RATE);
+}
+
+/***********************************************************
+ *  BuildCameraPath()
+ *
+ *  This method is used for recording the camera input of
+ *  the warm up and the measured frames.  The camera flies
+ *  forward, right, back and left for a quarter of the path
+ *  each while it turns and pitches along a sine wave, which
+ *  brings it back close to where it started.
+ ***********************************************************/
+void Benchmark::BuildCameraPath()
+{
+	const unsigned int PHASE_KEYS[4] =
+	{
+		ViewManager::INPUT_KEY_FORWARD,
+		ViewManager::INPUT_KEY_RIGHT,
+		ViewManager::INPUT_KEY_BACKWARD,
+		ViewManager::INPUT_KEY_LEFT
+	};
+
+	int sampleCount = m_settings.warmupFrames + m_settings.frameCount;
+	m_cameraPath.resize(sampleCount);
+
+	for (int i = 0; i < sampleCount; i++)
+	{
+		float phase = (float)i / (float)sampleCount;
+		ViewManager::INPUT_SAMPLE& sample = m_cameraPath[i];
+
+		sample.keyMask = PHASE_KEYS[std::min((int)(phase * 4.0f), 3)];
+		sample.mouseDeltaX = PATH_TURN_SPEED * sinf(TWO_PI * phase);
+		sample.mouseDeltaY = PATH_PITCH_SPEED * cosf(TWO_PI * phase);
+	}
+}
+
+/***********************************************************
+ *  RecordFrame()
+ *
+ *  This method is used for storing the CPU frame time and
+ *  the draw counts of a finished frame once the warm up is
+ *  over.  The GPU times arrive a few frames late and are
+ *  stored as they are read back.
+ ***********************************************************/
+void Benchmark::RecordFrame(const FrameProfiler& profiler, const SceneManager::RENDER_STATS& stats)
+{
+	int gpuSampleTotal = profiler.GetGPUSampleTotal(FrameProfiler::SECTION_RENDER_SCENE);
+	bool bNewGPUSample = (gpuSampleTotal != m_lastGPUSampleTotal);
+	m_lastGPUSampleTotal = gpuSampleTotal;
+
+	m_recordedFrames++;
+	if (m_recordedFrames <= m_settings.warmupFrames)
+	{
+		return;
+	}
+
+	m_frameTimes.push_back(profiler.GetLastFrameTime());
+	if (bNewGPUSample)
+	{
+		m_gpuTimes.push_back(profiler.GetLastGPUTime(FrameProfiler::SECTION_RENDER_SCENE));
+	}
+	m_drawCounts.push_back((float)stats.drawCount);
+	m_commandCounts.push_back((float)stats.commandCount);
+	m_submittedCounts.push_back((float)stats.submittedCount);
+}
+
+/***********************************************************
+ *  FormatSeries()
+ *
+ *  This method is used for formatting the average, the
+ *  percentiles and the maximum of a result series as a JSON
+ *  object.
+ ***********************************************************/
+std::string Benchmark::FormatSeries(const std::vector<float>& values)
+{
+	char text[256];
+
+	if (values.empty())
+	{
+		return(std::string("null"));
+	}
+
+	std::vector<float> sorted(values);
+	std::sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		total += sorted[i];
+	}
+
+	snprintf(text, sizeof(text),
+		"{\"average\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}",
+		total / (double)sorted.size(),
+		GetSortedPercentile(sorted, 50.0f),
+		GetSortedPercentile(sorted, 95.0f),
+		GetSortedPercentile(sorted, 99.0f),
+		sorted.back());
+
+	return(std::string(text));
+}
+
+/***********************************************************
+ *  GetPeakProcessMemory()
+ *
+ *  This method is used for getting the most memory the
+ *  process has had resident at once.
+ ***********************************************************/
+size_t Benchmark::GetPeakProcessMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return((size_t)counters.PeakWorkingSetSize);
+	}
+	return(0);
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		// the peak resident size is reported in kilobytes
+		return((size_t)usage.ru_maxrss * 1024);
+	}
+	return(0);
+#endif
+}
+
+/***********************************************************
+ *  WriteResults()
+ *
+ *  This method is used for writing the results of the
+ *  measured frames as JSON to the results file, or to the
+ *  standard output when no file is set.
+ ***********************************************************/
+bool Benchmark::WriteResults(const SceneManager& sceneManager) const
+{
+	std::ofstream file;
+	std::ostream* pOutput = &std::cout;
+
+	if (!m_settings.outputFile.empty())
+	{
+		file.open(m_settings.outputFile.c_str());
+		if (!file)
+		{
+			std::cout << "Could not write benchmark results:" << m_settings.outputFile << std::endl;
+			return(false);
+		}
+		pOutput = &file;
+	}
+
+	std::ostream& output = *pOutput;
+	output << "{\n";
+	output << "  \"frames\": " << m_frameTimes.size() << ",\n";
+	output << "  \"warmupFrames\": " << m_settings.warmupFrames << ",\n";
+	output << "  \"sceneCopies\": " << m_settings.sceneCopies << ",\n";
+	output << "  \"renderItems\": " << sceneManager.GetRenderItemCount() << ",\n";
+	output << "  \"frameTimeMs\": " << FormatSeries(m_frameTimes) << ",\n";
+	output << "  \"gpuSceneTimeMs\": " << FormatSeries(m_gpuTimes) << ",\n";
+	output << "  \"drawCalls\": " << FormatSeries(m_drawCounts) << ",\n";
+	output << "  \"indirectCommands\": " << FormatSeries(m_commandCounts) << ",\n";
+	output << "  \"submittedItems\": " << FormatSeries(m_submittedCounts) << ",\n";
+	output << "  \"textureBytes\": " << sceneManager.GetTextureResidentBytes() << ",\n";
+	output << "  \"peakProcessBytes\": " << GetPeakProcessMemory() << "\n";
+	output << "}" << std::endl;
+
+	return(output.good());
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmark.h
+// ============
+// measure the frame times of a scripted camera flight through the scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameProfiler.h"
+#include "SceneManager.h"
+#include "ViewManager.h"
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  Benchmark
+ *
+ *  This class contains the settings and the results of a
+ *  benchmark run.  The camera follows a recorded input path
+ *  that is the same on every run, the frames after the warm
+ *  up are measured, and the results are written as JSON so
+ *  that runs can be compared by scripts.
+ ***********************************************************/
+class Benchmark
+{
+public:
+	// options of a benchmark run
+	struct BENCHMARK_SETTINGS
+	{
+		// measured frames and the frames rendered before them
+		int frameCount = 1000;
+		int warmupFrames = 60;
+		// copies of the desk scene to render
+		int sceneCopies = 1;
+		// JSON results file, empty for the standard output
+		std::string outputFile;
+	};
+
+	// constructor
+	Benchmark(const BENCHMARK_SETTINGS& settings);
+	// destructor
+	~Benchmark();
+
+	// get the recorded input of the camera path
+	const std::vector<ViewManager::INPUT_SAMPLE>& GetCameraPath() const { return(m_cameraPath); }
+	// get the fixed frame time the camera path is played at
+	float GetPathFrameTime() const;
+	// store the timings and counts of a finished frame
+	void RecordFrame(const FrameProfiler& profiler, const SceneManager::RENDER_STATS& stats);
+	// write the results of the measured frames
+	bool WriteResults(const SceneManager& sceneManager) const;
+
+private:
+	BENCHMARK_SETTINGS m_settings;
+	std::vector<ViewManager::INPUT_SAMPLE> m_cameraPath;
+	int m_recordedFrames;
+	int m_lastGPUSampleTotal;
+
+	// results of the measured frames
+	std::vector<float> m_frameTimes;
+	std::vector<float> m_gpuTimes;
+	std::vector<float> m_drawCounts;
+	std::vector<float> m_commandCounts;
+	std::vector<float> m_submittedCounts;
+
+	// build the recorded input along the camera path
+	void BuildCameraPath();
+	// get the peak memory the process has used in bytes
+	static size_t GetPeakProcessMemory();
+	// format the average and percentiles of a result series
+	static std::string FormatSeries(const std::vector<float>& values);
+};
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthprepass.cpp
+// ============
+// draw the depth of the opaque render items before they are shaded
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DepthPrepass.h"
+#include "ShaderCompiler.h"
+
+#include <iostream>
+
+/***********************************************************
+ *  DepthPrepass()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DepthPrepass::DepthPrepass()
+{
+	m_programID = 0;
+	m_viewLocation = -1;
+	m_projectionLocation = -1;
+	m_instancingLocation = -1;
+	m_packedVerticesLocation = -1;
+	m_packedCenterLocation = -1;
+	m_packedExtentsLocation = -1;
+	m_savedProgram = 0;
+}
+
+/***********************************************************
+ *  ~DepthPrepass()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DepthPrepass::~DepthPrepass()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the depth only shader
+ *  program and looking up its uniforms.  It returns false
+ *  when the program fails to build.
+ ***********************************************************/
+bool DepthPrepass::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	m_programID = ShaderCompiler::BuildProgram(vertexShaderFile, fragmentShaderFile);
+	if (0 == m_programID)
+	{
+		std::cout << "The depth prepass is disabled" << std::endl;
+		return(false);
+	}
+
+	m_viewLocation = glGetUniformLocation(m_programID, "view");
+	m_projectionLocation = glGetUniformLocation(m_programID, "projection");
+	m_instancingLocation = glGetUniformLocation(m_programID, "bUseInstancing");
+	m_packedVerticesLocation = glGetUniformLocation(m_programID, "bUsePackedVertices");
+	m_packedCenterLocation = glGetUniformLocation(m_programID, "packedPositionCenter");
+	m_packedExtentsLocation = glGetUniformLocation(m_programID, "packedPositionExtents");
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shader program.
+ ***********************************************************/
+void DepthPrepass::Destroy()
+{
+	if (0 != m_programID)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for putting the depth only program in
+ *  use with the camera view and the vertex layout of the
+ *  mesh arena, and turning off the color writes.
+ ***********************************************************/
+void DepthPrepass::Begin(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	bool bPackedVertices,
+	const glm::vec3& packedCenter,
+	const glm::vec3& packedExtents)
+{
+	glGetIntegerv(GL_CURRENT_PROGRAM, &m_savedProgram);
+	glUseProgram(m_programID);
+	glUniformMatrix4fv(m_viewLocation, 1, GL_FALSE, &view[0][0]);
+	glUniformMatrix4fv(m_projectionLocation, 1, GL_FALSE, &projection[0][0]);
+	glUniform1i(m_instancingLocation, 1);
+	glUniform1i(m_packedVerticesLocation, bPackedVertices ? 1 : 0);
+	glUniform3f(m_packedCenterLocation, packedCenter.x, packedCenter.y, packedCenter.z);
+	glUniform3f(m_packedExtentsLocation, packedExtents.x, packedExtents.y, packedExtents.z);
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+}
+
+/***********************************************************
+ *  End()
+ *
+ *  This method is used for turning the color writes back on
+ *  and restoring the program in use.  The depth test is left
+ *  passing equal depths until the scene draws are done, and
+ *  the caller sets it back to GL_LESS.
+ ***********************************************************/
+void DepthPrepass::End()
+{
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthFunc(GL_LEQUAL);
+	glUseProgram((GLuint)m_savedProgram);
+}
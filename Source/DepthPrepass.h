@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthprepass.h
+// ============
+// draw the depth of the opaque render items before they are shaded
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  DepthPrepass
+ *
+ *  This class contains the depth only program the opaque
+ *  draws are issued with before the scene shaders run.  The
+ *  scene draws then only pass the depth test where they are
+ *  the nearest surface, so each pixel runs the textured and
+ *  lit fragment shader about once no matter the draw order.
+ ***********************************************************/
+class DepthPrepass
+{
+public:
+	// constructor
+	DepthPrepass();
+	// destructor
+	~DepthPrepass();
+
+	// build the depth only shader program
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// free the shader program
+	void Destroy();
+	// check if the program was built
+	bool IsReady() const { return(0 != m_programID); }
+
+	// set up the depth only drawing with the camera view
+	void Begin(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		bool bPackedVertices,
+		const glm::vec3& packedCenter,
+		const glm::vec3& packedExtents);
+	// restore the color writes and the program, and let the
+	// scene draws pass on the depth the prepass wrote
+	void End();
+
+private:
+	GLuint m_programID;
+	GLint m_viewLocation;
+	GLint m_projectionLocation;
+	GLint m_instancingLocation;
+	GLint m_packedVerticesLocation;
+	GLint m_packedCenterLocation;
+	GLint m_packedExtentsLocation;
+	// program in use before Begin()
+	GLint m_savedProgram;
+};
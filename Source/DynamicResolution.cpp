@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.cpp
+// ============
+// scale the scene resolution to hold a target frame time
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DynamicResolution.h"
+
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// default target of one 60 Hz refresh
+	const float DEFAULT_TARGET_FRAME_TIME = 1000.0f / 60.0f;
+	const float DEFAULT_MIN_SCALE = 0.5f;
+	const float DEFAULT_MAX_SCALE = 1.0f;
+
+	// weight of the newest GPU time in the smoothed time
+	const float AVERAGE_WEIGHT = 0.1f;
+	// GPU times measured at a scale before it can be lowered or
+	// raised again, which also covers the frames still in
+	// flight from before the last change
+	const int LOWER_SAMPLE_COUNT = 8;
+	const int RAISE_SAMPLE_COUNT = 60;
+	// fractions of the target the smoothed time must run over
+	// to lower the scale or stay under to raise it, and the
+	// fraction a new scale is aimed at
+	const float LOWER_THRESHOLD = 0.95f;
+	const float RAISE_THRESHOLD = 0.7f;
+	const float AIM_FRACTION = 0.85f;
+	// scales are picked in whole steps, and lowered by at most
+	// a few steps at a time
+	const float SCALE_STEP = 0.05f;
+	const float MAX_LOWER_CHANGE = 0.2f;
+}
+
+/***********************************************************
+ *  DynamicResolution()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DynamicResolution::DynamicResolution()
+{
+	m_bEnabled = true;
+	m_targetFrameTime = DEFAULT_TARGET_FRAME_TIME;
+	m_minScale = DEFAULT_MIN_SCALE;
+	m_maxScale = DEFAULT_MAX_SCALE;
+	m_scale = DEFAULT_MAX_SCALE;
+	m_averageTime = 0.0f;
+	m_sampleCount = 0;
+	m_lastSampleTotal = 0;
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used for turning the scaling on or off.
+ *  Turning it off returns to the largest scale.
+ ***********************************************************/
+void DynamicResolution::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+	if (bEnabled == false)
+	{
+		m_scale = m_maxScale;
+	}
+	ResetHistory();
+}
+
+/***********************************************************
+ *  SetScaleRange()
+ *
+ *  This method is used for setting the smallest and largest
+ *  render scale the scaling picks from.
+ ***********************************************************/
+void DynamicResolution::SetScaleRange(float minScale, float maxScale)
+{
+	m_minScale = (minScale < maxScale) ? minScale : maxScale;
+	m_maxScale = maxScale;
+	if (m_scale < m_minScale)
+	{
+		m_scale = m_minScale;
+	}
+	else if (m_scale > m_maxScale)
+	{
+		m_scale = m_maxScale;
+	}
+}
+
+/***********************************************************
+ *  ResetHistory()
+ *
+ *  This method is used for forgetting the measured GPU times,
+ *  so that the scale is only changed again once enough times
+ *  of the current conditions have been measured.
+ ***********************************************************/
+void DynamicResolution::ResetHistory()
+{
+	m_averageTime = 0.0f;
+	m_sampleCount = 0;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for adding the newest GPU time the
+ *  profiler read back for the scene to the smoothed time and
+ *  picking a new render scale when it has run over or stayed
+ *  under the target for long enough.  The GPU time is taken
+ *  to grow with the drawn pixel count, so a lowered scale is
+ *  the square root of the time ratio away from the current
+ *  one, while a raised scale only moves up by one step.  It
+ *  returns true when the scale changed.
+ ***********************************************************/
+bool DynamicResolution::Update(const FrameProfiler& profiler)
+{
+	int sampleTotal = profiler.GetGPUSampleTotal(FrameProfiler::SECTION_RENDER_SCENE);
+	if ((m_bEnabled == false) || (sampleTotal == m_lastSampleTotal))
+	{
+		m_lastSampleTotal = sampleTotal;
+		return(false);
+	}
+	m_lastSampleTotal = sampleTotal;
+
+	float gpuTime = profiler.GetLastGPUTime(FrameProfiler::SECTION_RENDER_SCENE);
+	if (m_sampleCount == 0)
+	{
+		m_averageTime = gpuTime;
+	}
+	else
+	{
+		m_averageTime += (gpuTime - m_averageTime) * AVERAGE_WEIGHT;
+	}
+	m_sampleCount++;
+
+	bool bLower = (m_scale > m_minScale) &&
+		(m_sampleCount >= LOWER_SAMPLE_COUNT) &&
+		(m_averageTime > m_targetFrameTime * LOWER_THRESHOLD);
+	bool bRaise = (m_scale < m_maxScale) &&
+		(m_sampleCount >= RAISE_SAMPLE_COUNT) &&
+		(m_averageTime < m_targetFrameTime * RAISE_THRESHOLD);
+	if ((bLower == false) && (bRaise == false))
+	{
+		return(false);
+	}
+
+	float scale = m_scale;
+	if (bLower)
+	{
+		// aim under the target, rounded down to a step and at
+		// least one step below the current scale
+		scale = m_scale * sqrtf(m_targetFrameTime * AIM_FRACTION / m_averageTime);
+		scale = floorf(scale / SCALE_STEP) * SCALE_STEP;
+		if (scale < m_scale - MAX_LOWER_CHANGE)
+		{
+			scale = m_scale - MAX_LOWER_CHANGE;
+		}
+		if (scale > m_scale - SCALE_STEP)
+		{
+			scale = m_scale - SCALE_STEP;
+		}
+	}
+	else
+	{
+		// only ever raise by one step, since overshooting drops
+		// the frame rate that was just recovered
+		scale = m_scale + SCALE_STEP;
+	}
+	if (scale < m_minScale)
+	{
+		scale = m_minScale;
+	}
+	else if (scale > m_maxScale)
+	{
+		scale = m_maxScale;
+	}
+
+	if (fabsf(scale - m_scale) < 0.001f)
+	{
+		return(false);
+	}
+
+	m_scale = scale;
+	ResetHistory();
+	return(true);
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// dynamicresolution.h
+// ============
+// scale the scene resolution to hold a target frame time
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameProfiler.h"
+
+/***********************************************************
+ *  DynamicResolution
+ *
+ *  This class contains the render scale the scene is drawn
+ *  at, which is lowered when the GPU time of the scene runs
+ *  over the target frame time and raised again when there is
+ *  time to spare.  The GPU time is used rather than the frame
+ *  time, since with vsync the frame time is held at the
+ *  refresh rate no matter how long the scene takes.  The
+ *  scale drops quickly and rises slowly, by whole steps, so
+ *  it settles instead of changing every frame.
+ ***********************************************************/
+class DynamicResolution
+{
+public:
+	// constructor
+	DynamicResolution();
+
+	// turn the scaling on or off, off holds the full resolution
+	void SetEnabled(bool bEnabled);
+	bool IsEnabled() const { return(m_bEnabled); }
+	// set the GPU time in milliseconds the scene should fit in
+	void SetTargetFrameTime(float milliseconds) { m_targetFrameTime = milliseconds; }
+	float GetTargetFrameTime() const { return(m_targetFrameTime); }
+	// set the smallest and largest render scale
+	void SetScaleRange(float minScale, float maxScale);
+
+	// measure the newest GPU time of the scene and pick the
+	// render scale, returning true when the scale changed
+	bool Update(const FrameProfiler& profiler);
+	// forget the measured times, such as after a resize
+	void ResetHistory();
+	// get the render scale the scene should be drawn at
+	float GetScale() const { return(m_scale); }
+
+private:
+	bool m_bEnabled;
+	float m_targetFrameTime;
+	float m_minScale;
+	float m_maxScale;
+	float m_scale;
+	// smoothed GPU time of the scene at the current scale
+	float m_averageTime;
+	int m_sampleCount;
+	// GPU samples the profiler had read back at the last update
+	int m_lastSampleTotal;
+};
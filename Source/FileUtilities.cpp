@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+// fileutilities.cpp
+// ============
+// create directories, hash file contents and replace files safely
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileUtilities.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// the multiplier of a 64-bit FNV-1a hash
+	const uint64_t HASH_PRIME = 1099511628211ull;
+	// added to a file name for the file being written
+	const char* TEMPORARY_SUFFIX = ".tmp";
+}
+
+/***********************************************************
+ *  CreateDirectoryPath()
+ *
+ *  This method is used for creating a directory.  It is not
+ *  an error when the directory already exists.
+ ***********************************************************/
+bool FileUtilities::CreateDirectoryPath(const std::string& directory)
+{
+#ifdef _WIN32
+	int result = _mkdir(directory.c_str());
+#else
+	int result = mkdir(directory.c_str(), 0755);
+#endif
+
+	return((result == 0) || (errno == EEXIST));
+}
+
+/***********************************************************
+ *  HashBytes()
+ *
+ *  This method is used for hashing bytes with 64-bit FNV-1a.
+ *  Passing in the hash of earlier bytes continues it, so
+ *  several buffers can be hashed as if they were one.
+ ***********************************************************/
+uint64_t FileUtilities::HashBytes(const void* pData, size_t size, uint64_t hash)
+{
+	const unsigned char* pBytes = (const unsigned char*)pData;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= HASH_PRIME;
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  WriteFileAtomic()
+ *
+ *  This method is used for replacing a file with the passed
+ *  in bytes.
+ ***********************************************************/
+bool FileUtilities::WriteFileAtomic(const std::string& filename, const void* pData, size_t size)
+{
+	FILE_PART part;
+	part.pData = pData;
+	part.size = size;
+
+	return(WriteFileAtomic(filename, &part, 1));
+}
+
+/***********************************************************
+ *  WriteFileAtomic()
+ *
+ *  This method is used for replacing a file with the passed
+ *  in parts.  They are written to a temporary file that is
+ *  renamed over the old file when complete.  On any failure
+ *  the temporary file is removed and false is returned, so a
+ *  failed write leaves no file behind but the old one.
+ ***********************************************************/
+bool FileUtilities::WriteFileAtomic(const std::string& filename, const FILE_PART* pParts, int partCount)
+{
+	std::string temporaryName = filename + TEMPORARY_SUFFIX;
+	bool bWritten = false;
+	{
+		std::ofstream file(temporaryName.c_str(), std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return(false);
+		}
+		for (int i = 0; i < partCount; i++)
+		{
+			if (pParts[i].size > 0)
+			{
+				file.write((const char*)pParts[i].pData, pParts[i].size);
+			}
+		}
+		file.flush();
+		bWritten = file.good();
+	}
+
+	if (bWritten)
+	{
+		// rename replaces the old file on POSIX, while Windows
+		// needs it removed first
+		if (0 == rename(temporaryName.c_str(), filename.c_str()))
+		{
+			return(true);
+		}
+		remove(filename.c_str());
+		if (0 == rename(temporaryName.c_str(), filename.c_str()))
+		{
+			return(true);
+		}
+	}
+
+	remove(temporaryName.c_str());
+	return(false);
+}
@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////////////////////////
+// fileutilities.h
+// ============
+// create directories, hash file contents and replace files safely
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/***********************************************************
+ *  FileUtilities
+ *
+ *  This class contains the file steps shared by the caches,
+ *  the scene file and the image writer.  A file is always
+ *  written to a temporary file that is renamed over the old
+ *  one when complete, so an interrupted write never leaves a
+ *  partly written file under the final name.
+ ***********************************************************/
+class FileUtilities
+{
+public:
+	// the starting value of a 64-bit FNV-1a hash
+	static const uint64_t HASH_OFFSET_BASIS = 14695981039346656037ull;
+
+	// one run of bytes of a file written in several parts
+	struct FILE_PART
+	{
+		const void* pData;
+		size_t size;
+	};
+
+	// create a directory, which may already exist
+	static bool CreateDirectoryPath(const std::string& directory);
+	// hash bytes with 64-bit FNV-1a, continuing from a hash
+	static uint64_t HashBytes(const void* pData, size_t size, uint64_t hash = HASH_OFFSET_BASIS);
+	// replace a file with the passed in bytes
+	static bool WriteFileAtomic(const std::string& filename, const void* pData, size_t size);
+	// replace a file with the passed in parts, written in order
+	static bool WriteFileAtomic(const std::string& filename, const FILE_PART* pParts, int partCount);
+};
@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// detect changes to the files the scene is loaded from
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <chrono>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_pollMilliseconds = DEFAULT_POLL_MILLISECONDS;
+	m_bStopping = false;
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the thread that checks
+ *  the watched files every passed in number of milliseconds.
+ ***********************************************************/
+void FileWatcher::Start(int pollMilliseconds)
+{
+	if (IsRunning())
+	{
+		return;
+	}
+
+	m_pollMilliseconds = (pollMilliseconds > 0) ? pollMilliseconds : DEFAULT_POLL_MILLISECONDS;
+	m_bStopping = false;
+	m_thread = std::thread(&FileWatcher::WatcherMain, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the thread that checks
+ *  the watched files.  Changes not yet taken are kept.
+ ***********************************************************/
+void FileWatcher::Stop()
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_wakeCondition.notify_all();
+	m_thread.join();
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used for watching a file for changes.  It
+ *  returns the ID the changes of the file are reported by.
+ *  A file is watched even while it does not exist yet.
+ ***********************************************************/
+int FileWatcher::AddFile(const std::string& filename)
+{
+	WATCHED_FILE file;
+	file.filename = filename;
+	file.modifiedTime = 0;
+	file.fileBytes = 0;
+	file.bChanging = false;
+	file.changingTime = 0;
+	file.changingBytes = 0;
+	ReadFileState(filename, file.modifiedTime, file.fileBytes);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_files.push_back(file);
+
+	return((int)m_files.size() - 1);
+}
+
+/***********************************************************
+ *  TakeChangedFiles()
+ *
+ *  This method is used for taking the IDs of the watched
+ *  files that changed since the last call, each only once.
+ ***********************************************************/
+void FileWatcher::TakeChangedFiles(std::vector<int>& watchIDs)
+{
+	watchIDs.clear();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	watchIDs.swap(m_changedIDs);
+}
+
+/***********************************************************
+ *  WatcherMain()
+ *
+ *  This method is used for checking the watched files on the
+ *  watcher thread until the watcher is stopped.
+ ***********************************************************/
+void FileWatcher::WatcherMain()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_bStopping)
+	{
+		lock.unlock();
+		CheckFiles();
+		lock.lock();
+
+		m_wakeCondition.wait_for(lock, std::chrono::milliseconds(m_pollMilliseconds),
+			[this]() { return(m_bStopping); });
+	}
+}
+
+/***********************************************************
+ *  CheckFiles()
+ *
+ *  This method is used for checking every watched file once.
+ *  A file whose state differs from the one it was last read
+ *  with is only reported when the previous check saw the
+ *  same new state, and a missing file is never reported.
+ *  The files are read without holding the lock, so adding a
+ *  file never waits on the file system.
+ ***********************************************************/
+void FileWatcher::CheckFiles()
+{
+	std::vector<std::string> filenames;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		filenames.reserve(m_files.size());
+		for (size_t i = 0; i < m_files.size(); i++)
+		{
+			filenames.push_back(m_files[i].filename);
+		}
+	}
+
+	for (size_t i = 0; i < filenames.size(); i++)
+	{
+		int64_t modifiedTime = 0;
+		int64_t fileBytes = 0;
+		bool bExists = ReadFileState(filenames[i], modifiedTime, fileBytes);
+
+		// the files are only ever added, so the index still holds
+		std::lock_guard<std::mutex> lock(m_mutex);
+		WATCHED_FILE& file = m_files[i];
+		if (!bExists || ((modifiedTime == file.modifiedTime) && (fileBytes == file.fileBytes)))
+		{
+			file.bChanging = false;
+			continue;
+		}
+
+		if (file.bChanging && (modifiedTime == file.changingTime) && (fileBytes == file.changingBytes))
+		{
+			file.modifiedTime = modifiedTime;
+			file.fileBytes = fileBytes;
+			file.bChanging = false;
+			m_changedIDs.push_back((int)i);
+		}
+		else
+		{
+			file.bChanging = true;
+			file.changingTime = modifiedTime;
+			file.changingBytes = fileBytes;
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadFileState()
+ *
+ *  This method is used for reading the modification time
+ *  and size of a file.  It returns false when the file does
+ *  not exist.
+ ***********************************************************/
+bool FileWatcher::ReadFileState(const std::string& filename, int64_t& modifiedTime, int64_t& fileBytes)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filename.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return(false);
+	}
+	// the write time counts 100 nanosecond intervals
+	modifiedTime = ((int64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) |
+		(int64_t)attributes.ftLastWriteTime.dwLowDateTime;
+	fileBytes = ((int64_t)attributes.nFileSizeHigh << 32) | (int64_t)attributes.nFileSizeLow;
+#else
+	struct stat status;
+	if (stat(filename.c_str(), &status) != 0)
+	{
+		return(false);
+	}
+	modifiedTime = (int64_t)status.st_mtime;
+	fileBytes = (int64_t)status.st_size;
+#endif
+
+	return(true);
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// detect changes to the files the scene is loaded from
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains a background thread that checks the
+ *  modification time and size of the watched files a few
+ *  times a second.  A file is only reported as changed once
+ *  it has stayed the same for a whole check, so a file that
+ *  an editor is still writing is never read half saved.  The
+ *  changes are queued for the rendering thread, which takes
+ *  them between frames.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// milliseconds between the checks of the watched files
+	static const int DEFAULT_POLL_MILLISECONDS = 250;
+
+	// start the thread that checks the watched files
+	void Start(int pollMilliseconds = DEFAULT_POLL_MILLISECONDS);
+	// stop the thread that checks the watched files
+	void Stop();
+	bool IsRunning() const { return(m_thread.joinable()); }
+
+	// watch a file and return the ID its changes are reported by
+	int AddFile(const std::string& filename);
+	// take the IDs of the files that changed since the last call
+	void TakeChangedFiles(std::vector<int>& watchIDs);
+
+private:
+	// last seen state of one watched file
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		// modification time and size the file was last read with
+		int64_t modifiedTime;
+		int64_t fileBytes;
+		// state seen by the last check while the file changes
+		bool bChanging;
+		int64_t changingTime;
+		int64_t changingBytes;
+	};
+
+	std::vector<WATCHED_FILE> m_files;
+	// IDs of the changed files not yet taken
+	std::vector<int> m_changedIDs;
+	// guards the watched files and the changed IDs
+	std::mutex m_mutex;
+	// the thread sleeps between checks until it is stopped
+	std::condition_variable m_wakeCondition;
+	std::thread m_thread;
+	int m_pollMilliseconds;
+	bool m_bStopping;
+
+	// check the watched files until the watcher is stopped
+	void WatcherMain();
+	// check every watched file once
+	void CheckFiles();
+	// read the modification time and size of a file
+	static bool ReadFileState(const std::string& filename, int64_t& modifiedTime, int64_t& fileBytes);
+};
@@ -0,0 +1,165 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// hand out the transient memory of a frame from one block reset every frame
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+
+#include <cstdint>
+
+// declaration of global variables
+namespace
+{
+	// the block is grown in steps of this many bytes, with room
+	// to spare over the most a frame has used
+	const size_t BLOCK_GRANULARITY = 64 * 1024;
+
+	// the alignment of the block and of the overflow blocks
+	const size_t BLOCK_ALIGNMENT = 16;
+
+	/***********************************************************
+	 *  AlignPointer()
+	 *
+	 *  Rounds an address up to a power of two alignment.
+	 ***********************************************************/
+	char* AlignPointer(char* pAddress, size_t alignment)
+	{
+		uintptr_t address = (uintptr_t)pAddress;
+		address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		return((char*)address);
+	}
+}
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena()
+{
+	m_pBlock = NULL;
+	m_capacity = 0;
+	m_usedBytes = 0;
+	m_pOverflowBlocks = NULL;
+	m_overflowBytes = 0;
+	m_overflowCount = 0;
+	m_peakBytes = 0;
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	FreeOverflowBlocks();
+	delete[] m_pBlock;
+	m_pBlock = NULL;
+}
+
+/***********************************************************
+ *  Reserve()
+ *
+ *  This method is used for growing the block to hold at
+ *  least the passed in bytes.  A block that is already big
+ *  enough is kept, so this costs nothing once the frames
+ *  have settled.  Everything allocated this frame is lost.
+ ***********************************************************/
+void FrameArena::Reserve(size_t bytes)
+{
+	if (bytes <= m_capacity)
+	{
+		return;
+	}
+
+	size_t capacity = bytes + bytes / 4;
+	capacity = (capacity + BLOCK_GRANULARITY - 1) / BLOCK_GRANULARITY * BLOCK_GRANULARITY;
+
+	// the block is allocated with room to align its start
+	delete[] m_pBlock;
+	m_pBlock = new char[capacity + BLOCK_ALIGNMENT];
+	m_capacity = capacity;
+	m_usedBytes = 0;
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for giving back everything that was
+ *  allocated since the last reset.  A frame that overflowed
+ *  the block grows it to hold that whole frame.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	size_t frameBytes = m_usedBytes + m_overflowBytes;
+	if (frameBytes > m_peakBytes)
+	{
+		m_peakBytes = frameBytes;
+	}
+
+	FreeOverflowBlocks();
+	m_usedBytes = 0;
+
+	if (m_peakBytes > m_capacity)
+	{
+		Reserve(m_peakBytes);
+	}
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for bumping the passed in bytes out
+ *  of the block at a power of two alignment.  When they do
+ *  not fit, they are allocated from the heap until the next
+ *  reset.  The memory is never freed on its own.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	if (alignment < 1)
+	{
+		alignment = 1;
+	}
+
+	if (NULL != m_pBlock)
+	{
+		char* pBase = AlignPointer(m_pBlock, BLOCK_ALIGNMENT);
+		char* pAddress = AlignPointer(pBase + m_usedBytes, alignment);
+		size_t end = (size_t)(pAddress - pBase) + bytes;
+		if (end <= m_capacity)
+		{
+			m_usedBytes = end;
+			return(pAddress);
+		}
+	}
+
+	// the header is followed by room to align the allocation
+	OVERFLOW_BLOCK* pOverflow = (OVERFLOW_BLOCK*)new char[sizeof(OVERFLOW_BLOCK) + alignment + bytes];
+	pOverflow->pNext = m_pOverflowBlocks;
+	m_pOverflowBlocks = pOverflow;
+	m_overflowBytes += bytes + alignment;
+	m_overflowCount++;
+
+	return(AlignPointer((char*)(pOverflow + 1), alignment));
+}
+
+/***********************************************************
+ *  FreeOverflowBlocks()
+ *
+ *  This method is used for freeing the heap blocks of the
+ *  allocations that did not fit the block.
+ ***********************************************************/
+void FrameArena::FreeOverflowBlocks()
+{
+	while (NULL != m_pOverflowBlocks)
+	{
+		OVERFLOW_BLOCK* pNext = m_pOverflowBlocks->pNext;
+		delete[] (char*)m_pOverflowBlocks;
+		m_pOverflowBlocks = pNext;
+	}
+	m_overflowBytes = 0;
+}
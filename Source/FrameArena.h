@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// hand out the transient memory of a frame from one block reset every frame
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class contains one block of memory that the
+ *  transient data of a frame is bumped out of, and which is
+ *  given back all at once when the next frame resets it.
+ *  An allocation that does not fit the block gets a block of
+ *  its own from the heap, and the next reset grows the main
+ *  block to the most any frame has used, so once the frames
+ *  settle they never touch the heap.  Allocations are only
+ *  made from the OpenGL thread, while the jobs of a frame
+ *  write into arrays that were allocated before they start.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena();
+	// destructor
+	~FrameArena();
+
+	// grow the block to hold at least the passed in bytes, only
+	// between frames since the allocations of the frame are lost
+	void Reserve(size_t bytes);
+	// give back everything allocated since the last reset
+	void Reset();
+	// allocate bytes at a power of two alignment for this frame
+	void* Allocate(size_t bytes, size_t alignment);
+
+	// get the bytes allocated this frame
+	size_t GetUsedBytes() const { return(m_usedBytes + m_overflowBytes); }
+	// get the bytes of the block
+	size_t GetCapacity() const { return(m_capacity); }
+	// get the most bytes any frame has allocated
+	size_t GetPeakBytes() const { return(m_peakBytes); }
+	// get the number of allocations that have not fit the block
+	int GetOverflowCount() const { return(m_overflowCount); }
+
+private:
+	// a heap block of an allocation that did not fit, the
+	// allocation follows the header
+	struct OVERFLOW_BLOCK
+	{
+		OVERFLOW_BLOCK* pNext;
+	};
+
+	char* m_pBlock;
+	size_t m_capacity;
+	size_t m_usedBytes;
+	// heap blocks of this frame and the bytes allocated in them
+	OVERFLOW_BLOCK* m_pOverflowBlocks;
+	size_t m_overflowBytes;
+	int m_overflowCount;
+	size_t m_peakBytes;
+
+	// free the heap blocks of the overflowed allocations
+	void FreeOverflowBlocks();
+};
+
+/***********************************************************
+ *  ArenaArray
+ *
+ *  This class contains an array of plain data allocated from
+ *  a frame arena.  It has the handful of vector operations
+ *  the frame code needs, and growing it copies the elements
+ *  into new arena memory instead of freeing the old memory.
+ *  The elements are lost when the arena is reset, so an array
+ *  must be allocated again each frame before it is used.
+ ***********************************************************/
+template <typename T>
+class ArenaArray
+{
+	static_assert(std::is_trivially_copyable<T>::value, "arena arrays hold plain data");
+
+public:
+	// constructor
+	ArenaArray()
+	{
+		m_pArena = NULL;
+		m_pData = NULL;
+		m_count = 0;
+		m_capacity = 0;
+	}
+
+	// start the array of this frame with room for the passed in
+	// number of elements
+	void Allocate(FrameArena& arena, int capacity)
+	{
+		m_pArena = &arena;
+		m_pData = NULL;
+		m_count = 0;
+		m_capacity = 0;
+		Reserve(capacity);
+	}
+	// drop the elements and the memory of the array
+	void Release()
+	{
+		m_pData = NULL;
+		m_count = 0;
+		m_capacity = 0;
+	}
+	// remove the elements, keeping the memory for this frame
+	void Clear() { m_count = 0; }
+
+	// make room for at least the passed in number of elements
+	void Reserve(int capacity)
+	{
+		if (capacity <= m_capacity)
+		{
+			return;
+		}
+		assert(NULL != m_pArena);
+
+		T* pData = (T*)m_pArena->Allocate((size_t)capacity * sizeof(T), alignof(T));
+		if (m_count > 0)
+		{
+			memcpy(pData, m_pData, (size_t)m_count * sizeof(T));
+		}
+		m_pData = pData;
+		m_capacity = capacity;
+	}
+	// set the number of elements, new elements are not set
+	void Resize(int count)
+	{
+		if (count > m_capacity)
+		{
+			Reserve((count > m_capacity * 2) ? count : m_capacity * 2);
+		}
+		m_count = count;
+	}
+	// add an element at the end
+	void Push(const T& value)
+	{
+		if (m_count == m_capacity)
+		{
+			Reserve((m_capacity > 0) ? m_capacity * 2 : 16);
+		}
+		m_pData[m_count++] = value;
+	}
+
+	// get the number of elements
+	int GetCount() const { return(m_count); }
+	bool IsEmpty() const { return(0 == m_count); }
+	// get the element storage
+	T* GetData() { return(m_pData); }
+	const T* GetData() const { return(m_pData); }
+	// get an element
+	T& operator[](int index) { return(m_pData[index]); }
+	const T& operator[](int index) const { return(m_pData[index]); }
+	T& Back() { return(m_pData[m_count - 1]); }
+	const T& Back() const { return(m_pData[m_count - 1]); }
+
+private:
+	FrameArena* m_pArena;
+	T* m_pData;
+	int m_count;
+	int m_capacity;
+};
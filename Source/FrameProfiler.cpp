@@ -0,0 +1,576 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// time the frame sections on the CPU and the GPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+#include "AllocationCounter.h"
+#include "ShaderCompiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// names of the sections and counters in the trace and summary
+	const char* const g_SectionNames[FrameProfiler::SECTION_COUNT] =
+	{
+		"Update",
+		"PrepareSceneView",
+		"RenderScene",
+		"SwapBuffers"
+	};
+	const char* const g_CounterNames[FrameProfiler::COUNTER_COUNT] =
+	{
+		"draws",
+		"uniformUploads",
+		"textureBinds",
+		"renderScalePercent",
+		"allocations"
+	};
+
+	// most events and frame counts kept for the Chrome trace
+	const size_t MAX_TRACE_EVENTS = 16384;
+	const size_t MAX_TRACE_COUNTERS = 4096;
+
+	// placement of the overlay graph in normalized device
+	// coordinates and the frame time at its full height
+	const float OVERLAY_RECT[4] = { -0.98f, 0.68f, 0.6f, 0.3f };
+	const float OVERLAY_MAX_TIME = 50.0f;
+	// frame allocation count drawn at the full height of the graph
+	const float OVERLAY_MAX_ALLOCATIONS = 64.0f;
+
+	// GLSL source files of the overlay graph
+	const char* const OVERLAY_VERTEX_SHADER = "shaders/overlayVertexShader.glsl";
+	const char* const OVERLAY_FRAGMENT_SHADER = "shaders/overlayFragmentShader.glsl";
+}
+
+/***********************************************************
+ *  FrameProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameProfiler::FrameProfiler()
+{
+	m_startTime = std::chrono::steady_clock::now();
+	m_frameIndex = 0;
+	m_frameStartMicroseconds = 0.0;
+	m_bInitialized = false;
+	m_frameCount = 0;
+	m_frameStartAllocations = 0;
+	m_overlayProgramID = 0;
+	m_overlayVAO = 0;
+
+	// the trace is allocated whole, so recording it never allocates
+	m_traceEvents.resize(MAX_TRACE_EVENTS);
+	m_traceEventFirst = 0;
+	m_traceEventCount = 0;
+	m_traceCounters.resize(MAX_TRACE_COUNTERS);
+	m_traceCounterFirst = 0;
+	m_traceCounterCount = 0;
+
+	for (int s = 0; s < SECTION_COUNT; s++)
+	{
+		m_sectionStartMicroseconds[s] = 0.0;
+		m_gpuSampleCount[s] = 0;
+		m_gpuSampleNext[s] = 0;
+		m_gpuSampleTotal[s] = 0;
+		for (int q = 0; q < QUERY_SET_COUNT; q++)
+		{
+			m_querySets[q].queries[s] = 0;
+			m_querySets[q].bIssued[s] = false;
+			m_querySets[q].startMicroseconds[s] = 0.0;
+		}
+	}
+	for (int c = 0; c < COUNTER_COUNT; c++)
+	{
+		m_counters[c] = 0;
+		m_lastCounters[c] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~FrameProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameProfiler::~FrameProfiler()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the timer queries of
+ *  every query set and building the overlay shader program.
+ ***********************************************************/
+void FrameProfiler::Initialize()
+{
+	for (int q = 0; q < QUERY_SET_COUNT; q++)
+	{
+		glGenQueries(SECTION_COUNT, m_querySets[q].queries);
+	}
+
+	m_overlayProgramID = ShaderCompiler::BuildProgram(OVERLAY_VERTEX_SHADER, OVERLAY_FRAGMENT_SHADER);
+	if (0 == m_overlayProgramID)
+	{
+		std::cout << "Could not build the profiler overlay shaders" << std::endl;
+	}
+
+	// the overlay vertices are generated from gl_VertexID
+	glGenVertexArrays(1, &m_overlayVAO);
+
+	m_bInitialized = true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the timer queries and
+ *  the overlay objects.
+ ***********************************************************/
+void FrameProfiler::Destroy()
+{
+	if (!m_bInitialized)
+	{
+		return;
+	}
+
+	for (int q = 0; q < QUERY_SET_COUNT; q++)
+	{
+		glDeleteQueries(SECTION_COUNT, m_querySets[q].queries);
+	}
+	if (0 != m_overlayProgramID)
+	{
+		glDeleteProgram(m_overlayProgramID);
+		m_overlayProgramID = 0;
+	}
+	if (0 != m_overlayVAO)
+	{
+		glDeleteVertexArrays(1, &m_overlayVAO);
+		m_overlayVAO = 0;
+	}
+	m_bInitialized = false;
+}
+
+/***********************************************************
+ *  GetMicroseconds()
+ *
+ *  This method is used for getting the time passed since
+ *  the profiler was created.
+ ***********************************************************/
+double FrameProfiler::GetMicroseconds() const
+{
+	std::chrono::duration<double, std::micro> elapsed =
+		std::chrono::steady_clock::now() - m_startTime;
+
+	return(elapsed.count());
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a frame.  The query set
+ *  of this frame was last used two frames ago, so its results
+ *  are read back before it is reused.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	m_frameStartMicroseconds = GetMicroseconds();
+	m_frameStartAllocations = AllocationCounter::GetAllocationCount();
+
+	if (m_bInitialized)
+	{
+		CollectQueryResults(m_querySets[m_frameIndex % QUERY_SET_COUNT]);
+	}
+
+	for (int c = 0; c < COUNTER_COUNT; c++)
+	{
+		m_counters[c] = 0;
+	}
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing a frame by storing its
+ *  CPU times, heap allocations and counters in the history.
+ ***********************************************************/
+void FrameProfiler::EndFrame()
+{
+	double frameEnd = GetMicroseconds();
+	int historyIndex = m_frameCount % HISTORY_FRAME_COUNT;
+
+	uint64_t allocations = AllocationCounter::GetAllocationCount() - m_frameStartAllocations;
+	m_counters[COUNTER_ALLOCATIONS] = (int)std::min(allocations, (uint64_t)INT32_MAX);
+	m_frameAllocations[historyIndex] = (float)m_counters[COUNTER_ALLOCATIONS];
+
+	m_frameTimes[historyIndex] = (float)((frameEnd - m_frameStartMicroseconds) / 1000.0);
+	AddTraceEvent(-1, false, m_frameStartMicroseconds, frameEnd - m_frameStartMicroseconds);
+
+	// the oldest counts are written over once the trace is full
+	TRACE_COUNTERS& counters = m_traceCounters[(m_traceCounterFirst + m_traceCounterCount) % MAX_TRACE_COUNTERS];
+	counters.timeMicroseconds = m_frameStartMicroseconds;
+	for (int c = 0; c < COUNTER_COUNT; c++)
+	{
+		counters.values[c] = m_counters[c];
+		m_lastCounters[c] = m_counters[c];
+	}
+	if (m_traceCounterCount < MAX_TRACE_COUNTERS)
+	{
+		m_traceCounterCount++;
+	}
+	else
+	{
+		m_traceCounterFirst = (m_traceCounterFirst + 1) % MAX_TRACE_COUNTERS;
+	}
+
+	m_frameCount++;
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  BeginSection()
+ *
+ *  This method is used for starting the CPU timer and the
+ *  GPU query of a section.  Sections must not overlap since
+ *  only one time elapsed query can be active at a time.
+ ***********************************************************/
+void FrameProfiler::BeginSection(int sectionID)
+{
+	double now = GetMicroseconds();
+	m_sectionStartMicroseconds[sectionID] = now;
+
+	if (m_bInitialized)
+	{
+		QUERY_SET& querySet = m_querySets[m_frameIndex % QUERY_SET_COUNT];
+		glBeginQuery(GL_TIME_ELAPSED, querySet.queries[sectionID]);
+		querySet.bIssued[sectionID] = true;
+		querySet.startMicroseconds[sectionID] = now;
+	}
+}
+
+/***********************************************************
+ *  EndSection()
+ *
+ *  This method is used for stopping the CPU timer and the
+ *  GPU query of a section.
+ ***********************************************************/
+void FrameProfiler::EndSection(int sectionID)
+{
+	if (m_bInitialized)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+	}
+
+	double start = m_sectionStartMicroseconds[sectionID];
+	double duration = GetMicroseconds() - start;
+	m_cpuSectionTimes[sectionID][m_frameCount % HISTORY_FRAME_COUNT] = (float)(duration / 1000.0);
+	AddTraceEvent(sectionID, false, start, duration);
+}
+
+/***********************************************************
+ *  SetCounter()
+ *
+ *  This method is used for setting the count of a counter
+ *  for the current frame.
+ ***********************************************************/
+void FrameProfiler::SetCounter(int counterID, int value)
+{
+	if ((counterID >= 0) && (counterID < COUNTER_COUNT))
+	{
+		m_counters[counterID] = value;
+	}
+}
+
+/***********************************************************
+ *  CollectQueryResults()
+ *
+ *  This method is used for reading back the GPU times of a
+ *  query set.  A result that is not available yet is dropped
+ *  instead of waited on, and the query is issued again.
+ ***********************************************************/
+void FrameProfiler::CollectQueryResults(QUERY_SET& querySet)
+{
+	for (int s = 0; s < SECTION_COUNT; s++)
+	{
+		if (!querySet.bIssued[s])
+		{
+			continue;
+		}
+		querySet.bIssued[s] = false;
+
+		GLuint bAvailable = 0;
+		glGetQueryObjectuiv(querySet.queries[s], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == GL_FALSE)
+		{
+			continue;
+		}
+
+		GLuint64 elapsedNanoseconds = 0;
+		glGetQueryObjectui64v(querySet.queries[s], GL_QUERY_RESULT, &elapsedNanoseconds);
+
+		double duration = (double)elapsedNanoseconds / 1000.0;
+		m_gpuSectionTimes[s][m_gpuSampleNext[s]] = (float)(duration / 1000.0);
+		m_gpuSampleNext[s] = (m_gpuSampleNext[s] + 1) % HISTORY_FRAME_COUNT;
+		m_gpuSampleTotal[s]++;
+		if (m_gpuSampleCount[s] < HISTORY_FRAME_COUNT)
+		{
+			m_gpuSampleCount[s]++;
+		}
+
+		// the GPU work is placed at the CPU time it was issued
+		AddTraceEvent(s, true, querySet.startMicroseconds[s], duration);
+	}
+}
+
+/***********************************************************
+ *  AddTraceEvent()
+ *
+ *  This method is used for recording a timed span for the
+ *  Chrome trace, dropping the oldest span when it is full.
+ ***********************************************************/
+void FrameProfiler::AddTraceEvent(int sectionID, bool bGPU, double startMicroseconds, double durationMicroseconds)
+{
+	TRACE_EVENT& traceEvent = m_traceEvents[(m_traceEventFirst + m_traceEventCount) % MAX_TRACE_EVENTS];
+
+	traceEvent.sectionID = sectionID;
+	traceEvent.bGPU = bGPU;
+	traceEvent.startMicroseconds = startMicroseconds;
+	traceEvent.durationMicroseconds = durationMicroseconds;
+	if (m_traceEventCount < MAX_TRACE_EVENTS)
+	{
+		m_traceEventCount++;
+	}
+	else
+	{
+		m_traceEventFirst = (m_traceEventFirst + 1) % MAX_TRACE_EVENTS;
+	}
+}
+
+/***********************************************************
+ *  GetPercentile()
+ *
+ *  This method is used for getting a percentile between 0
+ *  and 100 of the recent CPU or GPU times of a section, or
+ *  of the whole frame when the section ID is -1.
+ ***********************************************************/
+float FrameProfiler::GetPercentile(int sectionID, bool bGPU, float percentile) const
+{
+	const float* pTimes = m_frameTimes;
+	int sampleCount = std::min(m_frameCount, (int)HISTORY_FRAME_COUNT);
+
+	if ((sectionID >= 0) && (sectionID < SECTION_COUNT))
+	{
+		pTimes = bGPU ? m_gpuSectionTimes[sectionID] : m_cpuSectionTimes[sectionID];
+		if (bGPU)
+		{
+			sampleCount = m_gpuSampleCount[sectionID];
+		}
+	}
+	if (sampleCount == 0)
+	{
+		return(0.0f);
+	}
+
+	// the samples are copied to the stack, so no percentile allocates
+	float sorted[HISTORY_FRAME_COUNT];
+	std::copy(pTimes, pTimes + sampleCount, sorted);
+	int rank = (int)((percentile / 100.0f) * (float)(sampleCount - 1) + 0.5f);
+	rank = std::min(rank, sampleCount - 1);
+	std::nth_element(sorted, sorted + rank, sorted + sampleCount);
+
+	return(sorted[rank]);
+}
+
+/***********************************************************
+ *  GetLastFrameTime()
+ *
+ *  This method is used for getting the CPU time of the last
+ *  finished frame.
+ ***********************************************************/
+float FrameProfiler::GetLastFrameTime() const
+{
+	if (m_frameCount == 0)
+	{
+		return(0.0f);
+	}
+
+	return(m_frameTimes[(m_frameCount - 1) % HISTORY_FRAME_COUNT]);
+}
+
+/***********************************************************
+ *  GetLastGPUTime()
+ *
+ *  This method is used for getting the most recent GPU time
+ *  read back for a section.
+ ***********************************************************/
+float FrameProfiler::GetLastGPUTime(int sectionID) const
+{
+	if (m_gpuSampleCount[sectionID] == 0)
+	{
+		return(0.0f);
+	}
+
+	return(m_gpuSectionTimes[sectionID][(m_gpuSampleNext[sectionID] + HISTORY_FRAME_COUNT - 1) % HISTORY_FRAME_COUNT]);
+}
+
+/***********************************************************
+ *  GetSummary()
+ *
+ *  This method is used for formatting the frame percentiles,
+ *  the GPU time of the scene and the last frame counters
+ *  into one line.
+ ***********************************************************/
+std::string FrameProfiler::GetSummary() const
+{
+	char summary[256];
+
+	FormatSummary(summary, sizeof(summary));
+
+	return(std::string(summary));
+}
+
+/***********************************************************
+ *  FormatSummary()
+ *
+ *  This method is used for writing the one line summary of
+ *  GetSummary() into the passed in buffer, so that it can be
+ *  shown every frame without allocating.
+ ***********************************************************/
+void FrameProfiler::FormatSummary(char* summary, size_t summarySize) const
+{
+	snprintf(summary, summarySize,
+		"frame %.2f/%.2f/%.2f ms (p50/p95/p99), scene GPU %.2f ms, draws %d, uniforms %d, texture binds %d, scale %d%%, allocations %d",
+		GetPercentile(-1, false, 50.0f),
+		GetPercentile(-1, false, 95.0f),
+		GetPercentile(-1, false, 99.0f),
+		GetPercentile(SECTION_RENDER_SCENE, true, 50.0f),
+		m_lastCounters[COUNTER_DRAWS],
+		m_lastCounters[COUNTER_UNIFORM_UPLOADS],
+		m_lastCounters[COUNTER_TEXTURE_BINDS],
+		m_lastCounters[COUNTER_RENDER_SCALE_PERCENT],
+		m_lastCounters[COUNTER_ALLOCATIONS]);
+}
+
+/***********************************************************
+ *  DrawOverlay()
+ *
+ *  This method is used for drawing the recent frame times as
+ *  a bar graph in the corner of the window, with the heap
+ *  allocations of each frame hanging from the top of the
+ *  graph.  The shader program that was in use is restored
+ *  afterwards.
+ ***********************************************************/
+void FrameProfiler::DrawOverlay()
+{
+	if (0 == m_overlayProgramID)
+	{
+		return;
+	}
+
+	// order the ring buffers from the oldest to the newest frame
+	float frameTimes[HISTORY_FRAME_COUNT];
+	float frameAllocations[HISTORY_FRAME_COUNT];
+	int sampleCount = std::min(m_frameCount, (int)HISTORY_FRAME_COUNT);
+	for (int i = 0; i < HISTORY_FRAME_COUNT; i++)
+	{
+		int age = HISTORY_FRAME_COUNT - i;
+		int historyIndex = (m_frameCount - age + HISTORY_FRAME_COUNT) % HISTORY_FRAME_COUNT;
+		frameTimes[i] = (age <= sampleCount) ? m_frameTimes[historyIndex] : 0.0f;
+		frameAllocations[i] = (age <= sampleCount) ? m_frameAllocations[historyIndex] : 0.0f;
+	}
+
+	GLint previousProgramID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgramID);
+	GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean bBlend = glIsEnabled(GL_BLEND);
+
+	glUseProgram(m_overlayProgramID);
+	glUniform4fv(glGetUniformLocation(m_overlayProgramID, "frameTimes"), HISTORY_FRAME_COUNT / 4, frameTimes);
+	glUniform4fv(glGetUniformLocation(m_overlayProgramID, "overlayRect"), 1, OVERLAY_RECT);
+	glUniform1f(glGetUniformLocation(m_overlayProgramID, "graphMaxTime"), OVERLAY_MAX_TIME);
+	glUniform4fv(glGetUniformLocation(m_overlayProgramID, "frameAllocations"), HISTORY_FRAME_COUNT / 4, frameAllocations);
+	glUniform1f(glGetUniformLocation(m_overlayProgramID, "graphMaxAllocations"), OVERLAY_MAX_ALLOCATIONS);
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindVertexArray(m_overlayVAO);
+	// one background quad followed by a time and an allocation
+	// quad per frame
+	glDrawArrays(GL_TRIANGLES, 0, (2 * HISTORY_FRAME_COUNT + 1) * 6);
+	glBindVertexArray(0);
+
+	if (bDepthTest)
+	{
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (!bBlend)
+	{
+		glDisable(GL_BLEND);
+	}
+	glUseProgram((GLuint)previousProgramID);
+}
+
+/***********************************************************
+ *  ExportChromeTrace()
+ *
+ *  This method is used for writing the recorded spans and
+ *  counters in the Chrome trace event format, which can be
+ *  opened in chrome://tracing or Perfetto.  The CPU spans
+ *  are on thread 1 and the GPU spans on thread 2.
+ ***********************************************************/
+bool FrameProfiler::ExportChromeTrace(const std::string& filename) const
+{
+	std::ofstream file(filename.c_str());
+	if (!file)
+	{
+		std::cout << "Could not write trace file:" << filename << std::endl;
+		return(false);
+	}
+
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	char line[512];
+	for (size_t i = 0; i < m_traceEventCount; i++)
+	{
+		const TRACE_EVENT& traceEvent = m_traceEvents[(m_traceEventFirst + i) % MAX_TRACE_EVENTS];
+		const char* name = (traceEvent.sectionID >= 0) ? g_SectionNames[traceEvent.sectionID] : "Frame";
+		snprintf(line, sizeof(line),
+			",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			name,
+			traceEvent.bGPU ? 2 : 1,
+			traceEvent.startMicroseconds,
+			traceEvent.durationMicroseconds);
+		file << line;
+	}
+
+	for (size_t i = 0; i < m_traceCounterCount; i++)
+	{
+		const TRACE_COUNTERS& counters = m_traceCounters[(m_traceCounterFirst + i) % MAX_TRACE_COUNTERS];
+		snprintf(line, sizeof(line),
+			",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"%s\":%d,\"%s\":%d,\"%s\":%d,\"%s\":%d,\"%s\":%d}}",
+			counters.timeMicroseconds,
+			g_CounterNames[COUNTER_DRAWS], counters.values[COUNTER_DRAWS],
+			g_CounterNames[COUNTER_UNIFORM_UPLOADS], counters.values[COUNTER_UNIFORM_UPLOADS],
+			g_CounterNames[COUNTER_TEXTURE_BINDS], counters.values[COUNTER_TEXTURE_BINDS],
+			g_CounterNames[COUNTER_RENDER_SCALE_PERCENT], counters.values[COUNTER_RENDER_SCALE_PERCENT],
+			g_CounterNames[COUNTER_ALLOCATIONS], counters.values[COUNTER_ALLOCATIONS]);
+		file << line;
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	std::cout << "INFO: Wrote frame trace: " << filename << std::endl;
+	return(file.good());
+}
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// time the frame sections on the CPU and the GPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class contains the timings of the main loop sections
+ *  for a window of recent frames.  Each section is timed on
+ *  the CPU and with a GL_TIME_ELAPSED query on the GPU.  The
+ *  queries are double buffered and only read back once their
+ *  results are available, so the profiler never stalls the
+ *  frame.  The timings are summarized as percentiles, drawn
+ *  in an overlay graph and exported as a Chrome trace.  The
+ *  heap allocations of each frame are counted as well, and
+ *  the profiler itself never allocates once it is created.
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// constructor
+	FrameProfiler();
+	// destructor
+	~FrameProfiler();
+
+	// identifiers for the timed sections of a frame
+	enum SECTION_ID
+	{
+		SECTION_UPDATE = 0,
+		SECTION_PREPARE_VIEW,
+		SECTION_RENDER_SCENE,
+		SECTION_SWAP_BUFFERS,
+		SECTION_COUNT
+	};
+
+	// identifiers for the counted work of a frame
+	enum COUNTER_ID
+	{
+		COUNTER_DRAWS = 0,
+		COUNTER_UNIFORM_UPLOADS,
+		COUNTER_TEXTURE_BINDS,
+		COUNTER_RENDER_SCALE_PERCENT,
+		// heap allocations between BeginFrame() and EndFrame(),
+		// counted by the profiler itself
+		COUNTER_ALLOCATIONS,
+		COUNTER_COUNT
+	};
+
+	// create the timer queries and the overlay shader
+	void Initialize();
+	// free the timer queries and the overlay objects
+	void Destroy();
+
+	// mark the start and end of a frame
+	void BeginFrame();
+	void EndFrame();
+	// start and stop the timers of a section
+	void BeginSection(int sectionID);
+	void EndSection(int sectionID);
+	// set the count of a counter for the current frame
+	void SetCounter(int counterID, int value);
+
+	// get a percentile of the recent frame or section times in
+	// milliseconds, a section ID of -1 selects the whole frame
+	float GetPercentile(int sectionID, bool bGPU, float percentile) const;
+	// get the count of a counter in the last finished frame
+	int GetCounter(int counterID) const { return(m_lastCounters[counterID]); }
+	// get the CPU time of the last finished frame in milliseconds
+	float GetLastFrameTime() const;
+	// get the number of GPU times read back for a section so far
+	// and the most recent of them in milliseconds
+	int GetGPUSampleTotal(int sectionID) const { return(m_gpuSampleTotal[sectionID]); }
+	float GetLastGPUTime(int sectionID) const;
+	// get a one line summary of the recent frame timings
+	std::string GetSummary() const;
+	// write the summary into a buffer without allocating
+	void FormatSummary(char* summary, size_t summarySize) const;
+
+	// draw the recent frame times and allocation counts as a
+	// graph over the scene
+	void DrawOverlay();
+	// write the recorded events to a Chrome trace JSON file
+	bool ExportChromeTrace(const std::string& filename) const;
+
+	/***********************************************************
+	 *  ScopedSection
+	 *
+	 *  This class times a profiler section for as long as it
+	 *  stays in scope.
+	 ***********************************************************/
+	class ScopedSection
+	{
+	public:
+		ScopedSection(FrameProfiler* pProfiler, int sectionID)
+		{
+			m_pProfiler = pProfiler;
+			m_sectionID = sectionID;
+			m_pProfiler->BeginSection(m_sectionID);
+		}
+		~ScopedSection()
+		{
+			m_pProfiler->EndSection(m_sectionID);
+		}
+
+	private:
+		FrameProfiler* m_pProfiler;
+		int m_sectionID;
+	};
+
+private:
+	enum
+	{
+		// frames the percentiles and the overlay cover
+		HISTORY_FRAME_COUNT = 240,
+		// sets of queries in flight at the same time
+		QUERY_SET_COUNT = 2
+	};
+
+	// one timed span of the Chrome trace
+	struct TRACE_EVENT
+	{
+		int sectionID;
+		bool bGPU;
+		double startMicroseconds;
+		double durationMicroseconds;
+	};
+
+	// counts of one frame in the Chrome trace
+	struct TRACE_COUNTERS
+	{
+		double timeMicroseconds;
+		int values[COUNTER_COUNT];
+	};
+
+	// queries of one frame waiting for their results
+	struct QUERY_SET
+	{
+		GLuint queries[SECTION_COUNT];
+		bool bIssued[SECTION_COUNT];
+		double startMicroseconds[SECTION_COUNT];
+	};
+
+	std::chrono::steady_clock::time_point m_startTime;
+	unsigned int m_frameIndex;
+	double m_frameStartMicroseconds;
+	double m_sectionStartMicroseconds[SECTION_COUNT];
+	QUERY_SET m_querySets[QUERY_SET_COUNT];
+	bool m_bInitialized;
+
+	// recent times in milliseconds, filled as ring buffers
+	float m_frameTimes[HISTORY_FRAME_COUNT];
+	float m_cpuSectionTimes[SECTION_COUNT][HISTORY_FRAME_COUNT];
+	float m_gpuSectionTimes[SECTION_COUNT][HISTORY_FRAME_COUNT];
+	int m_frameCount;
+	int m_gpuSampleCount[SECTION_COUNT];
+	int m_gpuSampleNext[SECTION_COUNT];
+	int m_gpuSampleTotal[SECTION_COUNT];
+
+	int m_counters[COUNTER_COUNT];
+	int m_lastCounters[COUNTER_COUNT];
+	// heap allocations counted when the frame began, and the
+	// recent frame allocation counts filled as a ring buffer
+	uint64_t m_frameStartAllocations;
+	float m_frameAllocations[HISTORY_FRAME_COUNT];
+
+	// most recent events and counts for the Chrome trace, kept
+	// in ring buffers that are allocated once
+	std::vector<TRACE_EVENT> m_traceEvents;
+	size_t m_traceEventFirst;
+	size_t m_traceEventCount;
+	std::vector<TRACE_COUNTERS> m_traceCounters;
+	size_t m_traceCounterFirst;
+	size_t m_traceCounterCount;
+
+	// shader program and empty vertex array of the overlay
+	GLuint m_overlayProgramID;
+	GLuint m_overlayVAO;
+
+	// get the time since the profiler was created
+	double GetMicroseconds() const;
+	// read back the finished queries of a query set
+	void CollectQueryResults(QUERY_SET& querySet);
+	// add an event to the Chrome trace
+	void AddTraceEvent(int sectionID, bool bGPU, double startMicroseconds, double durationMicroseconds);
+};
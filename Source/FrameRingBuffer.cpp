@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameringbuffer.cpp
+// ============
+// stream the dynamic data of each frame through persistently mapped memory
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameRingBuffer.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// access the buffer is created and mapped with, the writes
+	// of the CPU are seen by the GPU without any flushing
+	const GLbitfield RING_BUFFER_FLAGS =
+		GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	// nanoseconds to wait on a fence before checking it again
+	const GLuint64 FENCE_WAIT_TIMEOUT = 1000000000;
+}
+
+/***********************************************************
+ *  FrameRingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameRingBuffer::FrameRingBuffer()
+{
+	m_bufferID = 0;
+	m_pMappedData = NULL;
+	m_regionBytes = 0;
+	m_region = 0;
+	m_regionUsed = 0;
+	m_waitCount = 0;
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		m_fences[i] = NULL;
+	}
+}
+
+/***********************************************************
+ *  ~FrameRingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameRingBuffer::~FrameRingBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the mapped buffer with
+ *  room for the passed in bytes in each of the regions.
+ ***********************************************************/
+bool FrameRingBuffer::Create(size_t regionBytes)
+{
+	Destroy();
+
+	if (false == CreateStorage(regionBytes))
+	{
+		return(false);
+	}
+
+	// the first frame moves on to region 0
+	m_region = REGION_COUNT - 1;
+	m_regionUsed = 0;
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for waiting until the GPU is done
+ *  with every region and freeing the buffer and fences.
+ ***********************************************************/
+void FrameRingBuffer::Destroy()
+{
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		WaitForRegion(i);
+	}
+
+	if (0 != m_bufferID)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+	}
+	m_pMappedData = NULL;
+	m_regionBytes = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving on to the next region and
+ *  waiting until the GPU has finished the frame that last
+ *  used it.  When the passed in bytes do not fit in a region
+ *  the buffer is replaced by a larger one.
+ ***********************************************************/
+bool FrameRingBuffer::BeginFrame(size_t frameBytes)
+{
+	if (NULL == m_pMappedData)
+	{
+		return(false);
+	}
+
+	m_region = (m_region + 1) % REGION_COUNT;
+	WaitForRegion(m_region);
+	m_regionUsed = 0;
+
+	if (frameBytes <= m_regionBytes)
+	{
+		return(true);
+	}
+
+	size_t regionBytes = m_regionBytes;
+	while (regionBytes < frameBytes)
+	{
+		regionBytes *= 2;
+	}
+
+	// the old buffer is only deleted once the new one exists, so
+	// the new buffer never reuses the name of the old one
+	for (int i = 0; i < REGION_COUNT; i++)
+	{
+		WaitForRegion(i);
+	}
+	GLuint oldBufferID = m_bufferID;
+	unsigned char* pOldMappedData = m_pMappedData;
+	if (false == CreateStorage(regionBytes))
+	{
+		m_bufferID = oldBufferID;
+		m_pMappedData = pOldMappedData;
+		return(false);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, oldBufferID);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glDeleteBuffers(1, &oldBufferID);
+
+	m_region = 0;
+	return(true);
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for reserving bytes in the region of
+ *  the current frame.  The offset of the allocation from the
+ *  start of the buffer is a multiple of the passed in
+ *  alignment, which need not be a power of two, so arrays of
+ *  any struct can be addressed by element.  NULL is returned
+ *  when the region is full.
+ ***********************************************************/
+void* FrameRingBuffer::Allocate(size_t bytes, size_t alignment, size_t& bufferOffset)
+{
+	if (NULL == m_pMappedData)
+	{
+		return(NULL);
+	}
+	if (alignment < 1)
+	{
+		alignment = 1;
+	}
+
+	size_t regionStart = m_region * m_regionBytes;
+	size_t offset = regionStart + m_regionUsed;
+	offset = ((offset + alignment - 1) / alignment) * alignment;
+
+	if (offset + bytes > regionStart + m_regionBytes)
+	{
+		return(NULL);
+	}
+
+	m_regionUsed = offset + bytes - regionStart;
+	bufferOffset = offset;
+	return(m_pMappedData + offset);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for fencing the region of the
+ *  current frame after all of the draws that read it.
+ ***********************************************************/
+void FrameRingBuffer::EndFrame()
+{
+	if (NULL == m_pMappedData)
+	{
+		return;
+	}
+
+	if (NULL != m_fences[m_region])
+	{
+		glDeleteSync(m_fences[m_region]);
+	}
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  WaitForRegion()
+ *
+ *  This method is used for blocking until the fence of the
+ *  frame that last used a region has passed.  The fence is
+ *  first checked without waiting, so the frames that had to
+ *  wait for the GPU can be counted.
+ ***********************************************************/
+void FrameRingBuffer::WaitForRegion(int region)
+{
+	if (NULL == m_fences[region])
+	{
+		return;
+	}
+
+	GLenum result = glClientWaitSync(m_fences[region], 0, 0);
+	if (GL_TIMEOUT_EXPIRED == result)
+	{
+		m_waitCount++;
+		do
+		{
+			result = glClientWaitSync(m_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIMEOUT);
+		} while (GL_TIMEOUT_EXPIRED == result);
+	}
+	if (GL_WAIT_FAILED == result)
+	{
+		std::cout << "Failed waiting on the frame data fence" << std::endl;
+	}
+
+	glDeleteSync(m_fences[region]);
+	m_fences[region] = NULL;
+}
+
+/***********************************************************
+ *  CreateStorage()
+ *
+ *  This method is used for creating a buffer with immutable
+ *  storage for every region and mapping all of it for
+ *  writing for as long as the buffer lives.
+ ***********************************************************/
+bool FrameRingBuffer::CreateStorage(size_t regionBytes)
+{
+	GLsizeiptr totalBytes = (GLsizeiptr)(regionBytes * REGION_COUNT);
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, m_bufferID);
+	glBufferStorage(GL_ARRAY_BUFFER, totalBytes, NULL, RING_BUFFER_FLAGS);
+	m_pMappedData = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, totalBytes, RING_BUFFER_FLAGS);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (NULL == m_pMappedData)
+	{
+		std::cout << "Could not map the frame data buffer" << std::endl;
+		glDeleteBuffers(1, &m_bufferID);
+		m_bufferID = 0;
+		return(false);
+	}
+
+	m_regionBytes = regionBytes;
+	return(true);
+}
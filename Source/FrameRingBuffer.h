@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameringbuffer.h
+// ============
+// stream the dynamic data of each frame through persistently mapped memory
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  FrameRingBuffer
+ *
+ *  This class contains one buffer that stays mapped for its
+ *  whole life and is split into a region for each frame in
+ *  flight.  A frame writes its data straight into its region
+ *  and is fenced after its draws, and a region is only
+ *  written again once the fence of the frame that last used
+ *  it has passed, so the driver never has to synchronize.
+ ***********************************************************/
+class FrameRingBuffer
+{
+public:
+	// constructor
+	FrameRingBuffer();
+	// destructor
+	~FrameRingBuffer();
+
+	// number of frames whose data can be in flight at once
+	static const int REGION_COUNT = 3;
+
+	// create the mapped buffer with the bytes of one region
+	bool Create(size_t regionBytes);
+	// free the mapped buffer and its fences
+	void Destroy();
+	// move to the next region, growing it to hold the frame's bytes
+	bool BeginFrame(size_t frameBytes);
+	// reserve bytes in the current region, returning where to write
+	void* Allocate(size_t bytes, size_t alignment, size_t& bufferOffset);
+	// fence the current region after the draws reading it
+	void EndFrame();
+
+	// get the buffer the offsets of the allocations refer to
+	GLuint GetBufferID() const { return(m_bufferID); }
+	// get the bytes each frame is able to write
+	size_t GetRegionBytes() const { return(m_regionBytes); }
+	// get the number of frames that waited on the GPU for a region
+	int GetWaitCount() const { return(m_waitCount); }
+
+private:
+	// buffer object and the address it is mapped to
+	GLuint m_bufferID;
+	unsigned char* m_pMappedData;
+	// bytes of one region
+	size_t m_regionBytes;
+	// region the current frame writes and the bytes it has used
+	int m_region;
+	size_t m_regionUsed;
+	// fence placed after the last frame that used each region
+	GLsync m_fences[REGION_COUNT];
+	// frames that found their region still in use by the GPU
+	int m_waitCount;
+
+	// block until the GPU is done with a region
+	void WaitForRegion(int region);
+	// create and map a new buffer with the bytes of one region
+	bool CreateStorage(size_t regionBytes);
+};
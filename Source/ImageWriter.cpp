@@ -0,0 +1,684 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagewriter.cpp
+// ============
+// encode rendered images and write them to disk on worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ImageWriter.h"
+#include "FileUtilities.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// the deflate window and the longest and shortest matches
+	const int DEFLATE_WINDOW_SIZE = 32768;
+	const int MIN_MATCH_LENGTH = 3;
+	const int MAX_MATCH_LENGTH = 258;
+	// hash table of three byte sequences and the most earlier
+	// positions of a sequence tried for the longest match
+	const int MATCH_HASH_BITS = 15;
+	const int MAX_MATCH_CHAIN = 32;
+
+	// base values and extra bit counts of the deflate length
+	// and distance codes
+	const int LENGTH_BASES[29] =
+	{
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+	const int LENGTH_EXTRA_BITS[29] =
+	{
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+	const int DISTANCE_BASES[30] =
+	{
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+		8193, 12289, 16385, 24577
+	};
+	const int DISTANCE_EXTRA_BITS[30] =
+	{
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	// bytes of a deflate stream, filled least significant bit first
+	struct BIT_WRITER
+	{
+		std::vector<unsigned char>* pBytes;
+		uint32_t bitBuffer;
+		int bitCount;
+	};
+
+	// append the low bits of a value to a deflate stream
+	void WriteBits(BIT_WRITER& writer, uint32_t bits, int count)
+	{
+		writer.bitBuffer |= bits << writer.bitCount;
+		writer.bitCount += count;
+		while (writer.bitCount >= 8)
+		{
+			writer.pBytes->push_back((unsigned char)(writer.bitBuffer & 0xFF));
+			writer.bitBuffer >>= 8;
+			writer.bitCount -= 8;
+		}
+	}
+
+	// append a Huffman code, which is stored most significant bit first
+	void WriteCode(BIT_WRITER& writer, uint32_t code, int length)
+	{
+		uint32_t reversed = 0;
+		for (int i = 0; i < length; i++)
+		{
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		WriteBits(writer, reversed, length);
+	}
+
+	// append a literal or length symbol with the fixed Huffman codes
+	void WriteLiteralLength(BIT_WRITER& writer, int symbol)
+	{
+		if (symbol < 144)
+		{
+			WriteCode(writer, 0x30 + symbol, 8);
+		}
+		else if (symbol < 256)
+		{
+			WriteCode(writer, 0x190 + symbol - 144, 9);
+		}
+		else if (symbol < 280)
+		{
+			WriteCode(writer, symbol - 256, 7);
+		}
+		else
+		{
+			WriteCode(writer, 0xC0 + symbol - 280, 8);
+		}
+	}
+
+	// append a match of the passed in length and distance
+	void WriteMatch(BIT_WRITER& writer, int length, int distance)
+	{
+		int lengthCode = 28;
+		while (LENGTH_BASES[lengthCode] > length)
+		{
+			lengthCode--;
+		}
+		WriteLiteralLength(writer, 257 + lengthCode);
+		WriteBits(writer, length - LENGTH_BASES[lengthCode], LENGTH_EXTRA_BITS[lengthCode]);
+
+		int distanceCode = 29;
+		while (DISTANCE_BASES[distanceCode] > distance)
+		{
+			distanceCode--;
+		}
+		WriteCode(writer, distanceCode, 5);
+		WriteBits(writer, distance - DISTANCE_BASES[distanceCode], DISTANCE_EXTRA_BITS[distanceCode]);
+	}
+
+	// hash the three bytes starting at a position
+	int HashSequence(const unsigned char* pData)
+	{
+		uint32_t value = ((uint32_t)pData[0] << 16) | ((uint32_t)pData[1] << 8) | pData[2];
+		return((int)((value * 2654435761u) >> (32 - MATCH_HASH_BITS)));
+	}
+
+	// compress bytes into a zlib stream of one fixed Huffman
+	// deflate block, matching repeated sequences within the window
+	void DeflateBytes(const std::vector<unsigned char>& data, std::vector<unsigned char>& compressed)
+	{
+		// zlib header of a 32K window with the fastest level
+		compressed.push_back(0x78);
+		compressed.push_back(0x01);
+
+		BIT_WRITER writer;
+		writer.pBytes = &compressed;
+		writer.bitBuffer = 0;
+		writer.bitCount = 0;
+		// final block with the fixed Huffman codes
+		WriteBits(writer, 1, 1);
+		WriteBits(writer, 1, 2);
+
+		std::vector<int> hashHeads((size_t)1 << MATCH_HASH_BITS, -1);
+		std::vector<int> previous(DEFLATE_WINDOW_SIZE, -1);
+		const int size = (int)data.size();
+		const unsigned char* pData = data.empty() ? NULL : &data[0];
+
+		int position = 0;
+		while (position < size)
+		{
+			int bestLength = 0;
+			int bestDistance = 0;
+			if (position + MIN_MATCH_LENGTH <= size)
+			{
+				int maxLength = size - position;
+				if (maxLength > MAX_MATCH_LENGTH)
+				{
+					maxLength = MAX_MATCH_LENGTH;
+				}
+
+				int candidate = hashHeads[HashSequence(pData + position)];
+				for (int chain = 0; (chain < MAX_MATCH_CHAIN) && (candidate >= 0); chain++)
+				{
+					if (position - candidate > DEFLATE_WINDOW_SIZE)
+					{
+						break;
+					}
+
+					int length = 0;
+					while ((length < maxLength) && (pData[candidate + length] == pData[position + length]))
+					{
+						length++;
+					}
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = position - candidate;
+						if (length == maxLength)
+						{
+							break;
+						}
+					}
+
+					int next = previous[candidate & (DEFLATE_WINDOW_SIZE - 1)];
+					if (next >= candidate)
+					{
+						break;
+					}
+					candidate = next;
+				}
+			}
+
+			int advance = 1;
+			if (bestLength >= MIN_MATCH_LENGTH)
+			{
+				WriteMatch(writer, bestLength, bestDistance);
+				advance = bestLength;
+			}
+			else
+			{
+				WriteLiteralLength(writer, pData[position]);
+			}
+
+			// every covered position can start a later match
+			for (int i = 0; i < advance; i++)
+			{
+				int inserted = position + i;
+				if (inserted + MIN_MATCH_LENGTH <= size)
+				{
+					int hash = HashSequence(pData + inserted);
+					previous[inserted & (DEFLATE_WINDOW_SIZE - 1)] = hashHeads[hash];
+					hashHeads[hash] = inserted;
+				}
+			}
+			position += advance;
+		}
+
+		// end of block, padded out to a whole byte
+		WriteLiteralLength(writer, 256);
+		if (writer.bitCount > 0)
+		{
+			compressed.push_back((unsigned char)(writer.bitBuffer & 0xFF));
+		}
+
+		// Adler-32 checksum of the uncompressed bytes
+		uint32_t sumA = 1;
+		uint32_t sumB = 0;
+		for (int i = 0; i < size; i++)
+		{
+			sumA = (sumA + pData[i]) % 65521;
+			sumB = (sumB + sumA) % 65521;
+		}
+		uint32_t adler = (sumB << 16) | sumA;
+		compressed.push_back((unsigned char)(adler >> 24));
+		compressed.push_back((unsigned char)(adler >> 16));
+		compressed.push_back((unsigned char)(adler >> 8));
+		compressed.push_back((unsigned char)adler);
+	}
+
+	// CRC-32 of every byte value, built once for all the workers
+	struct CRC_TABLE
+	{
+		uint32_t values[256];
+
+		CRC_TABLE()
+		{
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t value = n;
+				for (int k = 0; k < 8; k++)
+				{
+					value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+				}
+				values[n] = value;
+			}
+		}
+	};
+
+	// get the CRC-32 of the bytes of a PNG chunk
+	uint32_t Crc32(const unsigned char* pData, size_t size)
+	{
+		static const CRC_TABLE table;
+
+		uint32_t crc = 0xFFFFFFFFu;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = table.values[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return(crc ^ 0xFFFFFFFFu);
+	}
+
+	// append a value in the big endian order of PNG files
+	void WriteUint32BigEndian(std::vector<unsigned char>& bytes, uint32_t value)
+	{
+		bytes.push_back((unsigned char)(value >> 24));
+		bytes.push_back((unsigned char)(value >> 16));
+		bytes.push_back((unsigned char)(value >> 8));
+		bytes.push_back((unsigned char)value);
+	}
+
+	// append a PNG chunk with its length and checksum
+	void WritePNGChunk(std::vector<unsigned char>& bytes, const char* type, const std::vector<unsigned char>& data)
+	{
+		WriteUint32BigEndian(bytes, (uint32_t)data.size());
+		size_t typeOffset = bytes.size();
+		bytes.insert(bytes.end(), type, type + 4);
+		bytes.insert(bytes.end(), data.begin(), data.end());
+		WriteUint32BigEndian(bytes, Crc32(&bytes[typeOffset], bytes.size() - typeOffset));
+	}
+
+	// predict a byte from its left, upper and upper left neighbors
+	int PaethPredictor(int left, int up, int upLeft)
+	{
+		int estimate = left + up - upLeft;
+		int distanceLeft = abs(estimate - left);
+		int distanceUp = abs(estimate - up);
+		int distanceUpLeft = abs(estimate - upLeft);
+		if ((distanceLeft <= distanceUp) && (distanceLeft <= distanceUpLeft))
+		{
+			return(left);
+		}
+		return((distanceUp <= distanceUpLeft) ? up : upLeft);
+	}
+
+	// append a value in the little endian order of OpenEXR files
+	template <typename VALUE>
+	void WriteLittleEndian(std::vector<unsigned char>& bytes, VALUE value)
+	{
+		const unsigned char* pBytes = (const unsigned char*)&value;
+		bytes.insert(bytes.end(), pBytes, pBytes + sizeof(VALUE));
+	}
+
+	// append an OpenEXR header attribute
+	void WriteEXRAttribute(std::vector<unsigned char>& bytes, const char* name, const char* type, const std::vector<unsigned char>& value)
+	{
+		bytes.insert(bytes.end(), name, name + strlen(name) + 1);
+		bytes.insert(bytes.end(), type, type + strlen(type) + 1);
+		WriteLittleEndian(bytes, (int32_t)value.size());
+		bytes.insert(bytes.end(), value.begin(), value.end());
+	}
+}
+
+/***********************************************************
+ *  ImageWriter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ImageWriter::ImageWriter()
+{
+	m_activeJobs = 0;
+	m_maxQueuedImages = 0;
+	m_bStopWorkers = false;
+	m_writtenCount = 0;
+	m_failedCount = 0;
+}
+
+/***********************************************************
+ *  ~ImageWriter()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ImageWriter::~ImageWriter()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for starting the worker threads.  One
+ *  core is left for the rendering thread when the thread
+ *  count is not passed in.
+ ***********************************************************/
+void ImageWriter::Initialize(int workerCount, int maxQueuedImages)
+{
+	if (!m_workers.empty())
+	{
+		return;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+		if (workerCount < 1)
+		{
+			workerCount = 1;
+		}
+	}
+	m_maxQueuedImages = (maxQueuedImages > 0) ? maxQueuedImages : workerCount * 2;
+
+	m_bStopWorkers = false;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&ImageWriter::WorkerMain, this));
+	}
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for writing the images still queued
+ *  and then stopping the worker threads.
+ ***********************************************************/
+void ImageWriter::Shutdown()
+{
+	if (m_workers.empty())
+	{
+		return;
+	}
+
+	WaitForAll();
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_bStopWorkers = true;
+	}
+	m_queueCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+}
+
+/***********************************************************
+ *  QueueImage()
+ *
+ *  This method is used for queueing an image to be encoded
+ *  and written by a worker thread.  The pixels are swapped
+ *  out of the passed in vector, so no copy is made.  It waits
+ *  while the queue is full.  Without worker threads the image
+ *  is written before returning.
+ ***********************************************************/
+void ImageWriter::QueueImage(const std::string& filename, int format, int width, int height, std::vector<unsigned char>& pixels)
+{
+	IMAGE_JOB job;
+	job.filename = filename;
+	job.format = format;
+	job.width = width;
+	job.height = height;
+	job.pixels.swap(pixels);
+
+	if (m_workers.empty())
+	{
+		bool bWritten = (format == IMAGE_FORMAT_EXR) ?
+			WriteEXR(job.filename, width, height, (const uint16_t*)&job.pixels[0]) :
+			WritePNG(job.filename, width, height, &job.pixels[0]);
+		if (bWritten)
+		{
+			m_writtenCount++;
+		}
+		else
+		{
+			m_failedCount++;
+		}
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(m_queueMutex);
+		m_doneCondition.wait(lock, [this]() { return((int)m_jobs.size() < m_maxQueuedImages); });
+		m_jobs.push_back(std::move(job));
+	}
+	m_queueCondition.notify_one();
+}
+
+/***********************************************************
+ *  WaitForAll()
+ *
+ *  This method is used for blocking until every queued image
+ *  has been written.
+ ***********************************************************/
+void ImageWriter::WaitForAll()
+{
+	std::unique_lock<std::mutex> lock(m_queueMutex);
+	m_doneCondition.wait(lock, [this]() { return(m_jobs.empty() && (m_activeJobs == 0)); });
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is used for encoding and writing the queued
+ *  images until the worker threads are stopped.
+ ***********************************************************/
+void ImageWriter::WorkerMain()
+{
+	while (true)
+	{
+		IMAGE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueCondition.wait(lock, [this]() { return(m_bStopWorkers || !m_jobs.empty()); });
+			if (m_jobs.empty())
+			{
+				return;
+			}
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			m_activeJobs++;
+		}
+		// a queue slot was freed for the rendering thread
+		m_doneCondition.notify_all();
+
+		bool bWritten = (job.format == IMAGE_FORMAT_EXR) ?
+			WriteEXR(job.filename, job.width, job.height, (const uint16_t*)&job.pixels[0]) :
+			WritePNG(job.filename, job.width, job.height, &job.pixels[0]);
+		if (bWritten)
+		{
+			m_writtenCount++;
+		}
+		else
+		{
+			m_failedCount++;
+			std::cout << "Could not write image:" << job.filename << std::endl;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_activeJobs--;
+		}
+		m_doneCondition.notify_all();
+	}
+}
+
+/***********************************************************
+ *  WritePNG()
+ *
+ *  This method is used for encoding 8-bit RGBA pixels, with
+ *  their rows from the bottom up, as an RGB PNG file.  Every
+ *  row is filtered with the predictor that leaves the
+ *  smallest differences, which is what keeps the flat
+ *  backgrounds of rendered images small once deflated.
+ ***********************************************************/
+bool ImageWriter::WritePNG(const std::string& filename, int width, int height, const unsigned char* pPixels)
+{
+	const int BYTES_PER_PIXEL = 3;
+	const size_t rowBytes = (size_t)width * BYTES_PER_PIXEL;
+
+	std::vector<unsigned char> filtered;
+	filtered.reserve((rowBytes + 1) * height);
+	std::vector<unsigned char> row(rowBytes);
+	std::vector<unsigned char> previousRow(rowBytes, 0);
+	std::vector<unsigned char> candidate(rowBytes);
+	std::vector<unsigned char> bestRow(rowBytes);
+
+	for (int y = 0; y < height; y++)
+	{
+		// PNG rows run from the top down and drop the alpha
+		const unsigned char* pSource = pPixels + (size_t)(height - 1 - y) * width * 4;
+		for (int x = 0; x < width; x++)
+		{
+			row[x * 3 + 0] = pSource[x * 4 + 0];
+			row[x * 3 + 1] = pSource[x * 4 + 1];
+			row[x * 3 + 2] = pSource[x * 4 + 2];
+		}
+
+		int bestFilter = 0;
+		long bestCost = -1;
+		for (int filter = 0; filter < 5; filter++)
+		{
+			long cost = 0;
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				int left = (i >= BYTES_PER_PIXEL) ? row[i - BYTES_PER_PIXEL] : 0;
+				int up = previousRow[i];
+				int upLeft = (i >= BYTES_PER_PIXEL) ? previousRow[i - BYTES_PER_PIXEL] : 0;
+				int prediction = 0;
+				switch (filter)
+				{
+				case 1: prediction = left; break;
+				case 2: prediction = up; break;
+				case 3: prediction = (left + up) / 2; break;
+				case 4: prediction = PaethPredictor(left, up, upLeft); break;
+				default: break;
+				}
+				candidate[i] = (unsigned char)(row[i] - prediction);
+				cost += abs((int)(signed char)candidate[i]);
+			}
+			if ((bestCost < 0) || (cost < bestCost))
+			{
+				bestCost = cost;
+				bestFilter = filter;
+				bestRow.swap(candidate);
+			}
+		}
+
+		filtered.push_back((unsigned char)bestFilter);
+		filtered.insert(filtered.end(), bestRow.begin(), bestRow.end());
+		previousRow.swap(row);
+	}
+
+	std::vector<unsigned char> header;
+	WriteUint32BigEndian(header, (uint32_t)width);
+	WriteUint32BigEndian(header, (uint32_t)height);
+	// 8 bits per channel RGB, deflate, adaptive filtering, not interlaced
+	header.push_back(8);
+	header.push_back(2);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	std::vector<unsigned char> compressed;
+	DeflateBytes(filtered, compressed);
+
+	static const unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> bytes(PNG_SIGNATURE, PNG_SIGNATURE + 8);
+	WritePNGChunk(bytes, "IHDR", header);
+	WritePNGChunk(bytes, "IDAT", compressed);
+	WritePNGChunk(bytes, "IEND", std::vector<unsigned char>());
+
+	return(FileUtilities::WriteFileAtomic(filename, &bytes[0], bytes.size()));
+}
+
+/***********************************************************
+ *  WriteEXR()
+ *
+ *  This method is used for writing half float RGBA pixels,
+ *  with their rows from the bottom up, as an uncompressed
+ *  scanline OpenEXR file with half float R, G and B channels.
+ *  The values are written as they were rendered, so colors
+ *  brighter than one are kept.
+ ***********************************************************/
+bool ImageWriter::WriteEXR(const std::string& filename, int width, int height, const uint16_t* pPixels)
+{
+	// the channel list is sorted by name, each channel is half
+	// float and sampled at every pixel
+	static const char* const CHANNEL_NAMES[3] = { "B", "G", "R" };
+	static const int CHANNEL_OFFSETS[3] = { 2, 1, 0 };
+	std::vector<unsigned char> channels;
+	for (int c = 0; c < 3; c++)
+	{
+		channels.push_back((unsigned char)CHANNEL_NAMES[c][0]);
+		channels.push_back(0);
+		WriteLittleEndian(channels, (int32_t)1);
+		WriteLittleEndian(channels, (int32_t)0);
+		WriteLittleEndian(channels, (int32_t)1);
+		WriteLittleEndian(channels, (int32_t)1);
+	}
+	channels.push_back(0);
+
+	std::vector<unsigned char> window;
+	WriteLittleEndian(window, (int32_t)0);
+	WriteLittleEndian(window, (int32_t)0);
+	WriteLittleEndian(window, (int32_t)(width - 1));
+	WriteLittleEndian(window, (int32_t)(height - 1));
+
+	std::vector<unsigned char> noCompression(1, 0);
+	std::vector<unsigned char> increasingY(1, 0);
+	std::vector<unsigned char> aspectRatio;
+	WriteLittleEndian(aspectRatio, 1.0f);
+	std::vector<unsigned char> windowCenter;
+	WriteLittleEndian(windowCenter, 0.0f);
+	WriteLittleEndian(windowCenter, 0.0f);
+	std::vector<unsigned char> windowWidth;
+	WriteLittleEndian(windowWidth, 1.0f);
+
+	std::vector<unsigned char> bytes;
+	// magic number and version 2 of single part scanline files
+	WriteLittleEndian(bytes, (int32_t)20000630);
+	WriteLittleEndian(bytes, (int32_t)2);
+	WriteEXRAttribute(bytes, "channels", "chlist", channels);
+	WriteEXRAttribute(bytes, "compression", "compression", noCompression);
+	WriteEXRAttribute(bytes, "dataWindow", "box2i", window);
+	WriteEXRAttribute(bytes, "displayWindow", "box2i", window);
+	WriteEXRAttribute(bytes, "lineOrder", "lineOrder", increasingY);
+	WriteEXRAttribute(bytes, "pixelAspectRatio", "float", aspectRatio);
+	WriteEXRAttribute(bytes, "screenWindowCenter", "v2f", windowCenter);
+	WriteEXRAttribute(bytes, "screenWindowWidth", "float", windowWidth);
+	bytes.push_back(0);
+
+	// each scanline is a block of its y, its size and the
+	// pixels of each channel in turn
+	const int32_t lineBytes = width * 3 * (int32_t)sizeof(uint16_t);
+	uint64_t lineOffset = bytes.size() + (uint64_t)height * sizeof(uint64_t);
+	for (int y = 0; y < height; y++)
+	{
+		WriteLittleEndian(bytes, lineOffset);
+		lineOffset += 2 * sizeof(int32_t) + lineBytes;
+	}
+
+	bytes.reserve(bytes.size() + (size_t)height * (2 * sizeof(int32_t) + lineBytes));
+	for (int y = 0; y < height; y++)
+	{
+		WriteLittleEndian(bytes, (int32_t)y);
+		WriteLittleEndian(bytes, lineBytes);
+		// OpenEXR rows run from the top down
+		const uint16_t* pSource = pPixels + (size_t)(height - 1 - y) * width * 4;
+		for (int c = 0; c < 3; c++)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				WriteLittleEndian(bytes, pSource[x * 4 + CHANNEL_OFFSETS[c]]);
+			}
+		}
+	}
+
+	return(FileUtilities::WriteFileAtomic(filename, &bytes[0], bytes.size()));
+}
@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// imagewriter.h
+// ============
+// encode rendered images and write them to disk on worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  ImageWriter
+ *
+ *  This class contains a pool of worker threads that encode
+ *  rendered images as PNG or OpenEXR files and write them to
+ *  disk, so the rendering thread only hands the read back
+ *  pixels over.  The number of queued images is limited, and
+ *  queueing waits while the queue is full, so the memory of
+ *  a long batch stays bounded when the disk is slower than
+ *  the GPU.  Both encoders are written out here, PNG with a
+ *  fixed Huffman deflate and OpenEXR as uncompressed half
+ *  float scanlines, since the project has no image writing
+ *  library.
+ ***********************************************************/
+class ImageWriter
+{
+public:
+	// constructor
+	ImageWriter();
+	// destructor
+	~ImageWriter();
+
+	// identifiers for the file formats images are written as
+	enum IMAGE_FORMAT
+	{
+		IMAGE_FORMAT_PNG = 0,
+		IMAGE_FORMAT_EXR
+	};
+
+	// start the worker threads, 0 picks the thread count and
+	// queues up to twice as many images as there are threads
+	void Initialize(int workerCount = 0, int maxQueuedImages = 0);
+	// write the queued images and stop the worker threads
+	void Shutdown();
+
+	// queue an image read back from OpenGL, with its rows from
+	// the bottom up, taking over the passed in pixels - PNG
+	// images are 8-bit RGBA and EXR images half float RGBA
+	void QueueImage(const std::string& filename, int format, int width, int height, std::vector<unsigned char>& pixels);
+	// block until every queued image is written
+	void WaitForAll();
+
+	// get the number of images written and failed so far
+	int GetWrittenCount() const { return(m_writtenCount); }
+	int GetFailedCount() const { return(m_failedCount); }
+
+	// encode one image and write it to a file
+	static bool WritePNG(const std::string& filename, int width, int height, const unsigned char* pPixels);
+	static bool WriteEXR(const std::string& filename, int width, int height, const uint16_t* pPixels);
+
+private:
+	// an image waiting to be encoded
+	struct IMAGE_JOB
+	{
+		std::string filename;
+		int format;
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+	};
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_queueMutex;
+	// the workers wait for images, the rendering thread for room
+	// in the queue or for the last image to be written
+	std::condition_variable m_queueCondition;
+	std::condition_variable m_doneCondition;
+	std::deque<IMAGE_JOB> m_jobs;
+	int m_activeJobs;
+	int m_maxQueuedImages;
+	bool m_bStopWorkers;
+	std::atomic<int> m_writtenCount;
+	std::atomic<int> m_failedCount;
+
+	// encode the queued images until stopped
+	void WorkerMain();
+};
@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// spread the CPU work of a frame over a pool of worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+#include "AllocationCounter.h"
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem()
+{
+	m_queuedJobs = 0;
+	m_bStopWorkers = false;
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for starting the worker threads.
+ *  When no count is passed in, one thread is started per
+ *  hardware thread besides the calling one.
+ ***********************************************************/
+void JobSystem::Initialize(int workerCount)
+{
+	if (!m_queues.empty())
+	{
+		return;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+		if (workerCount < 1)
+		{
+			workerCount = 1;
+		}
+	}
+
+	m_bStopWorkers = false;
+	for (int i = 0; i <= workerCount; i++)
+	{
+		m_queues.push_back(std::unique_ptr<JOB_QUEUE>(new JOB_QUEUE()));
+	}
+	for (int i = 1; i <= workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+	}
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for stopping the worker threads.  No
+ *  parallel loop may be running.
+ ***********************************************************/
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopWorkers = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+	m_queues.clear();
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting [0, count) into ranges
+ *  of the grain size and running the body on each range.
+ *  The ranges are dealt out over all of the queues, and the
+ *  calling thread runs and steals jobs until all are done.
+ *  A loop with a single range runs on the calling thread.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int grainSize, const RANGE_FUNCTION& body)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (grainSize < 1)
+	{
+		grainSize = 1;
+	}
+
+	int jobCount = (count + grainSize - 1) / grainSize;
+	if ((jobCount == 1) || m_queues.empty())
+	{
+		body(0, count, 0);
+		return;
+	}
+
+	std::atomic<int> remaining(jobCount);
+	for (int j = 0; j < jobCount; j++)
+	{
+		JOB job;
+		job.pBody = &body;
+		job.begin = j * grainSize;
+		job.end = (job.begin + grainSize < count) ? job.begin + grainSize : count;
+		job.pRemaining = &remaining;
+
+		JOB_QUEUE& queue = *m_queues[j % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		PushJob(queue, job);
+	}
+	{
+		// the count is raised under the wake lock so that a worker
+		// checking it before sleeping can not miss the wake up
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_queuedJobs += jobCount;
+	}
+	m_wakeCondition.notify_all();
+
+	while (remaining.load() > 0)
+	{
+		JOB job;
+		if (PopJob(0, job))
+		{
+			RunJob(job, 0);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  PushJob()
+ *
+ *  This method is used for adding a job at the back of a
+ *  queue whose lock is held.  A full ring is doubled with
+ *  its jobs moved to the front, oldest first.
+ ***********************************************************/
+void JobSystem::PushJob(JOB_QUEUE& queue, const JOB& job)
+{
+	size_t capacity = queue.jobs.size();
+
+	if (queue.count == capacity)
+	{
+		std::vector<JOB> jobs((capacity > 0) ? capacity * 2 : 64);
+		for (size_t i = 0; i < queue.count; i++)
+		{
+			jobs[i] = queue.jobs[(queue.first + i) % capacity];
+		}
+		queue.jobs.swap(jobs);
+		queue.first = 0;
+		capacity = queue.jobs.size();
+	}
+
+	queue.jobs[(queue.first + queue.count) % capacity] = job;
+	queue.count++;
+}
+
+/***********************************************************
+ *  PopJob()
+ *
+ *  This method is used for taking the newest job from the
+ *  thread's own queue, or else the oldest job of the first
+ *  other queue that has one.
+ ***********************************************************/
+bool JobSystem::PopJob(int threadIndex, JOB& job)
+{
+	int queueCount = (int)m_queues.size();
+
+	for (int i = 0; i < queueCount; i++)
+	{
+		int queueIndex = (threadIndex + i) % queueCount;
+		JOB_QUEUE& queue = *m_queues[queueIndex];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (0 == queue.count)
+		{
+			continue;
+		}
+
+		size_t capacity = queue.jobs.size();
+		if (queueIndex == threadIndex)
+		{
+			job = queue.jobs[(queue.first + queue.count - 1) % capacity];
+		}
+		else
+		{
+			job = queue.jobs[queue.first];
+			queue.first = (queue.first + 1) % capacity;
+		}
+		queue.count--;
+		m_queuedJobs--;
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running the body of a job over
+ *  its range and counting the range as done.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job, int threadIndex)
+{
+	(*job.pBody)(job.begin, job.end, threadIndex);
+	job.pRemaining->fetch_sub(1);
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is used by each worker thread for running
+ *  and stealing jobs, sleeping while no jobs are queued.
+ ***********************************************************/
+void JobSystem::WorkerMain(int threadIndex)
+{
+	// the workers prepare the frames, so their allocations count
+	// against the frames as well
+	AllocationCounter::SetThreadTracked(true);
+
+	for (;;)
+	{
+		JOB job;
+		if (PopJob(threadIndex, job))
+		{
+			RunJob(job, threadIndex);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]()
+		{
+			return(m_bStopWorkers || (m_queuedJobs.load() > 0));
+		});
+		if (m_bStopWorkers)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// spread the CPU work of a frame over a pool of worker threads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains a pool of worker threads that each
+ *  own a queue of jobs.  A thread takes its newest job from
+ *  its own queue and, when that is empty, steals the oldest
+ *  job of another queue, so uneven jobs still keep every
+ *  thread busy.  The thread that starts a parallel loop runs
+ *  jobs as well until the whole loop is done, so it never
+ *  simply waits on the workers.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// constructor
+	JobSystem();
+	// destructor
+	~JobSystem();
+
+	// the body of a parallel loop, called with a range of
+	// indices and the index of the thread running it
+	typedef std::function<void(int begin, int end, int threadIndex)> RANGE_FUNCTION;
+
+	// start the worker threads, 0 picks the thread count
+	void Initialize(int workerCount = 0);
+	// stop the worker threads
+	void Shutdown();
+
+	// get the number of threads that run jobs, including the
+	// thread that starts the parallel loops
+	int GetThreadCount() const { return((int)m_queues.size()); }
+	// run the body over [0, count) in ranges of the grain size
+	// and return once every range is done
+	void ParallelFor(int count, int grainSize, const RANGE_FUNCTION& body);
+
+private:
+	// one range of a parallel loop
+	struct JOB
+	{
+		const RANGE_FUNCTION* pBody;
+		int begin;
+		int end;
+		std::atomic<int>* pRemaining;
+	};
+
+	// the jobs queued for one thread, kept in a ring that only
+	// grows when more jobs are queued than ever before, so the
+	// frames queue their jobs without allocating
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		std::vector<JOB> jobs;
+		size_t first = 0;
+		size_t count = 0;
+	};
+
+	// queue 0 belongs to the calling thread, the others to the workers
+	std::vector<std::unique_ptr<JOB_QUEUE>> m_queues;
+	std::vector<std::thread> m_workers;
+	// the idle workers sleep until jobs are queued
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<int> m_queuedJobs;
+	bool m_bStopWorkers;
+
+	// run jobs until the pool is shut down
+	void WorkerMain(int threadIndex);
+	// add a job at the back of a queue, holding its lock
+	static void PushJob(JOB_QUEUE& queue, const JOB& job);
+	// take a job from the thread's own queue or steal one
+	bool PopJob(int threadIndex, JOB& job);
+	// run a job and mark its range as done
+	static void RunJob(const JOB& job, int threadIndex);
+};
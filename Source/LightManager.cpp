@@ -0,0 +1,451 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.cpp
+// ============
+// manage the light sources of the 3D scene and their tiled light lists
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightManager.h"
+
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// width and height in pixels of each screen tile - must
+	// match the tile layout read by the fragment shader
+	const int LIGHT_TILE_SIZE = 16;
+
+	// shader storage buffer binding points
+	const GLuint LIGHT_BLOCK_BINDING = 1;
+	const GLuint TILE_RANGE_BLOCK_BINDING = 2;
+	const GLuint TILE_INDEX_BLOCK_BINDING = 3;
+
+	// std430 packing of one light in the light block
+	struct LIGHT_DATA
+	{
+		glm::vec4 positionRange;
+		glm::vec4 direction;
+		glm::vec4 spotDirectionFocal;
+		glm::vec4 ambientColor;
+		glm::vec4 diffuseColor;
+		glm::vec4 specularColorIntensity;
+	};
+}
+
+/***********************************************************
+ *  LightManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightManager::LightManager()
+{
+	m_lightVersion = 0;
+	m_bLightsDirty = true;
+	m_bTilesDirty = true;
+	m_lightBufferID = 0;
+	m_tileRangeBufferID = 0;
+	m_tileIndexBufferID = 0;
+	m_lastViewportWidth = 0;
+	m_lastViewportHeight = 0;
+}
+
+/***********************************************************
+ *  ~LightManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightManager::~LightManager()
+{
+	if (0 != m_lightBufferID)
+	{
+		glDeleteBuffers(1, &m_lightBufferID);
+		m_lightBufferID = 0;
+	}
+	if (0 != m_tileRangeBufferID)
+	{
+		glDeleteBuffers(1, &m_tileRangeBufferID);
+		m_tileRangeBufferID = 0;
+	}
+	if (0 != m_tileIndexBufferID)
+	{
+		glDeleteBuffers(1, &m_tileIndexBufferID);
+		m_tileIndexBufferID = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the light and tile
+ *  storage buffers and connecting them to the storage
+ *  blocks in the passed in shader program.
+ ***********************************************************/
+void LightManager::Initialize(GLuint programID)
+{
+	glGenBuffers(1, &m_lightBufferID);
+	glGenBuffers(1, &m_tileRangeBufferID);
+	glGenBuffers(1, &m_tileIndexBufferID);
+
+	ConnectProgram(programID);
+
+	m_bLightsDirty = true;
+	m_bTilesDirty = true;
+}
+
+/***********************************************************
+ *  ConnectProgram()
+ *
+ *  This method is used for connecting the storage blocks of
+ *  the passed in shader program to the light and tile buffer
+ *  bindings, after the program is first linked or replaced.
+ ***********************************************************/
+void LightManager::ConnectProgram(GLuint programID)
+{
+	const char* blockNames[3] = { "LightBlock", "TileRangeBlock", "TileIndexBlock" };
+	const GLuint blockBindings[3] = { LIGHT_BLOCK_BINDING, TILE_RANGE_BLOCK_BINDING, TILE_INDEX_BLOCK_BINDING };
+
+	for (int i = 0; i < 3; i++)
+	{
+		GLuint blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, blockNames[i]);
+		if (GL_INVALID_INDEX != blockIndex)
+		{
+			glShaderStorageBlockBinding(programID, blockIndex, blockBindings[i]);
+		}
+	}
+}
+
+/***********************************************************
+ *  AddLightSource()
+ *
+ *  This method is used for adding a light source to the
+ *  scene.  It returns the index of the added light.
+ ***********************************************************/
+int LightManager::AddLightSource(const LIGHT_SOURCE& light)
+{
+	m_lightSources.push_back(light);
+	m_lightReachesItems.push_back(1);
+	m_lightVersion++;
+	m_bLightsDirty = true;
+	m_bTilesDirty = true;
+
+	return((int)m_lightSources.size() - 1);
+}
+
+/***********************************************************
+ *  SetLightSource()
+ *
+ *  This method is used for changing a light source.  The
+ *  light buffer is only uploaded again when a value differs.
+ ***********************************************************/
+void LightManager::SetLightSource(int lightIndex, const LIGHT_SOURCE& light)
+{
+	if ((lightIndex < 0) || (lightIndex >= m_lightSources.size()))
+	{
+		return;
+	}
+
+	if (memcmp(&m_lightSources[lightIndex], &light, sizeof(LIGHT_SOURCE)) != 0)
+	{
+		m_lightSources[lightIndex] = light;
+		m_lightVersion++;
+		m_bLightsDirty = true;
+		m_bTilesDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetLightReachesItems()
+ *
+ *  This method is used for setting whether any render item
+ *  is inside of the range of a light.  A light that reaches
+ *  none cannot light a fragment, so the tile light lists are
+ *  rebuilt without it.  New lights are taken to reach items.
+ ***********************************************************/
+void LightManager::SetLightReachesItems(int lightIndex, bool bReachesItems)
+{
+	if ((lightIndex < 0) || (lightIndex >= m_lightSources.size()))
+	{
+		return;
+	}
+
+	char reaches = bReachesItems ? 1 : 0;
+	if (m_lightReachesItems[lightIndex] != reaches)
+	{
+		m_lightReachesItems[lightIndex] = reaches;
+		m_bTilesDirty = true;
+	}
+}
+
+/***********************************************************
+ *  GetLightSource()
+ *
+ *  This method is used for getting a light source.
+ ***********************************************************/
+const LightManager::LIGHT_SOURCE& LightManager::GetLightSource(int lightIndex) const
+{
+	return(m_lightSources[lightIndex]);
+}
+
+/***********************************************************
+ *  ClearLightSources()
+ *
+ *  This method is used for removing all of the light sources
+ *  before a scene defines its lights again.
+ ***********************************************************/
+void LightManager::ClearLightSources()
+{
+	m_lightSources.clear();
+	m_lightReachesItems.clear();
+	m_lightVersion++;
+	m_bLightsDirty = true;
+	m_bTilesDirty = true;
+}
+
+/***********************************************************
+ *  UpdateLightBuffers()
+ *
+ *  This method is used for uploading the lights when they
+ *  have changed, and for rebuilding the tile light lists
+ *  when the lights, the view or the viewport have changed.
+ ***********************************************************/
+void LightManager::UpdateLightBuffers(const glm::mat4& view, const glm::mat4& projection)
+{
+	GLint viewport[4] = { 0, 0, 0, 0 };
+
+	if (true == m_bLightsDirty)
+	{
+		UploadLights();
+	}
+
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	if ((true == m_bTilesDirty) ||
+		(m_lastView != view) ||
+		(m_lastProjection != projection) ||
+		(m_lastViewportWidth != viewport[2]) ||
+		(m_lastViewportHeight != viewport[3]))
+	{
+		BuildTiles(view, projection, viewport[2], viewport[3]);
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BLOCK_BINDING, m_lightBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_RANGE_BLOCK_BINDING, m_tileRangeBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_INDEX_BLOCK_BINDING, m_tileIndexBufferID);
+}
+
+/***********************************************************
+ *  UploadLights()
+ *
+ *  This method is used for packing all of the light sources
+ *  and uploading them into the light buffer in one call.
+ ***********************************************************/
+void LightManager::UploadLights()
+{
+	int lightCount = (int)m_lightSources.size();
+	// an empty storage buffer is not allowed, so always keep one entry
+	std::vector<LIGHT_DATA> lightData(lightCount > 0 ? lightCount : 1);
+
+	for (int i = 0; i < lightData.size(); i++)
+	{
+		LIGHT_SOURCE light = LIGHT_SOURCE();
+		if (i < lightCount)
+		{
+			light = m_lightSources[i];
+		}
+		lightData[i].positionRange = glm::vec4(light.position, light.range);
+		lightData[i].direction = glm::vec4(light.direction, 0.0f);
+		lightData[i].spotDirectionFocal = glm::vec4(light.spotDirection, light.focalStrength);
+		lightData[i].ambientColor = glm::vec4(light.ambientColor, 0.0f);
+		lightData[i].diffuseColor = glm::vec4(light.diffuseColor, 0.0f);
+		lightData[i].specularColorIntensity = glm::vec4(light.specularColor, light.specularIntensity);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_lightBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, lightData.size() * sizeof(LIGHT_DATA), &lightData[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_bLightsDirty = false;
+}
+
+/***********************************************************
+ *  GetLightTileRect()
+ *
+ *  This method is used for finding the inclusive rectangle
+ *  of screen tiles that the range of a light can touch.  It
+ *  returns false when the light is entirely off screen.
+ ***********************************************************/
+bool LightManager::GetLightTileRect(
+	const LIGHT_SOURCE& light,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	int viewportWidth,
+	int viewportHeight,
+	glm::ivec4& tileRect)
+{
+	int tilesX = (viewportWidth + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	int tilesY = (viewportHeight + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+
+	// directional and unbounded lights reach every tile
+	if ((glm::dot(light.direction, light.direction) > 0.0f) || (light.range <= 0.0f))
+	{
+		tileRect = glm::ivec4(0, 0, tilesX - 1, tilesY - 1);
+		return(true);
+	}
+
+	glm::vec4 viewPosition = view * glm::vec4(light.position, 1.0f);
+	float radius = light.range;
+
+	// the light sphere is entirely behind the camera
+	if (viewPosition.z - radius > 0.0f)
+	{
+		return(false);
+	}
+
+	// project the corners of the view-space box around the light
+	// sphere and take the screen bounds of the projected corners
+	glm::vec2 ndcMin(1.0f, 1.0f);
+	glm::vec2 ndcMax(-1.0f, -1.0f);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		glm::vec4 point(
+			viewPosition.x + ((corner & 1) ? radius : -radius),
+			viewPosition.y + ((corner & 2) ? radius : -radius),
+			viewPosition.z + ((corner & 4) ? radius : -radius),
+			1.0f);
+
+		// keep corners that cross the camera plane in front of it
+		if (point.z > -0.01f)
+		{
+			point.z = -0.01f;
+		}
+
+		glm::vec4 clip = projection * point;
+		glm::vec2 ndc(clip.x / clip.w, clip.y / clip.w);
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+
+	if ((ndcMin.x > 1.0f) || (ndcMin.y > 1.0f) || (ndcMax.x < -1.0f) || (ndcMax.y < -1.0f))
+	{
+		return(false);
+	}
+
+	ndcMin = glm::clamp(ndcMin, -1.0f, 1.0f);
+	ndcMax = glm::clamp(ndcMax, -1.0f, 1.0f);
+
+	// convert the bounds into pixels and then into tile indices,
+	// the fragment shader uses the same lower left origin
+	tileRect.x = (int)((ndcMin.x * 0.5f + 0.5f) * viewportWidth) / LIGHT_TILE_SIZE;
+	tileRect.y = (int)((ndcMin.y * 0.5f + 0.5f) * viewportHeight) / LIGHT_TILE_SIZE;
+	tileRect.z = (int)((ndcMax.x * 0.5f + 0.5f) * viewportWidth) / LIGHT_TILE_SIZE;
+	tileRect.w = (int)((ndcMax.y * 0.5f + 0.5f) * viewportHeight) / LIGHT_TILE_SIZE;
+	tileRect.z = (tileRect.z < tilesX) ? tileRect.z : tilesX - 1;
+	tileRect.w = (tileRect.w < tilesY) ? tileRect.w : tilesY - 1;
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildTiles()
+ *
+ *  This method is used for building the per-tile light lists
+ *  with a counting pass followed by a fill pass, so the lists
+ *  are stored back to back without any per-tile allocation.
+ ***********************************************************/
+void LightManager::BuildTiles(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	int viewportWidth,
+	int viewportHeight)
+{
+	int tilesX = (viewportWidth + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	int tilesY = (viewportHeight + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+	int lightCount = (int)m_lightSources.size();
+
+	if (tilesX < 1)
+		tilesX = 1;
+	if (tilesY < 1)
+		tilesY = 1;
+
+	int tileCount = tilesX * tilesY;
+
+	// the range buffer starts with the tile grid description
+	// followed by one offset and count pair for every tile
+	m_tileRanges.assign(4 + tileCount * 2, 0);
+	m_tileRanges[0] = tilesX;
+	m_tileRanges[1] = tilesY;
+	m_tileRanges[2] = LIGHT_TILE_SIZE;
+	m_tileRanges[3] = lightCount;
+
+	// count the lights touching each tile
+	m_lightTileRects.resize(lightCount);
+	for (int i = 0; i < lightCount; i++)
+	{
+		glm::ivec4& rect = m_lightTileRects[i];
+		if ((0 == m_lightReachesItems[i]) ||
+			(GetLightTileRect(m_lightSources[i], view, projection, viewportWidth, viewportHeight, rect) == false))
+		{
+			// an empty rectangle for lights that are off screen
+			// or that reach no render item
+			rect = glm::ivec4(0, 0, -1, -1);
+		}
+		for (int y = rect.y; y <= rect.w; y++)
+		{
+			for (int x = rect.x; x <= rect.z; x++)
+			{
+				m_tileRanges[4 + (y * tilesX + x) * 2 + 1]++;
+			}
+		}
+	}
+
+	// turn the counts into offsets into the index list
+	GLuint offset = 0;
+	for (int tile = 0; tile < tileCount; tile++)
+	{
+		m_tileRanges[4 + tile * 2] = offset;
+		offset += m_tileRanges[4 + tile * 2 + 1];
+		m_tileRanges[4 + tile * 2 + 1] = 0;
+	}
+
+	// fill the index list, recounting each tile as it is filled
+	m_tileLightIndices.assign(offset > 0 ? offset : 1, 0);
+	for (int i = 0; i < lightCount; i++)
+	{
+		const glm::ivec4& rect = m_lightTileRects[i];
+		for (int y = rect.y; y <= rect.w; y++)
+		{
+			for (int x = rect.x; x <= rect.z; x++)
+			{
+				GLuint* range = &m_tileRanges[4 + (y * tilesX + x) * 2];
+				m_tileLightIndices[range[0] + range[1]] = i;
+				range[1]++;
+			}
+		}
+	}
+	if (offset == 0)
+	{
+		m_tileLightIndices.clear();
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileRangeBufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_tileRanges.size() * sizeof(GLuint), &m_tileRanges[0], GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_tileIndexBufferID);
+	if (m_tileLightIndices.size() > 0)
+	{
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_tileLightIndices.size() * sizeof(GLuint), &m_tileLightIndices[0], GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		GLuint emptyIndex = 0;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint), &emptyIndex, GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	m_lastView = view;
+	m_lastProjection = projection;
+	m_lastViewportWidth = viewportWidth;
+	m_lastViewportHeight = viewportHeight;
+	m_bTilesDirty = false;
+}
@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.h
+// ============
+// manage the light sources of the 3D scene and their tiled light lists
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LightManager
+ *
+ *  This class contains the CPU-side array of scene light
+ *  sources, which is uploaded to a shader storage buffer only
+ *  when a light changes.  Each frame the screen is divided
+ *  into tiles and every tile gets the list of lights whose
+ *  range touches it, so the fragment shader only evaluates
+ *  the lights that can affect each fragment.  Lights whose
+ *  range reaches no render item are left out of the lists.
+ ***********************************************************/
+class LightManager
+{
+public:
+	// constructor
+	LightManager();
+	// destructor
+	~LightManager();
+
+	// a light with a non-zero direction is a directional light,
+	// otherwise it is a point light at its position that becomes
+	// a spotlight when it has a non-zero spot direction - a range
+	// of zero or less means the light reaches every fragment
+	struct LIGHT_SOURCE
+	{
+		glm::vec3 position;
+		glm::vec3 direction;
+		glm::vec3 spotDirection;
+		glm::vec3 ambientColor;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float focalStrength;
+		float specularIntensity;
+		float range;
+	};
+
+	// create the light buffers and connect them to the shader
+	void Initialize(GLuint programID);
+	// connect the light buffers to a newly linked shader program
+	void ConnectProgram(GLuint programID);
+
+	// add a light source and return its index
+	int AddLightSource(const LIGHT_SOURCE& light);
+	// change a previously added light source
+	void SetLightSource(int lightIndex, const LIGHT_SOURCE& light);
+	// get a previously added light source
+	const LIGHT_SOURCE& GetLightSource(int lightIndex) const;
+	// remove all of the light sources
+	void ClearLightSources();
+	// get the number of added light sources
+	int GetLightCount() const { return((int)m_lightSources.size()); }
+	// get the count of light changes, which differs whenever a
+	// light was added, changed or removed since it was read
+	unsigned int GetLightVersion() const { return(m_lightVersion); }
+	// set whether any render item is inside of a light's range
+	void SetLightReachesItems(int lightIndex, bool bReachesItems);
+
+	// upload changed lights and rebuild the tile light lists
+	void UpdateLightBuffers(const glm::mat4& view, const glm::mat4& projection);
+
+	// total number of tile light references in the last rebuild
+	int GetTileLightReferences() const { return((int)m_tileLightIndices.size()); }
+
+private:
+	// CPU-side light source array
+	std::vector<LIGHT_SOURCE> m_lightSources;
+	// set for each light whose range reaches a render item
+	std::vector<char> m_lightReachesItems;
+	// changed whenever a light is added, changed or removed
+	unsigned int m_lightVersion;
+	// true when the light buffer needs to be uploaded again
+	bool m_bLightsDirty;
+	// true when the tile light lists need to be rebuilt
+	bool m_bTilesDirty;
+
+	// shader storage buffers for the lights and tiles
+	GLuint m_lightBufferID;
+	GLuint m_tileRangeBufferID;
+	GLuint m_tileIndexBufferID;
+
+	// view state the tile lists were last built for
+	glm::mat4 m_lastView;
+	glm::mat4 m_lastProjection;
+	int m_lastViewportWidth;
+	int m_lastViewportHeight;
+
+	// per-tile offset and count pairs into the index list
+	std::vector<GLuint> m_tileRanges;
+	// light indices of all tiles stored back to back
+	std::vector<GLuint> m_tileLightIndices;
+	// screen tile rectangle covered by each light
+	std::vector<glm::ivec4> m_lightTileRects;
+
+	// upload the light array into the light buffer
+	void UploadLights();
+	// rebuild and upload the tile light lists
+	void BuildTiles(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		int viewportWidth,
+		int viewportHeight);
+	// find the rectangle of tiles a light's range touches
+	bool GetLightTileRect(
+		const LIGHT_SOURCE& light,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		int viewportWidth,
+		int viewportHeight,
+		glm::ivec4& tileRect);
+};
@@ -1,5 +1,8 @@
 #include <iostream>         // error handling and output
+#include <cassert>          // steady frame allocation check
+#include <cstdio>           // sscanf, window title summary
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -9,9 +12,14 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "DynamicResolution.h"
+#include "FrameProfiler.h"
+#include "OfflineRenderer.h"
+#include "RenderTargets.h"
 #include "SceneManager.h"
 #include "ViewManager.h"
-#include "ShapeMeshes.h"
 #include "ShaderManager.h"
 
 // Namespace for declaring global variables
@@ -29,6 +37,36 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame profiler object for timing the main loop sections
+	FrameProfiler* g_FrameProfiler = nullptr;
+	// benchmark run replacing the interactive session, if any
+	Benchmark* g_Benchmark = nullptr;
+	// offscreen targets the scene is drawn into and presented from
+	RenderTargets* g_RenderTargets = nullptr;
+	// render scale picked from the GPU time of the scene
+	DynamicResolution* g_DynamicResolution = nullptr;
+
+	// GLSL files of the scene shader program
+	const char* const VERTEX_SHADER_FILE = "shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_FILE = "shaders/fragmentShader.glsl";
+
+	// trace file written when F2 is pressed without --profile-trace
+	const char* const DEFAULT_TRACE_FILE = "frame_trace.json";
+	// seconds between the profiler summaries in the window title
+	const double SUMMARY_INTERVAL = 0.5;
+
+	// the camera is updated in fixed steps of this many seconds
+	// and the rendered view is blended between the last two
+	const float UPDATE_TIME_STEP = 1.0f / 120.0f;
+	// longest frame time caught up on, so a stall such as a
+	// dragged window does not run hundreds of update steps
+	const double MAX_FRAME_TIME = 0.25;
+
+	// frames after the last load, file change, resize or pick
+	// before the frames are expected to make no heap allocations
+	const int STEADY_FRAME_COUNT = 120;
+	// length of the window title with the profiler summary
+	const size_t TITLE_LENGTH = 512;
 }
 
 // Function declarations - all functions that are called manually
@@ -45,17 +83,205 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// the heap allocations of this thread are counted, so the
+	// frames can be checked for them
+	AllocationCounter::SetThreadTracked(true);
+
+	// the texture memory budget can be lowered when several
+	// viewers share one GPU, e.g. --texture-budget-mb 128, and a
+	// profiler trace can be written on exit with --profile-trace
+	const char* traceFile = NULL;
+	size_t textureBudget = 0;
+	// --benchmark N renders N measured frames in a hidden window
+	// along a fixed camera path and writes the results as JSON
+	bool bBenchmark = false;
+	// --present vsync, adaptive or uncapped picks the swap interval
+	int presentMode = ViewManager::PRESENT_VSYNC;
+	// --vertex-format packed or float picks the mesh vertex layout
+	SceneMeshes::VERTEX_FORMAT vertexFormat = SceneMeshes::VERTEX_FORMAT_PACKED;
+	// --scene reads a binary scene file instead of the built in
+	// scene, and --convert-scene text binary writes one and exits
+	const char* sceneFile = NULL;
+	// changed shader, texture and scene files are reloaded while
+	// running, except in benchmark runs or with --no-hot-reload
+	bool bHotReload = true;
+	// render items are drawn with compiled shader permutations,
+	// --no-shader-permutations draws with the branching shader
+	bool bShaderPermutations = true;
+	// --shadow-quality off, low, medium or high picks the shadow
+	// map resolution and filtering
+	ShadowManager::SHADOW_QUALITY shadowQuality = ShadowManager::SHADOW_QUALITY_MEDIUM;
+	// the opaque items are drawn depth only before they are
+	// shaded and hidden items are culled on the GPU, unless
+	// turned off with --no-depth-prepass or --no-occlusion-culling
+	bool bDepthPrepass = true;
+	bool bOcclusionCulling = true;
+	// the scene resolution is scaled to fit its GPU time in
+	// --target-frame-ms, except in benchmark runs or with
+	// --no-dynamic-resolution
+	bool bDynamicResolution = true;
+	float targetFrameTime = 0.0f;
+	// --render-poses renders each pose of a camera script into an
+	// image file of --render-output, --render-format png or exr
+	// and --render-size WxH, in a hidden window, and exits
+	bool bOfflineRender = false;
+	OfflineRenderer::OFFLINE_SETTINGS offlineSettings;
+	Benchmark::BENCHMARK_SETTINGS benchmarkSettings;
+	for (int i = 1; i < argc; i++)
+	{
+		bool bHasValue = (i + 1 < argc);
+		if ((strcmp(argv[i], "--texture-budget-mb") == 0) && bHasValue)
+		{
+			textureBudget = (size_t)atoi(argv[++i]) * 1024 * 1024;
+		}
+		else if ((strcmp(argv[i], "--profile-trace") == 0) && bHasValue)
+		{
+			traceFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--benchmark") == 0)
+		{
+			bBenchmark = true;
+			if (bHasValue && (atoi(argv[i + 1]) > 0))
+			{
+				benchmarkSettings.frameCount = atoi(argv[++i]);
+			}
+		}
+		else if ((strcmp(argv[i], "--benchmark-warmup") == 0) && bHasValue)
+		{
+			benchmarkSettings.warmupFrames = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--benchmark-output") == 0) && bHasValue)
+		{
+			benchmarkSettings.outputFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--scene-copies") == 0) && bHasValue)
+		{
+			benchmarkSettings.sceneCopies = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--present") == 0) && bHasValue)
+		{
+			i++;
+			if (strcmp(argv[i], "adaptive") == 0)
+			{
+				presentMode = ViewManager::PRESENT_ADAPTIVE;
+			}
+			else if (strcmp(argv[i], "uncapped") == 0)
+			{
+				presentMode = ViewManager::PRESENT_UNCAPPED;
+			}
+			else
+			{
+				presentMode = ViewManager::PRESENT_VSYNC;
+			}
+		}
+		else if ((strcmp(argv[i], "--scene") == 0) && bHasValue)
+		{
+			sceneFile = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--convert-scene") == 0) && (i + 2 < argc))
+		{
+			bool bConverted = SceneFile::ConvertTextScene(argv[i + 1], argv[i + 2]);
+			return(bConverted ? EXIT_SUCCESS : EXIT_FAILURE);
+		}
+		else if (strcmp(argv[i], "--no-hot-reload") == 0)
+		{
+			bHotReload = false;
+		}
+		else if (strcmp(argv[i], "--no-shader-permutations") == 0)
+		{
+			bShaderPermutations = false;
+		}
+		else if (strcmp(argv[i], "--no-depth-prepass") == 0)
+		{
+			bDepthPrepass = false;
+		}
+		else if (strcmp(argv[i], "--no-occlusion-culling") == 0)
+		{
+			bOcclusionCulling = false;
+		}
+		else if (strcmp(argv[i], "--no-dynamic-resolution") == 0)
+		{
+			bDynamicResolution = false;
+		}
+		else if ((strcmp(argv[i], "--target-frame-ms") == 0) && bHasValue)
+		{
+			targetFrameTime = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--render-poses") == 0) && bHasValue)
+		{
+			bOfflineRender = true;
+			offlineSettings.cameraScript = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--render-output") == 0) && bHasValue)
+		{
+			offlineSettings.outputDirectory = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--render-format") == 0) && bHasValue)
+		{
+			i++;
+			offlineSettings.format = (strcmp(argv[i], "exr") == 0) ?
+				ImageWriter::IMAGE_FORMAT_EXR : ImageWriter::IMAGE_FORMAT_PNG;
+		}
+		else if ((strcmp(argv[i], "--render-size") == 0) && bHasValue)
+		{
+			int width = 0;
+			int height = 0;
+			if ((sscanf(argv[++i], "%dx%d", &width, &height) == 2) && (width > 0) && (height > 0))
+			{
+				offlineSettings.width = width;
+				offlineSettings.height = height;
+			}
+		}
+		else if ((strcmp(argv[i], "--shadow-quality") == 0) && bHasValue)
+		{
+			i++;
+			if (strcmp(argv[i], "off") == 0)
+			{
+				shadowQuality = ShadowManager::SHADOW_QUALITY_OFF;
+			}
+			else if (strcmp(argv[i], "low") == 0)
+			{
+				shadowQuality = ShadowManager::SHADOW_QUALITY_LOW;
+			}
+			else if (strcmp(argv[i], "high") == 0)
+			{
+				shadowQuality = ShadowManager::SHADOW_QUALITY_HIGH;
+			}
+			else
+			{
+				shadowQuality = ShadowManager::SHADOW_QUALITY_MEDIUM;
+			}
+		}
+		else if ((strcmp(argv[i], "--vertex-format") == 0) && bHasValue)
+		{
+			i++;
+			if (strcmp(argv[i], "float") == 0)
+			{
+				vertexFormat = SceneMeshes::VERTEX_FORMAT_FLOAT;
+			}
+			else
+			{
+				vertexFormat = SceneMeshes::VERTEX_FORMAT_PACKED;
+			}
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
+	// benchmark runs and offline renders draw into a window
+	// that is never shown
+	if (bBenchmark || bOfflineRender)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
 
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
 	// try to create a new view manager object
-	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+	g_ViewManager = new ViewManager();
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
@@ -65,43 +291,273 @@ int main(int argc, char* argv[])
 	{
 		return(EXIT_FAILURE);
 	}
+	// benchmark frames are not held back by the display refresh
+	if (bBenchmark || bOfflineRender)
+	{
+		presentMode = ViewManager::PRESENT_UNCAPPED;
+	}
+	g_ViewManager->SetPresentMode(presentMode);
 
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
+		VERTEX_SHADER_FILE,
+		FRAGMENT_SHADER_FILE);
 	g_ShaderManager->use();
 
 	// try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	if (textureBudget > 0)
+	{
+		g_SceneManager->SetTextureBudget(textureBudget);
+	}
+	g_SceneManager->SetSceneCopies(benchmarkSettings.sceneCopies);
+	g_SceneManager->SetVertexFormat(vertexFormat);
+	if (NULL != sceneFile)
+	{
+		g_SceneManager->SetSceneFile(sceneFile);
+	}
+	g_SceneManager->SetShaderFiles(VERTEX_SHADER_FILE, FRAGMENT_SHADER_FILE);
+	g_SceneManager->SetHotReload(bHotReload && !bBenchmark && !bOfflineRender);
+	g_SceneManager->SetShaderPermutations(bShaderPermutations);
+	g_SceneManager->SetShadowQuality(shadowQuality);
+	g_SceneManager->SetDepthPrepass(bDepthPrepass);
+	// offline renders cut between unrelated poses, so culling
+	// against the depth of the image before would drop items
+	g_SceneManager->SetOcclusionCulling(bOcclusionCulling && !bOfflineRender);
 	g_SceneManager->PrepareScene();
 
+	// an offline render writes its images and exits without
+	// entering the main loop
+	int exitCode = EXIT_SUCCESS;
+	if (bOfflineRender)
+	{
+		OfflineRenderer offlineRenderer(offlineSettings);
+		if (offlineRenderer.Run(*g_SceneManager, *g_ViewManager) == false)
+		{
+			exitCode = EXIT_FAILURE;
+		}
+		glfwSetWindowShouldClose(g_Window, GLFW_TRUE);
+	}
+
+	// time the main loop sections, F1 toggles the overlay graph
+	// and F2 writes the trace of the recent frames
+	g_FrameProfiler = new FrameProfiler();
+	g_FrameProfiler->Initialize();
+	bool bShowOverlay = false;
+	double lastSummaryTime = glfwGetTime();
+
+	// draw the scene offscreen at a scale that holds the target
+	// time, benchmark frames are always drawn at full resolution
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	g_ViewManager->GetFramebufferSize(framebufferWidth, framebufferHeight);
+	g_RenderTargets = new RenderTargets();
+	g_RenderTargets->Resize(framebufferWidth, framebufferHeight);
+	g_DynamicResolution = new DynamicResolution();
+	g_DynamicResolution->SetEnabled(bDynamicResolution && !bBenchmark);
+	if (targetFrameTime > 0.0f)
+	{
+		g_DynamicResolution->SetTargetFrameTime(targetFrameTime);
+	}
+
+	// the benchmark camera is driven by the recorded path and the
+	// measurement starts with every texture already loaded
+	if (bBenchmark)
+	{
+		g_Benchmark = new Benchmark(benchmarkSettings);
+		g_ViewManager->SetInputScript(&g_Benchmark->GetCameraPath());
+		g_SceneManager->FinishTextureLoads();
+	}
+
+	// real time not yet covered by camera update steps
+	double lastFrameTime = glfwGetTime();
+	double updateAccumulator = 0.0;
+
+	// frames in a row with nothing loaded, changed or resized,
+	// which must not allocate once there are enough of them
+	int steadyFrames = 0;
+	bool bAllocationWarningShown = false;
+	char title[TITLE_LENGTH];
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		g_FrameProfiler->BeginFrame();
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
-		// Clear the frame and z buffers
-		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// query the latest GLFW events right before the camera is
+		// updated, so the input is never a whole frame old
+		glfwPollEvents();
+
+		// rebuild the render targets for a resized window, and
+		// measure its GPU times again before scaling
+		bool bSteadyFrame = true;
+		if (g_ViewManager->GetResizeRequest(framebufferWidth, framebufferHeight))
+		{
+			g_RenderTargets->Resize(framebufferWidth, framebufferHeight);
+			g_DynamicResolution->ResetHistory();
+			bSteadyFrame = false;
+		}
+		g_RenderTargets->SetRenderScale(g_DynamicResolution->GetScale());
+
+		// swap in the shader, texture and scene files that were
+		// changed, before anything of this frame is drawn
+		if (g_SceneManager->ApplyFileChanges() || g_SceneManager->IsLoadingTextures())
+		{
+			bSteadyFrame = false;
+		}
+
+		// move the camera in fixed steps covering the real time
+		// that has passed, benchmark runs take one step per frame
+		float interpolation = 1.0f;
+		{
+			FrameProfiler::ScopedSection section(g_FrameProfiler, FrameProfiler::SECTION_UPDATE);
+			double currentTime = glfwGetTime();
+			double frameTime = currentTime - lastFrameTime;
+			lastFrameTime = currentTime;
+
+			if (NULL != g_Benchmark)
+			{
+				g_ViewManager->UpdateCamera(g_Benchmark->GetPathFrameTime());
+			}
+			else
+			{
+				updateAccumulator += (frameTime < MAX_FRAME_TIME) ? frameTime : MAX_FRAME_TIME;
+				while (updateAccumulator >= UPDATE_TIME_STEP)
+				{
+					g_ViewManager->UpdateCamera(UPDATE_TIME_STEP);
+					updateAccumulator -= UPDATE_TIME_STEP;
+				}
+				interpolation = (float)(updateAccumulator / UPDATE_TIME_STEP);
+			}
+		}
 
 		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		{
+			FrameProfiler::ScopedSection section(g_FrameProfiler, FrameProfiler::SECTION_PREPARE_VIEW);
+			g_ViewManager->PrepareSceneView(interpolation);
+		}
+		g_SceneManager->SetSceneView(
+			g_ViewManager->GetViewMatrix(),
+			g_ViewManager->GetProjectionMatrix());
+
+		// pick the object under the mouse when it was clicked
+		float pickX = 0.0f;
+		float pickY = 0.0f;
+		if (g_ViewManager->GetPickRequest(pickX, pickY))
+		{
+			int pickedItem = g_SceneManager->PickRenderItem(pickX, pickY);
+			g_SceneManager->PrintRenderItem(pickedItem);
+			bSteadyFrame = false;
+		}
+
+		// refresh the 3D scene into the render targets and scale
+		// it up into the window
+		{
+			FrameProfiler::ScopedSection section(g_FrameProfiler, FrameProfiler::SECTION_RENDER_SCENE);
+			g_RenderTargets->BeginScene();
+			g_SceneManager->RenderScene();
+			g_RenderTargets->Present();
+		}
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+		const SceneManager::RENDER_STATS& stats = g_SceneManager->GetRenderStats();
+		g_FrameProfiler->SetCounter(FrameProfiler::COUNTER_DRAWS, stats.drawCount);
+		g_FrameProfiler->SetCounter(FrameProfiler::COUNTER_UNIFORM_UPLOADS, stats.uniformUploads);
+		g_FrameProfiler->SetCounter(FrameProfiler::COUNTER_TEXTURE_BINDS, stats.textureBinds);
+		g_FrameProfiler->SetCounter(FrameProfiler::COUNTER_RENDER_SCALE_PERCENT, (int)(g_RenderTargets->GetRenderScale() * 100.0f + 0.5f));
 
+		if (g_ViewManager->GetOverlayToggleRequest())
+		{
+			bShowOverlay = !bShowOverlay;
+		}
+		if (bShowOverlay)
+		{
+			g_FrameProfiler->DrawOverlay();
+		}
+		if (g_ViewManager->GetTraceExportRequest())
+		{
+			g_FrameProfiler->ExportChromeTrace((NULL != traceFile) ? traceFile : DEFAULT_TRACE_FILE);
+			bSteadyFrame = false;
+		}
 
 		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
+		{
+			FrameProfiler::ScopedSection section(g_FrameProfiler, FrameProfiler::SECTION_SWAP_BUFFERS);
+			glfwSwapBuffers(g_Window);
+		}
+		g_FrameProfiler->EndFrame();
 
-		// query the latest GLFW events
-		glfwPollEvents();
+		// once the frames have settled, all of their transient
+		// data comes from the frame arena and none from the heap
+		steadyFrames = bSteadyFrame ? steadyFrames + 1 : 0;
+		int frameAllocations = g_FrameProfiler->GetCounter(FrameProfiler::COUNTER_ALLOCATIONS);
+		if ((steadyFrames > STEADY_FRAME_COUNT) && (frameAllocations > 0))
+		{
+			if (!bAllocationWarningShown)
+			{
+				std::cout << "WARNING: A steady frame made " << frameAllocations << " heap allocations" << std::endl;
+				bAllocationWarningShown = true;
+			}
+			assert(frameAllocations == 0);
+		}
+
+		// pick the render scale of the next frames from the GPU
+		// times read back so far, while there is a window to draw
+		if (g_RenderTargets->IsReady())
+		{
+			g_DynamicResolution->Update(*g_FrameProfiler);
+		}
+
+		if (NULL != g_Benchmark)
+		{
+			g_Benchmark->RecordFrame(*g_FrameProfiler, stats);
+			if (g_ViewManager->IsInputScriptFinished())
+			{
+				glfwSetWindowShouldClose(g_Window, GLFW_TRUE);
+			}
+		}
+
+		// show the recent frame timings in the window title
+		double currentTime = glfwGetTime();
+		if (currentTime - lastSummaryTime >= SUMMARY_INTERVAL)
+		{
+			int titleLength = snprintf(title, sizeof(title), "%s - ", WINDOW_TITLE);
+			g_FrameProfiler->FormatSummary(title + titleLength, sizeof(title) - titleLength);
+			glfwSetWindowTitle(g_Window, title);
+			lastSummaryTime = currentTime;
+		}
+	}
+
+	if (NULL != traceFile)
+	{
+		g_FrameProfiler->ExportChromeTrace(traceFile);
+	}
+	if (NULL != g_Benchmark)
+	{
+		g_Benchmark->WriteResults(*g_SceneManager);
+		delete g_Benchmark;
+		g_Benchmark = NULL;
 	}
 
 	// clear the allocated manager objects from memory
+	if (NULL != g_DynamicResolution)
+	{
+		delete g_DynamicResolution;
+		g_DynamicResolution = NULL;
+	}
+	if (NULL != g_RenderTargets)
+	{
+		delete g_RenderTargets;
+		g_RenderTargets = NULL;
+	}
+	if (NULL != g_FrameProfiler)
+	{
+		delete g_FrameProfiler;
+		g_FrameProfiler = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -118,8 +574,9 @@ int main(int argc, char* argv[])
 		g_ShaderManager = NULL;
 	}
 
-	// Terminates the program successfully
-	exit(EXIT_SUCCESS); 
+	// Terminates the program, unsuccessfully if an offline
+	// render failed
+	exit(exitCode);
 }
 
 /***********************************************************
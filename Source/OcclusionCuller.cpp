@@ -0,0 +1,368 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.cpp
+// ============
+// cull the hidden render items on the GPU against a depth pyramid
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionCuller.h"
+#include "SceneMeshes.h"
+#include "ShaderCompiler.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// shader storage buffer binding points of the culling, apart
+	// from those of the light manager and texture registry
+	const GLuint CULL_RECORD_BINDING = 0;
+	const GLuint SOURCE_INSTANCE_BINDING = 5;
+	const GLuint CULLED_COMMAND_BINDING = 6;
+	const GLuint CULLED_INSTANCE_BINDING = 7;
+	// image units the pyramid levels are read and written through
+	const GLuint SOURCE_LEVEL_IMAGE_UNIT = 0;
+	const GLuint DESTINATION_LEVEL_IMAGE_UNIT = 1;
+	// texture unit the depth copy and the pyramid are read from,
+	// after the shadow maps
+	const GLint PYRAMID_TEXTURE_UNIT = 9;
+
+	// work group sizes, must match the compute shaders
+	const int CULL_GROUP_SIZE = 64;
+	const int PYRAMID_GROUP_SIZE = 8;
+}
+
+/***********************************************************
+ *  OcclusionCuller()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionCuller::OcclusionCuller()
+{
+	m_cullProgramID = 0;
+	m_copyProgramID = 0;
+	m_reduceProgramID = 0;
+	m_firstRecordLocation = -1;
+	m_firstInstanceLocation = -1;
+	m_recordCountLocation = -1;
+	m_viewProjectionLocation = -1;
+	m_pyramidSizeLocation = -1;
+	m_pyramidLevelsLocation = -1;
+	m_depthTextureID = 0;
+	m_pyramidTextureID = 0;
+	m_pyramidWidth = 0;
+	m_pyramidHeight = 0;
+	m_pyramidLevels = 0;
+	m_viewProjection = glm::mat4(1.0f);
+	m_bPyramidBuilt = false;
+	m_commandBufferID = 0;
+	m_commandBufferBytes = 0;
+	m_instanceBufferID = 0;
+	m_instanceBufferBytes = 0;
+}
+
+/***********************************************************
+ *  ~OcclusionCuller()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionCuller::~OcclusionCuller()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the compute programs
+ *  that cull the instances and build the depth pyramid.  The
+ *  pyramid file builds both the copy of the depth into the
+ *  first level and the reduction into the later levels.  It
+ *  returns false when a program fails to build.
+ ***********************************************************/
+bool OcclusionCuller::Initialize(const char* cullShaderFile, const char* pyramidShaderFile)
+{
+	m_cullProgramID = ShaderCompiler::BuildComputeProgram(cullShaderFile);
+	m_copyProgramID = ShaderCompiler::BuildComputeProgram(pyramidShaderFile, "#define PYRAMID_COPY_DEPTH 1\n");
+	m_reduceProgramID = ShaderCompiler::BuildComputeProgram(pyramidShaderFile);
+	if ((0 == m_cullProgramID) || (0 == m_copyProgramID) || (0 == m_reduceProgramID))
+	{
+		std::cout << "Occlusion culling is disabled" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_firstRecordLocation = glGetUniformLocation(m_cullProgramID, "firstRecord");
+	m_firstInstanceLocation = glGetUniformLocation(m_cullProgramID, "firstSourceInstance");
+	m_recordCountLocation = glGetUniformLocation(m_cullProgramID, "recordCount");
+	m_viewProjectionLocation = glGetUniformLocation(m_cullProgramID, "pyramidViewProjection");
+	m_pyramidSizeLocation = glGetUniformLocation(m_cullProgramID, "pyramidSize");
+	m_pyramidLevelsLocation = glGetUniformLocation(m_cullProgramID, "pyramidLevels");
+
+	// the samplers only ever read from their own unit
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_cullProgramID);
+	glUniform1i(glGetUniformLocation(m_cullProgramID, "depthPyramid"), PYRAMID_TEXTURE_UNIT);
+	glUseProgram(m_copyProgramID);
+	glUniform1i(glGetUniformLocation(m_copyProgramID, "depthTexture"), PYRAMID_TEXTURE_UNIT);
+	glUseProgram((GLuint)previousProgram);
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the compute programs, the
+ *  depth pyramid and the culled buffers.
+ ***********************************************************/
+void OcclusionCuller::Destroy()
+{
+	DestroyPyramid();
+
+	if (0 != m_cullProgramID)
+	{
+		glDeleteProgram(m_cullProgramID);
+		m_cullProgramID = 0;
+	}
+	if (0 != m_copyProgramID)
+	{
+		glDeleteProgram(m_copyProgramID);
+		m_copyProgramID = 0;
+	}
+	if (0 != m_reduceProgramID)
+	{
+		glDeleteProgram(m_reduceProgramID);
+		m_reduceProgramID = 0;
+	}
+	if (0 != m_commandBufferID)
+	{
+		glDeleteBuffers(1, &m_commandBufferID);
+		m_commandBufferID = 0;
+		m_commandBufferBytes = 0;
+	}
+	if (0 != m_instanceBufferID)
+	{
+		glDeleteBuffers(1, &m_instanceBufferID);
+		m_instanceBufferID = 0;
+		m_instanceBufferBytes = 0;
+	}
+}
+
+/***********************************************************
+ *  CreatePyramid()
+ *
+ *  This method is used for creating the depth copy and the
+ *  pyramid textures for a viewport size.  The pyramid has a
+ *  level for every halving of the larger side.
+ ***********************************************************/
+void OcclusionCuller::CreatePyramid(int width, int height)
+{
+	DestroyPyramid();
+
+	m_pyramidWidth = width;
+	m_pyramidHeight = height;
+	m_pyramidLevels = 1;
+	for (int size = (width > height) ? width : height; size > 1; size /= 2)
+	{
+		m_pyramidLevels++;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+	glGenTextures(1, &m_depthTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenTextures(1, &m_pyramidTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_pyramidTextureID);
+	glTexStorage2D(GL_TEXTURE_2D, m_pyramidLevels, GL_R32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  DestroyPyramid()
+ *
+ *  This method is used for freeing the depth copy and the
+ *  pyramid textures.
+ ***********************************************************/
+void OcclusionCuller::DestroyPyramid()
+{
+	if (0 != m_depthTextureID)
+	{
+		glDeleteTextures(1, &m_depthTextureID);
+		m_depthTextureID = 0;
+	}
+	if (0 != m_pyramidTextureID)
+	{
+		glDeleteTextures(1, &m_pyramidTextureID);
+		m_pyramidTextureID = 0;
+	}
+	m_pyramidWidth = 0;
+	m_pyramidHeight = 0;
+	m_pyramidLevels = 0;
+	m_bPyramidBuilt = false;
+}
+
+/***********************************************************
+ *  BuildPyramid()
+ *
+ *  This method is used for copying the depth buffer of the
+ *  current viewport, which must only hold the opaque draws,
+ *  into the first pyramid level and reducing each level
+ *  into the next.  The passed in view is the one the depth
+ *  was drawn with, which the next frame is culled against.
+ ***********************************************************/
+void OcclusionCuller::BuildPyramid(const glm::mat4& viewProjection)
+{
+	if (0 == m_cullProgramID)
+	{
+		return;
+	}
+
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		return;
+	}
+	if ((viewport[2] != m_pyramidWidth) || (viewport[3] != m_pyramidHeight))
+	{
+		CreatePyramid(viewport[2], viewport[3]);
+	}
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+
+	// the depth is read from the framebuffer being drawn
+	glActiveTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	glUseProgram(m_copyProgramID);
+	glBindImageTexture(DESTINATION_LEVEL_IMAGE_UNIT, m_pyramidTextureID, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glDispatchCompute(
+		(m_pyramidWidth + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+		(m_pyramidHeight + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+		1);
+
+	glUseProgram(m_reduceProgramID);
+	int levelWidth = m_pyramidWidth;
+	int levelHeight = m_pyramidHeight;
+	for (int level = 1; level < m_pyramidLevels; level++)
+	{
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+
+		// each level only reads what the level before it wrote
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+		glBindImageTexture(SOURCE_LEVEL_IMAGE_UNIT, m_pyramidTextureID, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(DESTINATION_LEVEL_IMAGE_UNIT, m_pyramidTextureID, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute(
+			(levelWidth + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+			(levelHeight + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+			1);
+	}
+	// the culling reads the pyramid with texture fetches
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram((GLuint)previousProgram);
+
+	m_viewProjection = viewProjection;
+	m_bPyramidBuilt = true;
+}
+
+/***********************************************************
+ *  CullInstances()
+ *
+ *  This method is used for culling the instances of a frame
+ *  against the pyramid.  The passed in offsets point into
+ *  the frame data buffer at the cull record and instance of
+ *  every queue entry, and at copies of the frame's indirect
+ *  commands with no instances and a base instance counted
+ *  from 0.  Each visible instance adds itself to the count
+ *  of its command and is copied into the culled instances.
+ ***********************************************************/
+void OcclusionCuller::CullInstances(
+	GLuint frameBufferID,
+	size_t recordOffset,
+	size_t instanceOffset,
+	size_t commandOffset,
+	int instanceCount,
+	int commandCount)
+{
+	if (!m_bPyramidBuilt || (instanceCount <= 0) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	ReserveBuffer(m_commandBufferID, m_commandBufferBytes, commandCount * sizeof(SceneMeshes::DRAW_COMMAND));
+	ReserveBuffer(m_instanceBufferID, m_instanceBufferBytes, instanceCount * sizeof(SceneMeshes::INSTANCE_DATA));
+
+	glBindBuffer(GL_COPY_READ_BUFFER, frameBufferID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_commandBufferID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+		commandOffset, 0, commandCount * sizeof(SceneMeshes::DRAW_COMMAND));
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GLint previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &previousProgram);
+	glUseProgram(m_cullProgramID);
+	glUniform1ui(m_firstRecordLocation, (GLuint)(recordOffset / sizeof(CULL_RECORD)));
+	glUniform1ui(m_firstInstanceLocation, (GLuint)(instanceOffset / sizeof(SceneMeshes::INSTANCE_DATA)));
+	glUniform1ui(m_recordCountLocation, (GLuint)instanceCount);
+	glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &m_viewProjection[0][0]);
+	glUniform2f(m_pyramidSizeLocation, (float)m_pyramidWidth, (float)m_pyramidHeight);
+	glUniform1i(m_pyramidLevelsLocation, m_pyramidLevels);
+
+	// the records and source instances are read in place from
+	// the frame data buffer, so no offset alignment applies
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_RECORD_BINDING, frameBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SOURCE_INSTANCE_BINDING, frameBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULLED_COMMAND_BINDING, m_commandBufferID);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULLED_INSTANCE_BINDING, m_instanceBufferID);
+	glActiveTexture(GL_TEXTURE0 + PYRAMID_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D, m_pyramidTextureID);
+
+	glDispatchCompute((instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	// the draws read the commands and the instance attributes
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+	glUseProgram((GLuint)previousProgram);
+}
+
+/***********************************************************
+ *  ReserveBuffer()
+ *
+ *  This method is used for growing a buffer that only the
+ *  GPU reads and writes, to at least the passed in bytes.
+ ***********************************************************/
+void OcclusionCuller::ReserveBuffer(GLuint& bufferID, size_t& bufferBytes, size_t bytes)
+{
+	if ((0 != bufferID) && (bytes <= bufferBytes))
+	{
+		return;
+	}
+
+	// grow by half again so a slowly growing frame does not
+	// reallocate every time
+	size_t newBytes = bytes + bytes / 2;
+	if (0 == bufferID)
+	{
+		glGenBuffers(1, &bufferID);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, bufferID);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, newBytes, NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	bufferBytes = newBytes;
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionculler.h
+// ============
+// cull the hidden render items on the GPU against a depth pyramid
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  OcclusionCuller
+ *
+ *  This class contains a hierarchical depth pyramid, built
+ *  from the depth of the opaque draws of a frame, where each
+ *  texel of a level holds the farthest depth of the texels
+ *  it covers in the level below.  The next frame a compute
+ *  shader tests the bounding sphere of every instance against
+ *  the pyramid with the view it was built from, and writes
+ *  the instances that may be visible and their counts into
+ *  the indirect commands the frame is drawn from.  The CPU
+ *  never reads the results back, so culling never stalls.
+ ***********************************************************/
+class OcclusionCuller
+{
+public:
+	// constructor
+	OcclusionCuller();
+	// destructor
+	~OcclusionCuller();
+
+	// bounds of one instance and the indirect command it is
+	// drawn by, must match the compute shader
+	struct CULL_RECORD
+	{
+		glm::vec4 sphere;
+		GLuint commandIndex;
+		GLuint padding[3];
+	};
+
+	// build the pyramid and culling compute programs
+	bool Initialize(const char* cullShaderFile, const char* pyramidShaderFile);
+	// free the programs, the pyramid and the culled buffers
+	void Destroy();
+	// check if a pyramid has been built to cull against
+	bool HasPyramid() const { return(m_bPyramidBuilt); }
+
+	// copy the depth of the current viewport into the pyramid,
+	// which is then culled against with the passed in view
+	void BuildPyramid(const glm::mat4& viewProjection);
+	// cull instances from the frame data buffer into the culled
+	// buffers, starting from commands with no instances
+	void CullInstances(
+		GLuint frameBufferID,
+		size_t recordOffset,
+		size_t instanceOffset,
+		size_t commandOffset,
+		int instanceCount,
+		int commandCount);
+
+	// get the buffers written by the last CullInstances()
+	GLuint GetCommandBufferID() const { return(m_commandBufferID); }
+	GLuint GetInstanceBufferID() const { return(m_instanceBufferID); }
+
+private:
+	GLuint m_cullProgramID;
+	GLuint m_copyProgramID;
+	GLuint m_reduceProgramID;
+	GLint m_firstRecordLocation;
+	GLint m_firstInstanceLocation;
+	GLint m_recordCountLocation;
+	GLint m_viewProjectionLocation;
+	GLint m_pyramidSizeLocation;
+	GLint m_pyramidLevelsLocation;
+
+	// depth copied out of the framebuffer and its pyramid
+	GLuint m_depthTextureID;
+	GLuint m_pyramidTextureID;
+	int m_pyramidWidth;
+	int m_pyramidHeight;
+	int m_pyramidLevels;
+	// view the pyramid was built with
+	glm::mat4 m_viewProjection;
+	bool m_bPyramidBuilt;
+
+	// indirect commands and instances that passed the culling
+	GLuint m_commandBufferID;
+	size_t m_commandBufferBytes;
+	GLuint m_instanceBufferID;
+	size_t m_instanceBufferBytes;
+
+	// create the depth copy and pyramid textures for a viewport
+	void CreatePyramid(int width, int height);
+	// free the depth copy and pyramid textures
+	void DestroyPyramid();
+	// grow a GPU only buffer to hold at least the passed in bytes
+	static void ReserveBuffer(GLuint& bufferID, size_t& bufferBytes, size_t bytes);
+};
@@ -0,0 +1,363 @@
+///////////////////////////////////////////////////////////////////////////////
+// offlinerenderer.cpp
+// ============
+// render the scene from a camera script into numbered image files
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OfflineRenderer.h"
+#include "FileUtilities.h"
+
+#include "GLFW/glfw3.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	// longest wait for a readback before checking again
+	const GLuint64 READBACK_WAIT_NANOSECONDS = 1000000000;
+	// images rendered between the progress messages
+	const int PROGRESS_INTERVAL = 100;
+
+	// read the passed in number of floats from a script line
+	bool ReadFloats(std::istringstream& line, float* pValues, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (!(line >> pValues[i]))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+}
+
+/***********************************************************
+ *  OfflineRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OfflineRenderer::OfflineRenderer(const OFFLINE_SETTINGS& settings)
+{
+	m_settings = settings;
+	for (int i = 0; i < READBACK_SLOT_COUNT; i++)
+	{
+		m_slots[i].bufferID = 0;
+		m_slots[i].fence = 0;
+		m_slots[i].imageIndex = -1;
+	}
+	m_imageBytes = 0;
+	m_failedReadbacks = 0;
+}
+
+/***********************************************************
+ *  ~OfflineRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OfflineRenderer::~OfflineRenderer()
+{
+	m_imageWriter.Shutdown();
+	DestroyReadbackBuffers();
+	m_renderTargets.Destroy();
+}
+
+/***********************************************************
+ *  LoadCameraScript()
+ *
+ *  This method is used for reading the camera poses of a
+ *  text camera script.  Each line starting with "pose" is a
+ *  pose, followed by any of the keys
+ *
+ *      position x y z  front x y z  up x y z  zoom degrees
+ *
+ *  with the values of the pose before it kept for the keys
+ *  that are left out, so a turntable only lists positions.
+ *  Everything after a '#' is a comment.
+ ***********************************************************/
+bool OfflineRenderer::LoadCameraScript(
+	const std::string& filename,
+	const ViewManager::CAMERA_POSE& initialPose,
+	std::vector<ViewManager::CAMERA_POSE>& poses)
+{
+	std::ifstream scriptFile(filename.c_str());
+	if (!scriptFile.is_open())
+	{
+		std::cout << "Could not open camera script:" << filename << std::endl;
+		return(false);
+	}
+
+	ViewManager::CAMERA_POSE pose = initialPose;
+	std::string text;
+	int lineNumber = 0;
+	while (std::getline(scriptFile, text))
+	{
+		lineNumber++;
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+		{
+			text.erase(comment);
+		}
+
+		std::istringstream line(text);
+		std::string kind;
+		if (!(line >> kind))
+		{
+			continue;
+		}
+
+		bool bSuccess = (kind == "pose");
+		std::string key;
+		while (bSuccess && (line >> key))
+		{
+			if (key == "position")
+				bSuccess = ReadFloats(line, &pose.position[0], 3);
+			else if (key == "front")
+				bSuccess = ReadFloats(line, &pose.front[0], 3);
+			else if (key == "up")
+				bSuccess = ReadFloats(line, &pose.up[0], 3);
+			else if (key == "zoom")
+				bSuccess = ReadFloats(line, &pose.zoom, 1);
+			else
+				bSuccess = false;
+		}
+		if (bSuccess == false)
+		{
+			std::cout << "Invalid camera script line " << lineNumber << ":" << filename << std::endl;
+			return(false);
+		}
+
+		poses.push_back(pose);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for rendering the scene from every
+ *  pose of the camera script and writing the images.  The
+ *  textures are loaded in full before the first image, and
+ *  the readback of each image is only waited on after the
+ *  next one has been submitted.  It returns once every image
+ *  is written, and false when the render could not be set up
+ *  or any image failed to be written.
+ ***********************************************************/
+bool OfflineRenderer::Run(SceneManager& sceneManager, ViewManager& viewManager)
+{
+	std::vector<ViewManager::CAMERA_POSE> poses;
+	if (LoadCameraScript(m_settings.cameraScript, viewManager.GetCameraPose(), poses) == false)
+	{
+		return(false);
+	}
+	if (poses.empty())
+	{
+		std::cout << "The camera script has no poses:" << m_settings.cameraScript << std::endl;
+		return(false);
+	}
+	if (FileUtilities::CreateDirectoryPath(m_settings.outputDirectory) == false)
+	{
+		std::cout << "Could not create the output directory:" << m_settings.outputDirectory << std::endl;
+		return(false);
+	}
+
+	// EXR images keep the colors brighter than one
+	bool bEXR = (m_settings.format == ImageWriter::IMAGE_FORMAT_EXR);
+	m_renderTargets.SetColorFormat(bEXR ? GL_RGBA16F : GL_RGBA8);
+	if (m_renderTargets.Resize(m_settings.width, m_settings.height) == false)
+	{
+		return(false);
+	}
+	m_imageBytes = (size_t)m_settings.width * m_settings.height * (bEXR ? 8 : 4);
+	CreateReadbackBuffers();
+	m_imageWriter.Initialize(m_settings.writerThreads);
+
+	viewManager.SetViewSize(m_settings.width, m_settings.height);
+	sceneManager.FinishTextureLoads();
+
+	int pendingSlot = -1;
+	for (int i = 0; i < (int)poses.size(); i++)
+	{
+		glfwPollEvents();
+
+		viewManager.SetCameraPose(poses[i]);
+		viewManager.PrepareSceneView(1.0f);
+		sceneManager.SetSceneView(
+			viewManager.GetViewMatrix(),
+			viewManager.GetProjectionMatrix());
+
+		glEnable(GL_DEPTH_TEST);
+		m_renderTargets.BeginScene();
+		sceneManager.RenderScene();
+
+		int slot = i % READBACK_SLOT_COUNT;
+		StartReadback(slot, i);
+		// the image before this one had the whole of this
+		// image's drawing to finish its readback in
+		if (pendingSlot >= 0)
+		{
+			FinishReadback(pendingSlot);
+		}
+		pendingSlot = slot;
+
+		if ((i + 1) % PROGRESS_INTERVAL == 0)
+		{
+			std::cout << "INFO: Rendered " << (i + 1) << " of " << poses.size() << " images" << std::endl;
+		}
+	}
+	FinishReadback(pendingSlot);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	m_imageWriter.WaitForAll();
+	viewManager.SetViewSize(0, 0);
+	std::cout << "INFO: Wrote " << m_imageWriter.GetWrittenCount() << " images to "
+		<< m_settings.outputDirectory << ", " << (m_imageWriter.GetFailedCount() + m_failedReadbacks) << " failed" << std::endl;
+
+	return((m_imageWriter.GetFailedCount() == 0) && (m_failedReadbacks == 0));
+}
+
+/***********************************************************
+ *  CreateReadbackBuffers()
+ *
+ *  This method is used for creating the pixel buffers the
+ *  images are read back into, sized for one whole image.
+ ***********************************************************/
+void OfflineRenderer::CreateReadbackBuffers()
+{
+	for (int i = 0; i < READBACK_SLOT_COUNT; i++)
+	{
+		glGenBuffers(1, &m_slots[i].bufferID);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_slots[i].bufferID);
+		glBufferData(GL_PIXEL_PACK_BUFFER, m_imageBytes, NULL, GL_STREAM_READ);
+		m_slots[i].fence = 0;
+		m_slots[i].imageIndex = -1;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DestroyReadbackBuffers()
+ *
+ *  This method is used for freeing the readback pixel
+ *  buffers and their fences.
+ ***********************************************************/
+void OfflineRenderer::DestroyReadbackBuffers()
+{
+	for (int i = 0; i < READBACK_SLOT_COUNT; i++)
+	{
+		if (0 != m_slots[i].fence)
+		{
+			glDeleteSync(m_slots[i].fence);
+			m_slots[i].fence = 0;
+		}
+		if (0 != m_slots[i].bufferID)
+		{
+			glDeleteBuffers(1, &m_slots[i].bufferID);
+			m_slots[i].bufferID = 0;
+		}
+		m_slots[i].imageIndex = -1;
+	}
+}
+
+/***********************************************************
+ *  StartReadback()
+ *
+ *  This method is used for queueing the copy of the drawn
+ *  scene color into a pixel buffer.  With a pixel buffer
+ *  bound, glReadPixels returns without waiting for the image
+ *  to be drawn, and the fence marks when the copy is done.
+ ***********************************************************/
+void OfflineRenderer::StartReadback(int slotIndex, int imageIndex)
+{
+	READBACK_SLOT& slot = m_slots[slotIndex];
+	bool bEXR = (m_settings.format == ImageWriter::IMAGE_FORMAT_EXR);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_renderTargets.GetFramebufferID());
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.bufferID);
+	glReadPixels(
+		0, 0, m_settings.width, m_settings.height,
+		GL_RGBA,
+		bEXR ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE,
+		0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.imageIndex = imageIndex;
+}
+
+/***********************************************************
+ *  FinishReadback()
+ *
+ *  This method is used for waiting on the readback of a
+ *  pixel buffer, copying the image out of it and queueing it
+ *  to be encoded and written by the image writer threads.
+ ***********************************************************/
+void OfflineRenderer::FinishReadback(int slotIndex)
+{
+	READBACK_SLOT& slot = m_slots[slotIndex];
+	if (slot.imageIndex < 0)
+	{
+		return;
+	}
+
+	if (0 != slot.fence)
+	{
+		GLenum result = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, READBACK_WAIT_NANOSECONDS);
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(slot.fence, 0, READBACK_WAIT_NANOSECONDS);
+		}
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+	}
+
+	std::vector<unsigned char> pixels(m_imageBytes);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.bufferID);
+	const void* pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, m_imageBytes, GL_MAP_READ_BIT);
+	if (NULL != pMapped)
+	{
+		memcpy(&pixels[0], pMapped, m_imageBytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (NULL != pMapped)
+	{
+		m_imageWriter.QueueImage(
+			GetImageFilename(slot.imageIndex),
+			m_settings.format,
+			m_settings.width,
+			m_settings.height,
+			pixels);
+	}
+	else
+	{
+		std::cout << "Could not map the readback of image " << slot.imageIndex << std::endl;
+		m_failedReadbacks++;
+	}
+	slot.imageIndex = -1;
+}
+
+/***********************************************************
+ *  GetImageFilename()
+ *
+ *  This method is used for getting the numbered file in the
+ *  output directory the image of a pose is written to.
+ ***********************************************************/
+std::string OfflineRenderer::GetImageFilename(int imageIndex) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "/frame_%05d.%s", imageIndex,
+		(m_settings.format == ImageWriter::IMAGE_FORMAT_EXR) ? "exr" : "png");
+	return(m_settings.outputDirectory + name);
+}
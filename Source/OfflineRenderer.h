@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// offlinerenderer.h
+// ============
+// render the scene from a camera script into numbered image files
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ImageWriter.h"
+#include "RenderTargets.h"
+#include "SceneManager.h"
+#include "ViewManager.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  OfflineRenderer
+ *
+ *  This class contains a batch render of the scene from each
+ *  camera pose of a camera script into its own image file.
+ *  The images are drawn offscreen at their own size, so the
+ *  window is never shown.  Each image is read back into one
+ *  of two pixel buffers while the next image is drawn, and is
+ *  only mapped once the image after it has been submitted,
+ *  so the GPU always has a frame queued instead of waiting
+ *  on the readback.  The encoding and the disk writes run on
+ *  the image writer threads.
+ ***********************************************************/
+class OfflineRenderer
+{
+public:
+	// options of an offline render
+	struct OFFLINE_SETTINGS
+	{
+		// camera script with one pose per rendered image
+		std::string cameraScript;
+		// directory the numbered images are written into
+		std::string outputDirectory = "renders";
+		// file format and pixel size of the images
+		int format = ImageWriter::IMAGE_FORMAT_PNG;
+		int width = 1920;
+		int height = 1080;
+		// image writer threads, 0 picks the thread count
+		int writerThreads = 0;
+	};
+
+	// constructor
+	OfflineRenderer(const OFFLINE_SETTINGS& settings);
+	// destructor
+	~OfflineRenderer();
+
+	// read the camera poses of a camera script, where each pose
+	// starts from the one before it and the first from the
+	// passed in pose
+	static bool LoadCameraScript(
+		const std::string& filename,
+		const ViewManager::CAMERA_POSE& initialPose,
+		std::vector<ViewManager::CAMERA_POSE>& poses);
+
+	// render and write the image of every pose of the camera
+	// script, returning false when any image was not written
+	bool Run(SceneManager& sceneManager, ViewManager& viewManager);
+
+private:
+	// pixel buffer an image is read back into, with the fence
+	// of the readback and the image it holds, -1 for none
+	struct READBACK_SLOT
+	{
+		GLuint bufferID;
+		GLsync fence;
+		int imageIndex;
+	};
+
+	enum
+	{
+		READBACK_SLOT_COUNT = 2
+	};
+
+	OFFLINE_SETTINGS m_settings;
+	RenderTargets m_renderTargets;
+	ImageWriter m_imageWriter;
+	READBACK_SLOT m_slots[READBACK_SLOT_COUNT];
+	size_t m_imageBytes;
+	int m_failedReadbacks;
+
+	// create and free the readback pixel buffers
+	void CreateReadbackBuffers();
+	void DestroyReadbackBuffers();
+	// start reading the drawn image back into a pixel buffer
+	void StartReadback(int slotIndex, int imageIndex);
+	// wait for a readback and queue its image to be written
+	void FinishReadback(int slotIndex);
+	// get the file the image of a pose is written to
+	std::string GetImageFilename(int imageIndex) const;
+};
@@ -0,0 +1,180 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.cpp
+// ============
+// collect and sort the render items of a frame before they are drawn
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+// declaration of global variables
+namespace
+{
+	// bit widths of the sort key fields
+	const int DEPTH_BITS = 24;
+	const int MESH_BITS = 8;
+	const int MATERIAL_BITS = 12;
+	const int TEXTURE_BITS = 12;
+	const int PROGRAM_BITS = 6;
+
+	const uint64_t DEPTH_MASK = (1ull << DEPTH_BITS) - 1;
+	const uint64_t MESH_MASK = (1ull << MESH_BITS) - 1;
+	const uint64_t MATERIAL_MASK = (1ull << MATERIAL_BITS) - 1;
+	const uint64_t TEXTURE_MASK = (1ull << TEXTURE_BITS) - 1;
+	const uint64_t PROGRAM_MASK = (1ull << PROGRAM_BITS) - 1;
+
+	// the transparency flag is the highest bit so that all the
+	// blended draws are sorted after all the opaque draws
+	const int TRANSPARENT_SHIFT = 63;
+
+	/***********************************************************
+	 *  CompareEntries()
+	 *
+	 *  Orders queue entries by sort key, keeping the authoring
+	 *  order of render items that have identical keys.
+	 ***********************************************************/
+	bool CompareEntries(const RenderQueue::QUEUE_ENTRY& a, const RenderQueue::QUEUE_ENTRY& b)
+	{
+		if (a.sortKey != b.sortKey)
+		{
+			return(a.sortKey < b.sortKey);
+		}
+		return(a.itemIndex < b.itemIndex);
+	}
+}
+
+/***********************************************************
+ *  RenderQueue()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderQueue::RenderQueue()
+{
+}
+
+/***********************************************************
+ *  ~RenderQueue()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderQueue::~RenderQueue()
+{
+}
+
+/***********************************************************
+ *  Begin()
+ *
+ *  This method is used for removing the draws of the last
+ *  frame and making room for the draws of this frame in the
+ *  frame arena, which must have been reset since the last.
+ ***********************************************************/
+void RenderQueue::Begin(FrameArena& arena, int capacity)
+{
+	m_entries.Allocate(arena, capacity);
+}
+
+/***********************************************************
+ *  Push()
+ *
+ *  This method is used for adding the draw of a render item
+ *  with its packed sort key.
+ ***********************************************************/
+void RenderQueue::Push(uint64_t sortKey, int itemIndex)
+{
+	QUEUE_ENTRY entry;
+
+	entry.sortKey = sortKey;
+	entry.itemIndex = itemIndex;
+	m_entries.Push(entry);
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the number of collected
+ *  draws before they are filled in with SetEntry().
+ ***********************************************************/
+void RenderQueue::Resize(int count)
+{
+	m_entries.Resize(count);
+}
+
+/***********************************************************
+ *  SetEntry()
+ *
+ *  This method is used for setting the draw at a queue
+ *  index.  Separate indices may be set from separate threads.
+ ***********************************************************/
+void RenderQueue::SetEntry(int queueIndex, uint64_t sortKey, int itemIndex)
+{
+	m_entries[queueIndex].sortKey = sortKey;
+	m_entries[queueIndex].itemIndex = itemIndex;
+}
+
+/***********************************************************
+ *  Sort()
+ *
+ *  This method is used for ordering the collected draws by
+ *  their sort keys.
+ ***********************************************************/
+void RenderQueue::Sort()
+{
+	std::sort(m_entries.GetData(), m_entries.GetData() + m_entries.GetCount(), CompareEntries);
+}
+
+/***********************************************************
+ *  MakeSortKey()
+ *
+ *  This method is used for packing the draw state and view
+ *  depth of a render item into a 64-bit sort key.
+ *
+ *  opaque:  | 0 | program | texture | material | mesh | depth |
+ *  blended: | 1 | inverted depth | program | texture | material | mesh |
+ *
+ *  The texture field stores the slot plus one so that solid
+ *  color draws, which have no slot, share the value zero.
+ *  The program field is the most significant state, since
+ *  switching shader programs costs the most.
+ ***********************************************************/
+uint64_t RenderQueue::MakeSortKey(
+	bool bTransparent,
+	int programIndex,
+	int textureSlot,
+	int materialIndex,
+	int meshID,
+	float viewDepth,
+	float farDepth)
+{
+	uint64_t program = (uint64_t)programIndex & PROGRAM_MASK;
+	uint64_t texture = (uint64_t)(textureSlot + 1) & TEXTURE_MASK;
+	uint64_t material = (uint64_t)(materialIndex + 1) & MATERIAL_MASK;
+	uint64_t mesh = (uint64_t)meshID & MESH_MASK;
+
+	// quantize the view depth into the depth field
+	float depthRatio = (farDepth > 0.0f) ? (viewDepth / farDepth) : 0.0f;
+	if (depthRatio < 0.0f)
+		depthRatio = 0.0f;
+	if (depthRatio > 1.0f)
+		depthRatio = 1.0f;
+	uint64_t depth = (uint64_t)(depthRatio * (float)DEPTH_MASK) & DEPTH_MASK;
+
+	uint64_t state =
+		(program << (TEXTURE_BITS + MATERIAL_BITS + MESH_BITS)) |
+		(texture << (MATERIAL_BITS + MESH_BITS)) |
+		(material << MESH_BITS) |
+		mesh;
+
+	if (bTransparent == false)
+	{
+		// group by state and then draw near to far for early-z
+		return((state << DEPTH_BITS) | depth);
+	}
+
+	// draw far to near so that blending composites correctly
+	return((1ull << TRANSPARENT_SHIFT) |
+		((DEPTH_MASK - depth) << (PROGRAM_BITS + TEXTURE_BITS + MATERIAL_BITS + MESH_BITS)) |
+		state);
+}
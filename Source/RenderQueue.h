@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderqueue.h
+// ============
+// collect and sort the render items of a frame before they are drawn
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameArena.h"
+
+#include <stdint.h>
+
+/***********************************************************
+ *  RenderQueue
+ *
+ *  This class contains the draws collected for one frame,
+ *  each with a packed 64-bit sort key.  Opaque draws are
+ *  grouped by shader program, texture, material and mesh
+ *  and then ordered front to back, while blended draws are
+ *  always ordered back to front after all of the opaque
+ *  draws.  The draws are transient data of the frame, so
+ *  they live in the frame arena.
+ ***********************************************************/
+class RenderQueue
+{
+public:
+	// constructor
+	RenderQueue();
+	// destructor
+	~RenderQueue();
+
+	struct QUEUE_ENTRY
+	{
+		uint64_t sortKey;
+		int itemIndex;
+	};
+
+	// start the draws of a frame in the frame arena, with room
+	// for the passed in number of draws
+	void Begin(FrameArena& arena, int capacity);
+	// add a draw of a render item with its sort key
+	void Push(uint64_t sortKey, int itemIndex);
+	// size the queue so that each draw can be set by its index,
+	// which lets several threads fill separate parts of it
+	void Resize(int count);
+	void SetEntry(int queueIndex, uint64_t sortKey, int itemIndex);
+	// order the collected draws by their sort keys
+	void Sort();
+
+	// get the number of collected draws
+	int GetCount() const { return(m_entries.GetCount()); }
+	// get the render item index of a sorted draw
+	int GetItemIndex(int queueIndex) const { return(m_entries[queueIndex].itemIndex); }
+
+	// pack the draw state and view depth into a sort key
+	static uint64_t MakeSortKey(
+		bool bTransparent,
+		int programIndex,
+		int textureSlot,
+		int materialIndex,
+		int meshID,
+		float viewDepth,
+		float farDepth);
+
+private:
+	// collected draws for the frame
+	ArenaArray<QUEUE_ENTRY> m_entries;
+};
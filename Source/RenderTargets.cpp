@@ -0,0 +1,236 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertargets.cpp
+// ============
+// draw the scene into offscreen targets and present them to the window
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderTargets.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// smallest fraction of the window size the scene is drawn at
+	const float MIN_RENDER_SCALE = 0.25f;
+}
+
+/***********************************************************
+ *  RenderTargets()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderTargets::RenderTargets()
+{
+	m_colorFormat = GL_RGBA8;
+	m_framebufferID = 0;
+	m_colorTextureID = 0;
+	m_depthTextureID = 0;
+	m_width = 0;
+	m_height = 0;
+	m_renderScale = 1.0f;
+	m_renderWidth = 0;
+	m_renderHeight = 0;
+}
+
+/***********************************************************
+ *  ~RenderTargets()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+RenderTargets::~RenderTargets()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for creating the scene color and
+ *  depth textures at the passed in window framebuffer size
+ *  and attaching them to the scene framebuffer.  Targets of
+ *  an earlier size are freed first.  A minimized window has
+ *  a size of zero, which leaves no targets until the next
+ *  resize.  The viewport is set to the whole new window, as
+ *  the window positions of picks are read against it.  It
+ *  returns false when the framebuffer could not be completed,
+ *  and the scene is then drawn straight into the window.
+ ***********************************************************/
+bool RenderTargets::Resize(int width, int height)
+{
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+	UpdateRenderSize();
+	if ((width <= 0) || (height <= 0))
+	{
+		return(false);
+	}
+	glViewport(0, 0, width, height);
+
+	GLint previousTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+
+	// the color is filtered when it is scaled up or sampled
+	glGenTextures(1, &m_colorTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_colorTextureID);
+	glTexStorage2D(GL_TEXTURE_2D, 1, m_colorFormat, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// the depth matches the format the depth pyramid copies into
+	glGenTextures(1, &m_depthTextureID);
+	glBindTexture(GL_TEXTURE_2D, m_depthTextureID);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindTexture(GL_TEXTURE_2D, (GLuint)previousTexture);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTextureID, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_depthTextureID, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "ERROR::RENDER_TARGETS::FRAMEBUFFER_INCOMPLETE: " << status << std::endl;
+		Destroy();
+		m_width = width;
+		m_height = height;
+		UpdateRenderSize();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the scene framebuffer and
+ *  its textures.
+ ***********************************************************/
+void RenderTargets::Destroy()
+{
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (0 != m_colorTextureID)
+	{
+		glDeleteTextures(1, &m_colorTextureID);
+		m_colorTextureID = 0;
+	}
+	if (0 != m_depthTextureID)
+	{
+		glDeleteTextures(1, &m_depthTextureID);
+		m_depthTextureID = 0;
+	}
+}
+
+/***********************************************************
+ *  SetRenderScale()
+ *
+ *  This method is used for setting the fraction of the
+ *  window size the next scenes are drawn at.
+ ***********************************************************/
+void RenderTargets::SetRenderScale(float renderScale)
+{
+	if (renderScale < MIN_RENDER_SCALE)
+	{
+		renderScale = MIN_RENDER_SCALE;
+	}
+	else if (renderScale > 1.0f)
+	{
+		renderScale = 1.0f;
+	}
+
+	m_renderScale = renderScale;
+	UpdateRenderSize();
+}
+
+/***********************************************************
+ *  UpdateRenderSize()
+ *
+ *  This method is used for sizing the scene viewport from
+ *  the window framebuffer size and the render scale, never
+ *  below one pixel while there is a window to draw into.
+ ***********************************************************/
+void RenderTargets::UpdateRenderSize()
+{
+	m_renderWidth = (int)(m_width * m_renderScale + 0.5f);
+	m_renderHeight = (int)(m_height * m_renderScale + 0.5f);
+	if ((m_width > 0) && (m_renderWidth < 1))
+	{
+		m_renderWidth = 1;
+	}
+	if ((m_height > 0) && (m_renderHeight < 1))
+	{
+		m_renderHeight = 1;
+	}
+}
+
+/***********************************************************
+ *  BeginScene()
+ *
+ *  This method is used for binding the scene framebuffer
+ *  with the scaled viewport and clearing its color and
+ *  depth.  Without targets the scene is drawn straight into
+ *  the whole window.
+ ***********************************************************/
+void RenderTargets::BeginScene()
+{
+	if (0 != m_framebufferID)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+		glViewport(0, 0, m_renderWidth, m_renderHeight);
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, m_width, m_height);
+	}
+
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+/***********************************************************
+ *  Present()
+ *
+ *  This method is used for scaling the drawn corner of the
+ *  scene color up to the whole window framebuffer, which is
+ *  left bound with its full viewport for the overlays drawn
+ *  after the scene.  The scene depth is not copied.
+ ***********************************************************/
+void RenderTargets::Present()
+{
+	if (0 != m_framebufferID)
+	{
+		bool bScaled = (m_renderWidth != m_width) || (m_renderHeight != m_height);
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebufferID);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glBlitFramebuffer(
+			0, 0, m_renderWidth, m_renderHeight,
+			0, 0, m_width, m_height,
+			GL_COLOR_BUFFER_BIT,
+			bScaled ? GL_LINEAR : GL_NEAREST);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, m_width, m_height);
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// rendertargets.h
+// ============
+// draw the scene into offscreen targets and present them to the window
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  RenderTargets
+ *
+ *  This class contains the color and depth textures the scene
+ *  is drawn into instead of the window framebuffer.  They are
+ *  created at the size of the window framebuffer and the scene
+ *  is drawn into a corner of them scaled by the render scale,
+ *  so the scale can change every frame without the targets
+ *  being created again.  Presenting scales that corner up to
+ *  the whole window with a framebuffer blit.  The textures are
+ *  kept for later passes to sample, which must scale their
+ *  texture coordinates by the render scale as well.
+ ***********************************************************/
+class RenderTargets
+{
+public:
+	// constructor
+	RenderTargets();
+	// destructor
+	~RenderTargets();
+
+	// set the format of the scene color, before Resize()
+	void SetColorFormat(GLenum colorFormat) { m_colorFormat = colorFormat; }
+	// create the targets for a window framebuffer size, freeing
+	// any earlier ones - a size of zero only frees them
+	bool Resize(int width, int height);
+	// free the targets
+	void Destroy();
+	// check if the targets were created
+	bool IsReady() const { return(0 != m_framebufferID); }
+
+	// set the fraction of the window size the scene is drawn at
+	void SetRenderScale(float renderScale);
+	float GetRenderScale() const { return(m_renderScale); }
+	// get the window framebuffer size and the scaled scene size
+	int GetWidth() const { return(m_width); }
+	int GetHeight() const { return(m_height); }
+	int GetRenderWidth() const { return(m_renderWidth); }
+	int GetRenderHeight() const { return(m_renderHeight); }
+
+	// bind the scene target with the scaled viewport and clear it
+	void BeginScene();
+	// scale the scene color up into the window framebuffer and
+	// leave it bound with the viewport of the whole window
+	void Present();
+
+	// get the framebuffer and textures the scene was drawn into
+	GLuint GetFramebufferID() const { return(m_framebufferID); }
+	GLuint GetColorTextureID() const { return(m_colorTextureID); }
+	GLuint GetDepthTextureID() const { return(m_depthTextureID); }
+
+private:
+	GLenum m_colorFormat;
+	GLuint m_framebufferID;
+	GLuint m_colorTextureID;
+	GLuint m_depthTextureID;
+	int m_width;
+	int m_height;
+	float m_renderScale;
+	int m_renderWidth;
+	int m_renderHeight;
+
+	// size the scaled scene viewport from the render scale
+	void UpdateRenderSize();
+};
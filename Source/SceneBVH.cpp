@@ -0,0 +1,448 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.cpp
+// ============
+// bounding volume hierarchy over the render items of the 3D scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// the build splits at the median so the tree is balanced
+	// and its depth stays far below the traversal stack size
+	const int TRAVERSAL_STACK_SIZE = 64;
+
+	// check if a ray hits a box, returning the entry distance
+	bool IntersectRayBox(
+		const glm::vec3& origin,
+		const glm::vec3& inverseDirection,
+		const glm::vec3& minimum,
+		const glm::vec3& maximum,
+		float maxDistance,
+		float& entryDistance)
+	{
+		float tNear = 0.0f;
+		float tFar = maxDistance;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float t0 = (minimum[axis] - origin[axis]) * inverseDirection[axis];
+			float t1 = (maximum[axis] - origin[axis]) * inverseDirection[axis];
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			tNear = std::max(tNear, t0);
+			tFar = std::min(tFar, t1);
+			if (tNear > tFar)
+			{
+				return(false);
+			}
+		}
+
+		entryDistance = tNear;
+		return(true);
+	}
+
+	// check if a ray hits a sphere, returning the hit distance
+	bool IntersectRaySphere(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		const glm::vec3& center,
+		float radius,
+		float& distance)
+	{
+		glm::vec3 toCenter = center - origin;
+		float along = glm::dot(toCenter, direction);
+		float distanceSquared = glm::dot(toCenter, toCenter) - along * along;
+		float radiusSquared = radius * radius;
+
+		if (distanceSquared > radiusSquared)
+		{
+			return(false);
+		}
+
+		float halfChord = sqrtf(radiusSquared - distanceSquared);
+		distance = along - halfChord;
+		if (distance < 0.0f)
+		{
+			// the ray starts inside of the sphere
+			distance = along + halfChord;
+		}
+
+		return(distance >= 0.0f);
+	}
+}
+
+/***********************************************************
+ *  SceneBVH()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneBVH::SceneBVH()
+{
+}
+
+/***********************************************************
+ *  ~SceneBVH()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneBVH::~SceneBVH()
+{
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree over the passed
+ *  in item bounding spheres from scratch.  It only needs to
+ *  be called when items are added or removed, moved items
+ *  are handled by Refit().
+ ***********************************************************/
+void SceneBVH::Build(const std::vector<glm::vec3>& centers, const std::vector<float>& radii)
+{
+	int itemCount = (int)centers.size();
+	std::vector<int> items(itemCount);
+
+	m_nodes.clear();
+	m_leafNodes.assign(itemCount, -1);
+
+	if (itemCount == 0)
+	{
+		return;
+	}
+
+	m_nodes.reserve(itemCount * 2 - 1);
+	for (int i = 0; i < itemCount; i++)
+	{
+		items[i] = i;
+	}
+
+	BuildNode(items, 0, itemCount, -1, centers, radii);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the subtree over a range
+ *  of items by splitting them at the median center along the
+ *  longest axis of their center bounds.
+ ***********************************************************/
+int SceneBVH::BuildNode(std::vector<int>& items, int first, int count, int parent,
+	const std::vector<glm::vec3>& centers, const std::vector<float>& radii)
+{
+	int nodeIndex = (int)m_nodes.size();
+	BVH_NODE node;
+
+	node.parent = parent;
+	node.left = -1;
+	node.right = -1;
+	node.itemIndex = -1;
+	node.center = glm::vec3(0.0f);
+	node.radius = 0.0f;
+	m_nodes.push_back(node);
+
+	if (count == 1)
+	{
+		int item = items[first];
+		BVH_NODE& leaf = m_nodes[nodeIndex];
+		leaf.itemIndex = item;
+		leaf.center = centers[item];
+		leaf.radius = radii[item];
+		leaf.minimum = centers[item] - glm::vec3(radii[item]);
+		leaf.maximum = centers[item] + glm::vec3(radii[item]);
+		m_leafNodes[item] = nodeIndex;
+		return(nodeIndex);
+	}
+
+	// split along the axis the centers are spread out the most
+	glm::vec3 centerMin = centers[items[first]];
+	glm::vec3 centerMax = centerMin;
+	for (int i = first + 1; i < first + count; i++)
+	{
+		centerMin = glm::min(centerMin, centers[items[i]]);
+		centerMax = glm::max(centerMax, centers[items[i]]);
+	}
+	glm::vec3 spread = centerMax - centerMin;
+	int axis = 0;
+	if (spread.y > spread[axis])
+	{
+		axis = 1;
+	}
+	if (spread.z > spread[axis])
+	{
+		axis = 2;
+	}
+
+	int half = count / 2;
+	std::nth_element(
+		items.begin() + first,
+		items.begin() + first + half,
+		items.begin() + first + count,
+		[&centers, axis](int a, int b)
+		{
+			return(centers[a][axis] < centers[b][axis]);
+		});
+
+	int left = BuildNode(items, first, half, nodeIndex, centers, radii);
+	int right = BuildNode(items, first + half, count - half, nodeIndex, centers, radii);
+
+	m_nodes[nodeIndex].left = left;
+	m_nodes[nodeIndex].right = right;
+	UpdateNodeBox(nodeIndex);
+
+	return(nodeIndex);
+}
+
+/***********************************************************
+ *  UpdateNodeBox()
+ *
+ *  This method is used for setting the box of an inner node
+ *  to the union of its child boxes.  It returns true when
+ *  the box changed.
+ ***********************************************************/
+bool SceneBVH::UpdateNodeBox(int nodeIndex)
+{
+	BVH_NODE& node = m_nodes[nodeIndex];
+	const BVH_NODE& left = m_nodes[node.left];
+	const BVH_NODE& right = m_nodes[node.right];
+
+	glm::vec3 minimum = glm::min(left.minimum, right.minimum);
+	glm::vec3 maximum = glm::max(left.maximum, right.maximum);
+
+	if ((minimum == node.minimum) && (maximum == node.maximum))
+	{
+		return(false);
+	}
+
+	node.minimum = minimum;
+	node.maximum = maximum;
+	return(true);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for updating the leaf of a moved item
+ *  and the boxes of its ancestors.  The walk up the tree
+ *  stops at the first ancestor whose box did not change.
+ ***********************************************************/
+void SceneBVH::Refit(int itemIndex, const glm::vec3& center, float radius)
+{
+	if ((itemIndex < 0) || (itemIndex >= (int)m_leafNodes.size()))
+	{
+		return;
+	}
+
+	int nodeIndex = m_leafNodes[itemIndex];
+	BVH_NODE& leaf = m_nodes[nodeIndex];
+	leaf.center = center;
+	leaf.radius = radius;
+	leaf.minimum = center - glm::vec3(radius);
+	leaf.maximum = center + glm::vec3(radius);
+
+	nodeIndex = leaf.parent;
+	while (nodeIndex >= 0)
+	{
+		if (UpdateNodeBox(nodeIndex) == false)
+		{
+			break;
+		}
+		nodeIndex = m_nodes[nodeIndex].parent;
+	}
+}
+
+/***********************************************************
+ *  CollectItems()
+ *
+ *  This method is used for collecting every item below the
+ *  passed in node without any more tests.
+ ***********************************************************/
+void SceneBVH::CollectItems(int nodeIndex, ArenaArray<int>& items) const
+{
+	int stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+
+	stack[stackSize++] = nodeIndex;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		if (node.itemIndex >= 0)
+		{
+			items.Push(node.itemIndex);
+		}
+		else
+		{
+			stack[stackSize++] = node.left;
+			stack[stackSize++] = node.right;
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for collecting the items whose bounds
+ *  are at least partly inside of the passed in frustum.  A
+ *  branch that is completely inside is collected without
+ *  testing its items.  The array is given room for every
+ *  item up front, so it never grows while it is filled.
+ ***********************************************************/
+void SceneBVH::QueryFrustum(const ViewFrustum& frustum, ArenaArray<int>& items) const
+{
+	int stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+
+	items.Clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+	items.Reserve((int)m_leafNodes.size());
+
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		int nodeIndex = stack[--stackSize];
+		const BVH_NODE& node = m_nodes[nodeIndex];
+
+		int containment = frustum.ClassifyBox(node.minimum, node.maximum);
+		if (containment == ViewFrustum::OUTSIDE)
+		{
+			continue;
+		}
+
+		if (node.itemIndex >= 0)
+		{
+			// the sphere is tighter than the leaf box at the corners
+			if ((containment == ViewFrustum::INSIDE) ||
+				frustum.IsSphereVisible(node.center, node.radius))
+			{
+				items.Push(node.itemIndex);
+			}
+		}
+		else if (containment == ViewFrustum::INSIDE)
+		{
+			CollectItems(nodeIndex, items);
+		}
+		else
+		{
+			stack[stackSize++] = node.left;
+			stack[stackSize++] = node.right;
+		}
+	}
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for collecting the items whose bounds
+ *  overlap the passed in sphere, such as the range of a
+ *  light source.
+ ***********************************************************/
+void SceneBVH::QuerySphere(const glm::vec3& center, float radius, std::vector<int>& items) const
+{
+	int stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+
+	items.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+
+		// distance from the sphere center to the node box
+		glm::vec3 closest = glm::clamp(center, node.minimum, node.maximum);
+		glm::vec3 offset = closest - center;
+		if (glm::dot(offset, offset) > radius * radius)
+		{
+			continue;
+		}
+
+		if (node.itemIndex >= 0)
+		{
+			float reach = radius + node.radius;
+			glm::vec3 between = node.center - center;
+			if (glm::dot(between, between) <= reach * reach)
+			{
+				items.push_back(node.itemIndex);
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.left;
+			stack[stackSize++] = node.right;
+		}
+	}
+}
+
+/***********************************************************
+ *  RayCast()
+ *
+ *  This method is used for finding the nearest item whose
+ *  bounding sphere is hit by the passed in ray.  The ray
+ *  direction must be normalized.  Branches that start past
+ *  the nearest hit found so far are skipped.
+ ***********************************************************/
+int SceneBVH::RayCast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const
+{
+	int stack[TRAVERSAL_STACK_SIZE];
+	int stackSize = 0;
+	int nearestItem = -1;
+	float nearestDistance = FLT_MAX;
+
+	if (m_nodes.empty())
+	{
+		return(-1);
+	}
+
+	// a zero direction component becomes an infinite slab step
+	glm::vec3 inverseDirection(
+		(direction.x != 0.0f) ? 1.0f / direction.x : FLT_MAX,
+		(direction.y != 0.0f) ? 1.0f / direction.y : FLT_MAX,
+		(direction.z != 0.0f) ? 1.0f / direction.z : FLT_MAX);
+
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		float entryDistance = 0.0f;
+
+		if (!IntersectRayBox(origin, inverseDirection, node.minimum, node.maximum, nearestDistance, entryDistance))
+		{
+			continue;
+		}
+
+		if (node.itemIndex >= 0)
+		{
+			float hitDistance = 0.0f;
+			if (IntersectRaySphere(origin, direction, node.center, node.radius, hitDistance) &&
+				(hitDistance < nearestDistance))
+			{
+				nearestDistance = hitDistance;
+				nearestItem = node.itemIndex;
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.left;
+			stack[stackSize++] = node.right;
+		}
+	}
+
+	distance = nearestDistance;
+	return(nearestItem);
+}
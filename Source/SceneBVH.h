@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.h
+// ============
+// bounding volume hierarchy over the render items of the 3D scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "FrameArena.h"
+#include "ViewFrustum.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  This class contains a binary tree of axis aligned boxes
+ *  over the bounding spheres of the render items.  The tree
+ *  is built once and then refit from the moved leaf up to
+ *  the root whenever an item's bounds change, so frustum
+ *  culling, ray picking and light range queries only visit
+ *  the branches that can contain a result.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	// constructor
+	SceneBVH();
+	// destructor
+	~SceneBVH();
+
+	// build the tree over the passed in item bounding spheres
+	void Build(const std::vector<glm::vec3>& centers, const std::vector<float>& radii);
+	// refit the tree after the bounds of an item changed
+	void Refit(int itemIndex, const glm::vec3& center, float radius);
+
+	// collect the items whose bounds are inside the frustum into
+	// an array allocated from the frame arena this frame
+	void QueryFrustum(const ViewFrustum& frustum, ArenaArray<int>& items) const;
+	// collect the items whose bounds overlap the sphere
+	void QuerySphere(const glm::vec3& center, float radius, std::vector<int>& items) const;
+	// find the nearest item whose bounds are hit by the ray
+	int RayCast(const glm::vec3& origin, const glm::vec3& direction, float& distance) const;
+
+	// get the number of items in the tree
+	int GetItemCount() const { return((int)m_leafNodes.size()); }
+
+private:
+	// one box of the tree, leaves reference a single item
+	struct BVH_NODE
+	{
+		glm::vec3 minimum;
+		glm::vec3 maximum;
+		int parent;
+		int left;
+		int right;
+		// render item of a leaf, -1 for an inner node
+		int itemIndex;
+		// bounding sphere of a leaf item
+		glm::vec3 center;
+		float radius;
+	};
+
+	// all the tree nodes, the root is the first node
+	std::vector<BVH_NODE> m_nodes;
+	// leaf node of each item
+	std::vector<int> m_leafNodes;
+
+	// build the subtree over a range of the passed in items
+	int BuildNode(std::vector<int>& items, int first, int count, int parent,
+		const std::vector<glm::vec3>& centers, const std::vector<float>& radii);
+	// set a node box to the union of its child boxes
+	bool UpdateNodeBox(int nodeIndex);
+	// collect every item below a node
+	void CollectItems(int nodeIndex, ArenaArray<int>& items) const;
+};
@@ -0,0 +1,560 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// map binary scene files into memory and convert them from the text form
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "FileUtilities.h"
+#include "SceneMeshes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// names of the meshes in the text form
+	struct MESH_NAME
+	{
+		const char* name;
+		int meshID;
+	};
+
+	const MESH_NAME MESH_NAMES[] =
+	{
+		{ "plane", SceneMeshes::MESH_PLANE },
+		{ "box", SceneMeshes::MESH_BOX },
+		{ "box_top", SceneMeshes::MESH_BOX_TOP },
+		{ "cylinder", SceneMeshes::MESH_CYLINDER },
+		{ "cylinder_top", SceneMeshes::MESH_CYLINDER_TOP },
+		{ "cone", SceneMeshes::MESH_CONE },
+		{ "sphere", SceneMeshes::MESH_SPHERE },
+		{ "half_sphere", SceneMeshes::MESH_HALF_SPHERE },
+		{ "torus", SceneMeshes::MESH_TORUS },
+		{ "half_torus", SceneMeshes::MESH_HALF_TORUS },
+		{ "prism", SceneMeshes::MESH_PRISM }
+	};
+
+	// find a mesh ID by its name in the text form, -1 if unknown
+	int FindMeshID(const std::string& name)
+	{
+		for (size_t i = 0; i < sizeof(MESH_NAMES) / sizeof(MESH_NAMES[0]); i++)
+		{
+			if (name == MESH_NAMES[i].name)
+			{
+				return(MESH_NAMES[i].meshID);
+			}
+		}
+		return(-1);
+	}
+
+	// read the passed in number of floats from a text line
+	bool ReadFloats(std::istringstream& line, float* pValues, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (!(line >> pValues[i]))
+			{
+				return(false);
+			}
+		}
+		return(true);
+	}
+
+	// append a string to the string table and return its offset
+	uint32_t AddString(std::string& stringTable, const std::string& value)
+	{
+		uint32_t offset = (uint32_t)stringTable.size();
+		stringTable.append(value);
+		stringTable.push_back('\0');
+		return(offset);
+	}
+
+	// append a record array to the file bytes and return its offset
+	template <typename RECORD>
+	uint32_t AppendRecords(std::vector<unsigned char>& bytes, const std::vector<RECORD>& records)
+	{
+		uint32_t offset = (uint32_t)bytes.size();
+		if (!records.empty())
+		{
+			const unsigned char* pFirst = (const unsigned char*)&records[0];
+			bytes.insert(bytes.end(), pFirst, pFirst + records.size() * sizeof(RECORD));
+		}
+		return(offset);
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_pData = NULL;
+	m_dataBytes = 0;
+	m_pHeader = NULL;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Close();
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method is used for mapping a binary scene file into
+ *  memory.  Only the header is checked, the records are
+ *  paged in by the operating system as they are read, so
+ *  opening takes the same time for any size of scene.
+ ***********************************************************/
+bool SceneFile::Open(const char* filename)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+	{
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	}
+	if (NULL == mapping)
+	{
+		CloseHandle(file);
+		std::cout << "Could not map scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	m_pData = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	m_dataBytes = (size_t)fileSize.QuadPart;
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+#else
+	int file = open(filename, O_RDONLY);
+	if (file < 0)
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	// the mapping stays valid once the file is closed
+	struct stat fileStatus;
+	void* pMapped = MAP_FAILED;
+	if ((fstat(file, &fileStatus) == 0) && (fileStatus.st_size > 0))
+	{
+		pMapped = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	close(file);
+
+	if (MAP_FAILED != pMapped)
+	{
+		m_pData = (const unsigned char*)pMapped;
+		m_dataBytes = (size_t)fileStatus.st_size;
+	}
+#endif
+
+	if (NULL == m_pData)
+	{
+		Close();
+		std::cout << "Could not map scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	m_pHeader = (const SCENE_HEADER*)m_pData;
+	if (false == ValidateHeader())
+	{
+		Close();
+		std::cout << "Scene file is not a valid version " << SCENE_FILE_VERSION
+			<< " scene:" << filename << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Close()
+ *
+ *  This method is used for unmapping the scene file.  The
+ *  records must not be used after it is closed.
+ ***********************************************************/
+void SceneFile::Close()
+{
+#ifdef _WIN32
+	if (NULL != m_pData)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (NULL != m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (NULL != m_fileHandle)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+#else
+	if (NULL != m_pData)
+	{
+		munmap((void*)m_pData, m_dataBytes);
+	}
+#endif
+
+	m_pData = NULL;
+	m_dataBytes = 0;
+	m_pHeader = NULL;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting a string of the string
+ *  table by its offset.  An offset outside of the table
+ *  gives an empty string.
+ ***********************************************************/
+const char* SceneFile::GetString(uint32_t stringOffset) const
+{
+	if ((false == IsOpen()) || (stringOffset >= m_pHeader->stringBytes))
+	{
+		return("");
+	}
+
+	return((const char*)(m_pData + m_pHeader->stringOffset + stringOffset));
+}
+
+/***********************************************************
+ *  IsArrayInFile()
+ *
+ *  This method is used for checking that a record array
+ *  starts on a 4 byte boundary and ends inside of the file.
+ ***********************************************************/
+bool SceneFile::IsArrayInFile(uint32_t offset, uint32_t count, size_t recordBytes) const
+{
+	if ((offset % 4) != 0)
+	{
+		return(false);
+	}
+
+	return(((size_t)offset <= m_dataBytes) &&
+		((size_t)count <= (m_dataBytes - offset) / recordBytes));
+}
+
+/***********************************************************
+ *  ValidateHeader()
+ *
+ *  This method is used for checking the header of the file,
+ *  that every record array lies inside of the file and that
+ *  the string table ends with a terminator, so that no
+ *  string read from the table can run past its end.
+ ***********************************************************/
+bool SceneFile::ValidateHeader() const
+{
+	if (m_dataBytes < sizeof(SCENE_HEADER))
+	{
+		return(false);
+	}
+
+	if ((m_pHeader->magic != SCENE_FILE_MAGIC) ||
+		(m_pHeader->version != SCENE_FILE_VERSION) ||
+		(m_pHeader->fileBytes != m_dataBytes))
+	{
+		return(false);
+	}
+
+	if (!IsArrayInFile(m_pHeader->textureOffset, m_pHeader->textureCount, sizeof(SCENE_TEXTURE)) ||
+		!IsArrayInFile(m_pHeader->materialOffset, m_pHeader->materialCount, sizeof(SCENE_MATERIAL)) ||
+		!IsArrayInFile(m_pHeader->lightOffset, m_pHeader->lightCount, sizeof(SCENE_LIGHT)) ||
+		!IsArrayInFile(m_pHeader->itemOffset, m_pHeader->itemCount, sizeof(SCENE_ITEM)) ||
+		!IsArrayInFile(m_pHeader->stringOffset, m_pHeader->stringBytes, 1))
+	{
+		return(false);
+	}
+
+	return((m_pHeader->stringBytes > 0) &&
+		(m_pData[m_pHeader->stringOffset + m_pHeader->stringBytes - 1] == '\0'));
+}
+
+/***********************************************************
+ *  ConvertTextScene()
+ *
+ *  This method is used for reading a scene in the text form
+ *  and writing it as a binary scene file.  Each line of the
+ *  text form holds one record, and anything after a # is a
+ *  comment:
+ *
+ *  texture <tag> <filename>
+ *  material <tag> ambient r g b strength s diffuse r g b
+ *      specular r g b shininess s
+ *  light position x y z direction x y z spot x y z
+ *      ambient r g b diffuse r g b specular r g b
+ *      focal f intensity i range r
+ *  item <mesh> scale x y z rotation x y z position x y z
+ *      texture <tag> material <tag> color r g b a uvscale u v
+ *
+ *  The values after the tag or mesh of a record are named
+ *  and may be given in any order, or left out for their
+ *  defaults.  Items refer to textures and materials by tag,
+ *  which are resolved into indices while converting.
+ ***********************************************************/
+bool SceneFile::ConvertTextScene(const char* textFilename, const char* sceneFilename)
+{
+	std::ifstream textFile(textFilename);
+	if (!textFile.is_open())
+	{
+		std::cout << "Could not open text scene:" << textFilename << std::endl;
+		return(false);
+	}
+
+	std::vector<SCENE_TEXTURE> textures;
+	std::vector<SCENE_MATERIAL> materials;
+	std::vector<SCENE_LIGHT> lights;
+	std::vector<SCENE_ITEM> items;
+	std::string stringTable;
+	std::unordered_map<std::string, int> textureIndices;
+	std::unordered_map<std::string, int> materialIndices;
+	// the tags of each item, resolved once every line is read
+	std::vector<std::string> itemTextureTags;
+	std::vector<std::string> itemMaterialTags;
+	std::vector<int> itemLines;
+
+	std::string text;
+	int lineNumber = 0;
+	bool bSuccess = true;
+	while (bSuccess && std::getline(textFile, text))
+	{
+		lineNumber++;
+		size_t comment = text.find('#');
+		if (comment != std::string::npos)
+		{
+			text.erase(comment);
+		}
+
+		std::istringstream line(text);
+		std::string kind;
+		if (!(line >> kind))
+		{
+			continue;
+		}
+
+		std::string key;
+		if (kind == "texture")
+		{
+			std::string tag;
+			std::string filename;
+			if (!(line >> tag >> filename))
+			{
+				bSuccess = false;
+				break;
+			}
+			SCENE_TEXTURE texture;
+			texture.tagOffset = AddString(stringTable, tag);
+			texture.filenameOffset = AddString(stringTable, filename);
+			textureIndices[tag] = (int)textures.size();
+			textures.push_back(texture);
+		}
+		else if (kind == "material")
+		{
+			std::string tag;
+			SCENE_MATERIAL material;
+			memset(&material, 0, sizeof(material));
+			if (!(line >> tag))
+			{
+				bSuccess = false;
+				break;
+			}
+			while (bSuccess && (line >> key))
+			{
+				if (key == "ambient")
+					bSuccess = ReadFloats(line, material.ambientColor, 3);
+				else if (key == "strength")
+					bSuccess = ReadFloats(line, &material.ambientStrength, 1);
+				else if (key == "diffuse")
+					bSuccess = ReadFloats(line, material.diffuseColor, 3);
+				else if (key == "specular")
+					bSuccess = ReadFloats(line, material.specularColor, 3);
+				else if (key == "shininess")
+					bSuccess = ReadFloats(line, &material.shininess, 1);
+				else
+					bSuccess = false;
+			}
+			material.tagOffset = AddString(stringTable, tag);
+			materialIndices[tag] = (int)materials.size();
+			materials.push_back(material);
+		}
+		else if (kind == "light")
+		{
+			SCENE_LIGHT light;
+			memset(&light, 0, sizeof(light));
+			while (bSuccess && (line >> key))
+			{
+				if (key == "position")
+					bSuccess = ReadFloats(line, light.position, 3);
+				else if (key == "direction")
+					bSuccess = ReadFloats(line, light.direction, 3);
+				else if (key == "spot")
+					bSuccess = ReadFloats(line, light.spotDirection, 3);
+				else if (key == "ambient")
+					bSuccess = ReadFloats(line, light.ambientColor, 3);
+				else if (key == "diffuse")
+					bSuccess = ReadFloats(line, light.diffuseColor, 3);
+				else if (key == "specular")
+					bSuccess = ReadFloats(line, light.specularColor, 3);
+				else if (key == "focal")
+					bSuccess = ReadFloats(line, &light.focalStrength, 1);
+				else if (key == "intensity")
+					bSuccess = ReadFloats(line, &light.specularIntensity, 1);
+				else if (key == "range")
+					bSuccess = ReadFloats(line, &light.range, 1);
+				else
+					bSuccess = false;
+			}
+			lights.push_back(light);
+		}
+		else if (kind == "item")
+		{
+			std::string meshName;
+			std::string textureTag;
+			std::string materialTag;
+			SCENE_ITEM item;
+			memset(&item, 0, sizeof(item));
+			item.scale[0] = item.scale[1] = item.scale[2] = 1.0f;
+			item.color[0] = item.color[1] = item.color[2] = item.color[3] = 1.0f;
+			item.uvScale[0] = item.uvScale[1] = 1.0f;
+
+			if (!(line >> meshName) || ((item.meshID = FindMeshID(meshName)) < 0))
+			{
+				bSuccess = false;
+				break;
+			}
+			while (bSuccess && (line >> key))
+			{
+				if (key == "scale")
+					bSuccess = ReadFloats(line, item.scale, 3);
+				else if (key == "rotation")
+					bSuccess = ReadFloats(line, item.rotationDegrees, 3);
+				else if (key == "position")
+					bSuccess = ReadFloats(line, item.position, 3);
+				else if (key == "color")
+					bSuccess = ReadFloats(line, item.color, 4);
+				else if (key == "uvscale")
+					bSuccess = ReadFloats(line, item.uvScale, 2);
+				else if (key == "texture")
+					bSuccess = (bool)(line >> textureTag);
+				else if (key == "material")
+					bSuccess = (bool)(line >> materialTag);
+				else
+					bSuccess = false;
+			}
+			items.push_back(item);
+			itemTextureTags.push_back(textureTag);
+			itemMaterialTags.push_back(materialTag);
+			itemLines.push_back(lineNumber);
+		}
+		else
+		{
+			bSuccess = false;
+		}
+	}
+
+	if (false == bSuccess)
+	{
+		std::cout << "Could not read line " << lineNumber << " of text scene:" << textFilename << std::endl;
+		return(false);
+	}
+
+	// resolve the item tags now that every tag is defined
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		items[i].textureIndex = -1;
+		items[i].materialIndex = -1;
+		if (!itemTextureTags[i].empty())
+		{
+			std::unordered_map<std::string, int>::const_iterator found = textureIndices.find(itemTextureTags[i]);
+			if (found == textureIndices.end())
+			{
+				std::cout << "Unknown texture " << itemTextureTags[i] << " on line " << itemLines[i]
+					<< " of text scene:" << textFilename << std::endl;
+				return(false);
+			}
+			items[i].textureIndex = found->second;
+		}
+		if (!itemMaterialTags[i].empty())
+		{
+			std::unordered_map<std::string, int>::const_iterator found = materialIndices.find(itemMaterialTags[i]);
+			if (found == materialIndices.end())
+			{
+				std::cout << "Unknown material " << itemMaterialTags[i] << " on line " << itemLines[i]
+					<< " of text scene:" << textFilename << std::endl;
+				return(false);
+			}
+			items[i].materialIndex = found->second;
+		}
+	}
+
+	// every record is a multiple of 4 bytes, so the arrays
+	// placed back to back all start on a 4 byte boundary
+	std::vector<unsigned char> bytes(sizeof(SCENE_HEADER));
+	SCENE_HEADER header;
+	header.magic = SCENE_FILE_MAGIC;
+	header.version = SCENE_FILE_VERSION;
+	header.textureCount = (uint32_t)textures.size();
+	header.textureOffset = AppendRecords(bytes, textures);
+	header.materialCount = (uint32_t)materials.size();
+	header.materialOffset = AppendRecords(bytes, materials);
+	header.lightCount = (uint32_t)lights.size();
+	header.lightOffset = AppendRecords(bytes, lights);
+	header.itemCount = (uint32_t)items.size();
+	header.itemOffset = AppendRecords(bytes, items);
+	stringTable.push_back('\0');
+	header.stringBytes = (uint32_t)stringTable.size();
+	header.stringOffset = (uint32_t)bytes.size();
+	bytes.insert(bytes.end(), stringTable.begin(), stringTable.end());
+	header.fileBytes = (uint32_t)bytes.size();
+	memcpy(&bytes[0], &header, sizeof(header));
+
+	if (!FileUtilities::WriteFileAtomic(sceneFilename, &bytes[0], bytes.size()))
+	{
+		std::cout << "Could not write scene file:" << sceneFilename << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// map binary scene files into memory and convert them from the text form
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains a binary scene file mapped into
+ *  memory.  The file is a header followed by fixed size
+ *  records for the textures, materials, lights and render
+ *  items and a table of the strings they refer to, so the
+ *  records are read in place with no parsing.  Records refer
+ *  to each other by index and to strings by offset.  The
+ *  binary files are written from an editable text form.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// identifies a scene file, the version must be raised
+	// whenever the layout of any record changes
+	static const uint32_t SCENE_FILE_MAGIC = 0x454e4353;
+	static const uint32_t SCENE_FILE_VERSION = 1;
+
+	// leading record of the file, with the byte offset from the
+	// start of the file and the count of each record array
+	struct SCENE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t fileBytes;
+		uint32_t textureCount;
+		uint32_t textureOffset;
+		uint32_t materialCount;
+		uint32_t materialOffset;
+		uint32_t lightCount;
+		uint32_t lightOffset;
+		uint32_t itemCount;
+		uint32_t itemOffset;
+		uint32_t stringBytes;
+		uint32_t stringOffset;
+	};
+
+	// texture image to load and the tag it is known by
+	struct SCENE_TEXTURE
+	{
+		uint32_t tagOffset;
+		uint32_t filenameOffset;
+	};
+
+	// object material, matching SceneManager::OBJECT_MATERIAL
+	struct SCENE_MATERIAL
+	{
+		uint32_t tagOffset;
+		float ambientColor[3];
+		float ambientStrength;
+		float diffuseColor[3];
+		float specularColor[3];
+		float shininess;
+	};
+
+	// light source, matching LightManager::LIGHT_SOURCE
+	struct SCENE_LIGHT
+	{
+		float position[3];
+		float direction[3];
+		float spotDirection[3];
+		float ambientColor[3];
+		float diffuseColor[3];
+		float specularColor[3];
+		float focalStrength;
+		float specularIntensity;
+		float range;
+	};
+
+	// render item, the texture and material are indices into
+	// the records of the file, -1 for none
+	struct SCENE_ITEM
+	{
+		int32_t meshID;
+		int32_t textureIndex;
+		int32_t materialIndex;
+		float scale[3];
+		float rotationDegrees[3];
+		float position[3];
+		float color[4];
+		float uvScale[2];
+	};
+
+	// map a binary scene file and check its header
+	bool Open(const char* filename);
+	// unmap the scene file
+	void Close();
+	bool IsOpen() const { return(NULL != m_pHeader); }
+
+	// get the record arrays of the mapped file
+	uint32_t GetTextureCount() const { return(IsOpen() ? m_pHeader->textureCount : 0); }
+	const SCENE_TEXTURE* GetTextures() const { return((const SCENE_TEXTURE*)GetRecords(m_pHeader->textureOffset)); }
+	uint32_t GetMaterialCount() const { return(IsOpen() ? m_pHeader->materialCount : 0); }
+	const SCENE_MATERIAL* GetMaterials() const { return((const SCENE_MATERIAL*)GetRecords(m_pHeader->materialOffset)); }
+	uint32_t GetLightCount() const { return(IsOpen() ? m_pHeader->lightCount : 0); }
+	const SCENE_LIGHT* GetLights() const { return((const SCENE_LIGHT*)GetRecords(m_pHeader->lightOffset)); }
+	uint32_t GetItemCount() const { return(IsOpen() ? m_pHeader->itemCount : 0); }
+	const SCENE_ITEM* GetItems() const { return((const SCENE_ITEM*)GetRecords(m_pHeader->itemOffset)); }
+	// get a string of the string table by its offset
+	const char* GetString(uint32_t stringOffset) const;
+
+	// write the binary scene file for a text scene file
+	static bool ConvertTextScene(const char* textFilename, const char* sceneFilename);
+
+private:
+	// mapped bytes of the file and the header at their start
+	const unsigned char* m_pData;
+	size_t m_dataBytes;
+	const SCENE_HEADER* m_pHeader;
+	// operating system handles of the open file and mapping
+	void* m_fileHandle;
+	void* m_mappingHandle;
+
+	// get the address of a record array in the mapped file
+	const void* GetRecords(uint32_t offset) const { return(m_pData + offset); }
+	// check that the header matches and its arrays fit the file
+	bool ValidateHeader() const;
+	// check that a record array lies inside of the file
+	bool IsArrayInFile(uint32_t offset, uint32_t count, size_t recordBytes) const;
+};
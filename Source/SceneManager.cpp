@@ -8,6 +8,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "ShaderCompiler.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -19,11 +20,53 @@
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
 	const char* g_UseLightingName = "bUseLighting";
+
+	// maximum number of materials in the material uniform
+	// buffer - must match MAX_MATERIALS in the fragment shader
+	const int MAX_MATERIALS = 256;
+	// uniform buffer binding point of the material block
+	const GLuint MATERIAL_BLOCK_BINDING = 0;
+
+	// view depth mapped to the end of the sort key depth range,
+	// matching the far plane of the projections in ViewManager
+	const float SORT_FAR_DEPTH = 100.0f;
+	// render items or queue entries handed to one job of the
+	// frame preparation, smaller scenes run on a single thread
+	const int JOB_GRAIN_SIZE = 512;
+	// bytes of dynamic data each frame starts out with room for,
+	// the frame data buffer grows when a frame needs more
+	const size_t INITIAL_FRAME_DATA_BYTES = 256 * 1024;
+	// file the generated meshes are cached in between launches
+	const char* MESH_CACHE_FILENAME = "scene_meshes.cache";
+	// depth only shaders the shadow maps and the depth prepass
+	// are drawn with
+	const char* SHADOW_VERTEX_SHADER = "shaders/shadowVertexShader.glsl";
+	const char* DEPTH_VERTEX_SHADER = "shaders/depthVertexShader.glsl";
+	const char* DEPTH_ONLY_FRAGMENT_SHADER = "shaders/shadowFragmentShader.glsl";
+	// compute shaders of the occlusion culling
+	const char* OCCLUSION_CULL_SHADER = "shaders/occlusionCullComputeShader.glsl";
+	const char* DEPTH_PYRAMID_SHADER = "shaders/depthPyramidComputeShader.glsl";
+	// arrays each frame allocates from the frame arena, each of
+	// which may need up to this many bytes of alignment padding
+	const int FRAME_ARENA_ARRAY_COUNT = 5 + ShadowManager::SHADOW_VIEW_COUNT;
+	const size_t FRAME_ARENA_ALIGNMENT = 16;
+
+	/***********************************************************
+	 *  HashTag()
+	 *
+	 *  Hashes a texture or material tag with 32-bit FNV-1a, so
+	 *  tags are looked up without building a string.
+	 ***********************************************************/
+	uint32_t HashTag(const char* tag)
+	{
+		uint32_t hash = 2166136261u;
+		for (const char* pChar = tag; *pChar != '\0'; pChar++)
+		{
+			hash = (hash ^ (uint8_t)*pChar) * 16777619u;
+		}
+		return(hash);
+	}
 }
 
 /***********************************************************
@@ -34,7 +77,42 @@ namespace
 SceneManager::SceneManager(ShaderManager *pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
-	m_basicMeshes = new ShapeMeshes();
+	m_pSceneMeshes = new SceneMeshes();
+	m_pUniformCache = new ShaderUniformCache();
+	m_pShaderPermutations = new ShaderPermutations();
+	m_bShaderPermutations = true;
+	m_pLightManager = new LightManager();
+	m_pTextureLoader = new TextureLoader();
+	m_pTextureRegistry = new TextureRegistry();
+	m_pTextureResidency = new TextureResidency(m_pTextureLoader, m_pTextureRegistry);
+	m_pJobSystem = new JobSystem();
+	m_pShadowManager = new ShadowManager();
+	for (int v = 0; v < ShadowManager::SHADOW_VIEW_COUNT; v++)
+	{
+		m_bShadowViewDirty[v] = false;
+	}
+	m_pDepthPrepass = new DepthPrepass();
+	m_bDepthPrepass = true;
+	m_pOcclusionCuller = new OcclusionCuller();
+	m_bOcclusionCulling = true;
+	m_bOcclusionCullFrame = false;
+	m_pFrameData = new FrameRingBuffer();
+	m_pSceneFile = new SceneFile();
+	m_pFileWatcher = new FileWatcher();
+	m_bHotReload = false;
+	m_vertexShaderWatchID = -1;
+	m_fragmentShaderWatchID = -1;
+	m_sceneWatchID = -1;
+	m_pInstanceData = NULL;
+	m_baseInstance = 0;
+	m_materialBufferID = 0;
+	m_bTransformsDirty = false;
+	m_geometryVersion = 0;
+	// the first frame always checks the lights
+	m_lightInfluenceGeometryVersion = ~0u;
+	m_lightInfluenceLightVersion = ~0u;
+	m_sceneCopies = 1;
+	m_viewPosition = glm::vec3(0.0f);
 }
 
 /***********************************************************
@@ -45,98 +123,89 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
 SceneManager::~SceneManager()
 {
 	m_pShaderManager = NULL;
-	delete m_basicMeshes;
-	m_basicMeshes = NULL;
+	delete m_pFileWatcher;
+	m_pFileWatcher = NULL;
+	delete m_pJobSystem;
+	m_pJobSystem = NULL;
+	DestroyGLTextures();
+	delete m_pTextureResidency;
+	m_pTextureResidency = NULL;
+	delete m_pTextureRegistry;
+	m_pTextureRegistry = NULL;
+	delete m_pSceneMeshes;
+	m_pSceneMeshes = NULL;
+	delete m_pUniformCache;
+	m_pUniformCache = NULL;
+	delete m_pShaderPermutations;
+	m_pShaderPermutations = NULL;
+	delete m_pShadowManager;
+	m_pShadowManager = NULL;
+	delete m_pDepthPrepass;
+	m_pDepthPrepass = NULL;
+	delete m_pOcclusionCuller;
+	m_pOcclusionCuller = NULL;
+	delete m_pLightManager;
+	m_pLightManager = NULL;
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	if (0 != m_materialBufferID)
+	{
+		glDeleteBuffers(1, &m_materialBufferID);
+		m_materialBufferID = 0;
+	}
+	delete m_pFrameData;
+	m_pFrameData = NULL;
+	delete m_pSceneFile;
+	m_pSceneFile = NULL;
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
- ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
-{
-	int width = 0;
-	int height = 0;
-	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+ *  This method is used for loading textures from image files
+ *  into the next available texture slot in memory.  The
+ *  image is decoded by the texture loader worker threads and
+ *  the slot shows a placeholder until the image is uploaded.
+ *  There is no limit to the number of texture slots.
+ ***********************************************************/
+bool SceneManager::CreateGLTexture(const char* filename, const char* tag)
+{
+	GLuint textureID = m_pTextureLoader->RequestTexture(filename);
 
-		return true;
+	if (0 == textureID)
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return false;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
+	// register the loaded texture and associate it with the special
+	// tag string, the slot is the texture's index in the registry
+	TEXTURE_INFO textureInfo;
+	textureInfo.ID = textureID;
+	textureInfo.tag = tag;
+	int textureSlot = m_pTextureRegistry->AddTexture(textureID);
+	m_pTextureResidency->AddTexture(textureSlot, textureID, filename);
+	m_textureIDs.push_back(textureInfo);
+	if (m_bHotReload)
+	{
+		m_textureWatchSlots[m_pFileWatcher->AddFile(filename)] = textureSlot;
+	}
+	// a tag whose hash is taken is found by searching the slots
+	m_textureSlotLookup.insert(std::make_pair(HashTag(tag), textureSlot));
 
-	// Error loading the image
-	return false;
+	return true;
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for binding the loaded textures for
+ *  the shaders, which select them by texture slot through
+ *  the texture registry instead of by texture unit.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
-	}
+	m_renderStats.textureBinds += m_pTextureRegistry->Bind();
 }
 
 /***********************************************************
@@ -147,10 +216,45 @@ void SceneManager::BindGLTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
+	// wait for the decoding workers so no upload targets a
+	// texture after it is deleted
+	m_pTextureLoader->Shutdown();
+	m_pTextureResidency->Destroy();
+	m_pTextureRegistry->Destroy();
+	m_textureIDs.clear();
+	m_textureSlotLookup.clear();
+}
+
+/***********************************************************
+ *  FinishTextureLoads()
+ *
+ *  This method is used for waiting until all of the scene
+ *  textures are uploaded and published, so that measured
+ *  frames never include texture uploads.
+ ***********************************************************/
+void SceneManager::FinishTextureLoads()
+{
+	m_pTextureLoader->WaitForAll();
+	UpdateTextureRegistry();
+}
+
+/***********************************************************
+ *  UpdateTextureRegistry()
+ *
+ *  This method is used for publishing the loaded textures
+ *  to the shaders once their final images are uploaded,
+ *  until then the texture slots show a placeholder.  The
+ *  residency manager may swap a texture for a reload with
+ *  fewer mip levels, so the slot IDs are refreshed.
+ ***********************************************************/
+void SceneManager::UpdateTextureRegistry()
+{
+	m_pTextureResidency->Update();
+	for (int i = 0; i < (int)m_textureIDs.size(); i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureIDs[i].ID = m_pTextureRegistry->GetTextureID(i);
 	}
+	BindGLTextures();
 }
 
 /***********************************************************
@@ -159,21 +263,14 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(const char* tag)
 {
 	int textureID = -1;
-	int index = 0;
-	bool bFound = false;
+	int textureSlot = FindTextureSlot(tag);
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (textureSlot >= 0)
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
-		{
-			textureID = m_textureIDs[index].ID;
-			bFound = true;
-		}
-		else
-			index++;
+		textureID = m_textureIDs[textureSlot].ID;
 	}
 
 	return(textureID);
@@ -184,22 +281,36 @@ int SceneManager::FindTextureID(std::string tag)
  *
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
+ *  The tag is found by its hash, and only when another tag
+ *  shares the hash are the slots searched by name.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(const char* tag)
 {
 	int textureSlot = -1;
-	int index = 0;
-	bool bFound = false;
 
-	while ((index < m_loadedTextures) && (bFound == false))
+	if (NULL == tag)
+	{
+		return(textureSlot);
+	}
+
+	std::unordered_map<uint32_t, int>::const_iterator found =
+		m_textureSlotLookup.find(HashTag(tag));
+	if (found != m_textureSlotLookup.end())
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		if (m_textureIDs[found->second].tag.compare(tag) == 0)
 		{
-			textureSlot = index;
-			bFound = true;
+			textureSlot = found->second;
 		}
 		else
-			index++;
+		{
+			for (int i = 0; (i < (int)m_textureIDs.size()) && (textureSlot < 0); i++)
+			{
+				if (m_textureIDs[i].tag.compare(tag) == 0)
+				{
+					textureSlot = i;
+				}
+			}
+		}
 	}
 
 	return(textureSlot);
@@ -211,33 +322,104 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(const char* tag, OBJECT_MATERIAL& material)
 {
-	if (m_objectMaterials.size() == 0)
+	int materialIndex = FindMaterialIndex(tag);
+
+	if (materialIndex < 0)
 	{
 		return(false);
 	}
 
-	int index = 0;
-	bool bFound = false;
-	while ((index < m_objectMaterials.size()) && (bFound == false))
+	material = m_objectMaterials[materialIndex];
+
+	return(true);
+}
+
+/***********************************************************
+ *  IndexObjectMaterials()
+ *
+ *  This method is used for indexing the defined materials
+ *  by tag so that tags can be resolved to material index
+ *  handles without scanning the materials list.
+ ***********************************************************/
+void SceneManager::IndexObjectMaterials()
+{
+	m_materialLookup.clear();
+
+	for (int index = 0; index < m_objectMaterials.size(); index++)
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
-		{
-			bFound = true;
-			material.ambientColor = m_objectMaterials[index].ambientColor;
-			material.ambientStrength = m_objectMaterials[index].ambientStrength;
-			material.diffuseColor = m_objectMaterials[index].diffuseColor;
-			material.specularColor = m_objectMaterials[index].specularColor;
-			material.shininess = m_objectMaterials[index].shininess;
-		}
-		else
-		{
-			index++;
-		}
+		// the first material defined with a tag is the one found,
+		// and a tag whose hash is taken is found by searching
+		m_materialLookup.insert(std::make_pair(HashTag(m_objectMaterials[index].tag.c_str()), index));
 	}
+}
 
-	return(true);
+/***********************************************************
+ *  GetMaterial()
+ *
+ *  This method is used for getting a defined material by
+ *  the index handle returned from FindMaterialIndex().
+ ***********************************************************/
+const SceneManager::OBJECT_MATERIAL& SceneManager::GetMaterial(int materialIndex) const
+{
+	return(m_objectMaterials[materialIndex]);
+}
+
+/***********************************************************
+ *  CreateMaterialBuffer()
+ *
+ *  This method is used for packing all of the defined
+ *  materials into one std140 uniform buffer so that a draw
+ *  selects its material with a single index upload.
+ ***********************************************************/
+void SceneManager::CreateMaterialBuffer()
+{
+	int materialCount = (int)m_objectMaterials.size();
+
+	if (materialCount > MAX_MATERIALS)
+	{
+		std::cout << "Only the first " << MAX_MATERIALS << " of " << materialCount << " materials can be used" << std::endl;
+		materialCount = MAX_MATERIALS;
+	}
+
+	// each std140 material entry is three vec4 values
+	std::vector<glm::vec4> materialData(MAX_MATERIALS * 3, glm::vec4(0.0f));
+	for (int i = 0; i < materialCount; i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		materialData[i * 3 + 0] = glm::vec4(material.ambientColor, material.ambientStrength);
+		materialData[i * 3 + 1] = glm::vec4(material.diffuseColor, 0.0f);
+		materialData[i * 3 + 2] = glm::vec4(material.specularColor, material.shininess);
+	}
+
+	if (0 == m_materialBufferID)
+	{
+		glGenBuffers(1, &m_materialBufferID);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_materialBufferID);
+	glBufferData(GL_UNIFORM_BUFFER, materialData.size() * sizeof(glm::vec4), &materialData[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// connect the buffer to the material block in the shader
+	ConnectMaterialBlock(m_pUniformCache->GetProgramID());
+	glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, m_materialBufferID);
+}
+
+/***********************************************************
+ *  ConnectMaterialBlock()
+ *
+ *  This method is used for connecting the material block of
+ *  the passed in shader program to the binding point of the
+ *  material uniform buffer.
+ ***********************************************************/
+void SceneManager::ConnectMaterialBlock(GLuint programID)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(programID, "MaterialBlock");
+	if (GL_INVALID_INDEX != blockIndex)
+	{
+		glUniformBlockBinding(programID, blockIndex, MATERIAL_BLOCK_BINDING);
+	}
 }
 
 /***********************************************************
@@ -255,26 +437,201 @@ void SceneManager::SetTransformations(
 {
 	// variables for this method
 	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
-
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+
+	modelView = ComputeModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_pUniformCache->SetIntValue(ShaderUniformCache::UNIFORM_USE_INSTANCING, false);
+		m_pUniformCache->SetIntValue(ShaderUniformCache::UNIFORM_USE_PACKED_VERTICES, false);
+		m_pUniformCache->SetMat4Value(ShaderUniformCache::UNIFORM_MODEL, modelView);
+	}
+}
+
+/***********************************************************
+ *  ComputeModelMatrix()
+ *
+ *  This method is used for composing the model matrix from
+ *  the passed in transformation values.  The result equals
+ *  translation * rotationX * rotationY * rotationZ * scale,
+ *  but each element is written directly instead of building
+ *  and multiplying five separate 4x4 matrices.
+ ***********************************************************/
+glm::mat4 SceneManager::ComputeModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
+	glm::mat4 modelView;
+
+	float cx = cosf(glm::radians(XrotationDegrees));
+	float sx = sinf(glm::radians(XrotationDegrees));
+	float cy = cosf(glm::radians(YrotationDegrees));
+	float sy = sinf(glm::radians(YrotationDegrees));
+	float cz = cosf(glm::radians(ZrotationDegrees));
+	float sz = sinf(glm::radians(ZrotationDegrees));
+
+	// each rotation column is multiplied by its axis scale
+	modelView[0] = glm::vec4(
+		cy * cz * scaleXYZ.x,
+		(sx * sy * cz + cx * sz) * scaleXYZ.x,
+		(sx * sz - cx * sy * cz) * scaleXYZ.x,
+		0.0f);
+	modelView[1] = glm::vec4(
+		-cy * sz * scaleXYZ.y,
+		(cx * cz - sx * sy * sz) * scaleXYZ.y,
+		(cx * sy * sz + sx * cz) * scaleXYZ.y,
+		0.0f);
+	modelView[2] = glm::vec4(
+		sy * scaleXYZ.z,
+		-sx * cy * scaleXYZ.z,
+		cx * cy * scaleXYZ.z,
+		0.0f);
+	// the translation occupies the last column
+	modelView[3] = glm::vec4(positionXYZ, 1.0f);
+
+	return(modelView);
+}
+
+/***********************************************************
+ *  UpdateRenderItemTransforms()
+ *
+ *  This method is used for rebuilding the cached model
+ *  matrices of only those render items whose transformation
+ *  values have changed since they were last composed.  The
+ *  matrices and bounds of separate items are independent and
+ *  are built by the job system, then the BVH is refit on this
+ *  thread since the refits share the upper tree nodes.
+ ***********************************************************/
+void SceneManager::UpdateRenderItemTransforms()
+{
+	if (m_bTransformsDirty == false)
+	{
+		return;
+	}
+
+	int itemCount = (int)m_renderList.meshIDs.size();
+
+	m_pJobSystem->ParallelFor(itemCount, JOB_GRAIN_SIZE,
+		[this](int begin, int end, int threadIndex)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (m_renderList.transformDirty[i] != 0)
+			{
+				m_renderList.modelMatrices[i] = ComputeModelMatrix(
+					m_renderList.scales[i],
+					m_renderList.rotationsDegrees[i].x,
+					m_renderList.rotationsDegrees[i].y,
+					m_renderList.rotationsDegrees[i].z,
+					m_renderList.positions[i]);
+				UpdateRenderItemBounds(i);
+			}
+		}
+	});
+
+	for (int i = 0; i < itemCount; i++)
+	{
+		if (m_renderList.transformDirty[i] != 0)
+		{
+			m_sceneBVH.Refit(i, m_renderList.boundsCenters[i], m_renderList.boundsRadii[i]);
+			m_renderList.transformDirty[i] = 0;
+		}
+	}
+
+	m_bTransformsDirty = false;
+	m_geometryVersion++;
+}
+
+/***********************************************************
+ *  UpdateRenderItemBounds()
+ *
+ *  This method is used for moving the object space bounds
+ *  of a render item's mesh into world space with its model
+ *  matrix.  The sphere radius is grown by the largest axis
+ *  scale so that it still encloses the mesh under any
+ *  rotation and non-uniform scale.
+ ***********************************************************/
+void SceneManager::UpdateRenderItemBounds(int itemIndex)
+{
+	const SceneMeshes::MESH_BOUNDS& bounds = m_pSceneMeshes->GetMeshBounds(m_renderList.meshIDs[itemIndex]);
+	const glm::mat4& model = m_renderList.modelMatrices[itemIndex];
+
+	float maxScale = glm::max(
+		glm::length(glm::vec3(model[0])),
+		glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+
+	m_renderList.boundsCenters[itemIndex] = glm::vec3(model * glm::vec4(bounds.center, 1.0f));
+	m_renderList.boundsRadii[itemIndex] = bounds.radius * maxScale;
+}
+
+/***********************************************************
+ *  SelectRenderItemLOD()
+ *
+ *  This method is used for picking the mesh level of detail
+ *  of a render item from the radius its bounding sphere
+ *  projects to with the current view and projection.
+ ***********************************************************/
+int SceneManager::SelectRenderItemLOD(int itemIndex) const
+{
+	float radius = m_renderList.boundsRadii[itemIndex] * m_projectionMatrix[1][1];
+
+	// a perspective projection divides by the view depth, the
+	// orthographic projection keeps the same size at any depth
+	if (0.0f != m_projectionMatrix[2][3])
+	{
+		glm::vec4 viewCenter = m_viewMatrix * glm::vec4(m_renderList.boundsCenters[itemIndex], 1.0f);
+		float depth = -viewCenter.z;
+		if (depth <= m_renderList.boundsRadii[itemIndex])
+		{
+			// the camera is at or inside of the bounding sphere
+			return(0);
+		}
+		radius /= depth;
+	}
+
+	return(SceneMeshes::SelectLevelOfDetail(radius));
+}
+
+/***********************************************************
+ *  SetRenderItemTransform()
+ *
+ *  This method is used for changing the transformation
+ *  values of a render item.  The item is only marked dirty
+ *  when one of the values actually differs.
+ ***********************************************************/
+void SceneManager::SetRenderItemTransform(
+	int itemIndex,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((itemIndex < 0) || (itemIndex >= m_renderList.meshIDs.size()))
+	{
+		return;
+	}
+
+	glm::vec3 rotationDegrees(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+
+	if ((m_renderList.scales[itemIndex] != scaleXYZ) ||
+		(m_renderList.rotationsDegrees[itemIndex] != rotationDegrees) ||
+		(m_renderList.positions[itemIndex] != positionXYZ))
+	{
+		m_renderList.scales[itemIndex] = scaleXYZ;
+		m_renderList.rotationsDegrees[itemIndex] = rotationDegrees;
+		m_renderList.positions[itemIndex] = positionXYZ;
+		m_renderList.transformDirty[itemIndex] = 1;
+		m_bTransformsDirty = true;
 	}
 }
 
@@ -300,8 +657,8 @@ void SceneManager::SetShaderColor(
 
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_pUniformCache->SetIntValue(ShaderUniformCache::UNIFORM_USE_TEXTURE, false);
+		m_pUniformCache->SetVec4Value(ShaderUniformCache::UNIFORM_OBJECT_COLOR, currentColor);
 	}
 }
 
@@ -312,15 +669,24 @@ void SceneManager::SetShaderColor(
  *  associated with the passed in ID into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	const char* textureTag)
+{
+	SetShaderTexture(FindTextureSlot(textureTag));
+}
+
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture data in the
+ *  passed in texture slot handle into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	int textureSlot)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-
-		int textureID = -1;
-		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		m_pUniformCache->SetIntValue(ShaderUniformCache::UNIFORM_USE_TEXTURE, true);
+		m_pUniformCache->SetIntValue(ShaderUniformCache::UNIFORM_OBJECT_TEXTURE, textureSlot);
 	}
 }
 
@@ -334,7 +700,7 @@ void SceneManager::SetTextureUVScale(float u, float v)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_pUniformCache->SetVec2Value(ShaderUniformCache::UNIFORM_UV_SCALE, glm::vec2(u, v));
 	}
 }
 
@@ -345,25 +711,252 @@ void SceneManager::SetTextureUVScale(float u, float v)
  *  into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	const char* materialTag)
+{
+	SetShaderMaterial(FindMaterialIndex(materialTag));
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for selecting the material with the
+ *  passed in index handle from the material uniform buffer.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	int materialIndex)
 {
-	if (m_objectMaterials.size() > 0)
+	if ((NULL != m_pShaderManager) &&
+		(materialIndex >= 0) &&
+		(materialIndex < m_objectMaterials.size()) &&
+		(materialIndex < MAX_MATERIALS))
 	{
-		OBJECT_MATERIAL material;
-		bool bReturn = false;
+		m_pUniformCache->SetIntValue(ShaderUniformCache::UNIFORM_MATERIAL_INDEX, materialIndex);
+	}
+}
+
+/***********************************************************
+ *  FindMaterialIndex()
+ *
+ *  This method is used for getting the index of a previously
+ *  defined material that is associated with the passed in tag.
+ *  The tag is found by its hash, and only when another tag
+ *  shares the hash are the materials searched by name.
+ ***********************************************************/
+int SceneManager::FindMaterialIndex(const char* tag)
+{
+	int materialIndex = -1;
+
+	if (NULL == tag)
+	{
+		return(materialIndex);
+	}
+
+	std::unordered_map<uint32_t, int>::const_iterator found =
+		m_materialLookup.find(HashTag(tag));
+	if (found != m_materialLookup.end())
+	{
+		if (m_objectMaterials[found->second].tag.compare(tag) == 0)
+		{
+			materialIndex = found->second;
+		}
+		else
+		{
+			for (int i = 0; (i < (int)m_objectMaterials.size()) && (materialIndex < 0); i++)
+			{
+				if (m_objectMaterials[i].tag.compare(tag) == 0)
+				{
+					materialIndex = i;
+				}
+			}
+		}
+	}
+
+	return(materialIndex);
+}
+
+/***********************************************************
+ *  AddRenderItem()
+ *
+ *  This method is used for adding an item to the retained
+ *  render list.  The texture and material tags are resolved
+ *  here once so that no lookups are needed while rendering.
+ *  Pass NULL for the texture tag to draw with the solid color.
+ ***********************************************************/
+int SceneManager::AddRenderItem(
+	int meshID,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	const char* textureTag,
+	const char* materialTag,
+	glm::vec4 color)
+{
+	int textureSlot = -1;
+	int materialIndex = -1;
+
+	if (NULL != textureTag)
+	{
+		textureSlot = FindTextureSlot(textureTag);
+	}
+	if (NULL != materialTag)
+	{
+		materialIndex = FindMaterialIndex(materialTag);
+	}
+
+	return(AddResolvedRenderItem(
+		meshID,
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ,
+		textureSlot,
+		materialIndex,
+		color,
+		glm::vec2(1.0f, 1.0f)));
+}
+
+/***********************************************************
+ *  AddResolvedRenderItem()
+ *
+ *  This method is used for adding an item to the retained
+ *  render list with an already resolved texture slot and
+ *  material index, -1 for none.
+ ***********************************************************/
+int SceneManager::AddResolvedRenderItem(
+	int meshID,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ,
+	int textureSlot,
+	int materialIndex,
+	glm::vec4 color,
+	glm::vec2 uvScale)
+{
+	m_renderList.meshIDs.push_back(meshID);
+	m_renderList.modelMatrices.push_back(ComputeModelMatrix(
+		scaleXYZ,
+		rotationDegrees.x,
+		rotationDegrees.y,
+		rotationDegrees.z,
+		positionXYZ));
+	m_renderList.textureSlots.push_back(textureSlot);
+	m_renderList.materialIndices.push_back(materialIndex);
+	m_renderList.colors.push_back(color);
+	m_renderList.uvScales.push_back(uvScale);
+	m_renderList.scales.push_back(scaleXYZ);
+	m_renderList.rotationsDegrees.push_back(rotationDegrees);
+	m_renderList.positions.push_back(positionXYZ);
+	m_renderList.transformDirty.push_back(0);
+	m_renderList.transparent.push_back((color.a < 1.0f) ? 1 : 0);
+	m_renderList.lodLevels.push_back(0);
+	m_renderList.permutations.push_back(0);
+	m_renderList.boundsCenters.push_back(glm::vec3(0.0f));
+	m_renderList.boundsRadii.push_back(0.0f);
+	UpdateRenderItemBounds((int)m_renderList.meshIDs.size() - 1);
+
+	return((int)m_renderList.meshIDs.size() - 1);
+}
+
+/***********************************************************
+ *  CopyRenderItem()
+ *
+ *  This method is used for adding a render item with the
+ *  same mesh, texture, material and transformation as the
+ *  passed in item, moved by the passed in offset.
+ ***********************************************************/
+int SceneManager::CopyRenderItem(int itemIndex, glm::vec3 offset)
+{
+	glm::vec3 position = m_renderList.positions[itemIndex] + offset;
+	glm::vec3 rotation = m_renderList.rotationsDegrees[itemIndex];
+
+	m_renderList.meshIDs.push_back(m_renderList.meshIDs[itemIndex]);
+	m_renderList.modelMatrices.push_back(ComputeModelMatrix(
+		m_renderList.scales[itemIndex],
+		rotation.x,
+		rotation.y,
+		rotation.z,
+		position));
+	m_renderList.textureSlots.push_back(m_renderList.textureSlots[itemIndex]);
+	m_renderList.materialIndices.push_back(m_renderList.materialIndices[itemIndex]);
+	m_renderList.colors.push_back(m_renderList.colors[itemIndex]);
+	m_renderList.uvScales.push_back(m_renderList.uvScales[itemIndex]);
+	m_renderList.scales.push_back(m_renderList.scales[itemIndex]);
+	m_renderList.rotationsDegrees.push_back(rotation);
+	m_renderList.positions.push_back(position);
+	m_renderList.transformDirty.push_back(0);
+	m_renderList.transparent.push_back(m_renderList.transparent[itemIndex]);
+	m_renderList.lodLevels.push_back(0);
+	m_renderList.permutations.push_back(0);
+	m_renderList.boundsCenters.push_back(glm::vec3(0.0f));
+	m_renderList.boundsRadii.push_back(0.0f);
+	UpdateRenderItemBounds((int)m_renderList.meshIDs.size() - 1);
+
+	return((int)m_renderList.meshIDs.size() - 1);
+}
+
+/***********************************************************
+ *  ReplicateRenderItems()
+ *
+ *  This method is used for growing the scene for scaling
+ *  measurements by repeating the desk scene built by
+ *  BuildRenderList().  The copies are laid out in a square
+ *  grid of floor sized cells next to the original scene.
+ ***********************************************************/
+void SceneManager::ReplicateRenderItems()
+{
+	// the floor plane spans 40 by 30 units
+	const float CELL_WIDTH = 42.0f;
+	const float CELL_DEPTH = 32.0f;
 
-		bReturn = FindMaterial(materialTag, material);
-		if (bReturn == true)
+	int itemCount = (int)m_renderList.meshIDs.size();
+	int columns = 1;
+	while (columns * columns < m_sceneCopies)
+	{
+		columns++;
+	}
+
+	ReserveRenderItems(itemCount * m_sceneCopies);
+	for (int copy = 1; copy < m_sceneCopies; copy++)
+	{
+		glm::vec3 offset(
+			(float)(copy % columns) * CELL_WIDTH,
+			0.0f,
+			-(float)(copy / columns) * CELL_DEPTH);
+
+		for (int i = 0; i < itemCount; i++)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			CopyRenderItem(i, offset);
 		}
 	}
 }
 
+/***********************************************************
+ *  ReserveRenderItems()
+ *
+ *  This method is used for making room in every array of
+ *  the render list for the passed in number of items, so
+ *  that adding them does not grow the arrays one by one.
+ ***********************************************************/
+void SceneManager::ReserveRenderItems(int itemCount)
+{
+	m_renderList.meshIDs.reserve(itemCount);
+	m_renderList.modelMatrices.reserve(itemCount);
+	m_renderList.textureSlots.reserve(itemCount);
+	m_renderList.materialIndices.reserve(itemCount);
+	m_renderList.colors.reserve(itemCount);
+	m_renderList.uvScales.reserve(itemCount);
+	m_renderList.scales.reserve(itemCount);
+	m_renderList.rotationsDegrees.reserve(itemCount);
+	m_renderList.positions.reserve(itemCount);
+	m_renderList.transformDirty.reserve(itemCount);
+	m_renderList.transparent.reserve(itemCount);
+	m_renderList.lodLevels.reserve(itemCount);
+	m_renderList.permutations.reserve(itemCount);
+	m_renderList.boundsCenters.reserve(itemCount);
+	m_renderList.boundsRadii.reserve(itemCount);
+}
+
 /**************************************************************/
 /*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
 /*** preparing and rendering their own 3D replicated scenes.***/
@@ -380,9 +973,10 @@ void SceneManager::SetShaderMaterial(
 void SceneManager::LoadSceneTextures()
 {
 	/*** STUDENTS - add the code BELOW for loading the textures that ***/
-	/*** will be used for mapping to objects in the 3D scene. Up to  ***/
-	/*** 16 textures can be loaded per scene. Refer to the code in   ***/
-	/*** the OpenGL Sample for help.                                 ***/
+	/*** will be used for mapping to objects in the 3D scene. Any    ***/
+	/*** number of textures can be loaded per scene, since each one  ***/
+	/*** is added to the texture registry and selected by its slot.  ***/
+	/*** Refer to the code in the OpenGL Sample for help.            ***/
 
 	bool bReturn = false;
 
@@ -415,8 +1009,8 @@ void SceneManager::LoadSceneTextures()
 
 
 	// after the texture image data is loaded into memory, the
-	// loaded textures need to be bound to texture slots - there
-	// are a total of 16 available slots for scene textures
+	// loaded textures need to be bound for the shaders - the
+	// number of texture slots is not limited
 	BindGLTextures();
 }
 
@@ -508,7 +1102,9 @@ void SceneManager::DefineObjectMaterials()
  *  SetupSceneLights()
  *
  *  This method is called to add and configure the light
- *  sources for the 3D scene.  There are up to 4 light sources.
+ *  sources for the 3D scene.  Any number of light sources
+ *  can be added; each fragment only evaluates the lights
+ *  whose range reaches its screen tile.
  ***********************************************************/
 void SceneManager::SetupSceneLights()
 {
@@ -519,32 +1115,31 @@ void SceneManager::SetupSceneLights()
 	//m_pShaderManager->setBoolValue(g_UseLightingName, true);
 
 	/*** STUDENTS - add the code BELOW for setting up light sources ***/
-	/*** Up to four light sources can be defined. Refer to the code ***/
-	/*** in the OpenGL Sample for help                              ***/
+	/*** A range of zero lets a light reach the whole scene, while  ***/
+	/*** lamps with a limited range only cost the tiles they touch  ***/
 	m_pShaderManager->setBoolValue(g_UseLightingName, true);
-	//ambient
-	m_pShaderManager->setVec3Value("lightSources[0].direction", 0.0f, -1.0f, 0.0f);
-	m_pShaderManager->setVec3Value("lightSources[0].ambientColor", 0.55f, 0.55f, 0.5f);
-	m_pShaderManager->setVec3Value("lightSources[0].diffuseColor", 0.65f, 0.65f, 0.6f);
-	m_pShaderManager->setVec3Value("lightSources[0].specularColor", 0.0f, 0.0f, 0.0f);
-	m_pShaderManager->setFloatValue("lightSources[0].specularIntensity", 0.0f);
 
+	LightManager::LIGHT_SOURCE light;
 
+	//ambient
+	light = LightManager::LIGHT_SOURCE();
+	light.direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	light.ambientColor = glm::vec3(0.55f, 0.55f, 0.5f);
+	light.diffuseColor = glm::vec3(0.65f, 0.65f, 0.6f);
+	light.specularColor = glm::vec3(0.0f, 0.0f, 0.0f);
+	light.specularIntensity = 0.0f;
+	m_pLightManager->AddLightSource(light);
 
 	//computer screen light	
-
-	m_pShaderManager->setVec3Value("lightSources[1].position", 0.0f, 2.77f, -0.4f);         
-	m_pShaderManager->setVec3Value("lightSources[1].spotDirection", 0.0f, -0.1f, 0.8f);        
-	m_pShaderManager->setVec3Value("lightSources[1].ambientColor", 0.04f, 0.05f, 0.1f);        
-	m_pShaderManager->setVec3Value("lightSources[1].diffuseColor", 0.1f, 0.15f, 0.4f);          
-	m_pShaderManager->setVec3Value("lightSources[1].specularColor", 0.1f, 0.1f, 0.2f);         
-	m_pShaderManager->setFloatValue("lightSources[1].focalStrength", 3.0f);                   
-	m_pShaderManager->setFloatValue("lightSources[1].specularIntensity", 0.05);               
-
-
-
-
-
+	light = LightManager::LIGHT_SOURCE();
+	light.position = glm::vec3(0.0f, 2.77f, -0.4f);
+	light.spotDirection = glm::vec3(0.0f, -0.1f, 0.8f);
+	light.ambientColor = glm::vec3(0.04f, 0.05f, 0.1f);
+	light.diffuseColor = glm::vec3(0.1f, 0.15f, 0.4f);
+	light.specularColor = glm::vec3(0.1f, 0.1f, 0.2f);
+	light.focalStrength = 3.0f;
+	light.specularIntensity = 0.05f;
+	m_pLightManager->AddLightSource(light);
 }
 
 /***********************************************************
@@ -556,234 +1151,1418 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-	//load scene textures
-	LoadSceneTextures();
-	DefineObjectMaterials();
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
-	SetupSceneLights();
-
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadBoxMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadConeMesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadTorusMesh(.1f);
-	m_basicMeshes->LoadPrismMesh();
-	
-}
+	// the shaders are loaded and in use before the scene is
+	// prepared, so the uniform locations only need to be
+	// looked up once here
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	m_pUniformCache->LoadLocations((GLuint)programID);
+	m_pLightManager->Initialize((GLuint)programID);
+	// start the worker threads that decode the texture images
+	// and the worker threads that prepare the frames
+	m_pTextureLoader->Initialize();
+	m_pJobSystem->Initialize();
+	m_pTextureRegistry->Initialize((GLuint)programID);
+	// the shadow block is created even with the shadows off,
+	// since every scene program reads it
+	m_pShadowManager->Initialize(SHADOW_VERTEX_SHADER, DEPTH_ONLY_FRAGMENT_SHADER);
+	m_pShadowManager->ConnectProgram((GLuint)programID);
+	// the depth prepass and the occlusion culling are each left
+	// off when their shaders do not build
+	if (m_bDepthPrepass)
+	{
+		m_bDepthPrepass = m_pDepthPrepass->Initialize(DEPTH_VERTEX_SHADER, DEPTH_ONLY_FRAGMENT_SHADER);
+	}
+	if (m_bOcclusionCulling)
+	{
+		m_bOcclusionCulling = m_pOcclusionCuller->Initialize(OCCLUSION_CULL_SHADER, DEPTH_PYRAMID_SHADER);
+	}
+	// the permutations are built from the same shader files as
+	// the program in use, which stays as their fallback
+	if (m_bShaderPermutations)
+	{
+		m_bShaderPermutations = (false == m_vertexShaderFilename.empty()) &&
+			m_pShaderPermutations->SetShaderFiles(m_vertexShaderFilename, m_fragmentShaderFilename);
+	}
+
+	// a scene file replaces the textures, materials, lights and
+	// render items built in code, it stays mapped until the
+	// render items have been read from it
+	bool bSceneFile = (false == m_sceneFilename.empty()) &&
+		m_pSceneFile->Open(m_sceneFilename.c_str());
+
+	//load scene textures
+	if (bSceneFile)
+	{
+		LoadSceneFileResources();
+	}
+	else
+	{
+		LoadSceneTextures();
+		DefineObjectMaterials();
+	}
+	IndexObjectMaterials();
+	CreateMaterialBuffer();
+	if (false == bSceneFile)
+	{
+		SetupSceneLights();
+	}
+
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene, and each is drawn with
+	// per-instance attributes so that the render items sharing
+	// a mesh are drawn in one call
+	m_pSceneMeshes->LoadMeshes(.1f, MESH_CACHE_FILENAME);
+	m_pFrameData->Create(INITIAL_FRAME_DATA_BYTES);
+
+	// the textures and materials must be defined before the
+	// render items are built so that their tags can be resolved
+	if (bSceneFile)
+	{
+		BuildSceneFileRenderList();
+		m_pSceneFile->Close();
+	}
+	else
+	{
+		BuildRenderList();
+	}
+	ReplicateRenderItems();
+	// index the render item bounds, later moves only refit it
+	m_sceneBVH.Build(m_renderList.boundsCenters, m_renderList.boundsRadii);
+	// build the permutations now rather than in the first frames
+	BuildShaderPermutations();
+
+	// the image files were watched as the textures were created,
+	// the changes are picked up by ApplyFileChanges()
+	if (m_bHotReload)
+	{
+		if (false == m_vertexShaderFilename.empty())
+		{
+			m_vertexShaderWatchID = m_pFileWatcher->AddFile(m_vertexShaderFilename);
+			m_fragmentShaderWatchID = m_pFileWatcher->AddFile(m_fragmentShaderFilename);
+		}
+		if (bSceneFile)
+		{
+			m_sceneWatchID = m_pFileWatcher->AddFile(m_sceneFilename);
+		}
+		m_pFileWatcher->Start();
+	}
+}
 
 /***********************************************************
- *  RenderScene()
+ *  BuildRenderList()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for building the retained render
+ *  items for the 3D scene.  Each item records the resolved
+ *  texture slot and material that were active for its draw.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::BuildRenderList()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
-	{
-		/*** Set needed transformations before drawing the basic mesh.  ***/
-		/*** This same ordering of code should be used for transforming ***/
-		/*** and drawing all the basic 3D shapes.						***/
-		/******************************************************************/
-		// set the XYZ scale for the mesh
-		scaleXYZ = glm::vec3(20.0f, 1.0f, 15.0f);
-
-		// set the XYZ rotation for the mesh
-		XrotationDegrees = 0.0f;
-		YrotationDegrees = 0.0f;
-		ZrotationDegrees = 0.0f;
-
-		// set the XYZ position for the mesh
-		positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-		// set the transformations into memory to be used on the drawn meshes
-		SetTransformations(
-			scaleXYZ,
-			XrotationDegrees,
-			YrotationDegrees,
-			ZrotationDegrees,
-			positionXYZ);
-
-		//SetShaderColor(1, 1, 1, 1);
-
-		// draw the mesh with transformation values
-		SetShaderTexture("floor");
-		SetTextureUVScale(1.0, 1.0);
-		SetShaderMaterial("wood");
-		m_basicMeshes->DrawPlaneMesh();
-		/****************************************************************/
-	}
-	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	//mug body
-	scaleXYZ = glm::vec3(.8f, 1.8f, 0.8f); 
-	positionXYZ = glm::vec3(-5.5f, 0.5f, 4.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	
-	SetShaderTexture("coffee");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawCylinderMesh(true, false, false); //drawing top of cyl to look like coffee
-	//SetShaderColor(0.33f, 0.35f, 0.36f, 1.0f);
-	SetShaderTexture("mug");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("mug");
-	m_basicMeshes->DrawCylinderMesh();
+	// floor
+	AddRenderItem(MESH_PLANE,
+		glm::vec3(20.0f, 1.0f, 15.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f),
+		"floor", "wood");
+
+	//mug body - drawing top of cyl to look like coffee
+	AddRenderItem(MESH_CYLINDER_TOP,
+		glm::vec3(.8f, 1.8f, 0.8f), 0.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 0.5f, 4.0f),
+		"coffee", "wood");
+	AddRenderItem(MESH_CYLINDER,
+		glm::vec3(.8f, 1.8f, 0.8f), 0.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 0.5f, 4.0f),
+		"mug", "mug");
 
 	//top lip torus
-	scaleXYZ = glm::vec3(.745f, .745f, 0.27f); 
-	positionXYZ = glm::vec3(-5.5f, 2.29f, 4.0f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	//SetShaderColor(0.33f, 0.35f, 0.36f, 1.0f);
-	SetShaderTexture("mug");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("mug");
-	m_basicMeshes->DrawTorusMesh();
+	AddRenderItem(MESH_TORUS,
+		glm::vec3(.745f, .745f, 0.27f), 90.0f, 0.0f, 0.0f, glm::vec3(-5.5f, 2.29f, 4.0f),
+		"mug", "mug");
 
 	//Handle
-	scaleXYZ = glm::vec3(0.6f, 0.6f, 0.75f);
-	positionXYZ = glm::vec3(-4.8f, 1.5f, 4.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 270.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("handle");
-	SetTextureUVScale(1.0, 1.0);
-	//SetShaderColor(0.96f, 0.45f, 0.18f, 1.0f);
-	SetShaderMaterial("mugHandle");
-	m_basicMeshes->DrawHalfTorusMesh();
+	AddRenderItem(MESH_HALF_TORUS,
+		glm::vec3(0.6f, 0.6f, 0.75f), 0.0f, 0.0f, 270.0f, glm::vec3(-4.8f, 1.5f, 4.0f),
+		"handle", "mugHandle");
 
 	//table
-	scaleXYZ = glm::vec3(11.0f, 0.5f, 11.0f);
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	//SetShaderColor(0.13f, 0.11f, 0.10f, 1.0f);
-	SetShaderTexture("desk");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("wood");
-	m_basicMeshes->DrawCylinderMesh();
+	AddRenderItem(MESH_CYLINDER,
+		glm::vec3(11.0f, 0.5f, 11.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f),
+		"desk", "wood");
 
 	//computer keyboard
-	scaleXYZ = glm::vec3(6.0f, 0.2f, 4.0f);
-	positionXYZ = glm::vec3(0.0f, 0.6f, 2.0f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("keyboard");
-	SetTextureUVScale(1.0, 1.0);
-	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawBoxMeshSide(ShapeMeshes::box_top);
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f);
-	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawBoxMesh();
+	AddRenderItem(MESH_BOX_TOP,
+		glm::vec3(6.0f, 0.2f, 4.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.6f, 2.0f),
+		"keyboard", "plastic");
+	AddRenderItem(MESH_BOX,
+		glm::vec3(6.0f, 0.2f, 4.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.6f, 2.0f),
+		NULL, "plastic", glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
 
 	//computer screen
-	scaleXYZ = glm::vec3(6.0f, 0.2f, 4.0f);
-	positionXYZ = glm::vec3(0.0f, 2.77f, -0.40f);
-	XrotationDegrees = 80.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("screen");
-	SetShaderMaterial("screen");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawBoxMeshSide(ShapeMeshes::box_top);
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f);
-	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawBoxMesh();
+	AddRenderItem(MESH_BOX_TOP,
+		glm::vec3(6.0f, 0.2f, 4.0f), 80.0f, 0.0f, 0.0f, glm::vec3(0.0f, 2.77f, -0.40f),
+		"screen", "screen");
+	AddRenderItem(MESH_BOX,
+		glm::vec3(6.0f, 0.2f, 4.0f), 80.0f, 0.0f, 0.0f, glm::vec3(0.0f, 2.77f, -0.40f),
+		NULL, "plastic", glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
 
 	//HINGE
-	scaleXYZ = glm::vec3(.15f, 6.0f, .15f);
-	positionXYZ = glm::vec3(3.0f, 0.75f, -0.02f);
-	XrotationDegrees = 90.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.1f, 0.1f, 0.1f, 1.0f);
-	m_basicMeshes->DrawCylinderMesh();
+	AddRenderItem(MESH_CYLINDER,
+		glm::vec3(.15f, 6.0f, .15f), 90.0f, 0.0f, 90.0f, glm::vec3(3.0f, 0.75f, -0.02f),
+		NULL, "plastic", glm::vec4(0.1f, 0.1f, 0.1f, 1.0f));
 
 	//mouse
-	scaleXYZ = glm::vec3(0.6f, 0.25f, 1.1f);  
-	positionXYZ = glm::vec3(4.5f, 0.5f, 1.5f);  
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.5f, 0.5f, 0.5f, 1.0f);
-	SetShaderMaterial("plastic");  
-	m_basicMeshes->DrawHalfSphereMesh();
+	AddRenderItem(MESH_HALF_SPHERE,
+		glm::vec3(0.6f, 0.25f, 1.1f), 0.0f, 0.0f, 0.0f, glm::vec3(4.5f, 0.5f, 1.5f),
+		NULL, "plastic", glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
 
 	//mouse scroll
-	scaleXYZ = glm::vec3(0.05f, 0.05f, 0.15f);      
-	positionXYZ = glm::vec3(4.5f, 0.75f, 1.0f);          
-	XrotationDegrees = 0.0f;                               
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 90.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(0.2f, 0.2f, 0.2f, 1.0f);            
-	SetShaderMaterial("plastic");
-	m_basicMeshes->DrawCylinderMesh();
-
-	
-	// Pages 
-	scaleXYZ = glm::vec3(2.0f, 0.5f, 3.0f);
-	positionXYZ = glm::vec3(7.5f, 0.8f, 2.5f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	//SetShaderColor(1.0f, 1.0f, 1.0f, 1.0f);
-	SetShaderTexture("paper_book");
-	SetTextureUVScale(1.0, 1.0);
-	m_basicMeshes->DrawBoxMesh();
+	AddRenderItem(MESH_CYLINDER,
+		glm::vec3(0.05f, 0.05f, 0.15f), 0.0f, 0.0f, 90.0f, glm::vec3(4.5f, 0.75f, 1.0f),
+		NULL, "plastic", glm::vec4(0.2f, 0.2f, 0.2f, 1.0f));
+
+	// Pages
+	AddRenderItem(MESH_BOX,
+		glm::vec3(2.0f, 0.5f, 3.0f), 0.0f, 0.0f, 0.0f, glm::vec3(7.5f, 0.8f, 2.5f),
+		"paper_book", "plastic");
 
 	// Top Cover
-	scaleXYZ = glm::vec3(2.01f, 0.05f, 3.01f);
-	positionXYZ = glm::vec3(7.5f, 1.05f, 2.5f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderMaterial("book_cover");
-	SetShaderColor(0.3f, 0.5f, 0.9f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddRenderItem(MESH_BOX,
+		glm::vec3(2.01f, 0.05f, 3.01f), 0.0f, 0.0f, 0.0f, glm::vec3(7.5f, 1.05f, 2.5f),
+		NULL, "book_cover", glm::vec4(0.3f, 0.5f, 0.9f, 1.0f));
 
 	// Bottom Cover
-	scaleXYZ = glm::vec3(2.01f, 0.05f, 3.01f);
-	positionXYZ = glm::vec3(7.5f, 0.55f, 2.5f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderMaterial("book_cover");
-	SetShaderColor(0.3f, 0.5f, 0.9f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddRenderItem(MESH_BOX,
+		glm::vec3(2.01f, 0.05f, 3.01f), 0.0f, 0.0f, 0.0f, glm::vec3(7.5f, 0.55f, 2.5f),
+		NULL, "book_cover", glm::vec4(0.3f, 0.5f, 0.9f, 1.0f));
 
 	// side cover
-	scaleXYZ = glm::vec3(0.05f, 0.55f, 3.01f);
-	positionXYZ = glm::vec3(6.49f, 0.8f, 2.5f);
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderMaterial("book_side");
-	SetShaderColor(0.65f, 0.65f, 0.6f, 1.0f);
-	m_basicMeshes->DrawBoxMesh();
+	AddRenderItem(MESH_BOX,
+		glm::vec3(0.05f, 0.55f, 3.01f), 0.0f, 0.0f, 0.0f, glm::vec3(6.49f, 0.8f, 2.5f),
+		NULL, "book_side", glm::vec4(0.65f, 0.65f, 0.6f, 1.0f));
+}
+
+/***********************************************************
+ *  LoadSceneFileResources()
+ *
+ *  This method is used for requesting the textures, and
+ *  defining the materials and light sources, of the mapped
+ *  scene file.  The materials keep the order of the file so
+ *  that the material indices of its items stay valid.
+ ***********************************************************/
+void SceneManager::LoadSceneFileResources()
+{
+	const SceneFile::SCENE_TEXTURE* pTextures = m_pSceneFile->GetTextures();
+	for (uint32_t i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+	{
+		// a reloaded scene keeps the textures that are already
+		// loaded, since their image files are watched on their own
+		const char* tag = m_pSceneFile->GetString(pTextures[i].tagOffset);
+		if (FindTextureSlot(tag) < 0)
+		{
+			CreateGLTexture(m_pSceneFile->GetString(pTextures[i].filenameOffset), tag);
+		}
+	}
+	BindGLTextures();
+
+	const SceneFile::SCENE_MATERIAL* pMaterials = m_pSceneFile->GetMaterials();
+	m_objectMaterials.reserve(m_pSceneFile->GetMaterialCount());
+	for (uint32_t i = 0; i < m_pSceneFile->GetMaterialCount(); i++)
+	{
+		const SceneFile::SCENE_MATERIAL& source = pMaterials[i];
+		OBJECT_MATERIAL material;
+		material.ambientColor = glm::vec3(source.ambientColor[0], source.ambientColor[1], source.ambientColor[2]);
+		material.ambientStrength = source.ambientStrength;
+		material.diffuseColor = glm::vec3(source.diffuseColor[0], source.diffuseColor[1], source.diffuseColor[2]);
+		material.specularColor = glm::vec3(source.specularColor[0], source.specularColor[1], source.specularColor[2]);
+		material.shininess = source.shininess;
+		material.tag = m_pSceneFile->GetString(source.tagOffset);
+		m_objectMaterials.push_back(material);
+	}
+
+	m_pShaderManager->setBoolValue(g_UseLightingName, true);
+	const SceneFile::SCENE_LIGHT* pLights = m_pSceneFile->GetLights();
+	for (uint32_t i = 0; i < m_pSceneFile->GetLightCount(); i++)
+	{
+		const SceneFile::SCENE_LIGHT& source = pLights[i];
+		LightManager::LIGHT_SOURCE light;
+		light.position = glm::vec3(source.position[0], source.position[1], source.position[2]);
+		light.direction = glm::vec3(source.direction[0], source.direction[1], source.direction[2]);
+		light.spotDirection = glm::vec3(source.spotDirection[0], source.spotDirection[1], source.spotDirection[2]);
+		light.ambientColor = glm::vec3(source.ambientColor[0], source.ambientColor[1], source.ambientColor[2]);
+		light.diffuseColor = glm::vec3(source.diffuseColor[0], source.diffuseColor[1], source.diffuseColor[2]);
+		light.specularColor = glm::vec3(source.specularColor[0], source.specularColor[1], source.specularColor[2]);
+		light.focalStrength = source.focalStrength;
+		light.specularIntensity = source.specularIntensity;
+		light.range = source.range;
+		m_pLightManager->AddLightSource(light);
+	}
+}
+
+/***********************************************************
+ *  BuildSceneFileRenderList()
+ *
+ *  This method is used for building the retained render
+ *  items from the item records of the mapped scene file.
+ *  The records hold indices instead of tags, so only the
+ *  textures of the file are looked up, not every item.
+ ***********************************************************/
+void SceneManager::BuildSceneFileRenderList()
+{
+	// a texture that failed to load has no slot, so the file
+	// texture indices are mapped to the registry slots
+	const SceneFile::SCENE_TEXTURE* pTextures = m_pSceneFile->GetTextures();
+	std::vector<int> textureSlots(m_pSceneFile->GetTextureCount());
+	for (uint32_t i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+	{
+		textureSlots[i] = FindTextureSlot(m_pSceneFile->GetString(pTextures[i].tagOffset));
+	}
+
+	const SceneFile::SCENE_ITEM* pItems = m_pSceneFile->GetItems();
+	int itemCount = (int)m_pSceneFile->GetItemCount();
+	ReserveRenderItems(itemCount * m_sceneCopies);
+	for (int i = 0; i < itemCount; i++)
+	{
+		const SceneFile::SCENE_ITEM& item = pItems[i];
+		if ((item.meshID < 0) || (item.meshID >= SceneMeshes::MESH_COUNT))
+		{
+			continue;
+		}
+
+		int textureSlot = -1;
+		if ((item.textureIndex >= 0) && (item.textureIndex < (int)textureSlots.size()))
+		{
+			textureSlot = textureSlots[item.textureIndex];
+		}
+		int materialIndex = -1;
+		if ((item.materialIndex >= 0) && (item.materialIndex < (int)m_objectMaterials.size()))
+		{
+			materialIndex = item.materialIndex;
+		}
+
+		AddResolvedRenderItem(
+			item.meshID,
+			glm::vec3(item.scale[0], item.scale[1], item.scale[2]),
+			glm::vec3(item.rotationDegrees[0], item.rotationDegrees[1], item.rotationDegrees[2]),
+			glm::vec3(item.position[0], item.position[1], item.position[2]),
+			textureSlot,
+			materialIndex,
+			glm::vec4(item.color[0], item.color[1], item.color[2], item.color[3]),
+			glm::vec2(item.uvScale[0], item.uvScale[1]));
+	}
+}
+
+/***********************************************************
+ *  SetShaderFiles()
+ *
+ *  This method is used for passing in the GLSL files the
+ *  scene shader program was loaded from, so that it can be
+ *  rebuilt when they change.
+ ***********************************************************/
+void SceneManager::SetShaderFiles(const std::string& vertexShaderFile, const std::string& fragmentShaderFile)
+{
+	m_vertexShaderFilename = vertexShaderFile;
+	m_fragmentShaderFilename = fragmentShaderFile;
+}
+
+/***********************************************************
+ *  ApplyFileChanges()
+ *
+ *  This method is used for reloading the shader, texture and
+ *  scene files that changed since the last frame.  It is
+ *  called between frames, so a frame is always drawn wholly
+ *  with the old or wholly with the new data.  Each change
+ *  only rebuilds what was loaded from the changed file, and
+ *  a file that fails to load keeps what was loaded before.
+ *  It returns true when any watched file had changed.
+ ***********************************************************/
+bool SceneManager::ApplyFileChanges()
+{
+	if (!m_pFileWatcher->IsRunning())
+	{
+		return(false);
+	}
+
+	m_pFileWatcher->TakeChangedFiles(m_changedWatchIDs);
+
+	bool bShadersChanged = false;
+	bool bSceneChanged = false;
+	for (size_t i = 0; i < m_changedWatchIDs.size(); i++)
+	{
+		int watchID = m_changedWatchIDs[i];
+		if ((watchID == m_vertexShaderWatchID) || (watchID == m_fragmentShaderWatchID))
+		{
+			bShadersChanged = true;
+		}
+		else if (watchID == m_sceneWatchID)
+		{
+			bSceneChanged = true;
+		}
+		else
+		{
+			// the new image is swapped in by the texture residency
+			// once it is uploaded, until then the old one is drawn
+			std::unordered_map<int, int>::const_iterator found = m_textureWatchSlots.find(watchID);
+			if (found != m_textureWatchSlots.end())
+			{
+				std::cout << "INFO: Reloading texture slot " << found->second << std::endl;
+				m_pTextureResidency->ReloadTexture(found->second);
+			}
+		}
+	}
+
+	if (bShadersChanged && ReloadShaders())
+	{
+		std::cout << "INFO: Reloaded shaders:" << m_vertexShaderFilename << ", " << m_fragmentShaderFilename << std::endl;
+	}
+	if (bSceneChanged && ReloadSceneFile())
+	{
+		std::cout << "INFO: Reloaded scene file:" << m_sceneFilename << std::endl;
+	}
+
+	return(!m_changedWatchIDs.empty());
+}
+
+/***********************************************************
+ *  ConnectShaderProgram()
+ *
+ *  This method is used for looking up the uniforms of a
+ *  newly linked scene shader program into the passed in
+ *  uniform cache, and connecting its storage and uniform
+ *  blocks.  The program must be in use.
+ ***********************************************************/
+void SceneManager::ConnectShaderProgram(GLuint programID, ShaderUniformCache* pUniforms)
+{
+	pUniforms->LoadLocations(programID);
+	m_pLightManager->ConnectProgram(programID);
+	m_pTextureRegistry->ConnectProgram(programID);
+	m_pShadowManager->ConnectProgram(programID);
+	ConnectMaterialBlock(programID);
+	// both the scene built in code and scene files are lit
+	pUniforms->SetIntValue(ShaderUniformCache::UNIFORM_USE_LIGHTING, true);
+}
+
+/***********************************************************
+ *  BuildShaderPermutations()
+ *
+ *  This method is used for building the programs of the
+ *  shader permutations the render items use, so that they
+ *  are compiled or loaded while the scene is prepared and
+ *  not in the middle of the first frames drawn.
+ ***********************************************************/
+void SceneManager::BuildShaderPermutations()
+{
+	if (!m_bShaderPermutations)
+	{
+		return;
+	}
+
+	bool bUsed[ShaderPermutations::PERMUTATION_COUNT] = { false };
+	int lightCount = m_pLightManager->GetLightCount();
+	for (int i = 0; i < (int)m_renderList.meshIDs.size(); i++)
+	{
+		bUsed[SelectRenderItemPermutation(i, lightCount)] = true;
+	}
+
+	for (int p = 0; p < ShaderPermutations::PERMUTATION_COUNT; p++)
+	{
+		if (bUsed[p])
+		{
+			m_pShaderPermutations->GetProgram(p);
+		}
+	}
+
+	std::cout << "INFO: Shader permutations compiled: " << m_pShaderPermutations->GetCompileCount()
+		<< ", loaded from the shader cache: " << m_pShaderPermutations->GetCacheLoadCount() << std::endl;
+}
+
+/***********************************************************
+ *  SelectRenderItemPermutation()
+ *
+ *  This method is used for picking the shader permutation of
+ *  a render item.  Items with a texture slot sample it and
+ *  items with a material are lit by the scene lights.
+ ***********************************************************/
+int SceneManager::SelectRenderItemPermutation(int itemIndex, int lightCount) const
+{
+	return(ShaderPermutations::MakePermutation(
+		m_renderList.textureSlots[itemIndex] >= 0,
+		m_renderList.materialIndices[itemIndex] >= 0,
+		lightCount));
+}
+
+/***********************************************************
+ *  UseShaderPermutation()
+ *
+ *  This method is used for putting the program of a shader
+ *  permutation in use, connecting it the first time it is
+ *  used.  When permutations are off or the permutation did
+ *  not build, the uniform branching program is used.  The
+ *  view uniforms are set into every program, since the view
+ *  manager only sets them into the fallback program.
+ ***********************************************************/
+ShaderUniformCache* SceneManager::UseShaderPermutation(int permutation)
+{
+	ShaderUniformCache* pUniforms = m_pUniformCache;
+	GLuint programID = 0;
+	if (m_bShaderPermutations)
+	{
+		programID = m_pShaderPermutations->GetProgram(permutation);
+	}
+	if (0 != programID)
+	{
+		pUniforms = &m_permutationUniforms[permutation];
+	}
+	else
+	{
+		programID = m_pUniformCache->GetProgramID();
+	}
+
+	glUseProgram(programID);
+	if (pUniforms->GetProgramID() != programID)
+	{
+		ConnectShaderProgram(programID, pUniforms);
+	}
+
+	pUniforms->SetMat4Value(ShaderUniformCache::UNIFORM_VIEW, m_viewMatrix);
+	pUniforms->SetMat4Value(ShaderUniformCache::UNIFORM_PROJECTION, m_projectionMatrix);
+	pUniforms->SetVec3Value(ShaderUniformCache::UNIFORM_VIEW_POSITION, m_viewPosition);
+
+	return(pUniforms);
+}
+
+/***********************************************************
+ *  ReloadShaders()
+ *
+ *  This method is used for building a new scene shader
+ *  program from the GLSL files and putting it in place of
+ *  the one in use.  When the files do not compile or link,
+ *  their errors are shown and the old program stays in use.
+ ***********************************************************/
+bool SceneManager::ReloadShaders()
+{
+	GLuint programID = ShaderCompiler::BuildProgram(
+		m_vertexShaderFilename.c_str(),
+		m_fragmentShaderFilename.c_str());
+	if (0 == programID)
+	{
+		std::cout << "Keeping the previous shaders" << std::endl;
+		return(false);
+	}
+
+	// the view manager sets its uniforms through the shader
+	// manager each frame, so it follows the new program
+	GLuint previousID = m_pShaderManager->m_programID;
+	m_pShaderManager->m_programID = programID;
+	glUseProgram(programID);
+	ConnectShaderProgram(programID, m_pUniformCache);
+	// draws still in flight keep the old program alive
+	glDeleteProgram(previousID);
+
+	// the permutations are built again from the same files, and
+	// their uniform caches are cleared since a new program may
+	// reuse the name of a deleted one
+	if (m_bShaderPermutations &&
+		m_pShaderPermutations->SetShaderFiles(m_vertexShaderFilename, m_fragmentShaderFilename))
+	{
+		for (int p = 0; p < ShaderPermutations::PERMUTATION_COUNT; p++)
+		{
+			m_permutationUniforms[p] = ShaderUniformCache();
+		}
+		BuildShaderPermutations();
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReloadSceneFile()
+ *
+ *  This method is used for reading the changed scene file
+ *  again.  The materials, lights and render items are all
+ *  rebuilt from it, while the textures that are already
+ *  loaded are kept and only the new ones are requested.
+ *  When the file cannot be read the current scene is kept.
+ ***********************************************************/
+bool SceneManager::ReloadSceneFile()
+{
+	if (!m_pSceneFile->Open(m_sceneFilename.c_str()))
+	{
+		std::cout << "Keeping the previous scene" << std::endl;
+		return(false);
+	}
+
+	m_objectMaterials.clear();
+	m_pLightManager->ClearLightSources();
+	LoadSceneFileResources();
+	IndexObjectMaterials();
+	CreateMaterialBuffer();
+
+	m_renderList = RENDER_LIST();
+	m_bTransformsDirty = false;
+	m_geometryVersion++;
+	BuildSceneFileRenderList();
+	m_pSceneFile->Close();
+	ReplicateRenderItems();
+	m_sceneBVH.Build(m_renderList.boundsCenters, m_renderList.boundsRadii);
+	BuildShaderPermutations();
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetSceneView()
+ *
+ *  This method is used for passing in the view and projection
+ *  matrices that the next rendered frame will be viewed with.
+ ***********************************************************/
+void SceneManager::SetSceneView(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = glm::vec3(glm::inverse(view)[3]);
+	m_viewFrustum.ExtractPlanes(projection * view);
+}
+
+/***********************************************************
+ *  PickRenderItem()
+ *
+ *  This method is used for finding the nearest render item
+ *  under the passed in window position.  The position is
+ *  turned into a ray through the current view and cast
+ *  against the scene BVH.
+ ***********************************************************/
+int SceneManager::PickRenderItem(float windowX, float windowY)
+{
+	GLint viewport[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	if ((viewport[2] <= 0) || (viewport[3] <= 0))
+	{
+		return(-1);
+	}
+
+	// window coordinates start at the top left corner
+	float ndcX = 2.0f * (windowX - viewport[0]) / viewport[2] - 1.0f;
+	float ndcY = 1.0f - 2.0f * (windowY - viewport[1]) / viewport[3];
+
+	// unproject the position on the near and far planes
+	glm::mat4 inverseViewProjection = glm::inverse(m_projectionMatrix * m_viewMatrix);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+
+	float distance = 0.0f;
+	return(m_sceneBVH.RayCast(origin, direction, distance));
+}
+
+/***********************************************************
+ *  PrintRenderItem()
+ *
+ *  This method is used for writing what a picked render item
+ *  is drawn with and where it is, so an item clicked in the
+ *  window can be found in the scene file.
+ ***********************************************************/
+void SceneManager::PrintRenderItem(int itemIndex) const
+{
+	if ((itemIndex < 0) || (itemIndex >= (int)m_renderList.meshIDs.size()))
+	{
+		std::cout << "INFO: No render item under the cursor" << std::endl;
+		return;
+	}
+
+	int materialIndex = m_renderList.materialIndices[itemIndex];
+	int textureSlot = m_renderList.textureSlots[itemIndex];
+	const glm::vec3& position = m_renderList.positions[itemIndex];
+
+	std::cout << "INFO: Picked render item " << itemIndex
+		<< ": mesh " << m_renderList.meshIDs[itemIndex]
+		<< ", material " << ((materialIndex >= 0) ? m_objectMaterials[materialIndex].tag : "none")
+		<< ", texture " << ((textureSlot >= 0) ? m_textureIDs[textureSlot].tag : "none")
+		<< ", position " << position.x << " " << position.y << " " << position.z << std::endl;
+}
+
+/***********************************************************
+ *  FindItemsLitBy()
+ *
+ *  This method is used for finding the render items inside
+ *  of the range of a scene light.  Directional lights and
+ *  lights without a range reach every render item.
+ ***********************************************************/
+void SceneManager::FindItemsLitBy(int lightIndex, std::vector<int>& items)
+{
+	items.clear();
+	if ((lightIndex < 0) || (lightIndex >= m_pLightManager->GetLightCount()))
+	{
+		return;
+	}
+
+	const LightManager::LIGHT_SOURCE& light = m_pLightManager->GetLightSource(lightIndex);
+	bool bDirectional = glm::dot(light.direction, light.direction) > 0.0f;
+
+	if (bDirectional || (light.range <= 0.0f))
+	{
+		for (int i = 0; i < (int)m_renderList.meshIDs.size(); i++)
+		{
+			items.push_back(i);
+		}
+		return;
+	}
+
+	// moved render items must be refit before the query
+	UpdateRenderItemTransforms();
+	m_sceneBVH.QuerySphere(light.position, light.range, items);
+}
+
+/***********************************************************
+ *  UpdateLightInfluence()
+ *
+ *  This method is used for finding the lights whose range
+ *  reaches no render item, so that the tile light lists
+ *  leave them out.  The lights are only checked again after
+ *  a render item moved or a light changed.
+ ***********************************************************/
+void SceneManager::UpdateLightInfluence()
+{
+	if ((m_lightInfluenceGeometryVersion == m_geometryVersion) &&
+		(m_lightInfluenceLightVersion == m_pLightManager->GetLightVersion()))
+	{
+		return;
+	}
+
+	// a query finds at most every render item, so the list
+	// only grows when render items were added
+	m_litItems.reserve(m_renderList.meshIDs.size());
+	int lightCount = m_pLightManager->GetLightCount();
+	for (int i = 0; i < lightCount; i++)
+	{
+		FindItemsLitBy(i, m_litItems);
+		m_pLightManager->SetLightReachesItems(i, !m_litItems.empty());
+	}
+
+	m_lightInfluenceGeometryVersion = m_geometryVersion;
+	m_lightInfluenceLightVersion = m_pLightManager->GetLightVersion();
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  sorting the retained render items by draw state and
+ *  drawing the basic 3D shapes
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	if (NULL == m_pShaderManager)
+	{
+		return;
+	}
+
+	m_renderStats = RENDER_STATS();
+	m_pUniformCache->ResetCounters();
+	for (int p = 0; p < ShaderPermutations::PERMUTATION_COUNT; p++)
+	{
+		m_permutationUniforms[p].ResetCounters();
+	}
+
+	// the transient data of the last frame is given back at once,
+	// and the arena only grows when render items were added
+	m_frameArena.Reset();
+	m_frameArena.Reserve(GetFrameArenaBytes());
+	m_instanceBatches.Release();
+	m_jobBatchCounts.Release();
+
+	// swap in the texture images decoded since the last frame
+	m_pTextureLoader->Update();
+	UpdateTextureRegistry();
+	// only the render items that were moved get new matrices
+	UpdateRenderItemTransforms();
+	UpdateLightInfluence();
+	// upload changed lights and rebuild the tile light lists
+	m_pLightManager->UpdateLightBuffers(m_viewMatrix, m_projectionMatrix);
+
+	// collect and sort the draws, and cull the casters of the
+	// shadow maps that are out of date
+	BuildRenderQueue();
+	m_pShadowManager->UpdateViews(*m_pLightManager, m_viewMatrix, m_projectionMatrix, m_geometryVersion);
+	CollectShadowCasters();
+
+	// the shadow maps are drawn before the scene reads them, with
+	// all the dynamic data of the frame in one region
+	m_bOcclusionCullFrame = m_bOcclusionCulling && m_pOcclusionCuller->HasPyramid();
+	size_t frameBytes = GetQueueFrameBytes() + GetShadowFrameBytes();
+	if ((frameBytes > 0) && m_pFrameData->BeginFrame(frameBytes))
+	{
+		RenderShadowMaps();
+		SubmitRenderQueue();
+		m_pFrameData->EndFrame();
+	}
+	else
+	{
+		m_pShadowManager->BindShadowData();
+		// nothing was drawn, so the next frame culls against the
+		// cleared depth
+		if (m_bOcclusionCulling)
+		{
+			m_pOcclusionCuller->BuildPyramid(m_projectionMatrix * m_viewMatrix);
+		}
+	}
+
+	m_renderStats.uniformUploads = m_pUniformCache->GetUploadCount();
+	for (int p = 0; p < ShaderPermutations::PERMUTATION_COUNT; p++)
+	{
+		m_renderStats.uniformUploads += m_permutationUniforms[p].GetUploadCount();
+	}
+}
+
+/***********************************************************
+ *  GetFrameArenaBytes()
+ *
+ *  This method is used for getting the most bytes of the
+ *  frame arena a frame of the render items can use.  Every
+ *  transient array holds at most one element per render
+ *  item, so the arena sized by this never runs out.
+ ***********************************************************/
+size_t SceneManager::GetFrameArenaBytes() const
+{
+	size_t itemCount = m_renderList.meshIDs.size();
+	size_t jobCount = (itemCount + JOB_GRAIN_SIZE - 1) / JOB_GRAIN_SIZE;
+
+	size_t itemBytes = sizeof(int) +
+		sizeof(RenderQueue::QUEUE_ENTRY) +
+		sizeof(INSTANCE_BATCH) +
+		ShadowManager::SHADOW_VIEW_COUNT * sizeof(int);
+
+	return(itemCount * itemBytes + jobCount * sizeof(int) +
+		FRAME_ARENA_ARRAY_COUNT * FRAME_ARENA_ALIGNMENT);
+}
+
+/***********************************************************
+ *  BuildRenderQueue()
+ *
+ *  This method is used for collecting the render items into
+ *  the render queue with sort keys built from their draw
+ *  state and their depth from the current camera view.
+ *  Only the render items the scene BVH finds inside of the
+ *  view volume reach the queue, the rest are culled.  Each
+ *  visible item also picks its mesh level of detail and its
+ *  shader permutation, which are part of the sort key so
+ *  equal levels are instanced and each program is used once.
+ ***********************************************************/
+void SceneManager::BuildRenderQueue()
+{
+	int itemCount = (int)m_renderList.meshIDs.size();
+
+	m_visibleItems.Allocate(m_frameArena, itemCount);
+	m_sceneBVH.QueryFrustum(m_viewFrustum, m_visibleItems);
+	m_renderStats.culledCount = itemCount - m_visibleItems.GetCount();
+
+	// every visible item has its own queue entry, so the sort
+	// keys are built in parallel
+	int visibleCount = m_visibleItems.GetCount();
+	m_renderQueue.Begin(m_frameArena, visibleCount);
+	int lightCount = m_pLightManager->GetLightCount();
+	m_renderQueue.Resize(visibleCount);
+	m_pJobSystem->ParallelFor(visibleCount, JOB_GRAIN_SIZE,
+		[this, lightCount](int begin, int end, int threadIndex)
+	{
+		for (int v = begin; v < end; v++)
+		{
+			int i = m_visibleItems[v];
+
+			// the distance along the view direction to the item origin
+			glm::vec4 viewPosition = m_viewMatrix * m_renderList.modelMatrices[i][3];
+
+			m_renderList.lodLevels[i] = (char)SelectRenderItemLOD(i);
+			m_renderList.permutations[i] = (char)SelectRenderItemPermutation(i, lightCount);
+			m_renderQueue.SetEntry(v,
+				RenderQueue::MakeSortKey(
+					m_renderList.transparent[i] != 0,
+					m_renderList.permutations[i],
+					m_renderList.textureSlots[i],
+					m_renderList.materialIndices[i],
+					m_renderList.meshIDs[i] * SceneMeshes::LOD_COUNT + m_renderList.lodLevels[i],
+					-viewPosition.z,
+					SORT_FAR_DEPTH),
+				i);
+		}
+	});
+
+	m_renderQueue.Sort();
+}
+
+/***********************************************************
+ *  CanInstanceTogether()
+ *
+ *  This method is used for checking if two render items can
+ *  be drawn in the same instanced draw.  The model matrix,
+ *  color, material and UV scale of each item are instance
+ *  data, so only the mesh, its level of detail, the shader
+ *  permutation and the texture must match.
+ *  Blended items are always drawn on their own to keep
+ *  their back to front order.
+ ***********************************************************/
+bool SceneManager::CanInstanceTogether(int firstItem, int secondItem) const
+{
+	if ((0 != m_renderList.transparent[firstItem]) ||
+		(0 != m_renderList.transparent[secondItem]))
+	{
+		return(false);
+	}
+
+	if ((m_renderList.meshIDs[firstItem] != m_renderList.meshIDs[secondItem]) ||
+		(m_renderList.lodLevels[firstItem] != m_renderList.lodLevels[secondItem]) ||
+		(m_renderList.permutations[firstItem] != m_renderList.permutations[secondItem]) ||
+		(m_renderList.textureSlots[firstItem] != m_renderList.textureSlots[secondItem]))
+	{
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildDrawCommands()
+ *
+ *  This method is used for turning the instanced draws of
+ *  the frame into indirect commands written to the passed in
+ *  mapped memory.  The shaders select the texture of each
+ *  command, so every command of the frame is issued with one
+ *  multi-draw.  Each command points at its instance data by
+ *  the base instance of the frame's region.
+ ***********************************************************/
+void SceneManager::BuildDrawCommands(SceneMeshes::DRAW_COMMAND* pCommands)
+{
+	int lastMeshID = -1;
+	int lastTextureSlot = -1;
+
+	for (int b = 0; b < m_instanceBatches.GetCount(); b++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[b];
+		int meshID = m_renderList.meshIDs[batch.itemIndex];
+		int textureSlot = m_renderList.textureSlots[batch.itemIndex];
+		m_pTextureResidency->MarkTextureUsed(textureSlot);
+
+		if ((0 == b) || (textureSlot != lastTextureSlot))
+		{
+			m_renderStats.textureChanges++;
+			lastTextureSlot = textureSlot;
+		}
+
+		pCommands[b] = m_pSceneMeshes->MakeDrawCommand(
+			meshID, m_renderList.lodLevels[batch.itemIndex], batch.instanceCount, m_baseInstance + batch.firstInstance);
+		if (meshID != lastMeshID)
+		{
+			m_renderStats.meshChanges++;
+			lastMeshID = meshID;
+		}
+	}
+}
+
+/***********************************************************
+ *  RecordInstanceBatches()
+ *
+ *  This method is used by the frame preparation jobs for
+ *  filling in the instance data of a part of the render
+ *  queue and recording its instanced draws into the passed
+ *  in draws, which have room for one draw per queue entry.
+ *  Neighboring queue entries that share a mesh and texture
+ *  are recorded as one instanced draw.
+ ***********************************************************/
+int SceneManager::RecordInstanceBatches(int firstQueueIndex, int lastQueueIndex, INSTANCE_BATCH* pBatches)
+{
+	int batchCount = 0;
+
+	for (int q = firstQueueIndex; q < lastQueueIndex; q++)
+	{
+		int i = m_renderQueue.GetItemIndex(q);
+
+		if ((0 == batchCount) ||
+			!CanInstanceTogether(pBatches[batchCount - 1].itemIndex, i))
+		{
+			INSTANCE_BATCH batch;
+			batch.firstInstance = q;
+			batch.instanceCount = 0;
+			batch.itemIndex = i;
+			pBatches[batchCount++] = batch;
+		}
+		pBatches[batchCount - 1].instanceCount++;
+
+		// the mapped memory is write combined, so the instance is
+		// built on the stack and written out whole
+		SceneMeshes::INSTANCE_DATA instance;
+		instance.model = m_renderList.modelMatrices[i];
+		instance.color = m_renderList.colors[i];
+		instance.materialIndex = (m_renderList.materialIndices[i] >= 0) ? m_renderList.materialIndices[i] : 0;
+		instance.textureSlot = m_renderList.textureSlots[i];
+		instance.uvScale = m_renderList.uvScales[i];
+		m_pInstanceData[q] = instance;
+	}
+
+	return(batchCount);
+}
+
+/***********************************************************
+ *  MergeCommandBuffers()
+ *
+ *  This method is used for joining the draws the jobs
+ *  recorded in queue order.  Each job's draws start at the
+ *  queue index of its part and only ever move toward the
+ *  front, so they are packed together in place.  An
+ *  instanced draw cut in two at the edge of two jobs' parts
+ *  is joined back together, so the draws match those of a
+ *  single threaded recording.
+ ***********************************************************/
+void SceneManager::MergeCommandBuffers()
+{
+	int batchCount = 0;
+
+	for (int j = 0; j < m_jobBatchCounts.GetCount(); j++)
+	{
+		int jobStart = j * JOB_GRAIN_SIZE;
+		int jobCount = m_jobBatchCounts[j];
+		int first = 0;
+
+		if ((jobCount > 0) && (batchCount > 0) &&
+			CanInstanceTogether(m_instanceBatches[batchCount - 1].itemIndex, m_instanceBatches[jobStart].itemIndex))
+		{
+			m_instanceBatches[batchCount - 1].instanceCount += m_instanceBatches[jobStart].instanceCount;
+			first = 1;
+		}
+		for (int b = first; b < jobCount; b++)
+		{
+			m_instanceBatches[batchCount++] = m_instanceBatches[jobStart + b];
+		}
+	}
+	m_instanceBatches.Resize(batchCount);
+}
+
+/***********************************************************
+ *  GetQueueFrameBytes()
+ *
+ *  This method is used for getting the bytes of the frame
+ *  data region the instance data and indirect commands of
+ *  the render queue are written to, along with the cull
+ *  records and empty commands of a frame culled on the GPU.
+ *  There are never more commands than queue entries, and
+ *  each allocation may need up to one element of padding.
+ ***********************************************************/
+size_t SceneManager::GetQueueFrameBytes() const
+{
+	size_t queueCount = (size_t)m_renderQueue.GetCount();
+	if (0 == queueCount)
+	{
+		return(0);
+	}
+
+	size_t commandBytes = queueCount * sizeof(SceneMeshes::DRAW_COMMAND) + sizeof(SceneMeshes::DRAW_COMMAND);
+	size_t frameBytes = queueCount * sizeof(SceneMeshes::INSTANCE_DATA) + sizeof(SceneMeshes::INSTANCE_DATA) +
+		commandBytes;
+	if (m_bOcclusionCullFrame)
+	{
+		frameBytes += queueCount * sizeof(OcclusionCuller::CULL_RECORD) + sizeof(OcclusionCuller::CULL_RECORD) +
+			commandBytes;
+	}
+
+	return(frameBytes);
+}
+
+/***********************************************************
+ *  SubmitRenderQueue()
+ *
+ *  This method is used for drawing the sorted render queue.
+ *  The jobs fill in the instance data and record instanced
+ *  draws for separate parts of the queue, and this thread
+ *  merges them and makes all of the OpenGL calls.  Each run
+ *  of instanced draws sharing a shader permutation is issued
+ *  with one multi-draw from the indirect buffer, and the
+ *  opaque draws are sorted by permutation first so each of
+ *  their programs is put in use once.  Every instance carries
+ *  its texture slot, so no texture is bound between the
+ *  draws.  The instance data and the indirect commands are
+ *  written into the frame's region of the mapped frame data
+ *  buffer, which must already be begun for the frame.
+ *  With occlusion culling the commands are drawn from the
+ *  culled buffers instead, and the depth of the opaque draws
+ *  is copied into the depth pyramid for the next frame.  The
+ *  depth prepass draws the opaque commands before any of
+ *  them are shaded.
+ ***********************************************************/
+void SceneManager::SubmitRenderQueue()
+{
+	int queueCount = m_renderQueue.GetCount();
+
+	if (queueCount == 0)
+	{
+		if (m_bOcclusionCulling)
+		{
+			m_pOcclusionCuller->BuildPyramid(m_projectionMatrix * m_viewMatrix);
+		}
+		return;
+	}
+
+	// there are never more indirect commands than queue entries
+	size_t instanceBytes = queueCount * sizeof(SceneMeshes::INSTANCE_DATA);
+	size_t commandBytes = queueCount * sizeof(SceneMeshes::DRAW_COMMAND);
+	size_t instanceOffset = 0;
+	size_t commandOffset = 0;
+	m_pInstanceData = (SceneMeshes::INSTANCE_DATA*)m_pFrameData->Allocate(
+		instanceBytes, sizeof(SceneMeshes::INSTANCE_DATA), instanceOffset);
+	SceneMeshes::DRAW_COMMAND* pCommands = (SceneMeshes::DRAW_COMMAND*)m_pFrameData->Allocate(
+		commandBytes, sizeof(SceneMeshes::DRAW_COMMAND), commandOffset);
+	m_baseInstance = (int)(instanceOffset / sizeof(SceneMeshes::INSTANCE_DATA));
+
+	// a job records at most one draw per queue entry, so each
+	// job gets the draws at the queue indices of its part
+	m_instanceBatches.Allocate(m_frameArena, queueCount);
+	m_instanceBatches.Resize(queueCount);
+	m_jobBatchCounts.Allocate(m_frameArena, (queueCount + JOB_GRAIN_SIZE - 1) / JOB_GRAIN_SIZE);
+	m_jobBatchCounts.Resize((queueCount + JOB_GRAIN_SIZE - 1) / JOB_GRAIN_SIZE);
+	m_pJobSystem->ParallelFor(queueCount, JOB_GRAIN_SIZE,
+		[this](int begin, int end, int threadIndex)
+	{
+		// each range is one grain, so its draws are written by
+		// exactly one thread
+		m_jobBatchCounts[begin / JOB_GRAIN_SIZE] =
+			RecordInstanceBatches(begin, end, &m_instanceBatches[begin]);
+	});
+	MergeCommandBuffers();
+	BuildDrawCommands(pCommands);
+
+	int commandCount = m_instanceBatches.GetCount();
+	// blended items are sorted after every opaque item
+	int opaqueCommandCount = 0;
+	while ((opaqueCommandCount < commandCount) &&
+		(0 == m_renderList.transparent[m_instanceBatches[opaqueCommandCount].itemIndex]))
+	{
+		opaqueCommandCount++;
+	}
+
+	GLuint commandBufferID = m_pFrameData->GetBufferID();
+	GLuint instanceBufferID = m_pFrameData->GetBufferID();
+	int firstCommand = (int)(commandOffset / sizeof(SceneMeshes::DRAW_COMMAND));
+	if (m_bOcclusionCullFrame && CullOccludedInstances(instanceOffset))
+	{
+		commandBufferID = m_pOcclusionCuller->GetCommandBufferID();
+		instanceBufferID = m_pOcclusionCuller->GetInstanceBufferID();
+		firstCommand = 0;
+	}
+
+	if (m_bDepthPrepass && (opaqueCommandCount > 0))
+	{
+		m_pDepthPrepass->Begin(
+			m_viewMatrix,
+			m_projectionMatrix,
+			SceneMeshes::VERTEX_FORMAT_PACKED == m_pSceneMeshes->GetVertexFormat(),
+			m_pSceneMeshes->GetPositionCenter(),
+			m_pSceneMeshes->GetPositionExtents());
+		m_pSceneMeshes->DrawMeshesIndirect(commandBufferID, firstCommand, opaqueCommandCount, instanceBufferID);
+		m_pDepthPrepass->End();
+		m_renderStats.drawCount++;
+	}
+
+	// blended items write depth but hide nothing behind them, so
+	// the pyramid is built between the opaque and blended draws
+	SubmitCommandRuns(commandBufferID, firstCommand, 0, opaqueCommandCount, instanceBufferID);
+	if (m_bOcclusionCulling)
+	{
+		m_pOcclusionCuller->BuildPyramid(m_projectionMatrix * m_viewMatrix);
+	}
+	SubmitCommandRuns(commandBufferID, firstCommand, opaqueCommandCount, commandCount, instanceBufferID);
+	glDepthFunc(GL_LESS);
+	m_pInstanceData = NULL;
+
+	// leave the fallback program in use for the view manager and
+	// the draws made outside of the render queue
+	glUseProgram(m_pUniformCache->GetProgramID());
+
+	m_renderStats.commandCount = commandCount;
+	m_renderStats.itemCount = queueCount;
+	m_renderStats.submittedCount = queueCount;
+}
+
+/***********************************************************
+ *  SubmitCommandRuns()
+ *
+ *  This method is used for drawing a range of the frame's
+ *  indirect commands.  Each run of commands sharing a shader
+ *  permutation is issued with one multi-draw.
+ ***********************************************************/
+void SceneManager::SubmitCommandRuns(
+	GLuint commandBufferID,
+	int firstCommand,
+	int beginCommand,
+	int endCommand,
+	GLuint instanceBufferID)
+{
+	int runStart = beginCommand;
+	while (runStart < endCommand)
+	{
+		int permutation = m_renderList.permutations[m_instanceBatches[runStart].itemIndex];
+		int runEnd = runStart + 1;
+		while ((runEnd < endCommand) &&
+			(m_renderList.permutations[m_instanceBatches[runEnd].itemIndex] == permutation))
+		{
+			runEnd++;
+		}
+
+		ShaderUniformCache* pUniforms = UseShaderPermutation(permutation);
+		pUniforms->SetIntValue(ShaderUniformCache::UNIFORM_USE_INSTANCING, true);
+		pUniforms->SetIntValue(ShaderUniformCache::UNIFORM_USE_PACKED_VERTICES,
+			SceneMeshes::VERTEX_FORMAT_PACKED == m_pSceneMeshes->GetVertexFormat());
+		pUniforms->SetVec3Value(ShaderUniformCache::UNIFORM_PACKED_POSITION_CENTER, m_pSceneMeshes->GetPositionCenter());
+		pUniforms->SetVec3Value(ShaderUniformCache::UNIFORM_PACKED_POSITION_EXTENTS, m_pSceneMeshes->GetPositionExtents());
+
+		m_pSceneMeshes->DrawMeshesIndirect(
+			commandBufferID,
+			firstCommand + runStart,
+			runEnd - runStart,
+			instanceBufferID);
+		m_renderStats.drawCount++;
+		// meshes, materials and textures are all selected per
+		// instance, so only the program changes between draws
+		m_renderStats.stateChanges++;
+		runStart = runEnd;
+	}
+}
+
+/***********************************************************
+ *  CullOccludedInstances()
+ *
+ *  This method is used for writing the bounding sphere and
+ *  command of every queue entry, and a copy of each indirect
+ *  command with no instances, then culling them on the GPU.
+ *  The empty commands are rebuilt from the instanced draws
+ *  rather than read back from the write combined memory.
+ *  It returns false when the frame has no room for them.
+ ***********************************************************/
+bool SceneManager::CullOccludedInstances(size_t instanceOffset)
+{
+	int queueCount = m_renderQueue.GetCount();
+	int commandCount = m_instanceBatches.GetCount();
+
+	size_t recordOffset = 0;
+	size_t commandOffset = 0;
+	OcclusionCuller::CULL_RECORD* pRecords = (OcclusionCuller::CULL_RECORD*)m_pFrameData->Allocate(
+		queueCount * sizeof(OcclusionCuller::CULL_RECORD), sizeof(OcclusionCuller::CULL_RECORD), recordOffset);
+	SceneMeshes::DRAW_COMMAND* pCommands = (SceneMeshes::DRAW_COMMAND*)m_pFrameData->Allocate(
+		commandCount * sizeof(SceneMeshes::DRAW_COMMAND), sizeof(SceneMeshes::DRAW_COMMAND), commandOffset);
+	if ((NULL == pRecords) || (NULL == pCommands))
+	{
+		return(false);
+	}
+
+	OcclusionCuller::CULL_RECORD record;
+	record.padding[0] = record.padding[1] = record.padding[2] = 0;
+	for (int b = 0; b < commandCount; b++)
+	{
+		const INSTANCE_BATCH& batch = m_instanceBatches[b];
+		// the culled instances of a command start at the same
+		// instance of the culled buffer as of the frame
+		pCommands[b] = m_pSceneMeshes->MakeDrawCommand(
+			m_renderList.meshIDs[batch.itemIndex],
+			m_renderList.lodLevels[batch.itemIndex],
+			0,
+			batch.firstInstance);
+
+		record.commandIndex = (GLuint)b;
+		for (int q = batch.firstInstance; q < batch.firstInstance + batch.instanceCount; q++)
+		{
+			int i = m_renderQueue.GetItemIndex(q);
+			record.sphere = glm::vec4(m_renderList.boundsCenters[i], m_renderList.boundsRadii[i]);
+			pRecords[q] = record;
+		}
+	}
+
+	m_pOcclusionCuller->CullInstances(
+		m_pFrameData->GetBufferID(),
+		recordOffset,
+		instanceOffset,
+		commandOffset,
+		queueCount,
+		commandCount);
+	m_renderStats.occlusionTestedCount = queueCount;
+
+	return(true);
+}
+
+/***********************************************************
+ *  CollectShadowCasters()
+ *
+ *  This method is used for finding the shadow maps that are
+ *  out of date and culling the render items against the
+ *  light view of each, with the same scene BVH and bounds
+ *  the main pass is culled by.  The maps that are still up
+ *  to date cost nothing.  Blended items cast no shadows.
+ ***********************************************************/
+void SceneManager::CollectShadowCasters()
+{
+	for (int v = 0; v < ShadowManager::SHADOW_VIEW_COUNT; v++)
+	{
+		m_shadowCasters[v].Release();
+		m_bShadowViewDirty[v] = m_pShadowManager->IsViewDirty(v);
+		if (!m_bShadowViewDirty[v])
+		{
+			continue;
+		}
+
+		ViewFrustum lightFrustum;
+		lightFrustum.ExtractPlanes(m_pShadowManager->GetViewProjection(v));
+		ArenaArray<int>& casters = m_shadowCasters[v];
+		casters.Allocate(m_frameArena, (int)m_renderList.meshIDs.size());
+		m_sceneBVH.QueryFrustum(lightFrustum, casters);
+
+		int casterCount = 0;
+		for (int c = 0; c < casters.GetCount(); c++)
+		{
+			if (0 == m_renderList.transparent[casters[c]])
+			{
+				casters[casterCount++] = casters[c];
+			}
+		}
+		casters.Resize(casterCount);
+	}
+}
+
+/***********************************************************
+ *  GetShadowFrameBytes()
+ *
+ *  This method is used for getting the bytes of the frame
+ *  data region the instance data and indirect commands of
+ *  the shadow casters are written to.  Each shadow map has
+ *  at most one command per mesh.
+ ***********************************************************/
+size_t SceneManager::GetShadowFrameBytes() const
+{
+	size_t frameBytes = 0;
+	for (int v = 0; v < ShadowManager::SHADOW_VIEW_COUNT; v++)
+	{
+		if (!m_shadowCasters[v].IsEmpty())
+		{
+			frameBytes += m_shadowCasters[v].GetCount() * sizeof(SceneMeshes::INSTANCE_DATA) +
+				sizeof(SceneMeshes::INSTANCE_DATA) +
+				(SceneMeshes::MESH_COUNT + 1) * sizeof(SceneMeshes::DRAW_COMMAND);
+		}
+	}
+
+	return(frameBytes);
+}
+
+/***********************************************************
+ *  RenderShadowMaps()
+ *
+ *  This method is used for drawing the casters of the out
+ *  of date shadow maps, then binding the maps and the light
+ *  views they were drawn with for the scene shaders.  The
+ *  farther cascades cover more of the world per texel, so
+ *  they are drawn with coarser mesh levels of detail.
+ ***********************************************************/
+void SceneManager::RenderShadowMaps()
+{
+	bool bAnyDirty = false;
+	for (int v = 0; v < ShadowManager::SHADOW_VIEW_COUNT; v++)
+	{
+		bAnyDirty = bAnyDirty || m_bShadowViewDirty[v];
+	}
+
+	if (bAnyDirty)
+	{
+		m_pShadowManager->BeginShadowPass(
+			SceneMeshes::VERTEX_FORMAT_PACKED == m_pSceneMeshes->GetVertexFormat(),
+			m_pSceneMeshes->GetPositionCenter(),
+			m_pSceneMeshes->GetPositionExtents());
+
+		for (int v = 0; v < ShadowManager::SHADOW_VIEW_COUNT; v++)
+		{
+			if (!m_bShadowViewDirty[v])
+			{
+				continue;
+			}
+
+			int lodLevel = 0;
+			if (v < ShadowManager::CASCADE_COUNT)
+			{
+				lodLevel = glm::min(v, SceneMeshes::LOD_COUNT - 1);
+			}
+
+			// an empty map is still cleared
+			m_pShadowManager->BeginView(v);
+			DrawShadowCasters(m_shadowCasters[v], lodLevel);
+			m_bShadowViewDirty[v] = false;
+			m_renderStats.shadowViewCount++;
+		}
+
+		m_pShadowManager->EndShadowPass();
+	}
+
+	m_pShadowManager->BindShadowData();
+}
+
+/***********************************************************
+ *  DrawShadowCasters()
+ *
+ *  This method is used for drawing render items into the
+ *  current shadow map.  Only the model matrix of an instance
+ *  is read by the depth only shader, so the items are sorted
+ *  by mesh alone and every mesh is one indirect command of a
+ *  single multi-draw.
+ ***********************************************************/
+void SceneManager::DrawShadowCasters(const ArenaArray<int>& items, int lodLevel)
+{
+	if (items.IsEmpty())
+	{
+		return;
+	}
+
+	size_t instanceOffset = 0;
+	size_t commandOffset = 0;
+	SceneMeshes::INSTANCE_DATA* pInstances = (SceneMeshes::INSTANCE_DATA*)m_pFrameData->Allocate(
+		items.GetCount() * sizeof(SceneMeshes::INSTANCE_DATA), sizeof(SceneMeshes::INSTANCE_DATA), instanceOffset);
+	SceneMeshes::DRAW_COMMAND* pCommands = (SceneMeshes::DRAW_COMMAND*)m_pFrameData->Allocate(
+		SceneMeshes::MESH_COUNT * sizeof(SceneMeshes::DRAW_COMMAND), sizeof(SceneMeshes::DRAW_COMMAND), commandOffset);
+	if ((NULL == pInstances) || (NULL == pCommands))
+	{
+		return;
+	}
+	int baseInstance = (int)(instanceOffset / sizeof(SceneMeshes::INSTANCE_DATA));
+
+	// count the items of each mesh, then give each mesh its
+	// run of instances
+	int meshStarts[SceneMeshes::MESH_COUNT] = { 0 };
+	for (int c = 0; c < items.GetCount(); c++)
+	{
+		meshStarts[m_renderList.meshIDs[items[c]]]++;
+	}
+	int commandCount = 0;
+	int nextInstance = 0;
+	for (int m = 0; m < SceneMeshes::MESH_COUNT; m++)
+	{
+		int instanceCount = meshStarts[m];
+		meshStarts[m] = nextInstance;
+		if (instanceCount > 0)
+		{
+			pCommands[commandCount++] = m_pSceneMeshes->MakeDrawCommand(
+				m, lodLevel, instanceCount, baseInstance + nextInstance);
+			nextInstance += instanceCount;
+		}
+	}
+
+	// the mapped memory is write combined, so each instance is
+	// built on the stack and written out whole
+	SceneMeshes::INSTANCE_DATA instance;
+	instance.color = glm::vec4(1.0f);
+	instance.materialIndex = 0;
+	instance.textureSlot = -1;
+	instance.uvScale = glm::vec2(1.0f);
+	for (int c = 0; c < items.GetCount(); c++)
+	{
+		int i = items[c];
+		instance.model = m_renderList.modelMatrices[i];
+		pInstances[meshStarts[m_renderList.meshIDs[i]]++] = instance;
+	}
+
+	m_pSceneMeshes->DrawMeshesIndirect(
+		m_pFrameData->GetBufferID(),
+		(int)(commandOffset / sizeof(SceneMeshes::DRAW_COMMAND)),
+		commandCount,
+		m_pFrameData->GetBufferID());
+	m_renderStats.shadowDrawCount++;
+	m_renderStats.shadowCasterCount += items.GetCount();
 }
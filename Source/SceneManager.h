@@ -9,10 +9,28 @@
 
 #pragma once
 
+#include "DepthPrepass.h"
+#include "FileWatcher.h"
+#include "FrameArena.h"
+#include "FrameRingBuffer.h"
+#include "JobSystem.h"
+#include "LightManager.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "SceneBVH.h"
+#include "SceneFile.h"
+#include "SceneMeshes.h"
 #include "ShaderManager.h"
-#include "ShapeMeshes.h"
+#include "ShaderPermutations.h"
+#include "ShaderUniformCache.h"
+#include "ShadowManager.h"
+#include "TextureLoader.h"
+#include "TextureRegistry.h"
+#include "TextureResidency.h"
+#include "ViewFrustum.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /***********************************************************
@@ -45,31 +63,243 @@ public:
 		std::string tag;
 	};
 
+	// identifiers for the basic mesh draw calls that
+	// can be referenced by the retained render items
+	enum MESH_ID
+	{
+		MESH_PLANE = SceneMeshes::MESH_PLANE,
+		MESH_BOX = SceneMeshes::MESH_BOX,
+		MESH_BOX_TOP = SceneMeshes::MESH_BOX_TOP,
+		MESH_CYLINDER = SceneMeshes::MESH_CYLINDER,
+		MESH_CYLINDER_TOP = SceneMeshes::MESH_CYLINDER_TOP,
+		MESH_CONE = SceneMeshes::MESH_CONE,
+		MESH_SPHERE = SceneMeshes::MESH_SPHERE,
+		MESH_HALF_SPHERE = SceneMeshes::MESH_HALF_SPHERE,
+		MESH_TORUS = SceneMeshes::MESH_TORUS,
+		MESH_HALF_TORUS = SceneMeshes::MESH_HALF_TORUS,
+		MESH_PRISM = SceneMeshes::MESH_PRISM
+	};
+
+	// retained render items stored as a struct of arrays,
+	// each array is indexed by the same render item index
+	struct RENDER_LIST
+	{
+		// basic mesh draw call for each item
+		std::vector<int> meshIDs;
+		// cached model matrix for each item
+		std::vector<glm::mat4> modelMatrices;
+		// texture slot for each item, -1 for a solid color
+		std::vector<int> textureSlots;
+		// index into the defined materials, -1 for none
+		std::vector<int> materialIndices;
+		// solid color used when no texture slot is set
+		std::vector<glm::vec4> colors;
+		// texture UV scale used when a texture slot is set
+		std::vector<glm::vec2> uvScales;
+		// transformation values the model matrix was built from
+		std::vector<glm::vec3> scales;
+		std::vector<glm::vec3> rotationsDegrees;
+		std::vector<glm::vec3> positions;
+		// set when the model matrix needs to be rebuilt
+		std::vector<char> transformDirty;
+		// set when the item is drawn with blending
+		std::vector<char> transparent;
+		// mesh level of detail picked for the current view
+		std::vector<char> lodLevels;
+		// shader permutation picked for the current frame
+		std::vector<char> permutations;
+		// world space bounding sphere of each item
+		std::vector<glm::vec3> boundsCenters;
+		std::vector<float> boundsRadii;
+	};
+
+	// counts of the draws and state changes of the last frame
+	struct RENDER_STATS
+	{
+		// draw calls issued, the indirect commands they
+		// executed and the render items drawn by them
+		int drawCount = 0;
+		int commandCount = 0;
+		int itemCount = 0;
+		// render items outside of the view and items submitted
+		int culledCount = 0;
+		int submittedCount = 0;
+		int textureChanges = 0;
+		int materialChanges = 0;
+		int meshChanges = 0;
+		int stateChanges = 0;
+		// uniform values sent to the driver and texture bindings
+		int uniformUploads = 0;
+		int textureBinds = 0;
+		// shadow maps drawn again, the render items drawn into
+		// them and the draw calls issued for them
+		int shadowViewCount = 0;
+		int shadowCasterCount = 0;
+		int shadowDrawCount = 0;
+		// instances tested against the depth pyramid on the GPU
+		int occlusionTestedCount = 0;
+	};
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
-	// pointer to basic shapes object
-	ShapeMeshes* m_basicMeshes;
-	// total number of loaded textures
-	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	// pointer to instanced basic shapes object
+	SceneMeshes* m_pSceneMeshes;
+	// pointer to cached shader uniform locations and values
+	ShaderUniformCache* m_pUniformCache;
+	// pointer to the programs of the scene shader permutations,
+	// each with its own uniform locations and values
+	ShaderPermutations* m_pShaderPermutations;
+	ShaderUniformCache m_permutationUniforms[ShaderPermutations::PERMUTATION_COUNT];
+	// false draws everything with the uniform branching shader
+	bool m_bShaderPermutations;
+	// pointer to scene light sources object
+	LightManager* m_pLightManager;
+	// pointer to asynchronous texture loading object
+	TextureLoader* m_pTextureLoader;
+	// pointer to the scene textures selected by index
+	TextureRegistry* m_pTextureRegistry;
+	// pointer to the video memory budget of the scene textures
+	TextureResidency* m_pTextureResidency;
+	// pointer to the worker threads that prepare the frames
+	JobSystem* m_pJobSystem;
+	// pointer to the shadow maps of the scene lights
+	ShadowManager* m_pShadowManager;
+	// render items casting into each shadow map drawn this frame
+	ArenaArray<int> m_shadowCasters[ShadowManager::SHADOW_VIEW_COUNT];
+	bool m_bShadowViewDirty[ShadowManager::SHADOW_VIEW_COUNT];
+	// pointer to the depth only drawing of the opaque items
+	// before they are shaded, and whether it is used
+	DepthPrepass* m_pDepthPrepass;
+	bool m_bDepthPrepass;
+	// pointer to the GPU culling of the hidden instances, whether
+	// it is used, and whether this frame is culled by it
+	OcclusionCuller* m_pOcclusionCuller;
+	bool m_bOcclusionCulling;
+	bool m_bOcclusionCullFrame;
+	// view and projection the next frame is viewed with
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// planes of the view volume the render items are culled by
+	ViewFrustum m_viewFrustum;
+	// spatial index over the render item bounds
+	SceneBVH m_sceneBVH;
+	// transient memory of the frame, reset as each frame starts
+	FrameArena m_frameArena;
+	// render items inside of the view volume this frame
+	ArenaArray<int> m_visibleItems;
+	// loaded textures info, indexed by texture slot
+	std::vector<TEXTURE_INFO> m_textureIDs;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// texture slot and material index handles keyed by the hash
+	// of their tag, so a tag is looked up without building strings
+	std::unordered_map<uint32_t, int> m_textureSlotLookup;
+	std::unordered_map<uint32_t, int> m_materialLookup;
+	// uniform buffer holding all the defined materials
+	GLuint m_materialBufferID;
+	// retained render items built once in PrepareScene()
+	RENDER_LIST m_renderList;
+	// true when any render item transform is dirty
+	bool m_bTransformsDirty;
+	// changed whenever a render item moves or the render items
+	// are rebuilt, so the shadow maps know to be drawn again
+	unsigned int m_geometryVersion;
+	// geometry and light versions the lights were last checked
+	// against the render items at, and the items of each check
+	unsigned int m_lightInfluenceGeometryVersion;
+	unsigned int m_lightInfluenceLightVersion;
+	std::vector<int> m_litItems;
+	// sorted draws of the current frame
+	RenderQueue m_renderQueue;
+	// draw statistics of the last rendered frame
+	RENDER_STATS m_renderStats;
+	// number of copies of the desk scene laid out in a grid
+	int m_sceneCopies;
+	// binary scene file the scene is read from, empty for the
+	// scene built in code, and the file while it is mapped
+	std::string m_sceneFilename;
+	SceneFile* m_pSceneFile;
+	// GLSL files of the scene shader program, for reloading it
+	std::string m_vertexShaderFilename;
+	std::string m_fragmentShaderFilename;
+	// pointer to the watcher of the shader, texture and scene
+	// files, which only runs when hot reloading is enabled
+	FileWatcher* m_pFileWatcher;
+	bool m_bHotReload;
+	// watch IDs of the shader files and the scene file, -1 for
+	// none, and the texture slot of each watched image file
+	int m_vertexShaderWatchID;
+	int m_fragmentShaderWatchID;
+	int m_sceneWatchID;
+	std::unordered_map<int, int> m_textureWatchSlots;
+	// watch IDs taken from the file watcher this frame
+	std::vector<int> m_changedWatchIDs;
+
+	// a run of sorted render items drawn in one instanced draw
+	struct INSTANCE_BATCH
+	{
+		int firstInstance;
+		int instanceCount;
+		int itemIndex;
+	};
+
+	// mapped buffer the dynamic data of each frame is written to
+	FrameRingBuffer* m_pFrameData;
+	// per-instance data of the current frame in queue order,
+	// written straight into the frame's mapped region
+	SceneMeshes::INSTANCE_DATA* m_pInstanceData;
+	// instance of the frame's region the instance data starts at
+	int m_baseInstance;
+	// instanced draws of the current frame, recorded by each job
+	// at the queue index its part of the render queue starts at
+	ArenaArray<INSTANCE_BATCH> m_instanceBatches;
+	// number of instanced draws each job recorded, merged in
+	// queue order on the OpenGL thread
+	ArenaArray<int> m_jobBatchCounts;
 
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
+	bool CreateGLTexture(const char* filename, const char* tag);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
+	// publish the textures whose images finished uploading
+	void UpdateTextureRegistry();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(const char* tag);
+	int FindTextureSlot(const char* tag);
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(const char* tag, OBJECT_MATERIAL& material);
+	// index the defined materials by tag for handle lookups
+	void IndexObjectMaterials();
+	// get a defined material by its index handle
+	const OBJECT_MATERIAL& GetMaterial(int materialIndex) const;
+	// pack the defined materials into the material uniform buffer
+	void CreateMaterialBuffer();
+	// connect the material block of a shader program to its buffer
+	void ConnectMaterialBlock(GLuint programID);
+	// look up and connect everything the scene sets in a newly
+	// linked shader program
+	void ConnectShaderProgram(GLuint programID, ShaderUniformCache* pUniforms);
+	// build the programs of the permutations the render items use
+	void BuildShaderPermutations();
+	// pick the shader permutation of a render item
+	int SelectRenderItemPermutation(int itemIndex, int lightCount) const;
+	// put the program of a permutation in use, returning its uniforms
+	ShaderUniformCache* UseShaderPermutation(int permutation);
+	// rebuild the scene shader program from its changed files
+	bool ReloadShaders();
+	// rebuild the textures, materials, lights and render items
+	// from the changed scene file
+	bool ReloadSceneFile();
 	// load all need textures before rendering
 	void LoadSceneTextures();
+	// read the textures, materials and lights of the scene file
+	void LoadSceneFileResources();
+	// build the retained render items of the scene file
+	void BuildSceneFileRenderList();
 
 	// set the transformation values 
 	// into the transform buffer
@@ -89,7 +319,9 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		const char* textureTag);
+	void SetShaderTexture(
+		int textureSlot);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -97,7 +329,90 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		const char* materialTag);
+	void SetShaderMaterial(
+		int materialIndex);
+
+	// find a defined material index by tag
+	int FindMaterialIndex(const char* tag);
+	// compose the model matrix from the transformation values
+	glm::mat4 ComputeModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// add an item to the retained render list
+	int AddRenderItem(
+		int meshID,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		const char* textureTag,
+		const char* materialTag,
+		glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+	// add an item whose texture slot and material are resolved
+	int AddResolvedRenderItem(
+		int meshID,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ,
+		int textureSlot,
+		int materialIndex,
+		glm::vec4 color,
+		glm::vec2 uvScale);
+	// make room in the render list for more items
+	void ReserveRenderItems(int itemCount);
+	// rebuild the model matrices of dirty render items
+	void UpdateRenderItemTransforms();
+	// move the mesh bounds of a render item into world space
+	void UpdateRenderItemBounds(int itemIndex);
+	// leave the lights that reach no render item out of the tiles
+	void UpdateLightInfluence();
+	// pick the mesh level of detail of a render item from its size on screen
+	int SelectRenderItemLOD(int itemIndex) const;
+	// add a copy of a render item moved by an offset
+	int CopyRenderItem(int itemIndex, glm::vec3 offset);
+	// lay out the extra copies of the desk scene in a grid
+	void ReplicateRenderItems();
+	// get the most bytes of the frame arena a frame can use
+	size_t GetFrameArenaBytes() const;
+	// collect the render items into the sorted render queue
+	void BuildRenderQueue();
+	// check if two render items can share one instanced draw
+	bool CanInstanceTogether(int firstItem, int secondItem) const;
+	// record the instance data and instanced draws of a part of
+	// the render queue, returning the number of draws recorded
+	int RecordInstanceBatches(int firstQueueIndex, int lastQueueIndex, INSTANCE_BATCH* pBatches);
+	// join the draws of the jobs into the instanced draws of the frame
+	void MergeCommandBuffers();
+	// write the indirect commands of the instanced draws
+	void BuildDrawCommands(SceneMeshes::DRAW_COMMAND* pCommands);
+	// get the bytes of frame data the render queue needs
+	size_t GetQueueFrameBytes() const;
+	// draw the sorted render queue
+	void SubmitRenderQueue();
+	// cull the instances of the frame hidden behind the depth
+	// pyramid into the culled indirect commands
+	bool CullOccludedInstances(size_t instanceOffset);
+	// draw a range of the frame's indirect commands, one
+	// multi-draw per run of equal shader permutations
+	void SubmitCommandRuns(
+		GLuint commandBufferID,
+		int firstCommand,
+		int beginCommand,
+		int endCommand,
+		GLuint instanceBufferID);
+	// cull the shadow casters of the shadow maps to draw again
+	void CollectShadowCasters();
+	// get the bytes of frame data the shadow casters need
+	size_t GetShadowFrameBytes() const;
+	// draw the out of date shadow maps
+	void RenderShadowMaps();
+	// draw render items into the current shadow map
+	void DrawShadowCasters(const ArenaArray<int>& items, int lodLevel);
 
 public:
 
@@ -109,5 +424,56 @@ public:
 	void SetupSceneLights();
 	// pre-define the object materials for lighting
 	void DefineObjectMaterials();
+	// build the retained render items for the 3D scene
+	void BuildRenderList();
+	// set the binary scene file to read, before PrepareScene()
+	void SetSceneFile(const std::string& filename) { m_sceneFilename = filename; }
+	// set the GLSL files the shaders were loaded from and watch
+	// them and the scene files for changes, before PrepareScene()
+	void SetShaderFiles(const std::string& vertexShaderFile, const std::string& fragmentShaderFile);
+	void SetHotReload(bool bHotReload) { m_bHotReload = bHotReload; }
+	// draw with compiled shader permutations, before PrepareScene()
+	void SetShaderPermutations(bool bEnable) { m_bShaderPermutations = bEnable; }
+	// set the quality of the shadows, before PrepareScene()
+	void SetShadowQuality(ShadowManager::SHADOW_QUALITY quality) { m_pShadowManager->SetQuality(quality); }
+	// draw the depth of the opaque items first and cull hidden
+	// items on the GPU, before PrepareScene()
+	void SetDepthPrepass(bool bEnable) { m_bDepthPrepass = bEnable; }
+	void SetOcclusionCulling(bool bEnable) { m_bOcclusionCulling = bEnable; }
+	// reload the changed files, called between frames, returning
+	// true when any file had changed
+	bool ApplyFileChanges();
+	// set the number of desk scene copies, before PrepareScene()
+	void SetSceneCopies(int copyCount) { m_sceneCopies = (copyCount > 1) ? copyCount : 1; }
+	// set the layout of the mesh vertices, before PrepareScene()
+	void SetVertexFormat(SceneMeshes::VERTEX_FORMAT format) { m_pSceneMeshes->SetVertexFormat(format); }
+	// get the number of retained render items
+	int GetRenderItemCount() const { return((int)m_renderList.meshIDs.size()); }
+	// block until every scene texture is loaded and published
+	void FinishTextureLoads();
+	// check if any texture image is still being loaded
+	bool IsLoadingTextures() const { return(m_pTextureLoader->GetPendingCount() > 0); }
+	// set the view and projection for the next frame
+	void SetSceneView(const glm::mat4& view, const glm::mat4& projection);
+	// find the render item under a window position, -1 for none
+	int PickRenderItem(float windowX, float windowY);
+	// print the mesh, material, texture and position of a render item
+	void PrintRenderItem(int itemIndex) const;
+	// find the render items inside of a light's range
+	void FindItemsLitBy(int lightIndex, std::vector<int>& items);
+	// get the draw statistics of the last rendered frame
+	const RENDER_STATS& GetRenderStats() const { return(m_renderStats); }
+	// set the bytes of video memory the scene textures may take
+	void SetTextureBudget(size_t budgetBytes) { m_pTextureResidency->SetBudget(budgetBytes); }
+	// get the bytes of video memory the scene textures take
+	size_t GetTextureResidentBytes() const { return(m_pTextureResidency->GetResidentBytes()); }
+	// change the transformation values of a render item
+	void SetRenderItemTransform(
+		int itemIndex,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
 
 };
\ No newline at end of file
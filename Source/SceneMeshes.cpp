@@ -0,0 +1,1023 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.cpp
+// ============
+// generate the basic 3D shape meshes and draw them with instancing
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneMeshes.h"
+#include "FileUtilities.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	const float PI = 3.14159265358979f;
+
+	// tessellation of the round shapes at each level of detail,
+	// the segment and stack counts must stay even so that the
+	// half sphere and half torus are whole rows
+	const int LOD_CIRCLE_SEGMENTS[SceneMeshes::LOD_COUNT] = { 36, 18, 10 };
+	const int LOD_SPHERE_STACKS[SceneMeshes::LOD_COUNT] = { 18, 10, 6 };
+	const int LOD_TORUS_TUBE_SEGMENTS[SceneMeshes::LOD_COUNT] = { 18, 10, 6 };
+	// screen radius below which each coarser level is drawn, as
+	// a fraction of half the viewport height
+	const float LOD_SCREEN_RADII[SceneMeshes::LOD_COUNT - 1] = { 0.12f, 0.04f };
+
+	// identifies a mesh cache file, the version must be raised
+	// whenever the generated shapes or the vertex layout change
+	const uint32_t MESH_CACHE_MAGIC = 0x4853454d;
+	const uint32_t MESH_CACHE_VERSION = 1;
+
+	// leading fields of a mesh cache file, followed by the draw
+	// ranges, the mesh bounds, the vertices and the indices
+	struct MESH_CACHE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t meshCount;
+		uint32_t lodCount;
+		uint32_t vertexSize;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		float torusThickness;
+	};
+
+	// vertex attribute locations used by the vertex shader
+	const GLuint POSITION_ATTRIBUTE = 0;
+	const GLuint NORMAL_ATTRIBUTE = 1;
+	const GLuint UV_ATTRIBUTE = 2;
+	const GLuint INSTANCE_MODEL_ATTRIBUTE = 3;
+	const GLuint INSTANCE_COLOR_ATTRIBUTE = 7;
+	const GLuint INSTANCE_INDEX_ATTRIBUTE = 8;
+	const GLuint INSTANCE_UV_SCALE_ATTRIBUTE = 9;
+
+	// largest index that fits in a 16-bit index buffer
+	const GLuint MAX_SHORT_INDEX = 0xffff;
+
+	// convert a value in -1 to 1 into a signed normalized short
+	GLshort PackSnorm16(float value)
+	{
+		value = glm::clamp(value, -1.0f, 1.0f);
+		return((GLshort)floorf(value * 32767.0f + 0.5f));
+	}
+
+	// convert a value in 0 to 1 into an unsigned normalized short
+	GLushort PackUnorm16(float value)
+	{
+		value = glm::clamp(value, 0.0f, 1.0f);
+		return((GLushort)floorf(value * 65535.0f + 0.5f));
+	}
+
+	// fold a unit normal onto the octahedron and flatten it into
+	// two values in -1 to 1, the vertex shader reverses this
+	glm::vec2 OctahedralEncode(const glm::vec3& normal)
+	{
+		glm::vec3 n = normal / (fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z));
+		glm::vec2 encoded(n.x, n.y);
+
+		if (n.z < 0.0f)
+		{
+			encoded.x = (1.0f - fabsf(n.y)) * ((n.x >= 0.0f) ? 1.0f : -1.0f);
+			encoded.y = (1.0f - fabsf(n.x)) * ((n.y >= 0.0f) ? 1.0f : -1.0f);
+		}
+
+		return(encoded);
+	}
+}
+
+/***********************************************************
+ *  SceneMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneMeshes::SceneMeshes()
+{
+	m_arenaVAO = 0;
+	m_arenaVBOs[0] = 0;
+	m_arenaVBOs[1] = 0;
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		for (int lod = 0; lod < LOD_COUNT; lod++)
+		{
+			SetDrawRange(i, lod, SHAPE_BOX, 0, 0);
+		}
+	}
+	m_attachedInstanceBuffer = 0;
+	m_vertexFormat = VERTEX_FORMAT_PACKED;
+	m_indexType = GL_UNSIGNED_INT;
+	m_positionCenter = glm::vec3(0.0f);
+	m_positionExtents = glm::vec3(1.0f);
+}
+
+/***********************************************************
+ *  ~SceneMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneMeshes::~SceneMeshes()
+{
+	DestroyArenaBuffers();
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for appending a vertex to the passed
+ *  in shape data and returning the index of the vertex.
+ ***********************************************************/
+GLuint SceneMeshes::AddVertex(
+	SHAPE_DATA& shape,
+	const glm::vec3& position,
+	const glm::vec3& normal,
+	const glm::vec2& uv)
+{
+	VERTEX vertex;
+
+	vertex.position = position;
+	vertex.normal = normal;
+	vertex.uv = uv;
+	shape.vertices.push_back(vertex);
+
+	return((GLuint)shape.vertices.size() - 1);
+}
+
+/***********************************************************
+ *  AddQuad()
+ *
+ *  This method is used for appending the two triangles of
+ *  the quad with the passed in counter-clockwise corners.
+ ***********************************************************/
+void SceneMeshes::AddQuad(SHAPE_DATA& shape, GLuint a, GLuint b, GLuint c, GLuint d)
+{
+	shape.indices.push_back(a);
+	shape.indices.push_back(b);
+	shape.indices.push_back(c);
+	shape.indices.push_back(a);
+	shape.indices.push_back(c);
+	shape.indices.push_back(d);
+}
+
+/***********************************************************
+ *  GeneratePlane()
+ *
+ *  This method is used for generating a flat plane that
+ *  spans -1 to 1 on the X and Z axes, facing up.
+ ***********************************************************/
+void SceneMeshes::GeneratePlane(SHAPE_DATA& shape)
+{
+	glm::vec3 normal(0.0f, 1.0f, 0.0f);
+
+	GLuint a = AddVertex(shape, glm::vec3(-1.0f, 0.0f, 1.0f), normal, glm::vec2(0.0f, 0.0f));
+	GLuint b = AddVertex(shape, glm::vec3(1.0f, 0.0f, 1.0f), normal, glm::vec2(1.0f, 0.0f));
+	GLuint c = AddVertex(shape, glm::vec3(1.0f, 0.0f, -1.0f), normal, glm::vec2(1.0f, 1.0f));
+	GLuint d = AddVertex(shape, glm::vec3(-1.0f, 0.0f, -1.0f), normal, glm::vec2(0.0f, 1.0f));
+	AddQuad(shape, a, b, c, d);
+
+	SetDrawRange(MESH_PLANE, 0, SHAPE_PLANE, 0, (GLuint)shape.indices.size());
+}
+
+/***********************************************************
+ *  GenerateBox()
+ *
+ *  This method is used for generating a unit cube centered
+ *  on the origin.  The sides are generated in the order
+ *  back, bottom, left, right, top, front so that each side
+ *  is a separate range of six indices.
+ ***********************************************************/
+void SceneMeshes::GenerateBox(SHAPE_DATA& shape)
+{
+	// the normal and the two in-plane axes of each side
+	const glm::vec3 sides[6][3] =
+	{
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) }
+	};
+
+	for (int side = 0; side < 6; side++)
+	{
+		glm::vec3 center = sides[side][0] * 0.5f;
+		glm::vec3 u = sides[side][1] * 0.5f;
+		glm::vec3 v = sides[side][2] * 0.5f;
+
+		GLuint a = AddVertex(shape, center - u - v, sides[side][0], glm::vec2(0.0f, 0.0f));
+		GLuint b = AddVertex(shape, center + u - v, sides[side][0], glm::vec2(1.0f, 0.0f));
+		GLuint c = AddVertex(shape, center + u + v, sides[side][0], glm::vec2(1.0f, 1.0f));
+		GLuint d = AddVertex(shape, center - u + v, sides[side][0], glm::vec2(0.0f, 1.0f));
+		AddQuad(shape, a, b, c, d);
+	}
+
+	SetDrawRange(MESH_BOX, 0, SHAPE_BOX, 0, (GLuint)shape.indices.size());
+	// the top is the fifth side
+	SetDrawRange(MESH_BOX_TOP, 0, SHAPE_BOX, 4 * 6, 6);
+}
+
+/***********************************************************
+ *  GenerateCylinder()
+ *
+ *  This method is used for generating a cylinder with a
+ *  radius of 1 that stands from 0 to 1 on the Y axis.  The
+ *  sides are generated first, followed by the top and the
+ *  bottom so that the top can be drawn on its own.
+ ***********************************************************/
+void SceneMeshes::GenerateCylinder(SHAPE_DATA& shape, int lodLevel)
+{
+	int circleSegments = LOD_CIRCLE_SEGMENTS[lodLevel];
+
+	// sides
+	for (int s = 0; s <= circleSegments; s++)
+	{
+		float angle = 2.0f * PI * s / circleSegments;
+		glm::vec3 normal(sinf(angle), 0.0f, cosf(angle));
+		float u = (float)s / circleSegments;
+
+		AddVertex(shape, glm::vec3(normal.x, 0.0f, normal.z), normal, glm::vec2(u, 0.0f));
+		AddVertex(shape, glm::vec3(normal.x, 1.0f, normal.z), normal, glm::vec2(u, 1.0f));
+	}
+	for (int s = 0; s < circleSegments; s++)
+	{
+		GLuint bottom = s * 2;
+		AddQuad(shape, bottom, bottom + 2, bottom + 3, bottom + 1);
+	}
+	GLuint sideIndexCount = (GLuint)shape.indices.size();
+
+	// top and bottom caps
+	for (int cap = 0; cap < 2; cap++)
+	{
+		float y = (cap == 0) ? 1.0f : 0.0f;
+		glm::vec3 normal(0.0f, (cap == 0) ? 1.0f : -1.0f, 0.0f);
+		GLuint center = AddVertex(shape, glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+
+		for (int s = 0; s <= circleSegments; s++)
+		{
+			float angle = 2.0f * PI * s / circleSegments;
+			float x = sinf(angle);
+			float z = cosf(angle);
+			AddVertex(shape, glm::vec3(x, y, z), normal, glm::vec2(x * 0.5f + 0.5f, z * 0.5f + 0.5f));
+		}
+		for (int s = 0; s < circleSegments; s++)
+		{
+			shape.indices.push_back(center);
+			shape.indices.push_back(center + 1 + ((cap == 0) ? s : s + 1));
+			shape.indices.push_back(center + 1 + ((cap == 0) ? s + 1 : s));
+		}
+	}
+
+	SetDrawRange(MESH_CYLINDER, lodLevel, SHAPE_CYLINDER, 0, (GLuint)shape.indices.size());
+	SetDrawRange(MESH_CYLINDER_TOP, lodLevel, SHAPE_CYLINDER, sideIndexCount, circleSegments * 3);
+}
+
+/***********************************************************
+ *  GenerateCone()
+ *
+ *  This method is used for generating a cone with a base
+ *  radius of 1 at 0 on the Y axis and its tip at 1.
+ ***********************************************************/
+void SceneMeshes::GenerateCone(SHAPE_DATA& shape, int lodLevel)
+{
+	int circleSegments = LOD_CIRCLE_SEGMENTS[lodLevel];
+
+	// sides, with a tip vertex per segment for smooth normals
+	for (int s = 0; s < circleSegments; s++)
+	{
+		float angle0 = 2.0f * PI * s / circleSegments;
+		float angle1 = 2.0f * PI * (s + 1) / circleSegments;
+		float angleTip = (angle0 + angle1) * 0.5f;
+
+		glm::vec3 base0(sinf(angle0), 0.0f, cosf(angle0));
+		glm::vec3 base1(sinf(angle1), 0.0f, cosf(angle1));
+
+		GLuint a = AddVertex(shape, base0, glm::normalize(base0 + glm::vec3(0.0f, 1.0f, 0.0f)),
+			glm::vec2((float)s / circleSegments, 0.0f));
+		GLuint b = AddVertex(shape, base1, glm::normalize(base1 + glm::vec3(0.0f, 1.0f, 0.0f)),
+			glm::vec2((float)(s + 1) / circleSegments, 0.0f));
+		GLuint c = AddVertex(shape, glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::normalize(glm::vec3(sinf(angleTip), 1.0f, cosf(angleTip))),
+			glm::vec2((s + 0.5f) / circleSegments, 1.0f));
+		shape.indices.push_back(a);
+		shape.indices.push_back(b);
+		shape.indices.push_back(c);
+	}
+
+	// bottom cap
+	glm::vec3 normal(0.0f, -1.0f, 0.0f);
+	GLuint center = AddVertex(shape, glm::vec3(0.0f, 0.0f, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+	for (int s = 0; s <= circleSegments; s++)
+	{
+		float angle = 2.0f * PI * s / circleSegments;
+		float x = sinf(angle);
+		float z = cosf(angle);
+		AddVertex(shape, glm::vec3(x, 0.0f, z), normal, glm::vec2(x * 0.5f + 0.5f, z * 0.5f + 0.5f));
+	}
+	for (int s = 0; s < circleSegments; s++)
+	{
+		shape.indices.push_back(center);
+		shape.indices.push_back(center + 2 + s);
+		shape.indices.push_back(center + 1 + s);
+	}
+
+	SetDrawRange(MESH_CONE, lodLevel, SHAPE_CONE, 0, (GLuint)shape.indices.size());
+}
+
+/***********************************************************
+ *  GenerateSphere()
+ *
+ *  This method is used for generating a sphere with a radius
+ *  of 1 centered on the origin.  The stacks are generated
+ *  from the top down so that the upper half of the sphere
+ *  is a single range of indices.
+ ***********************************************************/
+void SceneMeshes::GenerateSphere(SHAPE_DATA& shape, int lodLevel)
+{
+	int circleSegments = LOD_CIRCLE_SEGMENTS[lodLevel];
+	int sphereStacks = LOD_SPHERE_STACKS[lodLevel];
+	int rowLength = circleSegments + 1;
+
+	for (int i = 0; i <= sphereStacks; i++)
+	{
+		float phi = PI * i / sphereStacks;
+		float y = cosf(phi);
+		float radius = sinf(phi);
+
+		for (int s = 0; s <= circleSegments; s++)
+		{
+			float theta = 2.0f * PI * s / circleSegments;
+			glm::vec3 position(radius * sinf(theta), y, radius * cosf(theta));
+			AddVertex(shape, position, position,
+				glm::vec2((float)s / circleSegments, 1.0f - (float)i / sphereStacks));
+		}
+	}
+	for (int i = 0; i < sphereStacks; i++)
+	{
+		for (int s = 0; s < circleSegments; s++)
+		{
+			GLuint upper = i * rowLength + s;
+			GLuint lower = upper + rowLength;
+			AddQuad(shape, upper, lower, lower + 1, upper + 1);
+		}
+	}
+
+	SetDrawRange(MESH_SPHERE, lodLevel, SHAPE_SPHERE, 0, (GLuint)shape.indices.size());
+	SetDrawRange(MESH_HALF_SPHERE, lodLevel, SHAPE_SPHERE, 0, (sphereStacks / 2) * circleSegments * 6);
+}
+
+/***********************************************************
+ *  GenerateTorus()
+ *
+ *  This method is used for generating a torus in the XY
+ *  plane with a main radius of 1 and a tube radius equal to
+ *  the passed in thickness.  The ring is generated starting
+ *  on the X axis so that the upper half is a single range.
+ ***********************************************************/
+void SceneMeshes::GenerateTorus(SHAPE_DATA& shape, float thickness, int lodLevel)
+{
+	int circleSegments = LOD_CIRCLE_SEGMENTS[lodLevel];
+	int tubeSegments = LOD_TORUS_TUBE_SEGMENTS[lodLevel];
+	int rowLength = tubeSegments + 1;
+
+	for (int i = 0; i <= circleSegments; i++)
+	{
+		float theta = 2.0f * PI * i / circleSegments;
+		glm::vec3 outward(cosf(theta), sinf(theta), 0.0f);
+
+		for (int j = 0; j <= tubeSegments; j++)
+		{
+			float phi = 2.0f * PI * j / tubeSegments;
+			glm::vec3 normal = outward * cosf(phi) + glm::vec3(0.0f, 0.0f, sinf(phi));
+			AddVertex(shape, outward + normal * thickness, normal,
+				glm::vec2((float)i / circleSegments, (float)j / tubeSegments));
+		}
+	}
+	for (int i = 0; i < circleSegments; i++)
+	{
+		for (int j = 0; j < tubeSegments; j++)
+		{
+			GLuint a = i * rowLength + j;
+			GLuint b = a + rowLength;
+			AddQuad(shape, a, b, b + 1, a + 1);
+		}
+	}
+
+	SetDrawRange(MESH_TORUS, lodLevel, SHAPE_TORUS, 0, (GLuint)shape.indices.size());
+	SetDrawRange(MESH_HALF_TORUS, lodLevel, SHAPE_TORUS, 0, (circleSegments / 2) * tubeSegments * 6);
+}
+
+/***********************************************************
+ *  GeneratePrism()
+ *
+ *  This method is used for generating a triangular prism
+ *  that fits in a unit cube centered on the origin, with
+ *  the triangle faces at the front and back.
+ ***********************************************************/
+void SceneMeshes::GeneratePrism(SHAPE_DATA& shape)
+{
+	const glm::vec2 corners[3] =
+	{
+		glm::vec2(-0.5f, -0.5f),
+		glm::vec2(0.5f, -0.5f),
+		glm::vec2(0.0f, 0.5f)
+	};
+
+	// front and back triangles
+	for (int face = 0; face < 2; face++)
+	{
+		float z = (face == 0) ? 0.5f : -0.5f;
+		glm::vec3 normal(0.0f, 0.0f, (face == 0) ? 1.0f : -1.0f);
+		GLuint first = (GLuint)shape.vertices.size();
+
+		for (int c = 0; c < 3; c++)
+		{
+			AddVertex(shape, glm::vec3(corners[c], z), normal, corners[c] + glm::vec2(0.5f, 0.5f));
+		}
+		shape.indices.push_back(first);
+		shape.indices.push_back(first + ((face == 0) ? 1 : 2));
+		shape.indices.push_back(first + ((face == 0) ? 2 : 1));
+	}
+
+	// the three rectangular sides
+	for (int c = 0; c < 3; c++)
+	{
+		glm::vec2 p = corners[c];
+		glm::vec2 q = corners[(c + 1) % 3];
+		glm::vec2 edge = q - p;
+		glm::vec3 normal = glm::normalize(glm::vec3(edge.y, -edge.x, 0.0f));
+
+		GLuint a = AddVertex(shape, glm::vec3(p, 0.5f), normal, glm::vec2(0.0f, 0.0f));
+		GLuint b = AddVertex(shape, glm::vec3(p, -0.5f), normal, glm::vec2(1.0f, 0.0f));
+		GLuint d = AddVertex(shape, glm::vec3(q, -0.5f), normal, glm::vec2(1.0f, 1.0f));
+		GLuint e = AddVertex(shape, glm::vec3(q, 0.5f), normal, glm::vec2(0.0f, 1.0f));
+		AddQuad(shape, a, b, d, e);
+	}
+
+	SetDrawRange(MESH_PRISM, 0, SHAPE_PRISM, 0, (GLuint)shape.indices.size());
+}
+
+/***********************************************************
+ *  SetDrawRange()
+ *
+ *  This method is used for setting the part of a shape that
+ *  is drawn for the passed in mesh ID at a level of detail.
+ ***********************************************************/
+void SceneMeshes::SetDrawRange(int meshID, int lodLevel, int shapeID, GLuint firstIndex, GLuint indexCount)
+{
+	DRAW_RANGE& range = m_drawRanges[meshID][lodLevel];
+
+	range.shape = shapeID * LOD_COUNT + lodLevel;
+	range.firstIndex = firstIndex;
+	range.indexCount = indexCount;
+	range.baseVertex = 0;
+}
+
+/***********************************************************
+ *  GenerateShapes()
+ *
+ *  This method is used for generating every shape into the
+ *  passed in array, which holds a shape for each level of
+ *  detail of each shape ID.  The flat shapes are only
+ *  generated once and every level of detail draws them.
+ ***********************************************************/
+void SceneMeshes::GenerateShapes(SHAPE_DATA* shapes, float torusThickness)
+{
+	GeneratePlane(shapes[SHAPE_PLANE * LOD_COUNT]);
+	GenerateBox(shapes[SHAPE_BOX * LOD_COUNT]);
+	GeneratePrism(shapes[SHAPE_PRISM * LOD_COUNT]);
+
+	const int flatMeshes[] = { MESH_PLANE, MESH_BOX, MESH_BOX_TOP, MESH_PRISM };
+	for (int i = 0; i < 4; i++)
+	{
+		for (int lod = 1; lod < LOD_COUNT; lod++)
+		{
+			m_drawRanges[flatMeshes[i]][lod] = m_drawRanges[flatMeshes[i]][0];
+		}
+	}
+
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		GenerateCylinder(shapes[SHAPE_CYLINDER * LOD_COUNT + lod], lod);
+		GenerateCone(shapes[SHAPE_CONE * LOD_COUNT + lod], lod);
+		GenerateSphere(shapes[SHAPE_SPHERE * LOD_COUNT + lod], lod);
+		GenerateTorus(shapes[SHAPE_TORUS * LOD_COUNT + lod], torusThickness, lod);
+	}
+}
+
+/***********************************************************
+ *  LoadMeshes()
+ *
+ *  This method is used for loading all of the shapes into
+ *  GPU buffers.  The packed arena is read from the passed
+ *  in cache file when it matches, otherwise the shapes are
+ *  generated and the cache file is written for next time.
+ ***********************************************************/
+void SceneMeshes::LoadMeshes(float torusThickness, const char* cacheFilename)
+{
+	std::vector<VERTEX> vertices;
+	std::vector<GLuint> indices;
+
+	DestroyArenaBuffers();
+
+	if ((NULL == cacheFilename) ||
+		(false == ReadMeshCache(cacheFilename, torusThickness, vertices, indices)))
+	{
+		std::vector<SHAPE_DATA> shapes(SHAPE_COUNT * LOD_COUNT);
+
+		GenerateShapes(&shapes[0], torusThickness);
+		ComputeMeshBounds(&shapes[0]);
+		PackArena(&shapes[0], vertices, indices);
+
+		if (NULL != cacheFilename)
+		{
+			WriteMeshCache(cacheFilename, torusThickness, vertices, indices);
+		}
+	}
+
+	CreateArenaBuffers(vertices, indices);
+}
+
+/***********************************************************
+ *  SelectLevelOfDetail()
+ *
+ *  This method is used for picking the level of detail for
+ *  a mesh from the radius of its bounding sphere on screen,
+ *  as a fraction of half the viewport height.
+ ***********************************************************/
+int SceneMeshes::SelectLevelOfDetail(float screenRadius)
+{
+	int lod = 0;
+
+	while ((lod < LOD_COUNT - 1) && (screenRadius < LOD_SCREEN_RADII[lod]))
+	{
+		lod++;
+	}
+
+	return(lod);
+}
+
+/***********************************************************
+ *  ComputeMeshBounds()
+ *
+ *  This method is used for computing the box and sphere that
+ *  enclose the vertices referenced by each draw range, so a
+ *  partial mesh such as the box top gets tighter bounds than
+ *  its whole shape.  The coarser levels of detail lie inside
+ *  of the finest one, so its bounds are used for all levels.
+ ***********************************************************/
+void SceneMeshes::ComputeMeshBounds(const SHAPE_DATA* shapes)
+{
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		const DRAW_RANGE& range = m_drawRanges[i][0];
+		const SHAPE_DATA& shape = shapes[range.shape];
+		glm::vec3 minimum(0.0f);
+		glm::vec3 maximum(0.0f);
+
+		for (GLuint n = 0; n < range.indexCount; n++)
+		{
+			const glm::vec3& position = shape.vertices[shape.indices[range.firstIndex + n]].position;
+			if (n == 0)
+			{
+				minimum = position;
+				maximum = position;
+			}
+			else
+			{
+				minimum = glm::min(minimum, position);
+				maximum = glm::max(maximum, position);
+			}
+		}
+
+		m_meshBounds[i].center = (minimum + maximum) * 0.5f;
+		m_meshBounds[i].extents = (maximum - minimum) * 0.5f;
+		m_meshBounds[i].radius = glm::length(m_meshBounds[i].extents);
+	}
+}
+
+/***********************************************************
+ *  PackArena()
+ *
+ *  This method is used for packing the generated shapes
+ *  back to back into one array of vertices and indices.
+ *  The shape indices stay relative to the shape, and each
+ *  draw range records the base vertex and first index of its
+ *  shape inside the arena.
+ ***********************************************************/
+void SceneMeshes::PackArena(const SHAPE_DATA* shapes, std::vector<VERTEX>& vertices, std::vector<GLuint>& indices)
+{
+	GLint shapeBaseVertex[SHAPE_COUNT * LOD_COUNT];
+	GLuint shapeFirstIndex[SHAPE_COUNT * LOD_COUNT];
+
+	vertices.clear();
+	indices.clear();
+	for (int i = 0; i < SHAPE_COUNT * LOD_COUNT; i++)
+	{
+		shapeBaseVertex[i] = (GLint)vertices.size();
+		shapeFirstIndex[i] = (GLuint)indices.size();
+		vertices.insert(vertices.end(), shapes[i].vertices.begin(), shapes[i].vertices.end());
+		indices.insert(indices.end(), shapes[i].indices.begin(), shapes[i].indices.end());
+	}
+
+	// move the draw ranges from their shape into the arena
+	for (int i = 0; i < MESH_COUNT; i++)
+	{
+		for (int lod = 0; lod < LOD_COUNT; lod++)
+		{
+			DRAW_RANGE& range = m_drawRanges[i][lod];
+			range.baseVertex = shapeBaseVertex[range.shape];
+			range.firstIndex += shapeFirstIndex[range.shape];
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadMeshCache()
+ *
+ *  This method is used for reading the packed arena, the
+ *  draw ranges and the mesh bounds from a cache file.  The
+ *  file is only used when its header matches the current
+ *  version, layout and torus thickness.
+ ***********************************************************/
+bool SceneMeshes::ReadMeshCache(const char* filename, float torusThickness, std::vector<VERTEX>& vertices, std::vector<GLuint>& indices)
+{
+	std::ifstream file(filename, std::ios::binary);
+	MESH_CACHE_HEADER header;
+
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	file.read((char*)&header, sizeof(header));
+	if (!file.good() ||
+		(header.magic != MESH_CACHE_MAGIC) ||
+		(header.version != MESH_CACHE_VERSION) ||
+		(header.meshCount != MESH_COUNT) ||
+		(header.lodCount != LOD_COUNT) ||
+		(header.vertexSize != sizeof(VERTEX)) ||
+		(header.torusThickness != torusThickness) ||
+		(header.vertexCount == 0) ||
+		(header.indexCount == 0))
+	{
+		return(false);
+	}
+
+	DRAW_RANGE drawRanges[MESH_COUNT][LOD_COUNT];
+	MESH_BOUNDS meshBounds[MESH_COUNT];
+	vertices.resize(header.vertexCount);
+	indices.resize(header.indexCount);
+
+	file.read((char*)drawRanges, sizeof(drawRanges));
+	file.read((char*)meshBounds, sizeof(meshBounds));
+	file.read((char*)&vertices[0], vertices.size() * sizeof(VERTEX));
+	file.read((char*)&indices[0], indices.size() * sizeof(GLuint));
+	if (!file.good())
+	{
+		vertices.clear();
+		indices.clear();
+		return(false);
+	}
+
+	memcpy(m_drawRanges, drawRanges, sizeof(m_drawRanges));
+	memcpy(m_meshBounds, meshBounds, sizeof(m_meshBounds));
+	return(true);
+}
+
+/***********************************************************
+ *  WriteMeshCache()
+ *
+ *  This method is used for writing the packed arena, the
+ *  draw ranges and the mesh bounds to a cache file.
+ ***********************************************************/
+bool SceneMeshes::WriteMeshCache(const char* filename, float torusThickness, const std::vector<VERTEX>& vertices, const std::vector<GLuint>& indices) const
+{
+	MESH_CACHE_HEADER header;
+
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.meshCount = MESH_COUNT;
+	header.lodCount = LOD_COUNT;
+	header.vertexSize = sizeof(VERTEX);
+	header.vertexCount = (uint32_t)vertices.size();
+	header.indexCount = (uint32_t)indices.size();
+	header.torusThickness = torusThickness;
+
+	FileUtilities::FILE_PART parts[5];
+	parts[0].pData = &header;
+	parts[0].size = sizeof(header);
+	parts[1].pData = m_drawRanges;
+	parts[1].size = sizeof(m_drawRanges);
+	parts[2].pData = m_meshBounds;
+	parts[2].size = sizeof(m_meshBounds);
+	parts[3].pData = vertices.data();
+	parts[3].size = vertices.size() * sizeof(VERTEX);
+	parts[4].pData = indices.data();
+	parts[4].size = indices.size() * sizeof(GLuint);
+
+	return(FileUtilities::WriteFileAtomic(filename, parts, 5));
+}
+
+/***********************************************************
+ *  PackVertices()
+ *
+ *  This method is used for converting the arena vertices
+ *  into the packed vertex layout.  Every basic shape fits in
+ *  about the same unit space, so all positions are stored
+ *  relative to the bounds of the whole arena, and one center
+ *  and extents decode the positions of any draw.
+ ***********************************************************/
+void SceneMeshes::PackVertices(const std::vector<VERTEX>& vertices, std::vector<PACKED_VERTEX>& packedVertices)
+{
+	glm::vec3 minimum = vertices[0].position;
+	glm::vec3 maximum = vertices[0].position;
+	for (size_t i = 1; i < vertices.size(); i++)
+	{
+		minimum = glm::min(minimum, vertices[i].position);
+		maximum = glm::max(maximum, vertices[i].position);
+	}
+
+	m_positionCenter = (minimum + maximum) * 0.5f;
+	m_positionExtents = glm::max((maximum - minimum) * 0.5f, glm::vec3(1.0e-6f));
+
+	packedVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const VERTEX& vertex = vertices[i];
+		PACKED_VERTEX& packed = packedVertices[i];
+		glm::vec3 position = (vertex.position - m_positionCenter) / m_positionExtents;
+		glm::vec2 normal = OctahedralEncode(vertex.normal);
+
+		packed.position[0] = PackSnorm16(position.x);
+		packed.position[1] = PackSnorm16(position.y);
+		packed.position[2] = PackSnorm16(position.z);
+		packed.position[3] = 0;
+		packed.normal[0] = PackSnorm16(normal.x);
+		packed.normal[1] = PackSnorm16(normal.y);
+		packed.uv[0] = PackUnorm16(vertex.uv.x);
+		packed.uv[1] = PackUnorm16(vertex.uv.y);
+	}
+}
+
+/***********************************************************
+ *  GetVertexSize()
+ *
+ *  This method is used for getting the bytes of one arena
+ *  vertex in the current vertex format.
+ ***********************************************************/
+int SceneMeshes::GetVertexSize() const
+{
+	if (VERTEX_FORMAT_PACKED == m_vertexFormat)
+	{
+		return((int)sizeof(PACKED_VERTEX));
+	}
+
+	return((int)sizeof(VERTEX));
+}
+
+/***********************************************************
+ *  CreateArenaBuffers()
+ *
+ *  This method is used for loading the arena vertices and
+ *  indices into one vertex buffer and one index buffer, in
+ *  the current vertex format.  The indices of every shape
+ *  are relative to its base vertex, so 16-bit indices are
+ *  used whenever no shape has more vertices than they hold.
+ ***********************************************************/
+void SceneMeshes::CreateArenaBuffers(const std::vector<VERTEX>& vertices, const std::vector<GLuint>& indices)
+{
+	GLuint largestIndex = 0;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		largestIndex = (indices[i] > largestIndex) ? indices[i] : largestIndex;
+	}
+
+	glGenVertexArrays(1, &m_arenaVAO);
+	glBindVertexArray(m_arenaVAO);
+
+	glGenBuffers(2, m_arenaVBOs);
+	glBindBuffer(GL_ARRAY_BUFFER, m_arenaVBOs[0]);
+	if (VERTEX_FORMAT_PACKED == m_vertexFormat)
+	{
+		std::vector<PACKED_VERTEX> packedVertices;
+		PackVertices(vertices, packedVertices);
+		glBufferData(GL_ARRAY_BUFFER, packedVertices.size() * sizeof(PACKED_VERTEX), &packedVertices[0], GL_STATIC_DRAW);
+
+		// the normalized attributes arrive in the shader as -1 to 1
+		// and 0 to 1, which the shader decodes
+		glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_SHORT, GL_TRUE, sizeof(PACKED_VERTEX), (void*)offsetof(PACKED_VERTEX, position));
+		glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+		glVertexAttribPointer(NORMAL_ATTRIBUTE, 2, GL_SHORT, GL_TRUE, sizeof(PACKED_VERTEX), (void*)offsetof(PACKED_VERTEX, normal));
+		glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+		glVertexAttribPointer(UV_ATTRIBUTE, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PACKED_VERTEX), (void*)offsetof(PACKED_VERTEX, uv));
+		glEnableVertexAttribArray(UV_ATTRIBUTE);
+	}
+	else
+	{
+		m_positionCenter = glm::vec3(0.0f);
+		m_positionExtents = glm::vec3(1.0f);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VERTEX), &vertices[0], GL_STATIC_DRAW);
+
+		glVertexAttribPointer(POSITION_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (void*)offsetof(VERTEX, position));
+		glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+		glVertexAttribPointer(NORMAL_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (void*)offsetof(VERTEX, normal));
+		glEnableVertexAttribArray(NORMAL_ATTRIBUTE);
+		glVertexAttribPointer(UV_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(VERTEX), (void*)offsetof(VERTEX, uv));
+		glEnableVertexAttribArray(UV_ATTRIBUTE);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_arenaVBOs[1]);
+	if (largestIndex <= MAX_SHORT_INDEX)
+	{
+		std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+		m_indexType = GL_UNSIGNED_SHORT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), &shortIndices[0], GL_STATIC_DRAW);
+	}
+	else
+	{
+		m_indexType = GL_UNSIGNED_INT;
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
+	}
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  AttachInstanceBuffer()
+ *
+ *  This method is used for attaching the per-instance
+ *  attributes of the passed in buffer to the arena.  It is
+ *  only needed when a different instance buffer is drawn.
+ ***********************************************************/
+void SceneMeshes::AttachInstanceBuffer(GLuint instanceBuffer)
+{
+	glBindVertexArray(m_arenaVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+	// the model matrix takes one attribute per column
+	for (int column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(INSTANCE_MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE_DATA),
+			(void*)(offsetof(INSTANCE_DATA, model) + column * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(INSTANCE_MODEL_ATTRIBUTE + column);
+		glVertexAttribDivisor(INSTANCE_MODEL_ATTRIBUTE + column, 1);
+	}
+
+	glVertexAttribPointer(INSTANCE_COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(INSTANCE_DATA),
+		(void*)offsetof(INSTANCE_DATA, color));
+	glEnableVertexAttribArray(INSTANCE_COLOR_ATTRIBUTE);
+	glVertexAttribDivisor(INSTANCE_COLOR_ATTRIBUTE, 1);
+
+	glVertexAttribIPointer(INSTANCE_INDEX_ATTRIBUTE, 2, GL_INT, sizeof(INSTANCE_DATA),
+		(void*)offsetof(INSTANCE_DATA, materialIndex));
+	glEnableVertexAttribArray(INSTANCE_INDEX_ATTRIBUTE);
+	glVertexAttribDivisor(INSTANCE_INDEX_ATTRIBUTE, 1);
+
+	glVertexAttribPointer(INSTANCE_UV_SCALE_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(INSTANCE_DATA),
+		(void*)offsetof(INSTANCE_DATA, uvScale));
+	glEnableVertexAttribArray(INSTANCE_UV_SCALE_ATTRIBUTE);
+	glVertexAttribDivisor(INSTANCE_UV_SCALE_ATTRIBUTE, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_attachedInstanceBuffer = instanceBuffer;
+}
+
+/***********************************************************
+ *  DrawMeshInstanced()
+ *
+ *  This method is used for drawing the passed in number of
+ *  instances of a mesh in one call.  Each instance reads its
+ *  model matrix, color and material and texture indices from
+ *  the instance buffer, starting at the base instance.
+ ***********************************************************/
+void SceneMeshes::DrawMeshInstanced(
+	int meshID,
+	int instanceCount,
+	GLuint instanceBuffer,
+	int baseInstance,
+	int lodLevel)
+{
+	if ((meshID < 0) || (meshID >= MESH_COUNT) || (instanceCount <= 0) ||
+		(lodLevel < 0) || (lodLevel >= LOD_COUNT))
+	{
+		return;
+	}
+
+	if (instanceBuffer != m_attachedInstanceBuffer)
+	{
+		AttachInstanceBuffer(instanceBuffer);
+	}
+
+	const DRAW_RANGE& range = m_drawRanges[meshID][lodLevel];
+
+	glBindVertexArray(m_arenaVAO);
+	glDrawElementsInstancedBaseVertexBaseInstance(
+		GL_TRIANGLES,
+		range.indexCount,
+		m_indexType,
+		(void*)((size_t)range.firstIndex * GetIndexSize()),
+		instanceCount,
+		range.baseVertex,
+		baseInstance);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  MakeDrawCommand()
+ *
+ *  This method is used for building the indirect draw
+ *  command that draws the passed in number of instances of
+ *  a mesh at a level of detail, starting at the passed in
+ *  instance.
+ ***********************************************************/
+SceneMeshes::DRAW_COMMAND SceneMeshes::MakeDrawCommand(
+	int meshID,
+	int lodLevel,
+	int instanceCount,
+	int baseInstance) const
+{
+	DRAW_COMMAND command;
+
+	command.count = 0;
+	command.instanceCount = 0;
+	command.firstIndex = 0;
+	command.baseVertex = 0;
+	command.baseInstance = 0;
+
+	if ((meshID >= 0) && (meshID < MESH_COUNT) && (instanceCount > 0) &&
+		(lodLevel >= 0) && (lodLevel < LOD_COUNT))
+	{
+		const DRAW_RANGE& range = m_drawRanges[meshID][lodLevel];
+		command.count = range.indexCount;
+		command.instanceCount = (GLuint)instanceCount;
+		command.firstIndex = range.firstIndex;
+		command.baseVertex = range.baseVertex;
+		command.baseInstance = (GLuint)baseInstance;
+	}
+
+	return(command);
+}
+
+/***********************************************************
+ *  DrawMeshesIndirect()
+ *
+ *  This method is used for drawing a run of commands stored
+ *  in the passed in indirect buffer with one multi-draw.
+ *  Since every mesh lives in the same arena, the commands
+ *  can mix any of the meshes.
+ ***********************************************************/
+void SceneMeshes::DrawMeshesIndirect(
+	GLuint commandBuffer,
+	int firstCommand,
+	int commandCount,
+	GLuint instanceBuffer)
+{
+	if (commandCount <= 0)
+	{
+		return;
+	}
+
+	if (instanceBuffer != m_attachedInstanceBuffer)
+	{
+		AttachInstanceBuffer(instanceBuffer);
+	}
+
+	glBindVertexArray(m_arenaVAO);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		m_indexType,
+		(void*)(firstCommand * sizeof(DRAW_COMMAND)),
+		commandCount,
+		0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DestroyArenaBuffers()
+ *
+ *  This method is used for freeing the shared arena buffers
+ *  of the loaded shapes.
+ ***********************************************************/
+void SceneMeshes::DestroyArenaBuffers()
+{
+	if (0 != m_arenaVAO)
+	{
+		glDeleteVertexArrays(1, &m_arenaVAO);
+		glDeleteBuffers(2, m_arenaVBOs);
+		m_arenaVAO = 0;
+		m_arenaVBOs[0] = 0;
+		m_arenaVBOs[1] = 0;
+	}
+	m_attachedInstanceBuffer = 0;
+}
@@ -0,0 +1,253 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenemeshes.h
+// ============
+// generate the basic 3D shape meshes and draw them with instancing
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  SceneMeshes
+ *
+ *  This class contains the same basic shapes as ShapeMeshes,
+ *  generated with matching dimensions and texture mapping,
+ *  but every draw takes a per-instance buffer so that many
+ *  render items sharing a mesh are drawn with one call.  All
+ *  shapes share one vertex and index arena so that any set
+ *  of meshes can be drawn with a single multi-draw.  The
+ *  round shapes are generated at several levels of detail,
+ *  and the packed arena is kept in a cache file so later
+ *  launches skip the generation.  The arena vertices can be
+ *  stored in a packed layout of half the size, which the
+ *  vertex shader decodes.
+ ***********************************************************/
+class SceneMeshes
+{
+public:
+	// constructor
+	SceneMeshes();
+	// destructor
+	~SceneMeshes();
+
+	// identifiers for the drawable meshes, a mesh ID can refer
+	// to only part of a shape such as the top side of the box
+	enum MESH_ID
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_BOX_TOP,
+		MESH_CYLINDER,
+		MESH_CYLINDER_TOP,
+		MESH_CONE,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_TORUS,
+		MESH_HALF_TORUS,
+		MESH_PRISM,
+		MESH_COUNT
+	};
+
+	// number of tessellations each mesh is generated at,
+	// level 0 is the finest
+	static const int LOD_COUNT = 3;
+
+	// layouts the arena vertices can be stored in
+	enum VERTEX_FORMAT
+	{
+		// float positions, normals and texture coordinates
+		VERTEX_FORMAT_FLOAT = 0,
+		// snorm16 positions inside of the arena bounds,
+		// octahedral snorm16 normals and unorm16 coordinates
+		VERTEX_FORMAT_PACKED
+	};
+
+	// per-instance values read by the vertex shader
+	struct INSTANCE_DATA
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		GLint materialIndex;
+		GLint textureSlot;
+		glm::vec2 uvScale;
+	};
+
+	// object space bounds of a mesh as a box and a sphere
+	// around the same center
+	struct MESH_BOUNDS
+	{
+		glm::vec3 center;
+		glm::vec3 extents;
+		float radius;
+	};
+
+	// layout of one glMultiDrawElementsIndirect command
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// generate the shapes, or read them from the cache file,
+	// and load them into GPU buffers
+	void LoadMeshes(float torusThickness, const char* cacheFilename = NULL);
+
+	// set the layout of the arena vertices, before LoadMeshes()
+	void SetVertexFormat(VERTEX_FORMAT format) { m_vertexFormat = format; }
+	VERTEX_FORMAT GetVertexFormat() const { return(m_vertexFormat); }
+	// get the center and extents that packed positions are
+	// relative to, for decoding them in the vertex shader
+	const glm::vec3& GetPositionCenter() const { return(m_positionCenter); }
+	const glm::vec3& GetPositionExtents() const { return(m_positionExtents); }
+	// get the bytes of one arena vertex and one index
+	int GetVertexSize() const;
+	int GetIndexSize() const { return((GL_UNSIGNED_SHORT == m_indexType) ? 2 : 4); }
+
+	// draw instances of a mesh from the passed in instance
+	// buffer, starting at the passed in instance
+	void DrawMeshInstanced(
+		int meshID,
+		int instanceCount,
+		GLuint instanceBuffer,
+		int baseInstance = 0,
+		int lodLevel = 0);
+
+	// pick the level of detail for a mesh whose bounding sphere
+	// covers the passed in fraction of half the viewport height
+	static int SelectLevelOfDetail(float screenRadius);
+
+	// get the object space bounds of a mesh
+	const MESH_BOUNDS& GetMeshBounds(int meshID) const { return(m_meshBounds[meshID]); }
+
+	// build the indirect command that draws instances of a mesh
+	DRAW_COMMAND MakeDrawCommand(int meshID, int lodLevel, int instanceCount, int baseInstance) const;
+	// draw a run of commands from the passed in indirect buffer
+	void DrawMeshesIndirect(
+		GLuint commandBuffer,
+		int firstCommand,
+		int commandCount,
+		GLuint instanceBuffer);
+
+	// instanced draws for each of the basic shapes
+	void DrawPlaneMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_PLANE, count, instanceBuffer); }
+	void DrawBoxMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_BOX, count, instanceBuffer); }
+	void DrawCylinderMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_CYLINDER, count, instanceBuffer); }
+	void DrawConeMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_CONE, count, instanceBuffer); }
+	void DrawSphereMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_SPHERE, count, instanceBuffer); }
+	void DrawHalfSphereMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_HALF_SPHERE, count, instanceBuffer); }
+	void DrawTorusMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_TORUS, count, instanceBuffer); }
+	void DrawHalfTorusMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_HALF_TORUS, count, instanceBuffer); }
+	void DrawPrismMeshInstanced(int count, GLuint instanceBuffer) { DrawMeshInstanced(MESH_PRISM, count, instanceBuffer); }
+
+private:
+	// vertex layout shared by all generated shapes
+	struct VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+	};
+
+	// vertex layout of the packed vertex format, the fourth
+	// position component only pads the position to 8 bytes
+	struct PACKED_VERTEX
+	{
+		GLshort position[4];
+		GLshort normal[2];
+		GLushort uv[2];
+	};
+
+	// generated vertices and indices of one shape
+	struct SHAPE_DATA
+	{
+		std::vector<VERTEX> vertices;
+		std::vector<GLuint> indices;
+	};
+
+	// the part of the arena drawn for a mesh ID, the shape is
+	// the index of the generated shape and level of detail
+	struct DRAW_RANGE
+	{
+		int shape;
+		GLuint firstIndex;
+		GLuint indexCount;
+		GLint baseVertex;
+	};
+
+	// identifiers for the generated shapes
+	enum SHAPE_ID
+	{
+		SHAPE_PLANE = 0,
+		SHAPE_BOX,
+		SHAPE_CYLINDER,
+		SHAPE_CONE,
+		SHAPE_SPHERE,
+		SHAPE_TORUS,
+		SHAPE_PRISM,
+		SHAPE_COUNT
+	};
+
+	// vertex array, vertex buffer and index buffer shared by all shapes
+	GLuint m_arenaVAO;
+	GLuint m_arenaVBOs[2];
+	DRAW_RANGE m_drawRanges[MESH_COUNT][LOD_COUNT];
+	// bounds of the vertices referenced by the finest draw range
+	MESH_BOUNDS m_meshBounds[MESH_COUNT];
+	// instance buffer currently attached to the arena vertex array
+	GLuint m_attachedInstanceBuffer;
+	// layout of the arena vertices and the type of its indices
+	VERTEX_FORMAT m_vertexFormat;
+	GLenum m_indexType;
+	// bounds of every arena vertex, the packed positions are
+	// stored relative to them
+	glm::vec3 m_positionCenter;
+	glm::vec3 m_positionExtents;
+
+	// append a vertex to a shape and return its index
+	static GLuint AddVertex(
+		SHAPE_DATA& shape,
+		const glm::vec3& position,
+		const glm::vec3& normal,
+		const glm::vec2& uv);
+	// append the two triangles of a quad to a shape
+	static void AddQuad(SHAPE_DATA& shape, GLuint a, GLuint b, GLuint c, GLuint d);
+
+	// generate the vertices and indices of each shape, the
+	// round shapes at the passed in level of detail
+	void GeneratePlane(SHAPE_DATA& shape);
+	void GenerateBox(SHAPE_DATA& shape);
+	void GenerateCylinder(SHAPE_DATA& shape, int lodLevel);
+	void GenerateCone(SHAPE_DATA& shape, int lodLevel);
+	void GenerateSphere(SHAPE_DATA& shape, int lodLevel);
+	void GenerateTorus(SHAPE_DATA& shape, float thickness, int lodLevel);
+	void GeneratePrism(SHAPE_DATA& shape);
+	// generate every shape at every level of detail
+	void GenerateShapes(SHAPE_DATA* shapes, float torusThickness);
+
+	// pack the generated shapes back to back into arena data
+	void PackArena(const SHAPE_DATA* shapes, std::vector<VERTEX>& vertices, std::vector<GLuint>& indices);
+	// load the packed arena data into the shared arena buffers
+	void CreateArenaBuffers(const std::vector<VERTEX>& vertices, const std::vector<GLuint>& indices);
+	// convert the arena vertices into the packed vertex layout
+	void PackVertices(const std::vector<VERTEX>& vertices, std::vector<PACKED_VERTEX>& packedVertices);
+	// compute the bounds of each draw range
+	void ComputeMeshBounds(const SHAPE_DATA* shapes);
+	// set the draw range of a mesh ID at a level of detail
+	void SetDrawRange(int meshID, int lodLevel, int shapeID, GLuint firstIndex, GLuint indexCount);
+	// read and write the packed arena data and draw ranges
+	bool ReadMeshCache(const char* filename, float torusThickness, std::vector<VERTEX>& vertices, std::vector<GLuint>& indices);
+	bool WriteMeshCache(const char* filename, float torusThickness, const std::vector<VERTEX>& vertices, const std::vector<GLuint>& indices) const;
+	// attach the per-instance attributes to the arena
+	void AttachInstanceBuffer(GLuint instanceBuffer);
+	// free the shared arena buffers
+	void DestroyArenaBuffers();
+};
@@ -0,0 +1,211 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercompiler.cpp
+// ============
+// compile and link shader programs from GLSL files
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderCompiler.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// declaration of global variables
+namespace
+{
+	// write the log of a program that failed to link and delete
+	// it, returning the program or 0 when it failed
+	GLuint CheckLinkStatus(GLuint programID)
+	{
+		GLint bLinked = 0;
+		glGetProgramiv(programID, GL_LINK_STATUS, &bLinked);
+		if (bLinked == GL_FALSE)
+		{
+			char infoLog[512];
+			glGetProgramInfoLog(programID, sizeof(infoLog), NULL, infoLog);
+			std::cout << "Could not link shader program\n" << infoLog << std::endl;
+			glDeleteProgram(programID);
+			return(0);
+		}
+
+		return(programID);
+	}
+}
+
+/***********************************************************
+ *  ReadShaderFile()
+ *
+ *  This method is used for reading the whole source text of
+ *  the passed in GLSL file.
+ ***********************************************************/
+bool ShaderCompiler::ReadShaderFile(const char* filename, std::string& source)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		std::cout << "Could not open shader file:" << filename << std::endl;
+		return(false);
+	}
+	std::stringstream text;
+	text << file.rdbuf();
+	source = text.str();
+
+	return(true);
+}
+
+/***********************************************************
+ *  InsertDefines()
+ *
+ *  This method is used for adding preprocessor definitions
+ *  to GLSL source.  They go right after the #version line,
+ *  which must stay first, and before any #extension line.
+ ***********************************************************/
+std::string ShaderCompiler::InsertDefines(const std::string& source, const std::string& defines)
+{
+	std::string result = source;
+	size_t insertAt = 0;
+	size_t versionAt = result.find("#version");
+	if (std::string::npos != versionAt)
+	{
+		size_t lineEnd = result.find('\n', versionAt);
+		if (std::string::npos == lineEnd)
+		{
+			result += "\n";
+			insertAt = result.size();
+		}
+		else
+		{
+			insertAt = lineEnd + 1;
+		}
+	}
+	result.insert(insertAt, defines);
+
+	return(result);
+}
+
+/***********************************************************
+ *  CompileShaderSource()
+ *
+ *  This method is used for compiling one shader stage from
+ *  GLSL source.  The name is only used in error messages.
+ ***********************************************************/
+GLuint ShaderCompiler::CompileShaderSource(GLenum shaderType, const std::string& source, const char* name)
+{
+	const char* pText = source.c_str();
+
+	GLuint shaderID = glCreateShader(shaderType);
+	glShaderSource(shaderID, 1, &pText, NULL);
+	glCompileShader(shaderID);
+
+	GLint bCompiled = 0;
+	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &bCompiled);
+	if (bCompiled == GL_FALSE)
+	{
+		char infoLog[512];
+		glGetShaderInfoLog(shaderID, sizeof(infoLog), NULL, infoLog);
+		std::cout << "Could not compile shader:" << name << "\n" << infoLog << std::endl;
+		glDeleteShader(shaderID);
+		return(0);
+	}
+
+	return(shaderID);
+}
+
+/***********************************************************
+ *  CompileShaderFile()
+ *
+ *  This method is used for compiling one shader stage from
+ *  the source in the passed in GLSL file.
+ ***********************************************************/
+GLuint ShaderCompiler::CompileShaderFile(GLenum shaderType, const char* filename)
+{
+	std::string source;
+	if (!ReadShaderFile(filename, source))
+	{
+		return(0);
+	}
+
+	return(CompileShaderSource(shaderType, source, filename));
+}
+
+/***********************************************************
+ *  LinkProgram()
+ *
+ *  This method is used for linking a shader program from the
+ *  passed in compiled stages.  The stages are not deleted.
+ *  A program linked as retrievable keeps its binary so that
+ *  it can be saved and loaded again without compiling.
+ ***********************************************************/
+GLuint ShaderCompiler::LinkProgram(GLuint vertexShaderID, GLuint fragmentShaderID, bool bRetrievable)
+{
+	if ((0 == vertexShaderID) || (0 == fragmentShaderID))
+	{
+		return(0);
+	}
+
+	GLuint programID = glCreateProgram();
+	glAttachShader(programID, vertexShaderID);
+	glAttachShader(programID, fragmentShaderID);
+	if (bRetrievable)
+	{
+		glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(programID);
+	glDetachShader(programID, vertexShaderID);
+	glDetachShader(programID, fragmentShaderID);
+
+	return(CheckLinkStatus(programID));
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for compiling the passed in vertex
+ *  and fragment shader files and linking them into a new
+ *  shader program.
+ ***********************************************************/
+GLuint ShaderCompiler::BuildProgram(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	GLuint vertexShaderID = CompileShaderFile(GL_VERTEX_SHADER, vertexShaderFile);
+	GLuint fragmentShaderID = CompileShaderFile(GL_FRAGMENT_SHADER, fragmentShaderFile);
+	GLuint programID = LinkProgram(vertexShaderID, fragmentShaderID);
+
+	// glDeleteShader ignores a stage that failed to compile
+	glDeleteShader(vertexShaderID);
+	glDeleteShader(fragmentShaderID);
+
+	return(programID);
+}
+
+/***********************************************************
+ *  BuildComputeProgram()
+ *
+ *  This method is used for compiling the passed in compute
+ *  shader file with the passed in preprocessor definitions
+ *  and linking it into a new shader program.
+ ***********************************************************/
+GLuint ShaderCompiler::BuildComputeProgram(const char* computeShaderFile, const std::string& defines)
+{
+	std::string source;
+	if (!ReadShaderFile(computeShaderFile, source))
+	{
+		return(0);
+	}
+
+	GLuint computeShaderID = CompileShaderSource(GL_COMPUTE_SHADER, InsertDefines(source, defines), computeShaderFile);
+	if (0 == computeShaderID)
+	{
+		return(0);
+	}
+
+	GLuint programID = glCreateProgram();
+	glAttachShader(programID, computeShaderID);
+	glLinkProgram(programID);
+	glDetachShader(programID, computeShaderID);
+	glDeleteShader(computeShaderID);
+
+	return(CheckLinkStatus(programID));
+}
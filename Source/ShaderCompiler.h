@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadercompiler.h
+// ============
+// compile and link shader programs from GLSL files
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+
+/***********************************************************
+ *  ShaderCompiler
+ *
+ *  This class contains the steps of building a shader
+ *  program from its GLSL files.  Each step writes the
+ *  compiler or linker log on failure and returns 0, so a
+ *  caller can keep the program it already has.
+ ***********************************************************/
+class ShaderCompiler
+{
+public:
+	// read the source text of a GLSL file
+	static bool ReadShaderFile(const char* filename, std::string& source);
+	// add preprocessor definitions right after the version line
+	static std::string InsertDefines(const std::string& source, const std::string& defines);
+	// compile one shader stage from GLSL source, 0 on failure
+	static GLuint CompileShaderSource(GLenum shaderType, const std::string& source, const char* name);
+	// compile one shader stage from a GLSL file, 0 on failure
+	static GLuint CompileShaderFile(GLenum shaderType, const char* filename);
+	// link a program from compiled stages, 0 on failure, a
+	// retrievable program can be saved with glGetProgramBinary
+	static GLuint LinkProgram(GLuint vertexShaderID, GLuint fragmentShaderID, bool bRetrievable = false);
+	// compile and link a program from its GLSL files, 0 on failure
+	static GLuint BuildProgram(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// compile and link a compute program from its GLSL file with
+	// preprocessor definitions, 0 on failure
+	static GLuint BuildComputeProgram(const char* computeShaderFile, const std::string& defines = std::string());
+};
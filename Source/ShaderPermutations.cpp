@@ -0,0 +1,355 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderpermutations.cpp
+// ============
+// build the scene shader permutations and cache their program binaries
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderPermutations.h"
+#include "FileUtilities.h"
+#include "ShaderCompiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	const char* DEFAULT_CACHE_DIRECTORY = "shader_cache";
+
+	// identifies a cached program binary, the version must be
+	// raised whenever the header or the permutations change
+	const uint32_t PROGRAM_BINARY_MAGIC = 0x47525053;	// "SPRG"
+	const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+	// most lights a fragment of each light count bucket loops
+	// over, the last bucket loops over every light of its tile
+	const int LIGHT_BUCKET_LIMITS[ShaderPermutations::LIGHT_BUCKET_COUNT] = { 1, 2, 4, 8, 0 };
+
+	// hash text, continuing from a hash
+	uint64_t HashText(uint64_t hash, const char* text)
+	{
+		if (NULL == text)
+		{
+			return(hash);
+		}
+		return(FileUtilities::HashBytes(text, strlen(text), hash));
+	}
+}
+
+/***********************************************************
+ *  ShaderPermutations()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderPermutations::ShaderPermutations()
+{
+	m_sourceHash = 0;
+	m_cacheDirectory = DEFAULT_CACHE_DIRECTORY;
+	m_compileCount = 0;
+	m_cacheLoadCount = 0;
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		m_programs[i] = 0;
+		m_bFailed[i] = false;
+	}
+}
+
+/***********************************************************
+ *  ~ShaderPermutations()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderPermutations::~ShaderPermutations()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  SetShaderFiles()
+ *
+ *  This method is used for reading the GLSL source of the
+ *  scene shader files.  The programs built from the old
+ *  source are deleted, so each permutation is built again
+ *  the next time it is asked for.  The driver strings are
+ *  part of the source hash, so a driver update never loads
+ *  a binary saved by another driver.
+ ***********************************************************/
+bool ShaderPermutations::SetShaderFiles(const std::string& vertexShaderFile, const std::string& fragmentShaderFile)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+	if (!ShaderCompiler::ReadShaderFile(vertexShaderFile.c_str(), vertexSource) ||
+		!ShaderCompiler::ReadShaderFile(fragmentShaderFile.c_str(), fragmentSource))
+	{
+		return(false);
+	}
+
+	Destroy();
+	m_vertexShaderFile = vertexShaderFile;
+	m_fragmentShaderFile = fragmentShaderFile;
+	m_vertexSource = vertexSource;
+	m_fragmentSource = fragmentSource;
+
+	uint64_t hash = FileUtilities::HASH_OFFSET_BASIS;
+	hash = HashText(hash, m_vertexSource.c_str());
+	hash = HashText(hash, m_fragmentSource.c_str());
+	hash = HashText(hash, (const char*)glGetString(GL_VENDOR));
+	hash = HashText(hash, (const char*)glGetString(GL_RENDERER));
+	hash = HashText(hash, (const char*)glGetString(GL_VERSION));
+	m_sourceHash = hash;
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for getting the program of the passed
+ *  in permutation, building it on first use.  A permutation
+ *  that fails to build returns 0 from then on, until the
+ *  shader files are read again.
+ ***********************************************************/
+GLuint ShaderPermutations::GetProgram(int permutation)
+{
+	if ((permutation < 0) || (permutation >= PERMUTATION_COUNT) || m_vertexSource.empty())
+	{
+		return(0);
+	}
+
+	if ((0 == m_programs[permutation]) && !m_bFailed[permutation])
+	{
+		m_programs[permutation] = BuildProgram(permutation);
+		m_bFailed[permutation] = (0 == m_programs[permutation]);
+	}
+
+	return(m_programs[permutation]);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for deleting all of the built
+ *  permutation programs.
+ ***********************************************************/
+void ShaderPermutations::Destroy()
+{
+	for (int i = 0; i < PERMUTATION_COUNT; i++)
+	{
+		if (0 != m_programs[i])
+		{
+			glDeleteProgram(m_programs[i]);
+			m_programs[i] = 0;
+		}
+		m_bFailed[i] = false;
+	}
+}
+
+/***********************************************************
+ *  MakePermutation()
+ *
+ *  This method is used for picking the permutation of a draw.
+ *  Lit permutations use the smallest light count bucket that
+ *  holds every light of the scene, since a tile never lists
+ *  more lights than the scene has.  Unlit permutations all
+ *  use the first bucket, so no duplicate programs are built.
+ ***********************************************************/
+int ShaderPermutations::MakePermutation(bool bTextured, bool bLit, int lightCount)
+{
+	int permutation = bTextured ? PERMUTATION_TEXTURED : 0;
+
+	if (bLit && (lightCount > 0))
+	{
+		int bucket = LIGHT_BUCKET_COUNT - 1;
+		for (int b = 0; b < LIGHT_BUCKET_COUNT - 1; b++)
+		{
+			if (lightCount <= LIGHT_BUCKET_LIMITS[b])
+			{
+				bucket = b;
+				break;
+			}
+		}
+		permutation |= PERMUTATION_LIT | (bucket << LIGHT_BUCKET_SHIFT);
+	}
+
+	return(permutation);
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for loading the cached binary of a
+ *  permutation, or compiling and linking it from the source
+ *  with its definitions and saving its binary when there is
+ *  no usable cached binary.
+ ***********************************************************/
+GLuint ShaderPermutations::BuildProgram(int permutation)
+{
+	std::string cachePath = GetCachePath(permutation);
+	GLuint programID = LoadProgramBinary(cachePath);
+	if (0 != programID)
+	{
+		m_cacheLoadCount++;
+		return(programID);
+	}
+
+	std::string defines = GetDefines(permutation);
+	GLuint vertexShaderID = ShaderCompiler::CompileShaderSource(GL_VERTEX_SHADER,
+		ShaderCompiler::InsertDefines(m_vertexSource, defines), m_vertexShaderFile.c_str());
+	GLuint fragmentShaderID = ShaderCompiler::CompileShaderSource(GL_FRAGMENT_SHADER,
+		ShaderCompiler::InsertDefines(m_fragmentSource, defines), m_fragmentShaderFile.c_str());
+	programID = ShaderCompiler::LinkProgram(vertexShaderID, fragmentShaderID, true);
+	glDeleteShader(vertexShaderID);
+	glDeleteShader(fragmentShaderID);
+
+	if (0 == programID)
+	{
+		std::cout << "Could not build shader permutation " << permutation << std::endl;
+		return(0);
+	}
+
+	m_compileCount++;
+	if (!SaveProgramBinary(programID, cachePath))
+	{
+		std::cout << "Could not write shader cache file:" << cachePath << std::endl;
+	}
+
+	return(programID);
+}
+
+/***********************************************************
+ *  GetDefines()
+ *
+ *  This method is used for getting the preprocessor lines
+ *  that fix the features of a permutation in the shaders.
+ *  A light limit of 0 loops over every light of a tile.
+ ***********************************************************/
+std::string ShaderPermutations::GetDefines(int permutation)
+{
+	int bucket = permutation >> LIGHT_BUCKET_SHIFT;
+	char defines[160];
+
+	snprintf(defines, sizeof(defines),
+		"#define SHADER_PERMUTATION 1\n"
+		"#define USE_TEXTURE %d\n"
+		"#define USE_LIGHTING %d\n"
+		"#define MAX_ACTIVE_LIGHTS %d\n",
+		(permutation & PERMUTATION_TEXTURED) ? 1 : 0,
+		(permutation & PERMUTATION_LIT) ? 1 : 0,
+		LIGHT_BUCKET_LIMITS[bucket]);
+
+	return(std::string(defines));
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the path of the cached
+ *  binary of a permutation of the current source.
+ ***********************************************************/
+std::string ShaderPermutations::GetCachePath(int permutation) const
+{
+	char name[40];
+
+	snprintf(name, sizeof(name), "%016llx_%02d.bin", (unsigned long long)m_sourceHash, permutation);
+
+	return(m_cacheDirectory + "/" + name);
+}
+
+/***********************************************************
+ *  LoadProgramBinary()
+ *
+ *  This method is used for creating a program from a cached
+ *  binary.  The driver may reject a binary it saved itself,
+ *  for example after a driver update, in which case the
+ *  permutation is compiled again.
+ ***********************************************************/
+GLuint ShaderPermutations::LoadProgramBinary(const std::string& path) const
+{
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (!file.is_open())
+	{
+		return(0);
+	}
+
+	PROGRAM_BINARY_HEADER header;
+	if (!file.read((char*)&header, sizeof(header)) ||
+		(header.magic != PROGRAM_BINARY_MAGIC) ||
+		(header.version != PROGRAM_BINARY_VERSION) ||
+		(header.sourceHash != m_sourceHash) ||
+		(header.binaryBytes == 0))
+	{
+		return(0);
+	}
+
+	std::vector<char> binary(header.binaryBytes);
+	if (!file.read(&binary[0], header.binaryBytes))
+	{
+		return(0);
+	}
+
+	GLuint programID = glCreateProgram();
+	glProgramBinary(programID, (GLenum)header.binaryFormat, &binary[0], (GLsizei)header.binaryBytes);
+
+	GLint bLinked = 0;
+	glGetProgramiv(programID, GL_LINK_STATUS, &bLinked);
+	if (bLinked == GL_FALSE)
+	{
+		glDeleteProgram(programID);
+		return(0);
+	}
+
+	return(programID);
+}
+
+/***********************************************************
+ *  SaveProgramBinary()
+ *
+ *  This method is used for writing the binary of a linked
+ *  program to the cache.
+ ***********************************************************/
+bool ShaderPermutations::SaveProgramBinary(GLuint programID, const std::string& path) const
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	GLint binaryBytes = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &binaryBytes);
+	if ((formatCount <= 0) || (binaryBytes <= 0))
+	{
+		// the driver cannot save programs, so nothing is cached
+		return(true);
+	}
+
+	std::vector<char> binary(binaryBytes);
+	GLenum binaryFormat = 0;
+	GLsizei writtenBytes = 0;
+	glGetProgramBinary(programID, binaryBytes, &writtenBytes, &binaryFormat, &binary[0]);
+	if (writtenBytes <= 0)
+	{
+		return(false);
+	}
+
+	if (!FileUtilities::CreateDirectoryPath(m_cacheDirectory))
+	{
+		return(false);
+	}
+
+	PROGRAM_BINARY_HEADER header;
+	header.magic = PROGRAM_BINARY_MAGIC;
+	header.version = PROGRAM_BINARY_VERSION;
+	header.sourceHash = m_sourceHash;
+	header.binaryFormat = (uint32_t)binaryFormat;
+	header.binaryBytes = (uint32_t)writtenBytes;
+
+	FileUtilities::FILE_PART parts[2];
+	parts[0].pData = &header;
+	parts[0].size = sizeof(header);
+	parts[1].pData = &binary[0];
+	parts[1].size = (size_t)writtenBytes;
+
+	return(FileUtilities::WriteFileAtomic(path, parts, 2));
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderpermutations.h
+// ============
+// build the scene shader permutations and cache their program binaries
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <stdint.h>
+#include <string>
+
+/***********************************************************
+ *  ShaderPermutations
+ *
+ *  This class contains the programs built from the scene
+ *  shader files with the texturing, the lighting and the
+ *  most lights a fragment loops over fixed at compile time,
+ *  so that the fragment shader does not branch on uniforms.
+ *  A permutation is built the first time it is asked for,
+ *  and its linked binary is saved so that later launches on
+ *  the same driver load it instead of compiling.
+ ***********************************************************/
+class ShaderPermutations
+{
+public:
+	// constructor
+	ShaderPermutations();
+	// destructor
+	~ShaderPermutations();
+
+	// bits of a permutation index, above them is the index of
+	// the light count bucket of lit permutations
+	static const int PERMUTATION_TEXTURED = 1;
+	static const int PERMUTATION_LIT = 2;
+	static const int LIGHT_BUCKET_SHIFT = 2;
+	static const int LIGHT_BUCKET_COUNT = 5;
+	static const int PERMUTATION_COUNT = LIGHT_BUCKET_COUNT << LIGHT_BUCKET_SHIFT;
+
+	// read the shader files, keeping the built programs when
+	// either file cannot be read
+	bool SetShaderFiles(const std::string& vertexShaderFile, const std::string& fragmentShaderFile);
+	// set the directory the program binaries are cached in
+	void SetCacheDirectory(const std::string& directory) { m_cacheDirectory = directory; }
+	// get the program of a permutation, 0 when it fails to build
+	GLuint GetProgram(int permutation);
+	// delete all of the built programs
+	void Destroy();
+
+	// get the number of programs compiled and loaded from the cache
+	int GetCompileCount() const { return(m_compileCount); }
+	int GetCacheLoadCount() const { return(m_cacheLoadCount); }
+
+	// pick the permutation of a draw with the scene light count
+	static int MakePermutation(bool bTextured, bool bLit, int lightCount);
+
+private:
+	// GLSL source of the shader files
+	std::string m_vertexShaderFile;
+	std::string m_fragmentShaderFile;
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+	// hash of the sources and the driver, any change of either
+	// leaves the cached binaries unused
+	uint64_t m_sourceHash;
+	std::string m_cacheDirectory;
+	// built program of each permutation, and the permutations
+	// that failed so they are not built again every frame
+	GLuint m_programs[PERMUTATION_COUNT];
+	bool m_bFailed[PERMUTATION_COUNT];
+	int m_compileCount;
+	int m_cacheLoadCount;
+
+	// leading record of a cached program binary
+	struct PROGRAM_BINARY_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t binaryFormat;
+		uint32_t binaryBytes;
+	};
+
+	// compile and link a permutation, or load it from the cache
+	GLuint BuildProgram(int permutation);
+	// get the preprocessor definitions of a permutation
+	static std::string GetDefines(int permutation);
+	// get the path of the cached binary of a permutation
+	std::string GetCachePath(int permutation) const;
+	// load a linked program from a cached binary, 0 on failure
+	GLuint LoadProgramBinary(const std::string& path) const;
+	// save the binary of a linked program to the cache
+	bool SaveProgramBinary(GLuint programID, const std::string& path) const;
+};
@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniformcache.cpp
+// ============
+// cache the shader uniform locations and skip redundant uniform uploads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderUniformCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// shader uniform names indexed by uniform ID
+	const char* g_UniformNames[ShaderUniformCache::UNIFORM_COUNT] =
+	{
+		"model",
+		"view",
+		"projection",
+		"viewPosition",
+		"objectColor",
+		"objectTexture",
+		"bUseTexture",
+		"bUseLighting",
+		"UVscale",
+		"materialIndex",
+		"bUseInstancing",
+		"bUsePackedVertices",
+		"packedPositionCenter",
+		"packedPositionExtents"
+	};
+}
+
+/***********************************************************
+ *  ShaderUniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderUniformCache::ShaderUniformCache()
+{
+	m_programID = 0;
+	for (int i = 0; i < UNIFORM_COUNT; i++)
+	{
+		m_locations[i] = -1;
+	}
+	Invalidate();
+	ResetCounters();
+}
+
+/***********************************************************
+ *  ~ShaderUniformCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderUniformCache::~ShaderUniformCache()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  LoadLocations()
+ *
+ *  This method is used for looking up the location of every
+ *  cached uniform in the passed in linked shader program.
+ *  It should be called once after the shaders are loaded.
+ ***********************************************************/
+void ShaderUniformCache::LoadLocations(GLuint programID)
+{
+	m_programID = programID;
+
+	for (int i = 0; i < UNIFORM_COUNT; i++)
+	{
+		m_locations[i] = glGetUniformLocation(m_programID, g_UniformNames[i]);
+	}
+
+	// the uniform values in a newly linked program are unknown
+	Invalidate();
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting all the shadow values
+ *  so that the next value set into each uniform is uploaded.
+ ***********************************************************/
+void ShaderUniformCache::Invalidate()
+{
+	for (int i = 0; i < UNIFORM_COUNT; i++)
+	{
+		m_shadows[i].bValid = false;
+	}
+}
+
+/***********************************************************
+ *  ResetCounters()
+ *
+ *  This method is used for resetting the upload statistics.
+ ***********************************************************/
+void ShaderUniformCache::ResetCounters()
+{
+	m_uploadCount = 0;
+	m_skippedCount = 0;
+}
+
+/***********************************************************
+ *  UpdateShadow()
+ *
+ *  This method is used for comparing the passed in value
+ *  with the shadow copy of the uniform.  It returns true and
+ *  stores the value when it needs to be uploaded.
+ ***********************************************************/
+bool ShaderUniformCache::UpdateShadow(int uniformID, const float* values, int count)
+{
+	UNIFORM_SHADOW& shadow = m_shadows[uniformID];
+
+	if ((shadow.bValid == true) &&
+		(memcmp(shadow.values, values, count * sizeof(float)) == 0))
+	{
+		m_skippedCount++;
+		return(false);
+	}
+
+	memcpy(shadow.values, values, count * sizeof(float));
+	shadow.bValid = true;
+	m_uploadCount++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetIntValue()
+ *
+ *  This method is used for setting an integer or boolean
+ *  value into the identified uniform.
+ ***********************************************************/
+void ShaderUniformCache::SetIntValue(int uniformID, int value)
+{
+	float shadowValue = 0.0f;
+
+	// store the integer bits so every value compares exactly
+	memcpy(&shadowValue, &value, sizeof(int));
+	if (UpdateShadow(uniformID, &shadowValue, 1) == true)
+	{
+		glUniform1i(m_locations[uniformID], value);
+	}
+}
+
+/***********************************************************
+ *  SetFloatValue()
+ *
+ *  This method is used for setting a float value into the
+ *  identified uniform.
+ ***********************************************************/
+void ShaderUniformCache::SetFloatValue(int uniformID, float value)
+{
+	if (UpdateShadow(uniformID, &value, 1) == true)
+	{
+		glUniform1f(m_locations[uniformID], value);
+	}
+}
+
+/***********************************************************
+ *  SetVec2Value()
+ *
+ *  This method is used for setting a vec2 value into the
+ *  identified uniform.
+ ***********************************************************/
+void ShaderUniformCache::SetVec2Value(int uniformID, const glm::vec2& value)
+{
+	if (UpdateShadow(uniformID, glm::value_ptr(value), 2) == true)
+	{
+		glUniform2fv(m_locations[uniformID], 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  SetVec3Value()
+ *
+ *  This method is used for setting a vec3 value into the
+ *  identified uniform.
+ ***********************************************************/
+void ShaderUniformCache::SetVec3Value(int uniformID, const glm::vec3& value)
+{
+	if (UpdateShadow(uniformID, glm::value_ptr(value), 3) == true)
+	{
+		glUniform3fv(m_locations[uniformID], 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  SetVec4Value()
+ *
+ *  This method is used for setting a vec4 value into the
+ *  identified uniform.
+ ***********************************************************/
+void ShaderUniformCache::SetVec4Value(int uniformID, const glm::vec4& value)
+{
+	if (UpdateShadow(uniformID, glm::value_ptr(value), 4) == true)
+	{
+		glUniform4fv(m_locations[uniformID], 1, glm::value_ptr(value));
+	}
+}
+
+/***********************************************************
+ *  SetMat4Value()
+ *
+ *  This method is used for setting a mat4 value into the
+ *  identified uniform.
+ ***********************************************************/
+void ShaderUniformCache::SetMat4Value(int uniformID, const glm::mat4& value)
+{
+	if (UpdateShadow(uniformID, glm::value_ptr(value), 16) == true)
+	{
+		glUniformMatrix4fv(m_locations[uniformID], 1, GL_FALSE, glm::value_ptr(value));
+	}
+}
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniformcache.h
+// ============
+// cache the shader uniform locations and skip redundant uniform uploads
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShaderUniformCache
+ *
+ *  This class contains a table of uniform locations that is
+ *  filled once after the shaders are loaded, along with a
+ *  shadow copy of the last value set into each uniform so
+ *  that identical uploads are never sent to the driver.
+ ***********************************************************/
+class ShaderUniformCache
+{
+public:
+	// constructor
+	ShaderUniformCache();
+	// destructor
+	~ShaderUniformCache();
+
+	// identifiers for the cached shader uniforms
+	enum UNIFORM_ID
+	{
+		UNIFORM_MODEL = 0,
+		UNIFORM_VIEW,
+		UNIFORM_PROJECTION,
+		UNIFORM_VIEW_POSITION,
+		UNIFORM_OBJECT_COLOR,
+		UNIFORM_OBJECT_TEXTURE,
+		UNIFORM_USE_TEXTURE,
+		UNIFORM_USE_LIGHTING,
+		UNIFORM_UV_SCALE,
+		UNIFORM_MATERIAL_INDEX,
+		UNIFORM_USE_INSTANCING,
+		UNIFORM_USE_PACKED_VERTICES,
+		UNIFORM_PACKED_POSITION_CENTER,
+		UNIFORM_PACKED_POSITION_EXTENTS,
+		UNIFORM_COUNT
+	};
+
+	// look up all uniform locations in the linked program
+	void LoadLocations(GLuint programID);
+	// forget the shadow values so the next sets are uploaded
+	void Invalidate();
+	// linked shader program the locations were loaded from
+	GLuint GetProgramID() const { return(m_programID); }
+
+	// set the uniform values, skipping unchanged values
+	void SetIntValue(int uniformID, int value);
+	void SetFloatValue(int uniformID, float value);
+	void SetVec2Value(int uniformID, const glm::vec2& value);
+	void SetVec3Value(int uniformID, const glm::vec3& value);
+	void SetVec4Value(int uniformID, const glm::vec4& value);
+	void SetMat4Value(int uniformID, const glm::mat4& value);
+
+	// number of uniform values uploaded and skipped
+	int GetUploadCount() const { return(m_uploadCount); }
+	int GetSkippedCount() const { return(m_skippedCount); }
+	void ResetCounters();
+
+private:
+	struct UNIFORM_SHADOW
+	{
+		bool bValid;
+		float values[16];
+	};
+
+	// linked shader program the locations belong to
+	GLuint m_programID;
+	// uniform locations indexed by uniform ID
+	GLint m_locations[UNIFORM_COUNT];
+	// last values set into each uniform
+	UNIFORM_SHADOW m_shadows[UNIFORM_COUNT];
+	// upload statistics
+	int m_uploadCount;
+	int m_skippedCount;
+
+	// compare the value with the shadow copy and store it
+	bool UpdateShadow(int uniformID, const float* values, int count);
+};
@@ -0,0 +1,607 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmanager.cpp
+// ============
+// render and cache the shadow maps of the scene lights
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowManager.h"
+#include "ShaderCompiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// uniform buffer binding point of the shadow block, after
+	// the material block
+	const GLuint SHADOW_BLOCK_BINDING = 1;
+	// texture unit of the shadow maps, after the texture array
+	// units of the texture registry
+	const GLint SHADOW_TEXTURE_UNIT = 8;
+
+	// view depth in front of the camera that the cascades cover
+	const float SHADOW_DISTANCE = 30.0f;
+	// blend between the logarithmic and the uniform split of
+	// the cascades, higher values give the near cascades more
+	const float CASCADE_SPLIT_LAMBDA = 0.7f;
+	// extra radius fitted around the part of the view of each
+	// cascade, so small camera moves keep the cached map
+	const float CASCADE_MARGIN = 1.25f;
+	// distance the cascades reach toward the light past their
+	// region, for shadow casters outside of the view
+	const float CASTER_DISTANCE = 30.0f;
+
+	// near plane of the spotlight view and the spot falloff the
+	// edge of its map is placed at
+	const float SPOT_NEAR_PLANE = 0.1f;
+	const float SPOT_EDGE_FALLOFF = 0.01f;
+	const float SPOT_MIN_DEGREES = 20.0f;
+	const float SPOT_MAX_DEGREES = 120.0f;
+
+	// biases that keep the surfaces from shadowing themselves
+	const float DEPTH_BIAS = 0.0002f;
+	const float NORMAL_OFFSET_TEXELS = 1.5f;
+	const float POLYGON_OFFSET_FACTOR = 2.0f;
+	const float POLYGON_OFFSET_UNITS = 4.0f;
+
+	// map sizes and filter radii of each shadow quality
+	const int QUALITY_MAP_SIZES[] = { 0, 1024, 2048, 2048 };
+	const int QUALITY_FILTER_RADII[] = { 0, 0, 1, 2 };
+}
+
+/***********************************************************
+ *  ShadowManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowManager::ShadowManager()
+{
+	m_quality = SHADOW_QUALITY_MEDIUM;
+	m_mapSize = 0;
+	m_filterRadius = 0;
+	for (int v = 0; v < SHADOW_VIEW_COUNT; v++)
+	{
+		m_views[v].bActive = false;
+		m_views[v].viewProjection = glm::mat4(1.0f);
+		m_views[v].texelSize = 0.0f;
+		m_views[v].regionCenter = glm::vec3(0.0f);
+		m_views[v].regionRadius = 0.0f;
+		m_views[v].lightDirection = glm::vec3(0.0f);
+		m_views[v].bDrawn = false;
+		m_views[v].drawnViewProjection = glm::mat4(1.0f);
+		m_views[v].drawnTexelSize = 0.0f;
+		m_views[v].drawnGeometryVersion = 0;
+	}
+	for (int c = 0; c < CASCADE_COUNT; c++)
+	{
+		m_cascadeSplits[c] = 0.0f;
+	}
+	m_directionalLight = -1;
+	m_spotLight = -1;
+	m_viewForward = glm::vec3(0.0f, 0.0f, -1.0f);
+	m_geometryVersion = 0;
+	m_depthTextureID = 0;
+	m_framebufferID = 0;
+	m_programID = 0;
+	m_viewProjectionLocation = -1;
+	m_packedVerticesLocation = -1;
+	m_packedCenterLocation = -1;
+	m_packedExtentsLocation = -1;
+	m_blockBufferID = 0;
+	memset(&m_uploadedBlock, 0, sizeof(m_uploadedBlock));
+	m_bBlockUploaded = false;
+	m_savedFramebuffer = 0;
+	m_savedViewport[0] = m_savedViewport[1] = m_savedViewport[2] = m_savedViewport[3] = 0;
+	m_savedProgram = 0;
+}
+
+/***********************************************************
+ *  ~ShadowManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowManager::~ShadowManager()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the shadow block, and
+ *  unless the shadows are off, the depth texture array of
+ *  the shadow maps, the framebuffer they are drawn through
+ *  and the depth only shader program.  The shadow block is
+ *  created even without shadows, since the scene shaders
+ *  always read it.  It returns false when the shadow maps
+ *  could not be created, which leaves the shadows off.
+ ***********************************************************/
+bool ShadowManager::Initialize(const char* vertexShaderFile, const char* fragmentShaderFile)
+{
+	glGenBuffers(1, &m_blockBufferID);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_blockBufferID);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(SHADOW_BLOCK), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	if (SHADOW_QUALITY_OFF == m_quality)
+	{
+		BindShadowData();
+		return(true);
+	}
+
+	m_mapSize = QUALITY_MAP_SIZES[m_quality];
+	m_filterRadius = QUALITY_FILTER_RADII[m_quality];
+
+	m_programID = ShaderCompiler::BuildProgram(vertexShaderFile, fragmentShaderFile);
+	if (0 == m_programID)
+	{
+		std::cout << "Shadows are disabled" << std::endl;
+		BindShadowData();
+		return(false);
+	}
+	m_viewProjectionLocation = glGetUniformLocation(m_programID, "lightViewProjection");
+	m_packedVerticesLocation = glGetUniformLocation(m_programID, "bUsePackedVertices");
+	m_packedCenterLocation = glGetUniformLocation(m_programID, "packedPositionCenter");
+	m_packedExtentsLocation = glGetUniformLocation(m_programID, "packedPositionExtents");
+
+	// the maps stay bound to their own unit, so creating them
+	// leaves the texture array units of the registry alone
+	glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+	glGenTextures(1, &m_depthTextureID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTextureID);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT32F, m_mapSize, m_mapSize, SHADOW_VIEW_COUNT);
+	// linear filtering of a depth comparison blends the results
+	// of four texels, on top of the filter radius
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glActiveTexture(GL_TEXTURE0);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &m_framebufferID);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTextureID, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)previousFramebuffer);
+
+	if (GL_FRAMEBUFFER_COMPLETE != status)
+	{
+		std::cout << "Shadow map framebuffer is incomplete, shadows are disabled" << std::endl;
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+		BindShadowData();
+		return(false);
+	}
+
+	BindShadowData();
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the shadow maps, their
+ *  framebuffer, the shader program and the shadow block.
+ ***********************************************************/
+void ShadowManager::Destroy()
+{
+	if (0 != m_framebufferID)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		m_framebufferID = 0;
+	}
+	if (0 != m_depthTextureID)
+	{
+		glDeleteTextures(1, &m_depthTextureID);
+		m_depthTextureID = 0;
+	}
+	if (0 != m_programID)
+	{
+		glDeleteProgram(m_programID);
+		m_programID = 0;
+	}
+	if (0 != m_blockBufferID)
+	{
+		glDeleteBuffers(1, &m_blockBufferID);
+		m_blockBufferID = 0;
+	}
+	m_bBlockUploaded = false;
+}
+
+/***********************************************************
+ *  ConnectProgram()
+ *
+ *  This method is used for connecting the shadow block and
+ *  the shadow map sampler of a scene shader program.  The
+ *  sampler is set even when the shadows are off, so that it
+ *  never shares a unit with a sampler of another type.  The
+ *  program must be in use for its uniforms to be set.
+ ***********************************************************/
+void ShadowManager::ConnectProgram(GLuint programID)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(programID, "ShadowBlock");
+	if (GL_INVALID_INDEX != blockIndex)
+	{
+		glUniformBlockBinding(programID, blockIndex, SHADOW_BLOCK_BINDING);
+	}
+
+	GLint location = glGetUniformLocation(programID, "shadowMaps");
+	if (location >= 0)
+	{
+		glUniform1i(location, SHADOW_TEXTURE_UNIT);
+	}
+}
+
+/***********************************************************
+ *  UpdateViews()
+ *
+ *  This method is used for picking the first directional
+ *  light and the first spotlight of the scene as the
+ *  shadowed lights, and fitting their views to the camera.
+ *  The passed in geometry version changes whenever a render
+ *  item moves, which makes every map out of date.
+ ***********************************************************/
+void ShadowManager::UpdateViews(
+	const LightManager& lights,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	unsigned int geometryVersion)
+{
+	m_directionalLight = -1;
+	m_spotLight = -1;
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	for (int i = 0; i < lights.GetLightCount(); i++)
+	{
+		const LightManager::LIGHT_SOURCE& light = lights.GetLightSource(i);
+		if (glm::dot(light.direction, light.direction) > 0.0f)
+		{
+			if (m_directionalLight < 0)
+			{
+				m_directionalLight = i;
+			}
+		}
+		else if (glm::dot(light.spotDirection, light.spotDirection) > 0.0f)
+		{
+			if (m_spotLight < 0)
+			{
+				m_spotLight = i;
+			}
+		}
+	}
+
+	m_geometryVersion = geometryVersion;
+	m_viewForward = glm::normalize(-glm::vec3(glm::inverse(view)[2]));
+
+	if (m_directionalLight >= 0)
+	{
+		UpdateCascades(lights.GetLightSource(m_directionalLight), view, projection);
+	}
+	else
+	{
+		for (int c = 0; c < CASCADE_COUNT; c++)
+		{
+			m_views[c].bActive = false;
+			m_views[c].regionRadius = 0.0f;
+		}
+	}
+
+	if (m_spotLight >= 0)
+	{
+		UpdateSpotView(lights.GetLightSource(m_spotLight));
+	}
+	else
+	{
+		m_views[SPOT_SHADOW_VIEW].bActive = false;
+	}
+}
+
+/***********************************************************
+ *  UpdateCascades()
+ *
+ *  This method is used for splitting the view in front of
+ *  the camera into the cascades and fitting an orthographic
+ *  light view around each part.  A cascade keeps its region
+ *  while its part of the view stays inside of it, and a new
+ *  region is snapped to whole map texels so that the edges
+ *  of the shadows do not crawl as the camera moves.
+ ***********************************************************/
+void ShadowManager::UpdateCascades(const LightManager::LIGHT_SOURCE& light, const glm::mat4& view, const glm::mat4& projection)
+{
+	// the near and far planes of the camera, a perspective
+	// projection has a non-zero w row in its depth column
+	float nearDepth = 0.0f;
+	float farDepth = 0.0f;
+	if (0.0f != projection[2][3])
+	{
+		nearDepth = projection[3][2] / (projection[2][2] - 1.0f);
+		farDepth = projection[3][2] / (projection[2][2] + 1.0f);
+	}
+	else
+	{
+		nearDepth = (projection[3][2] + 1.0f) / projection[2][2];
+		farDepth = (projection[3][2] - 1.0f) / projection[2][2];
+	}
+	if (farDepth <= nearDepth)
+	{
+		return;
+	}
+	float shadowDepth = glm::min(farDepth, nearDepth + SHADOW_DISTANCE);
+	float logNear = glm::max(nearDepth, 0.01f);
+
+	// corners of the view volume on the near and far planes
+	glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+	const float cornerX[4] = { -1.0f, 1.0f, 1.0f, -1.0f };
+	const float cornerY[4] = { -1.0f, -1.0f, 1.0f, 1.0f };
+	glm::vec3 nearCorners[4];
+	glm::vec3 farCorners[4];
+	for (int k = 0; k < 4; k++)
+	{
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(cornerX[k], cornerY[k], -1.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(cornerX[k], cornerY[k], 1.0f, 1.0f);
+		nearCorners[k] = glm::vec3(nearPoint) / nearPoint.w;
+		farCorners[k] = glm::vec3(farPoint) / farPoint.w;
+	}
+
+	glm::vec3 lightDirection = glm::normalize(light.direction);
+	glm::vec3 up = (fabs(lightDirection.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+
+	float sliceStart = nearDepth;
+	for (int c = 0; c < CASCADE_COUNT; c++)
+	{
+		float fraction = (float)(c + 1) / CASCADE_COUNT;
+		float uniformSplit = nearDepth + (shadowDepth - nearDepth) * fraction;
+		float logSplit = logNear * powf(shadowDepth / logNear, fraction);
+		float sliceEnd = CASCADE_SPLIT_LAMBDA * logSplit + (1.0f - CASCADE_SPLIT_LAMBDA) * uniformSplit;
+		m_cascadeSplits[c] = sliceEnd;
+
+		// the corners of the part of the view move linearly
+		// in depth along the edges of the view volume
+		float startFraction = (sliceStart - nearDepth) / (farDepth - nearDepth);
+		float endFraction = (sliceEnd - nearDepth) / (farDepth - nearDepth);
+		glm::vec3 sliceCorners[8];
+		glm::vec3 sliceCenter(0.0f);
+		for (int k = 0; k < 4; k++)
+		{
+			sliceCorners[k] = glm::mix(nearCorners[k], farCorners[k], startFraction);
+			sliceCorners[k + 4] = glm::mix(nearCorners[k], farCorners[k], endFraction);
+			sliceCenter += sliceCorners[k] + sliceCorners[k + 4];
+		}
+		sliceCenter /= 8.0f;
+		float sliceRadius = 0.0f;
+		for (int k = 0; k < 8; k++)
+		{
+			sliceRadius = glm::max(sliceRadius, glm::length(sliceCorners[k] - sliceCenter));
+		}
+		sliceStart = sliceEnd;
+
+		// keep the region while it holds the part of the view
+		// and is not much larger than it needs to be
+		SHADOW_VIEW& cascade = m_views[c];
+		bool bContained = (cascade.regionRadius > 0.0f) &&
+			(cascade.lightDirection == lightDirection) &&
+			(glm::length(sliceCenter - cascade.regionCenter) + sliceRadius <= cascade.regionRadius - cascade.texelSize) &&
+			(sliceRadius * CASCADE_MARGIN * 2.0f >= cascade.regionRadius);
+		cascade.bActive = true;
+		if (bContained)
+		{
+			continue;
+		}
+
+		// round the radius so the texel size only changes when
+		// the part of the view grows or shrinks noticeably
+		float radius = ceilf(sliceRadius * CASCADE_MARGIN * 4.0f) / 4.0f;
+		float texelSize = 2.0f * radius / m_mapSize;
+		glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(sliceCenter, 1.0f));
+		lightCenter.x = floorf(lightCenter.x / texelSize) * texelSize;
+		lightCenter.y = floorf(lightCenter.y / texelSize) * texelSize;
+
+		// the light looks down its negative z axis, the near
+		// plane is pushed toward the light for outside casters
+		glm::mat4 lightProjection = glm::ortho(
+			lightCenter.x - radius, lightCenter.x + radius,
+			lightCenter.y - radius, lightCenter.y + radius,
+			-lightCenter.z - radius - CASTER_DISTANCE, -lightCenter.z + radius);
+
+		cascade.viewProjection = lightProjection * lightView;
+		cascade.texelSize = texelSize;
+		cascade.regionCenter = sliceCenter;
+		cascade.regionRadius = radius;
+		cascade.lightDirection = lightDirection;
+	}
+}
+
+/***********************************************************
+ *  UpdateSpotView()
+ *
+ *  This method is used for fitting a perspective view to the
+ *  cone of the spotlight.  The edge of the map is where the
+ *  spot falloff has faded the light out, and the view only
+ *  changes when the spotlight itself does.
+ ***********************************************************/
+void ShadowManager::UpdateSpotView(const LightManager::LIGHT_SOURCE& light)
+{
+	glm::vec3 spotDirection = glm::normalize(light.spotDirection);
+	glm::vec3 up = (fabs(spotDirection.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	glm::mat4 lightView = glm::lookAt(light.position, light.position + spotDirection, up);
+
+	float focalStrength = glm::max(light.focalStrength, 1.0f);
+	float fieldOfView = 2.0f * acosf(powf(SPOT_EDGE_FALLOFF, 1.0f / focalStrength));
+	fieldOfView = glm::clamp(fieldOfView, glm::radians(SPOT_MIN_DEGREES), glm::radians(SPOT_MAX_DEGREES));
+	float farPlane = (light.range > 0.0f) ? light.range : SHADOW_DISTANCE;
+
+	SHADOW_VIEW& spot = m_views[SPOT_SHADOW_VIEW];
+	spot.bActive = true;
+	spot.viewProjection = glm::perspective(fieldOfView, 1.0f, SPOT_NEAR_PLANE, farPlane) * lightView;
+	// a texel covers this much of the world per unit of distance
+	spot.texelSize = 2.0f * tanf(0.5f * fieldOfView) / m_mapSize;
+}
+
+/***********************************************************
+ *  IsViewDirty()
+ *
+ *  This method is used for checking if the map of a shadow
+ *  view must be drawn again, because it was never drawn, its
+ *  light view moved or the scene geometry changed.
+ ***********************************************************/
+bool ShadowManager::IsViewDirty(int viewIndex) const
+{
+	const SHADOW_VIEW& shadowView = m_views[viewIndex];
+	if (!shadowView.bActive)
+	{
+		return(false);
+	}
+
+	return(!shadowView.bDrawn ||
+		(shadowView.drawnGeometryVersion != m_geometryVersion) ||
+		(shadowView.drawnViewProjection != shadowView.viewProjection));
+}
+
+/***********************************************************
+ *  BeginShadowPass()
+ *
+ *  This method is used for saving the drawing state of the
+ *  main pass and setting up the depth only drawing of the
+ *  shadow maps, with the vertex layout of the mesh arena.
+ ***********************************************************/
+void ShadowManager::BeginShadowPass(bool bPackedVertices, const glm::vec3& packedCenter, const glm::vec3& packedExtents)
+{
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, m_savedViewport);
+	glGetIntegerv(GL_CURRENT_PROGRAM, &m_savedProgram);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_mapSize, m_mapSize);
+	glUseProgram(m_programID);
+	glUniform1i(m_packedVerticesLocation, bPackedVertices ? 1 : 0);
+	glUniform3f(m_packedCenterLocation, packedCenter.x, packedCenter.y, packedCenter.z);
+	glUniform3f(m_packedExtentsLocation, packedExtents.x, packedExtents.y, packedExtents.z);
+
+	// slope scaled offset of the stored depths against acne
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+}
+
+/***********************************************************
+ *  BeginView()
+ *
+ *  This method is used for directing the next draws into
+ *  the cleared map of a shadow view, and recording the state
+ *  the map is drawn with.  The cascades clamp the casters
+ *  in front of their near plane onto it.
+ ***********************************************************/
+void ShadowManager::BeginView(int viewIndex)
+{
+	SHADOW_VIEW& shadowView = m_views[viewIndex];
+
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTextureID, 0, viewIndex);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	if (viewIndex < CASCADE_COUNT)
+	{
+		glEnable(GL_DEPTH_CLAMP);
+	}
+	else
+	{
+		glDisable(GL_DEPTH_CLAMP);
+	}
+	glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, &shadowView.viewProjection[0][0]);
+
+	shadowView.bDrawn = true;
+	shadowView.drawnViewProjection = shadowView.viewProjection;
+	shadowView.drawnTexelSize = shadowView.texelSize;
+	shadowView.drawnGeometryVersion = m_geometryVersion;
+}
+
+/***********************************************************
+ *  EndShadowPass()
+ *
+ *  This method is used for restoring the drawing state the
+ *  main pass was in before the shadow maps were drawn.
+ ***********************************************************/
+void ShadowManager::EndShadowPass()
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisable(GL_DEPTH_CLAMP);
+	glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)m_savedFramebuffer);
+	glViewport(m_savedViewport[0], m_savedViewport[1], m_savedViewport[2], m_savedViewport[3]);
+	glUseProgram((GLuint)m_savedProgram);
+}
+
+/***********************************************************
+ *  BindShadowData()
+ *
+ *  This method is used for uploading the shadow block when
+ *  it differs from the last upload, and binding it along
+ *  with the shadow maps.  The block holds the light views
+ *  the maps were drawn with, and a light is only shadowed
+ *  once all of its maps have been drawn.
+ ***********************************************************/
+void ShadowManager::BindShadowData()
+{
+	SHADOW_BLOCK block;
+	memset(&block, 0, sizeof(block));
+	block.shadowLights = glm::ivec4(-1, -1, m_filterRadius, CASCADE_COUNT);
+
+	if (IsEnabled())
+	{
+		bool bCascadesDrawn = (m_directionalLight >= 0);
+		for (int v = 0; v < SHADOW_VIEW_COUNT; v++)
+		{
+			block.shadowMatrices[v] = m_views[v].drawnViewProjection;
+			if ((v < CASCADE_COUNT) && !(m_views[v].bActive && m_views[v].bDrawn))
+			{
+				bCascadesDrawn = false;
+			}
+		}
+		for (int c = 0; c < CASCADE_COUNT; c++)
+		{
+			block.cascadeSplits[c] = m_cascadeSplits[c];
+			block.texelSizes[c] = m_views[c].drawnTexelSize;
+		}
+		block.texelSizes[SPOT_SHADOW_VIEW] = m_views[SPOT_SHADOW_VIEW].drawnTexelSize;
+
+		if (bCascadesDrawn)
+		{
+			block.shadowLights.x = m_directionalLight;
+		}
+		if ((m_spotLight >= 0) && m_views[SPOT_SHADOW_VIEW].bActive && m_views[SPOT_SHADOW_VIEW].bDrawn)
+		{
+			block.shadowLights.y = m_spotLight;
+		}
+		block.shadowParams = glm::vec4(DEPTH_BIAS, NORMAL_OFFSET_TEXELS, 1.0f / m_mapSize, 0.0f);
+		block.viewForward = glm::vec4(m_viewForward, 0.0f);
+	}
+
+	if (!m_bBlockUploaded || (memcmp(&block, &m_uploadedBlock, sizeof(block)) != 0))
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_blockBufferID);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		m_uploadedBlock = block;
+		m_bBlockUploaded = true;
+	}
+
+	glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_BLOCK_BINDING, m_blockBufferID);
+	if (0 != m_depthTextureID)
+	{
+		glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTextureID);
+		glActiveTexture(GL_TEXTURE0);
+	}
+}
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowmanager.h
+// ============
+// render and cache the shadow maps of the scene lights
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "LightManager.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadowManager
+ *
+ *  This class contains the shadow maps of the first
+ *  directional light, split into cascades over the distance
+ *  in front of the camera, and of the first spotlight.  All
+ *  of the maps are layers of one depth texture array.  Each
+ *  cascade covers a padded region around its part of the
+ *  view, so it is only fitted again when that part leaves the
+ *  region, and a map is only drawn again when its light view
+ *  or the scene geometry has changed since it was drawn.
+ ***********************************************************/
+class ShadowManager
+{
+public:
+	// constructor
+	ShadowManager();
+	// destructor
+	~ShadowManager();
+
+	// cascades of the directional light, followed by the view
+	// of the spotlight - must match the fragment shader
+	static const int CASCADE_COUNT = 3;
+	static const int SPOT_SHADOW_VIEW = CASCADE_COUNT;
+	static const int SHADOW_VIEW_COUNT = CASCADE_COUNT + 1;
+
+	// map resolution and filtering of the shadows
+	enum SHADOW_QUALITY
+	{
+		SHADOW_QUALITY_OFF = 0,
+		SHADOW_QUALITY_LOW,
+		SHADOW_QUALITY_MEDIUM,
+		SHADOW_QUALITY_HIGH
+	};
+
+	// set the quality of the shadows, before Initialize()
+	void SetQuality(SHADOW_QUALITY quality) { m_quality = quality; }
+	SHADOW_QUALITY GetQuality() const { return(m_quality); }
+	// create the shadow maps and the depth only shader program
+	bool Initialize(const char* vertexShaderFile, const char* fragmentShaderFile);
+	// free the shadow maps and the shader program
+	void Destroy();
+	// connect the shadow block and sampler of a scene program
+	void ConnectProgram(GLuint programID);
+	// check if the shadow maps were created
+	bool IsEnabled() const { return(0 != m_framebufferID); }
+
+	// pick the shadowed lights and fit their views to the camera
+	void UpdateViews(
+		const LightManager& lights,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		unsigned int geometryVersion);
+	// check if a shadow view has a light and needs to be drawn
+	bool IsViewActive(int viewIndex) const { return(m_views[viewIndex].bActive); }
+	bool IsViewDirty(int viewIndex) const;
+	// get the light view and projection of a shadow view
+	const glm::mat4& GetViewProjection(int viewIndex) const { return(m_views[viewIndex].viewProjection); }
+
+	// set up the depth only drawing of the shadow maps
+	void BeginShadowPass(bool bPackedVertices, const glm::vec3& packedCenter, const glm::vec3& packedExtents);
+	// direct the next draws into the map of a shadow view
+	void BeginView(int viewIndex);
+	// restore the drawing state of the main pass
+	void EndShadowPass();
+	// upload the shadow block and bind it with the shadow maps
+	void BindShadowData();
+
+private:
+	// std140 packing of the shadow block
+	struct SHADOW_BLOCK
+	{
+		glm::mat4 shadowMatrices[SHADOW_VIEW_COUNT];
+		// view depth where each cascade ends
+		glm::vec4 cascadeSplits;
+		// world size of a map texel of each cascade, and of the
+		// spotlight map one unit away from the light
+		glm::vec4 texelSizes;
+		// directional light index, spotlight index, filter
+		// radius in texels and cascade count
+		glm::ivec4 shadowLights;
+		// depth bias, normal offset in texels, texel size in the map
+		glm::vec4 shadowParams;
+		// camera forward direction the cascades are picked by
+		glm::vec4 viewForward;
+	};
+
+	// light view of one layer of the shadow maps
+	struct SHADOW_VIEW
+	{
+		bool bActive;
+		glm::mat4 viewProjection;
+		float texelSize;
+		// region of the world a cascade was last fitted to
+		glm::vec3 regionCenter;
+		float regionRadius;
+		glm::vec3 lightDirection;
+		// state the map was last drawn with
+		bool bDrawn;
+		glm::mat4 drawnViewProjection;
+		float drawnTexelSize;
+		unsigned int drawnGeometryVersion;
+	};
+
+	SHADOW_QUALITY m_quality;
+	int m_mapSize;
+	int m_filterRadius;
+	SHADOW_VIEW m_views[SHADOW_VIEW_COUNT];
+	int m_directionalLight;
+	int m_spotLight;
+	float m_cascadeSplits[CASCADE_COUNT];
+	glm::vec3 m_viewForward;
+	unsigned int m_geometryVersion;
+
+	// depth texture array with a layer per view, the framebuffer
+	// its layers are drawn through and the depth only program
+	GLuint m_depthTextureID;
+	GLuint m_framebufferID;
+	GLuint m_programID;
+	GLint m_viewProjectionLocation;
+	GLint m_packedVerticesLocation;
+	GLint m_packedCenterLocation;
+	GLint m_packedExtentsLocation;
+	// uniform buffer of the shadow block and its last upload
+	GLuint m_blockBufferID;
+	SHADOW_BLOCK m_uploadedBlock;
+	bool m_bBlockUploaded;
+
+	// drawing state saved by BeginShadowPass()
+	GLint m_savedFramebuffer;
+	GLint m_savedViewport[4];
+	GLint m_savedProgram;
+
+	// fit the cascades of the directional light to the camera
+	void UpdateCascades(const LightManager::LIGHT_SOURCE& light, const glm::mat4& view, const glm::mat4& projection);
+	// fit the perspective view of the spotlight
+	void UpdateSpotView(const LightManager::LIGHT_SOURCE& light);
+};
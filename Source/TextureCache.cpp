@@ -0,0 +1,521 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.cpp
+// ============
+// read and write block compressed textures and the on-disk texture cache
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureCache.h"
+#include "FileUtilities.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// declaration of global variables
+namespace
+{
+	const char* DEFAULT_CACHE_DIRECTORY = "texture_cache";
+
+	// DDS file layout
+	const uint32_t DDS_MAGIC = 0x20534444;	// "DDS "
+	const size_t DDS_HEADER_SIZE = 124;
+	const size_t DDS_DX10_HEADER_SIZE = 20;
+	const uint32_t DDS_FOURCC_DXT1 = 0x31545844;
+	const uint32_t DDS_FOURCC_DXT5 = 0x35545844;
+	const uint32_t DDS_FOURCC_DX10 = 0x30315844;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDSD_REQUIRED = 0x1 | 0x2 | 0x4 | 0x1000;
+	const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDSD_LINEARSIZE = 0x80000;
+	const uint32_t DDSCAPS_COMPLEX = 0x8;
+	const uint32_t DDSCAPS_TEXTURE = 0x1000;
+	const uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+	// DXGI formats of the DX10 DDS header
+	const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+	const uint32_t DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+	const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+	const uint32_t DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+	const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+	const uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+	// KTX2 file layout
+	const unsigned char KTX2_IDENTIFIER[12] =
+	{
+		0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+	};
+	const size_t KTX2_HEADER_SIZE = 80;
+	const size_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+	// Vulkan formats of the KTX2 header
+	const uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131;
+	const uint32_t VK_FORMAT_BC1_RGB_SRGB_BLOCK = 132;
+	const uint32_t VK_FORMAT_BC1_RGBA_UNORM_BLOCK = 133;
+	const uint32_t VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+	const uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137;
+	const uint32_t VK_FORMAT_BC3_SRGB_BLOCK = 138;
+	const uint32_t VK_FORMAT_BC7_UNORM_BLOCK = 145;
+	const uint32_t VK_FORMAT_BC7_SRGB_BLOCK = 146;
+
+	// read little endian values from file bytes
+	uint32_t ReadUint32(const std::vector<unsigned char>& bytes, size_t offset)
+	{
+		uint32_t value = 0;
+		memcpy(&value, &bytes[offset], sizeof(value));
+		return(value);
+	}
+
+	uint64_t ReadUint64(const std::vector<unsigned char>& bytes, size_t offset)
+	{
+		uint64_t value = 0;
+		memcpy(&value, &bytes[offset], sizeof(value));
+		return(value);
+	}
+
+	// append a little endian value to file bytes
+	void WriteUint32(std::vector<unsigned char>& bytes, uint32_t value)
+	{
+		unsigned char packed[4];
+		memcpy(packed, &value, sizeof(value));
+		bytes.insert(bytes.end(), packed, packed + 4);
+	}
+}
+
+/***********************************************************
+ *  TextureCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureCache::TextureCache()
+{
+	m_cacheDirectory = DEFAULT_CACHE_DIRECTORY;
+}
+
+/***********************************************************
+ *  ~TextureCache()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureCache::~TextureCache()
+{
+}
+
+/***********************************************************
+ *  SetCacheDirectory()
+ *
+ *  This method is used for setting the directory that the
+ *  compressed forms of the source images are kept in.
+ ***********************************************************/
+void TextureCache::SetCacheDirectory(const std::string& directory)
+{
+	m_cacheDirectory = directory;
+}
+
+/***********************************************************
+ *  GetCachePath()
+ *
+ *  This method is used for getting the path of the cached
+ *  DDS file that belongs to the passed in source hash.
+ ***********************************************************/
+std::string TextureCache::GetCachePath(uint64_t sourceHash) const
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "%016llx.dds", (unsigned long long)sourceHash);
+
+	return(m_cacheDirectory + "/" + name);
+}
+
+/***********************************************************
+ *  CreateCacheDirectory()
+ *
+ *  This method is used for creating the cache directory.  It
+ *  is not an error when the directory already exists.
+ ***********************************************************/
+bool TextureCache::CreateCacheDirectory() const
+{
+	return(FileUtilities::CreateDirectoryPath(m_cacheDirectory));
+}
+
+/***********************************************************
+ *  ReadFileBytes()
+ *
+ *  This method is used for reading a whole file into memory.
+ ***********************************************************/
+bool TextureCache::ReadFileBytes(const std::string& filename, std::vector<unsigned char>& bytes)
+{
+	std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+
+	bytes.clear();
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	std::streamoff size = file.tellg();
+	if (size <= 0)
+	{
+		return(false);
+	}
+
+	bytes.resize((size_t)size);
+	file.seekg(0, std::ios::beg);
+	file.read((char*)&bytes[0], size);
+
+	return(file.good());
+}
+
+/***********************************************************
+ *  GetBlockSize()
+ *
+ *  This method is used for getting the number of bytes in a
+ *  4x4 pixel block of the passed in compressed format.
+ ***********************************************************/
+int TextureCache::GetBlockSize(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+		return(8);
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+		return(16);
+	default:
+		return(0);
+	}
+}
+
+/***********************************************************
+ *  BuildMipLevels()
+ *
+ *  This method is used for filling in the size and offset of
+ *  each mip level of compressed data that is stored from the
+ *  largest level down with no padding.
+ ***********************************************************/
+bool TextureCache::BuildMipLevels(COMPRESSED_IMAGE& image, int levelCount, size_t availableBytes)
+{
+	int blockSize = GetBlockSize(image.internalFormat);
+	int width = image.width;
+	int height = image.height;
+	size_t offset = 0;
+
+	image.levels.clear();
+	for (int level = 0; level < levelCount; level++)
+	{
+		MIP_LEVEL mip;
+		mip.offset = offset;
+		mip.size = (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+		mip.width = width;
+		mip.height = height;
+		if (offset + mip.size > availableBytes)
+		{
+			return(false);
+		}
+		image.levels.push_back(mip);
+
+		offset += mip.size;
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsCompressedContainer()
+ *
+ *  This method is used for checking if the passed in file
+ *  bytes are a DDS or KTX2 file instead of a source image.
+ ***********************************************************/
+bool TextureCache::IsCompressedContainer(const std::vector<unsigned char>& bytes)
+{
+	if ((bytes.size() >= 4) && (ReadUint32(bytes, 0) == DDS_MAGIC))
+	{
+		return(true);
+	}
+
+	return((bytes.size() >= sizeof(KTX2_IDENTIFIER)) &&
+		(0 == memcmp(&bytes[0], KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER))));
+}
+
+/***********************************************************
+ *  ParseContainer()
+ *
+ *  This method is used for parsing a DDS or KTX2 file held
+ *  in memory into a compressed image with its mip chain.
+ ***********************************************************/
+bool TextureCache::ParseContainer(const std::vector<unsigned char>& bytes, COMPRESSED_IMAGE& image)
+{
+	if ((bytes.size() >= 4) && (ReadUint32(bytes, 0) == DDS_MAGIC))
+	{
+		return(ParseDDS(bytes, image));
+	}
+
+	return(ParseKTX2(bytes, image));
+}
+
+/***********************************************************
+ *  ParseDDS()
+ *
+ *  This method is used for parsing a DDS file with DXT1 or
+ *  DXT5 data, or BC1, BC3 or BC7 data behind a DX10 header.
+ ***********************************************************/
+bool TextureCache::ParseDDS(const std::vector<unsigned char>& bytes, COMPRESSED_IMAGE& image)
+{
+	size_t dataOffset = 4 + DDS_HEADER_SIZE;
+
+	if (bytes.size() < dataOffset)
+	{
+		return(false);
+	}
+
+	// the header fields follow the magic number
+	image.height = (int)ReadUint32(bytes, 4 + 8);
+	image.width = (int)ReadUint32(bytes, 4 + 12);
+	int levelCount = (int)ReadUint32(bytes, 4 + 24);
+	uint32_t pixelFormatFlags = ReadUint32(bytes, 4 + 76);
+	uint32_t fourCC = ReadUint32(bytes, 4 + 80);
+
+	if ((pixelFormatFlags & DDPF_FOURCC) == 0)
+	{
+		return(false);
+	}
+
+	if (fourCC == DDS_FOURCC_DXT1)
+	{
+		image.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	}
+	else if (fourCC == DDS_FOURCC_DXT5)
+	{
+		image.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	}
+	else if (fourCC == DDS_FOURCC_DX10)
+	{
+		if (bytes.size() < dataOffset + DDS_DX10_HEADER_SIZE)
+		{
+			return(false);
+		}
+
+		switch (ReadUint32(bytes, dataOffset))
+		{
+		case DXGI_FORMAT_BC1_UNORM:
+			image.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			break;
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+			image.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			break;
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+			break;
+		case DXGI_FORMAT_BC7_UNORM:
+			image.internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+			break;
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+			break;
+		default:
+			return(false);
+		}
+		dataOffset += DDS_DX10_HEADER_SIZE;
+	}
+	else
+	{
+		return(false);
+	}
+
+	if ((image.width <= 0) || (image.height <= 0))
+	{
+		return(false);
+	}
+	if (levelCount < 1)
+	{
+		levelCount = 1;
+	}
+
+	image.data.assign(bytes.begin() + dataOffset, bytes.end());
+
+	return(BuildMipLevels(image, levelCount, image.data.size()));
+}
+
+/***********************************************************
+ *  ParseKTX2()
+ *
+ *  This method is used for parsing a KTX2 file with BC1, BC3
+ *  or BC7 data and no supercompression.  The levels are
+ *  copied from the level index into tightly packed data.
+ ***********************************************************/
+bool TextureCache::ParseKTX2(const std::vector<unsigned char>& bytes, COMPRESSED_IMAGE& image)
+{
+	if (bytes.size() < KTX2_HEADER_SIZE)
+	{
+		return(false);
+	}
+
+	uint32_t vkFormat = ReadUint32(bytes, 12);
+	image.width = (int)ReadUint32(bytes, 20);
+	image.height = (int)ReadUint32(bytes, 24);
+	uint32_t layerCount = ReadUint32(bytes, 32);
+	uint32_t faceCount = ReadUint32(bytes, 36);
+	int levelCount = (int)ReadUint32(bytes, 40);
+	uint32_t supercompression = ReadUint32(bytes, 44);
+
+	// only single 2D images stored as plain blocks are supported
+	if ((supercompression != 0) || (layerCount > 1) || (faceCount != 1))
+	{
+		return(false);
+	}
+
+	switch (vkFormat)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		image.internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		break;
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		image.internalFormat = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+		break;
+	case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		image.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		break;
+	case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+		break;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+		image.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		break;
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+		image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+		break;
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+		image.internalFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+		break;
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		image.internalFormat = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+		break;
+	default:
+		return(false);
+	}
+
+	if ((image.width <= 0) || (image.height <= 0))
+	{
+		return(false);
+	}
+	if (levelCount < 1)
+	{
+		levelCount = 1;
+	}
+	if (bytes.size() < KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_SIZE)
+	{
+		return(false);
+	}
+
+	// size the packed data from the mip chain, then copy each level
+	if (!BuildMipLevels(image, levelCount, (size_t)-1))
+	{
+		return(false);
+	}
+	const MIP_LEVEL& lastLevel = image.levels.back();
+	image.data.resize(lastLevel.offset + lastLevel.size);
+
+	for (int level = 0; level < levelCount; level++)
+	{
+		size_t indexOffset = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+		uint64_t byteOffset = ReadUint64(bytes, indexOffset);
+		uint64_t byteLength = ReadUint64(bytes, indexOffset + 8);
+		const MIP_LEVEL& mip = image.levels[level];
+
+		if ((byteLength != mip.size) || (byteOffset + byteLength > bytes.size()))
+		{
+			return(false);
+		}
+		memcpy(&image.data[mip.offset], &bytes[(size_t)byteOffset], mip.size);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteDDS()
+ *
+ *  This method is used for writing a compressed image with
+ *  its mip chain as a DDS file.  BC1 and BC3 use the classic
+ *  DXT1 and DXT5 header, and BC7 uses the DX10 header.
+ ***********************************************************/
+bool TextureCache::WriteDDS(const std::string& filename, const COMPRESSED_IMAGE& image)
+{
+	std::vector<unsigned char> bytes;
+	uint32_t fourCC = 0;
+	uint32_t dxgiFormat = 0;
+
+	switch (image.internalFormat)
+	{
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		fourCC = DDS_FOURCC_DXT1;
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		fourCC = DDS_FOURCC_DXT5;
+		break;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		fourCC = DDS_FOURCC_DX10;
+		dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+		break;
+	default:
+		return(false);
+	}
+
+	if (image.levels.empty())
+	{
+		return(false);
+	}
+
+	WriteUint32(bytes, DDS_MAGIC);
+	WriteUint32(bytes, (uint32_t)DDS_HEADER_SIZE);
+	WriteUint32(bytes, DDSD_REQUIRED | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE);
+	WriteUint32(bytes, (uint32_t)image.height);
+	WriteUint32(bytes, (uint32_t)image.width);
+	WriteUint32(bytes, (uint32_t)image.levels[0].size);
+	WriteUint32(bytes, 0);
+	WriteUint32(bytes, (uint32_t)image.levels.size());
+	for (int i = 0; i < 11; i++)
+	{
+		WriteUint32(bytes, 0);
+	}
+	// pixel format
+	WriteUint32(bytes, 32);
+	WriteUint32(bytes, DDPF_FOURCC);
+	WriteUint32(bytes, fourCC);
+	for (int i = 0; i < 5; i++)
+	{
+		WriteUint32(bytes, 0);
+	}
+	// surface capabilities
+	WriteUint32(bytes, DDSCAPS_TEXTURE | DDSCAPS_COMPLEX | DDSCAPS_MIPMAP);
+	for (int i = 0; i < 4; i++)
+	{
+		WriteUint32(bytes, 0);
+	}
+
+	if (fourCC == DDS_FOURCC_DX10)
+	{
+		// a 2D texture with a single array layer
+		WriteUint32(bytes, dxgiFormat);
+		WriteUint32(bytes, 3);
+		WriteUint32(bytes, 0);
+		WriteUint32(bytes, 1);
+		WriteUint32(bytes, 0);
+	}
+
+	bytes.insert(bytes.end(), image.data.begin(), image.data.end());
+
+	return(FileUtilities::WriteFileAtomic(filename, &bytes[0], bytes.size()));
+}
@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturecache.h
+// ============
+// read and write block compressed textures and the on-disk texture cache
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureCache
+ *
+ *  This class contains the reading of BC1, BC3 and BC7 block
+ *  compressed textures with their mip chains from DDS and
+ *  KTX2 files.  It also manages a directory of DDS files
+ *  holding the compressed form of source images, where each
+ *  file is named by a hash of the source image bytes.
+ ***********************************************************/
+class TextureCache
+{
+public:
+	// constructor
+	TextureCache();
+	// destructor
+	~TextureCache();
+
+	// one mip level inside of the compressed data
+	struct MIP_LEVEL
+	{
+		size_t offset;
+		size_t size;
+		int width;
+		int height;
+	};
+
+	// a block compressed texture with its whole mip chain
+	struct COMPRESSED_IMAGE
+	{
+		GLenum internalFormat;
+		int width;
+		int height;
+		std::vector<MIP_LEVEL> levels;
+		std::vector<unsigned char> data;
+	};
+
+	// set the directory the cached textures are kept in
+	void SetCacheDirectory(const std::string& directory);
+	// get the cache file path for a source image hash
+	std::string GetCachePath(uint64_t sourceHash) const;
+	// create the cache directory if it does not exist
+	bool CreateCacheDirectory() const;
+
+	// read a whole file into memory
+	static bool ReadFileBytes(const std::string& filename, std::vector<unsigned char>& bytes);
+	// check if file bytes start with a DDS or KTX2 identifier
+	static bool IsCompressedContainer(const std::vector<unsigned char>& bytes);
+	// parse a DDS or KTX2 file held in memory
+	static bool ParseContainer(const std::vector<unsigned char>& bytes, COMPRESSED_IMAGE& image);
+	// write a compressed image as a DDS file
+	static bool WriteDDS(const std::string& filename, const COMPRESSED_IMAGE& image);
+	// get the size of one 4x4 block of a compressed format
+	static int GetBlockSize(GLenum internalFormat);
+
+private:
+	// directory the cached textures are kept in
+	std::string m_cacheDirectory;
+
+	// parse the two supported containers
+	static bool ParseDDS(const std::vector<unsigned char>& bytes, COMPRESSED_IMAGE& image);
+	static bool ParseKTX2(const std::vector<unsigned char>& bytes, COMPRESSED_IMAGE& image);
+	// fill in the mip levels of tightly packed compressed data
+	static bool BuildMipLevels(COMPRESSED_IMAGE& image, int levelCount, size_t availableBytes);
+};
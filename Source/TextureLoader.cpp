@@ -0,0 +1,652 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and stream them to the GPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "FileUtilities.h"
+
+#include "stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+// declaration of global variables
+namespace
+{
+	// size of each staging slot, larger images are uploaded
+	// directly from the decoded memory
+	const GLsizeiptr STAGING_SLOT_SIZE = 16 * 1024 * 1024;
+
+	// color of a texture whose image is not uploaded yet
+	const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureLoader::TextureLoader()
+{
+	m_bStopWorkers = false;
+	m_pendingCount = 0;
+	m_stagingBufferID = 0;
+	m_pStagingMemory = NULL;
+	for (int i = 0; i < STAGING_SLOT_COUNT; i++)
+	{
+		m_stagingSlots[i].offset = i * STAGING_SLOT_SIZE;
+		m_stagingSlots[i].fence = 0;
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	Shutdown();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for starting the decode worker
+ *  threads.  One core is left for the rendering thread when
+ *  the thread count is not passed in.
+ ***********************************************************/
+void TextureLoader::Initialize(int workerCount)
+{
+	if (!m_workers.empty())
+	{
+		return;
+	}
+
+	if (workerCount <= 0)
+	{
+		workerCount = (int)std::thread::hardware_concurrency() - 1;
+		if (workerCount < 1)
+		{
+			workerCount = 1;
+		}
+	}
+
+	// indicate to always flip images vertically when loaded - this
+	// is a global setting, so it is set before any worker starts
+	stbi_set_flip_vertically_on_load(true);
+	m_textureCache.CreateCacheDirectory();
+
+	m_bStopWorkers = false;
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerMain, this));
+	}
+}
+
+/***********************************************************
+ *  Shutdown()
+ *
+ *  This method is used for stopping the worker threads and
+ *  freeing the decoded images that were never uploaded.
+ ***********************************************************/
+void TextureLoader::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_bStopWorkers = true;
+		m_decodeJobs.clear();
+	}
+	m_queueCondition.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	for (size_t i = 0; i < m_decodedImages.size(); i++)
+	{
+		stbi_image_free(m_decodedImages[i].pixels);
+	}
+	m_decodedImages.clear();
+
+	for (int i = 0; i < STAGING_SLOT_COUNT; i++)
+	{
+		if (0 != m_stagingSlots[i].fence)
+		{
+			glDeleteSync(m_stagingSlots[i].fence);
+			m_stagingSlots[i].fence = 0;
+		}
+	}
+	if (0 != m_stagingBufferID)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBufferID);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &m_stagingBufferID);
+		m_stagingBufferID = 0;
+		m_pStagingMemory = NULL;
+	}
+}
+
+/***********************************************************
+ *  RequestTexture()
+ *
+ *  This method is used for creating the texture object of an
+ *  image file with a placeholder pixel and queueing the file
+ *  to be decoded by a worker thread.  Skipped mip levels are
+ *  only left out of block compressed images, which includes
+ *  every cached source image after its first load.
+ ***********************************************************/
+GLuint TextureLoader::RequestTexture(const std::string& filename, int skipLevels)
+{
+	GLuint textureID = 0;
+
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	m_textureStates[textureID] = TEXTURE_PENDING;
+	m_pendingCount++;
+
+	DECODE_JOB job;
+	job.textureID = textureID;
+	job.filename = filename;
+	job.skipLevels = skipLevels;
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_decodeJobs.push_back(job);
+	}
+	m_queueCondition.notify_one();
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is used by each worker thread for decoding
+ *  the queued image files until the loader is shut down.
+ ***********************************************************/
+void TextureLoader::WorkerMain()
+{
+	for (;;)
+	{
+		DECODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueCondition.wait(lock, [this]()
+			{
+				return(m_bStopWorkers || !m_decodeJobs.empty());
+			});
+			if (m_bStopWorkers)
+			{
+				return;
+			}
+			job = m_decodeJobs.front();
+			m_decodeJobs.pop_front();
+		}
+
+		DECODED_IMAGE image;
+		DecodeImage(job, image);
+
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_decodedImages.push_back(std::move(image));
+	}
+}
+
+/***********************************************************
+ *  DecodeImage()
+ *
+ *  This method is used by the worker threads for turning an
+ *  image file into data that is ready to upload.  Container
+ *  files are parsed as they are, and source images are first
+ *  looked up in the texture cache by the hash of their bytes
+ *  before they are decoded.
+ ***********************************************************/
+void TextureLoader::DecodeImage(const DECODE_JOB& job, DECODED_IMAGE& image) const
+{
+	std::vector<unsigned char> bytes;
+
+	image.textureID = job.textureID;
+	image.filename = job.filename;
+	image.pixels = NULL;
+	image.width = 0;
+	image.height = 0;
+	image.channels = 0;
+	image.bCompressed = false;
+	image.skipLevels = job.skipLevels;
+
+	if (!TextureCache::ReadFileBytes(job.filename, bytes))
+	{
+		return;
+	}
+
+	if (TextureCache::IsCompressedContainer(bytes))
+	{
+		image.bCompressed = TextureCache::ParseContainer(bytes, image.compressed);
+		return;
+	}
+
+	// the cache file is named by the hash of the source bytes,
+	// so an edited image gets a new cache file
+	std::string cachePath = m_textureCache.GetCachePath(FileUtilities::HashBytes(bytes.data(), bytes.size()));
+	std::vector<unsigned char> cachedBytes;
+	if (TextureCache::ReadFileBytes(cachePath, cachedBytes) &&
+		TextureCache::ParseContainer(cachedBytes, image.compressed))
+	{
+		image.bCompressed = true;
+		return;
+	}
+
+	// try to parse the image data from the specified image file
+	image.pixels = stbi_load_from_memory(
+		&bytes[0],
+		(int)bytes.size(),
+		&image.width,
+		&image.height,
+		&image.channels,
+		0);
+	image.cachePath = cachePath;
+}
+
+/***********************************************************
+ *  CreateStagingBuffer()
+ *
+ *  This method is used for creating the pixel buffer that
+ *  stays mapped for the lifetime of the loader.
+ ***********************************************************/
+void TextureLoader::CreateStagingBuffer()
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_stagingBufferID);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBufferID);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, STAGING_SLOT_SIZE * STAGING_SLOT_COUNT, NULL, flags);
+	m_pStagingMemory = (unsigned char*)glMapBufferRange(
+		GL_PIXEL_UNPACK_BUFFER, 0, STAGING_SLOT_SIZE * STAGING_SLOT_COUNT, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+/***********************************************************
+ *  FindFreeStagingSlot()
+ *
+ *  This method is used for finding a staging slot that the
+ *  GPU has finished reading from, without waiting on it.
+ ***********************************************************/
+int TextureLoader::FindFreeStagingSlot()
+{
+	for (int i = 0; i < STAGING_SLOT_COUNT; i++)
+	{
+		STAGING_SLOT& slot = m_stagingSlots[i];
+		if (0 == slot.fence)
+		{
+			return(i);
+		}
+
+		GLenum result = glClientWaitSync(slot.fence, 0, 0);
+		if ((result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED))
+		{
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  StageUploadData()
+ *
+ *  This method is used for copying upload data into a free
+ *  staging slot and binding the staging buffer, so that the
+ *  returned pixels pointer is an offset into the buffer.
+ *  Data that does not fit in a slot is left where it is.  It
+ *  returns the slot, -1 when unstaged, or -2 when all of the
+ *  slots are busy.
+ ***********************************************************/
+int TextureLoader::StageUploadData(const void* data, GLsizeiptr size, const void*& pixels)
+{
+	pixels = data;
+
+	if ((size > STAGING_SLOT_SIZE) || (NULL == m_pStagingMemory))
+	{
+		return(-1);
+	}
+
+	int slotIndex = FindFreeStagingSlot();
+	if (slotIndex < 0)
+	{
+		return(-2);
+	}
+
+	memcpy(m_pStagingMemory + m_stagingSlots[slotIndex].offset, data, size);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_stagingBufferID);
+	pixels = (const void*)m_stagingSlots[slotIndex].offset;
+
+	return(slotIndex);
+}
+
+/***********************************************************
+ *  UploadImage()
+ *
+ *  This method is used for replacing the placeholder of a
+ *  texture with its decoded image.  Images that fit in a
+ *  staging slot are copied through the pixel buffer so the
+ *  driver can transfer them without stalling the thread.
+ *  Source images are compressed by the driver and written
+ *  to the texture cache for the next launch.
+ ***********************************************************/
+int TextureLoader::UploadImage(const DECODED_IMAGE& image)
+{
+	GLenum format = 0;
+	GLint internalFormat = 0;
+
+	if (image.bCompressed)
+	{
+		return(UploadCompressedImage(image));
+	}
+
+	// if the loaded image is in RGB format
+	if (image.channels == 3)
+	{
+		format = GL_RGB;
+		internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	}
+	// if the loaded image is in RGBA format - it supports transparency
+	else if (image.channels == 4)
+	{
+		format = GL_RGBA;
+		internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	}
+	else
+	{
+		std::cout << "Not implemented to handle image with " << image.channels << " channels" << std::endl;
+		return(UPLOAD_FAILED);
+	}
+
+	GLsizeiptr imageSize = (GLsizeiptr)image.width * image.height * image.channels;
+	const void* pixels = NULL;
+	int slotIndex = StageUploadData(image.pixels, imageSize, pixels);
+	if (slotIndex == -2)
+	{
+		return(UPLOAD_RETRY);
+	}
+
+	// decoded rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, image.textureID);
+	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, pixels);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (slotIndex >= 0)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_stagingSlots[slotIndex].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	std::cout << "Successfully loaded image:" << image.filename << ", width:" << image.width << ", height:" << image.height << ", channels:" << image.channels << std::endl;
+
+	if (!image.cachePath.empty() && !WriteCacheFile(image.textureID, image.cachePath))
+	{
+		std::cout << "Could not write texture cache file:" << image.cachePath << std::endl;
+	}
+
+	return(UPLOAD_DONE);
+}
+
+/***********************************************************
+ *  UploadCompressedImage()
+ *
+ *  This method is used for uploading every mip level of a
+ *  block compressed image, so no mipmaps are generated.  The
+ *  skipped levels are left out, so the next level becomes
+ *  the base level of the texture.
+ ***********************************************************/
+int TextureLoader::UploadCompressedImage(const DECODED_IMAGE& image)
+{
+	const TextureCache::COMPRESSED_IMAGE& compressed = image.compressed;
+	const void* data = NULL;
+	// at least the smallest level is always uploaded
+	size_t firstLevel = (image.skipLevels > 0) ? (size_t)image.skipLevels : 0;
+	if (firstLevel >= compressed.levels.size())
+	{
+		firstLevel = compressed.levels.size() - 1;
+	}
+
+	int slotIndex = StageUploadData(&compressed.data[0], (GLsizeiptr)compressed.data.size(), data);
+	if (slotIndex == -2)
+	{
+		return(UPLOAD_RETRY);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, image.textureID);
+	for (size_t level = firstLevel; level < compressed.levels.size(); level++)
+	{
+		const TextureCache::MIP_LEVEL& mip = compressed.levels[level];
+		glCompressedTexImage2D(
+			GL_TEXTURE_2D,
+			(GLint)(level - firstLevel),
+			compressed.internalFormat,
+			mip.width,
+			mip.height,
+			0,
+			(GLsizei)mip.size,
+			(const unsigned char*)data + mip.offset);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)(compressed.levels.size() - firstLevel) - 1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (slotIndex >= 0)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_stagingSlots[slotIndex].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	std::cout << "Successfully loaded compressed image:" << image.filename << ", width:" << compressed.levels[firstLevel].width << ", height:" << compressed.levels[firstLevel].height << ", levels:" << (compressed.levels.size() - firstLevel) << std::endl;
+
+	return(UPLOAD_DONE);
+}
+
+/***********************************************************
+ *  WriteCacheFile()
+ *
+ *  This method is used for reading back every mip level of
+ *  a texture the driver has compressed and writing them to
+ *  the passed in cache file.  It only runs on the first load
+ *  of a source image.
+ ***********************************************************/
+bool TextureLoader::WriteCacheFile(GLuint textureID, const std::string& cachePath)
+{
+	TextureCache::COMPRESSED_IMAGE compressed;
+	GLint bCompressed = 0;
+	GLint internalFormat = 0;
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &bCompressed);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &compressed.width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &compressed.height);
+	compressed.internalFormat = (GLenum)internalFormat;
+
+	if ((bCompressed == GL_FALSE) || (TextureCache::GetBlockSize(compressed.internalFormat) == 0))
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return(false);
+	}
+
+	// the generated mip chain runs down to a 1x1 level
+	int width = compressed.width;
+	int height = compressed.height;
+	for (GLint level = 0; ; level++)
+	{
+		GLint levelSize = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelSize);
+
+		TextureCache::MIP_LEVEL mip;
+		mip.offset = compressed.data.size();
+		mip.size = (size_t)levelSize;
+		mip.width = width;
+		mip.height = height;
+		compressed.levels.push_back(mip);
+
+		compressed.data.resize(mip.offset + mip.size);
+		glGetCompressedTexImage(GL_TEXTURE_2D, level, &compressed.data[mip.offset]);
+
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return(TextureCache::WriteDDS(cachePath, compressed));
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the images the workers
+ *  have decoded so far and publishing their textures as
+ *  ready.  Uploads stop for the frame when every staging slot
+ *  is still in use.  It returns the number of uploads.
+ ***********************************************************/
+int TextureLoader::Update()
+{
+	int uploadCount = 0;
+
+	if (m_pendingCount == 0)
+	{
+		return(0);
+	}
+
+	if (0 == m_stagingBufferID)
+	{
+		CreateStagingBuffer();
+	}
+
+	for (;;)
+	{
+		DECODED_IMAGE image;
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			if (m_decodedImages.empty())
+			{
+				break;
+			}
+			image = std::move(m_decodedImages.front());
+			m_decodedImages.pop_front();
+		}
+
+		int state = TEXTURE_FAILED;
+		if ((NULL == image.pixels) && (image.bCompressed == false))
+		{
+			std::cout << "Could not load image:" << image.filename << std::endl;
+		}
+		else
+		{
+			int result = UploadImage(image);
+			if (result == UPLOAD_RETRY)
+			{
+				// every staging slot is busy, retry next frame
+				std::lock_guard<std::mutex> lock(m_queueMutex);
+				m_decodedImages.push_front(std::move(image));
+				break;
+			}
+			if (result == UPLOAD_DONE)
+			{
+				state = TEXTURE_READY;
+				uploadCount++;
+			}
+		}
+
+		stbi_image_free(image.pixels);
+		m_textureStates[image.textureID] = state;
+		m_pendingCount--;
+	}
+
+	return(uploadCount);
+}
+
+/***********************************************************
+ *  WaitForAll()
+ *
+ *  This method is used for blocking until every requested
+ *  texture has been decoded and uploaded.
+ ***********************************************************/
+void TextureLoader::WaitForAll()
+{
+	while (m_pendingCount > 0)
+	{
+		if (Update() == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+/***********************************************************
+ *  IsTextureReady()
+ *
+ *  This method is used for checking if the image of the
+ *  passed in texture has replaced its placeholder.
+ ***********************************************************/
+bool TextureLoader::IsTextureReady(GLuint textureID) const
+{
+	std::unordered_map<GLuint, int>::const_iterator found = m_textureStates.find(textureID);
+
+	return((found != m_textureStates.end()) && (found->second == TEXTURE_READY));
+}
+
+/***********************************************************
+ *  IsTexturePending()
+ *
+ *  This method is used for checking if the passed in texture
+ *  is still waiting for its image to be decoded or uploaded.
+ ***********************************************************/
+bool TextureLoader::IsTexturePending(GLuint textureID) const
+{
+	std::unordered_map<GLuint, int>::const_iterator found = m_textureStates.find(textureID);
+
+	return((found != m_textureStates.end()) && (found->second == TEXTURE_PENDING));
+}
+
+/***********************************************************
+ *  ReleaseTexture()
+ *
+ *  This method is used for dropping the state of a finished
+ *  texture before its owner deletes it, so the state does not
+ *  carry over to a new texture given the same name.
+ ***********************************************************/
+void TextureLoader::ReleaseTexture(GLuint textureID)
+{
+	std::unordered_map<GLuint, int>::iterator found = m_textureStates.find(textureID);
+
+	if ((found != m_textureStates.end()) && (found->second != TEXTURE_PENDING))
+	{
+		m_textureStates.erase(found);
+	}
+}
@@ -0,0 +1,160 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and stream them to the GPU
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureCache.h"
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class contains a pool of worker threads that decode
+ *  texture image files in parallel.  Every requested texture
+ *  gets its OpenGL texture object right away, holding a
+ *  placeholder pixel, so it can be bound to a slot before
+ *  its image is ready.  The decoded images are copied into a
+ *  persistent-mapped pixel buffer and uploaded from there on
+ *  the thread that owns the OpenGL context.
+ *
+ *  DDS and KTX2 files are uploaded with their own compressed
+ *  mip chains.  Other images are compressed to BC1 or BC3 by
+ *  the driver on their first load and the result is written
+ *  to the texture cache, so later loads skip both the image
+ *  decode and the mipmap generation.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor
+	TextureLoader();
+	// destructor
+	~TextureLoader();
+
+	// start the decode worker threads, 0 picks the thread count
+	void Initialize(int workerCount = 0);
+	// stop the worker threads and free the staging buffer
+	void Shutdown();
+
+	// queue the decode of an image file and return its texture,
+	// skipping the passed in number of its largest mip levels
+	GLuint RequestTexture(const std::string& filename, int skipLevels = 0);
+	// upload the decoded images, called on the OpenGL thread
+	int Update();
+	// block until every requested texture is uploaded
+	void WaitForAll();
+
+	// check if the image of a requested texture is uploaded
+	bool IsTextureReady(GLuint textureID) const;
+	// check if a requested texture is still being loaded
+	bool IsTexturePending(GLuint textureID) const;
+	// forget the state of a texture that is about to be deleted
+	void ReleaseTexture(GLuint textureID);
+	// get the number of requested textures not yet uploaded
+	int GetPendingCount() const { return(m_pendingCount); }
+
+private:
+	// an image file waiting to be decoded
+	struct DECODE_JOB
+	{
+		GLuint textureID;
+		std::string filename;
+		int skipLevels;
+	};
+
+	// pixels decoded by a worker, waiting to be uploaded
+	struct DECODED_IMAGE
+	{
+		GLuint textureID;
+		std::string filename;
+		unsigned char* pixels;
+		int width;
+		int height;
+		int channels;
+		// block compressed data read from a container or the cache
+		bool bCompressed;
+		TextureCache::COMPRESSED_IMAGE compressed;
+		// cache file to write after the upload, empty for none
+		std::string cachePath;
+		// largest compressed mip levels left out of the upload
+		int skipLevels;
+	};
+
+	// part of the staging buffer with the fence of its last upload
+	struct STAGING_SLOT
+	{
+		GLintptr offset;
+		GLsync fence;
+	};
+
+	// identifiers for the state of a requested texture
+	enum TEXTURE_STATE
+	{
+		TEXTURE_PENDING = 0,
+		TEXTURE_READY,
+		TEXTURE_FAILED
+	};
+
+	// results of trying to upload a decoded image
+	enum UPLOAD_RESULT
+	{
+		UPLOAD_DONE = 0,
+		UPLOAD_FAILED,
+		UPLOAD_RETRY
+	};
+
+	enum
+	{
+		STAGING_SLOT_COUNT = 4
+	};
+
+	// on-disk cache of the compressed source images
+	TextureCache m_textureCache;
+
+	// decode worker threads and the queues they share
+	std::vector<std::thread> m_workers;
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueCondition;
+	std::deque<DECODE_JOB> m_decodeJobs;
+	std::deque<DECODED_IMAGE> m_decodedImages;
+	bool m_bStopWorkers;
+
+	// state of every requested texture, only used on the OpenGL thread
+	std::unordered_map<GLuint, int> m_textureStates;
+	int m_pendingCount;
+
+	// persistent-mapped pixel buffer the uploads are staged in
+	GLuint m_stagingBufferID;
+	unsigned char* m_pStagingMemory;
+	STAGING_SLOT m_stagingSlots[STAGING_SLOT_COUNT];
+
+	// decode the queued image files until stopped
+	void WorkerMain();
+	// find a staging slot whose last upload has completed
+	int FindFreeStagingSlot();
+	// decode or read the compressed data of an image file
+	void DecodeImage(const DECODE_JOB& job, DECODED_IMAGE& image) const;
+	// copy upload data into a free staging slot
+	int StageUploadData(const void* data, GLsizeiptr size, const void*& pixels);
+	// upload a decoded image into its texture object
+	int UploadImage(const DECODED_IMAGE& image);
+	int UploadCompressedImage(const DECODED_IMAGE& image);
+	// read back a driver compressed texture into the cache
+	bool WriteCacheFile(GLuint textureID, const std::string& cachePath);
+	// create the staging buffer on first use
+	void CreateStagingBuffer();
+};
@@ -0,0 +1,570 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureregistry.cpp
+// ============
+// select any number of scene textures by index from the shaders
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureRegistry.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// shader storage binding point of the texture entries
+	const GLuint TEXTURE_BLOCK_BINDING = 4;
+	// number of texture arrays the shaders can sample, must
+	// match MAX_TEXTURE_ARRAYS in the fragment shader
+	const int MAX_TEXTURE_ARRAYS = 8;
+	// layers an array is created with before it has to grow
+	const int INITIAL_ARRAY_LAYERS = 4;
+
+	// color of a texture whose image is not published yet
+	const unsigned char PLACEHOLDER_PIXEL[4] = { 128, 128, 128, 255 };
+
+	// layout of one entry in the texture block, the bindless
+	// handle or the array and layer, followed by the first and
+	// last array levels the image of the layer filled
+	struct GPU_TEXTURE_ENTRY
+	{
+		GLuint values[4];
+	};
+
+	// set the repeat wrapping and filtering of the scene textures
+	void SetTextureSampling(GLenum target)
+	{
+		glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	// get the number of levels of a full mip chain
+	int GetMipChainLength(int width, int height)
+	{
+		int levels = 1;
+		for (int size = (width > height) ? width : height; size > 1; size /= 2)
+		{
+			levels++;
+		}
+		return(levels);
+	}
+
+	// get the size of a mip level
+	int GetLevelSize(int size, int level)
+	{
+		size >>= level;
+		return((size > 0) ? size : 1);
+	}
+}
+
+/***********************************************************
+ *  TextureRegistry()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureRegistry::TextureRegistry()
+{
+	m_mode = MODE_TEXTURE_ARRAYS;
+	m_entryBufferID = 0;
+	m_bEntriesDirty = false;
+	m_placeholderTextureID = 0;
+	m_placeholderHandle = 0;
+}
+
+/***********************************************************
+ *  ~TextureRegistry()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureRegistry::~TextureRegistry()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for picking between the bindless and
+ *  texture array modes, creating the placeholder and the
+ *  entry buffer, and connecting the texture block and the
+ *  array samplers of the passed in shader program, which
+ *  must be in use.
+ ***********************************************************/
+void TextureRegistry::Initialize(GLuint programID)
+{
+	m_mode = GLEW_ARB_bindless_texture ? MODE_BINDLESS : MODE_TEXTURE_ARRAYS;
+
+	glGenBuffers(1, &m_entryBufferID);
+
+	if (m_mode == MODE_BINDLESS)
+	{
+		glGenTextures(1, &m_placeholderTextureID);
+		glBindTexture(GL_TEXTURE_2D, m_placeholderTextureID);
+		SetTextureSampling(GL_TEXTURE_2D);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		m_placeholderHandle = glGetTextureHandleARB(m_placeholderTextureID);
+		glMakeTextureHandleResidentARB(m_placeholderHandle);
+	}
+	else
+	{
+		// the first array holds only the placeholder
+		int baseLevel = 0;
+		int placeholderArray = FindTextureArray(GL_RGBA8, 1, 1, baseLevel);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[placeholderArray].arrayID);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		m_arrays[placeholderArray].layerCount = 1;
+	}
+
+	ConnectProgram(programID);
+	m_bEntriesDirty = true;
+}
+
+/***********************************************************
+ *  ConnectProgram()
+ *
+ *  This method is used for connecting the texture block and
+ *  the array samplers of the passed in shader program, after
+ *  the program is first linked or replaced.  The program
+ *  must be in use for its uniforms to be set.
+ ***********************************************************/
+void TextureRegistry::ConnectProgram(GLuint programID)
+{
+	GLuint blockIndex = glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, "TextureBlock");
+	if (GL_INVALID_INDEX != blockIndex)
+	{
+		glShaderStorageBlockBinding(programID, blockIndex, TEXTURE_BLOCK_BINDING);
+	}
+
+	GLint location = glGetUniformLocation(programID, "bUseBindlessTextures");
+	if (location >= 0)
+	{
+		glUniform1i(location, (m_mode == MODE_BINDLESS) ? 1 : 0);
+	}
+
+	if (m_mode == MODE_TEXTURE_ARRAYS)
+	{
+		// each array sampler reads from the texture unit of its index
+		GLint units[MAX_TEXTURE_ARRAYS];
+		for (int i = 0; i < MAX_TEXTURE_ARRAYS; i++)
+		{
+			units[i] = i;
+		}
+		location = glGetUniformLocation(programID, "textureArrays");
+		if (location >= 0)
+		{
+			glUniform1iv(location, MAX_TEXTURE_ARRAYS, units);
+		}
+	}
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for registering a texture and
+ *  returning its index.  The entry shows the placeholder
+ *  until the texture is published.
+ ***********************************************************/
+int TextureRegistry::AddTexture(GLuint textureID)
+{
+	TEXTURE_ENTRY entry;
+
+	entry.textureID = textureID;
+	entry.bPublished = false;
+	entry.handle = m_placeholderHandle;
+	entry.arrayIndex = 0;
+	entry.layer = 0;
+	entry.baseLevel = 0;
+	entry.lastLevel = 0;
+	m_entries.push_back(entry);
+	m_bEntriesDirty = true;
+
+	return((int)m_entries.size() - 1);
+}
+
+/***********************************************************
+ *  PublishTexture()
+ *
+ *  This method is used for pointing the entry of a texture
+ *  at its uploaded image.  In the bindless mode the texture
+ *  handle is made resident, which freezes the texture, so
+ *  this must only be called once its image is final.
+ ***********************************************************/
+void TextureRegistry::PublishTexture(int textureIndex)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_entries.size()))
+	{
+		return;
+	}
+
+	TEXTURE_ENTRY& entry = m_entries[textureIndex];
+	if (entry.bPublished || (0 == entry.textureID))
+	{
+		return;
+	}
+
+	if (m_mode == MODE_BINDLESS)
+	{
+		entry.handle = glGetTextureHandleARB(entry.textureID);
+		glMakeTextureHandleResidentARB(entry.handle);
+	}
+	else if (!CopyIntoArray(entry))
+	{
+		return;
+	}
+
+	entry.bPublished = true;
+	m_bEntriesDirty = true;
+}
+
+/***********************************************************
+ *  ReplaceTexture()
+ *
+ *  This method is used for releasing the published image of
+ *  an entry, deleting its texture and registering the passed
+ *  in texture in its place.  The entry keeps its index and
+ *  shows the placeholder until the new texture is published.
+ ***********************************************************/
+void TextureRegistry::ReplaceTexture(int textureIndex, GLuint textureID)
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_entries.size()))
+	{
+		return;
+	}
+
+	TEXTURE_ENTRY& entry = m_entries[textureIndex];
+	if (entry.textureID == textureID)
+	{
+		return;
+	}
+
+	if (entry.bPublished)
+	{
+		if (m_mode == MODE_BINDLESS)
+		{
+			glMakeTextureHandleNonResidentARB(entry.handle);
+		}
+		else
+		{
+			m_arrays[entry.arrayIndex].freeLayers.push_back(entry.layer);
+		}
+	}
+	if (0 != entry.textureID)
+	{
+		glDeleteTextures(1, &entry.textureID);
+	}
+
+	entry.textureID = textureID;
+	entry.bPublished = false;
+	entry.handle = m_placeholderHandle;
+	entry.arrayIndex = 0;
+	entry.layer = 0;
+	entry.baseLevel = 0;
+	entry.lastLevel = 0;
+	m_bEntriesDirty = true;
+}
+
+/***********************************************************
+ *  FindTextureArray()
+ *
+ *  This method is used for finding the texture array that
+ *  fits an image of the passed in size and format, and the
+ *  array level the image starts at.  An array of the same
+ *  size is used first, then a larger array whose lower level
+ *  has the image size, such as the array a demoted image was
+ *  in at full size, and otherwise an array is created.  It
+ *  returns -1 when none fits and all of the shader array
+ *  samplers are used.
+ ***********************************************************/
+int TextureRegistry::FindTextureArray(GLenum internalFormat, int width, int height, int& baseLevel)
+{
+	int fittingArray = -1;
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		const TEXTURE_ARRAY& textureArray = m_arrays[i];
+		if (textureArray.internalFormat != internalFormat)
+		{
+			continue;
+		}
+		for (int level = 0; level < textureArray.levels; level++)
+		{
+			if ((GetLevelSize(textureArray.width, level) == width) &&
+				(GetLevelSize(textureArray.height, level) == height))
+			{
+				if (0 == level)
+				{
+					baseLevel = 0;
+					return((int)i);
+				}
+				if (fittingArray < 0)
+				{
+					fittingArray = (int)i;
+					baseLevel = level;
+				}
+				break;
+			}
+		}
+	}
+
+	// sharing a larger array saves a sampler, and a demoted image
+	// takes the layer its full size image gave up, so it costs
+	// no memory either
+	if ((fittingArray >= 0) || ((int)m_arrays.size() >= MAX_TEXTURE_ARRAYS))
+	{
+		return(fittingArray);
+	}
+
+	baseLevel = 0;
+
+	TEXTURE_ARRAY textureArray;
+	textureArray.internalFormat = internalFormat;
+	textureArray.width = width;
+	textureArray.height = height;
+	textureArray.levels = GetMipChainLength(width, height);
+	textureArray.layerCount = 0;
+	textureArray.layerCapacity = INITIAL_ARRAY_LAYERS;
+	textureArray.arrayID = CreateArrayStorage(textureArray, textureArray.layerCapacity);
+	m_arrays.push_back(textureArray);
+
+	return((int)m_arrays.size() - 1);
+}
+
+/***********************************************************
+ *  CreateArrayStorage()
+ *
+ *  This method is used for creating the immutable storage
+ *  of a texture array with the passed in number of layers.
+ ***********************************************************/
+GLuint TextureRegistry::CreateArrayStorage(const TEXTURE_ARRAY& textureArray, int layerCapacity)
+{
+	GLuint arrayID = 0;
+
+	glGenTextures(1, &arrayID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, arrayID);
+	glTexStorage3D(
+		GL_TEXTURE_2D_ARRAY,
+		textureArray.levels,
+		textureArray.internalFormat,
+		textureArray.width,
+		textureArray.height,
+		layerCapacity);
+	SetTextureSampling(GL_TEXTURE_2D_ARRAY);
+	// the shaders read the base level of each layer by its level
+	// of detail, which needs a mipmap minification filter
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	return(arrayID);
+}
+
+/***********************************************************
+ *  CopyIntoArray()
+ *
+ *  This method is used for copying every mip level of a
+ *  published texture into a new layer of the array fitting
+ *  its size and format, from the array level the image
+ *  starts at.  The levels the image filled are kept with the
+ *  entry for the shaders.  Layers freed by replaced textures
+ *  are reused, otherwise a full array is replaced by one with
+ *  twice the layers and its existing layers are copied over.
+ ***********************************************************/
+bool TextureRegistry::CopyIntoArray(TEXTURE_ENTRY& entry)
+{
+	GLint width = 0;
+	GLint height = 0;
+	GLint internalFormat = 0;
+	GLint maxLevel = 0;
+
+	glBindTexture(GL_TEXTURE_2D, entry.textureID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	int baseLevel = 0;
+	int arrayIndex = FindTextureArray((GLenum)internalFormat, width, height, baseLevel);
+	if (arrayIndex < 0)
+	{
+		std::cout << "Texture registry has no free texture array for texture:" << entry.textureID <<
+			", every array sampler holds another image size or format" << std::endl;
+		return(false);
+	}
+
+	TEXTURE_ARRAY& textureArray = m_arrays[arrayIndex];
+
+	// the full mip chain, limited by the last uploaded level and
+	// by the levels left in the array below the base level
+	int levels = GetMipChainLength(width, height);
+	if (levels > maxLevel + 1)
+	{
+		levels = maxLevel + 1;
+	}
+	if (levels > textureArray.levels - baseLevel)
+	{
+		levels = textureArray.levels - baseLevel;
+	}
+
+	int layer = textureArray.layerCount;
+	if (!textureArray.freeLayers.empty())
+	{
+		layer = textureArray.freeLayers.back();
+		textureArray.freeLayers.pop_back();
+	}
+	else if (textureArray.layerCount == textureArray.layerCapacity)
+	{
+		int layerCapacity = textureArray.layerCapacity * 2;
+		GLuint arrayID = CreateArrayStorage(textureArray, layerCapacity);
+
+		int levelWidth = textureArray.width;
+		int levelHeight = textureArray.height;
+		for (int level = 0; level < textureArray.levels; level++)
+		{
+			glCopyImageSubData(
+				textureArray.arrayID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+				arrayID, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+				levelWidth, levelHeight, textureArray.layerCount);
+			levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+			levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+		}
+
+		glDeleteTextures(1, &textureArray.arrayID);
+		textureArray.arrayID = arrayID;
+		textureArray.layerCapacity = layerCapacity;
+	}
+
+	int levelWidth = width;
+	int levelHeight = height;
+	for (int level = 0; level < levels; level++)
+	{
+		glCopyImageSubData(
+			entry.textureID, GL_TEXTURE_2D, level, 0, 0, 0,
+			textureArray.arrayID, GL_TEXTURE_2D_ARRAY, baseLevel + level, 0, 0, layer,
+			levelWidth, levelHeight, 1);
+		levelWidth = (levelWidth > 1) ? levelWidth / 2 : 1;
+		levelHeight = (levelHeight > 1) ? levelHeight / 2 : 1;
+	}
+
+	entry.arrayIndex = arrayIndex;
+	entry.layer = layer;
+	entry.baseLevel = baseLevel;
+	entry.lastLevel = baseLevel + levels - 1;
+	if (layer == textureArray.layerCount)
+	{
+		textureArray.layerCount++;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for uploading the entries when any
+ *  of them changed and binding the entry buffer, along with
+ *  the texture arrays in the texture array mode.
+ ***********************************************************/
+int TextureRegistry::Bind()
+{
+	int bindCount = 0;
+
+	if (0 == m_entryBufferID)
+	{
+		return(0);
+	}
+
+	if (m_bEntriesDirty && !m_entries.empty())
+	{
+		std::vector<GPU_TEXTURE_ENTRY> gpuEntries(m_entries.size());
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			const TEXTURE_ENTRY& entry = m_entries[i];
+			if (m_mode == MODE_BINDLESS)
+			{
+				gpuEntries[i].values[0] = (GLuint)(entry.handle & 0xFFFFFFFFull);
+				gpuEntries[i].values[1] = (GLuint)(entry.handle >> 32);
+			}
+			else
+			{
+				gpuEntries[i].values[0] = (GLuint)entry.arrayIndex;
+				gpuEntries[i].values[1] = (GLuint)entry.layer;
+			}
+			gpuEntries[i].values[2] = (GLuint)entry.baseLevel;
+			gpuEntries[i].values[3] = (GLuint)entry.lastLevel;
+		}
+
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_entryBufferID);
+		glBufferData(
+			GL_SHADER_STORAGE_BUFFER,
+			gpuEntries.size() * sizeof(GPU_TEXTURE_ENTRY),
+			&gpuEntries[0],
+			GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		m_bEntriesDirty = false;
+	}
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TEXTURE_BLOCK_BINDING, m_entryBufferID);
+	bindCount++;
+
+	if (m_mode == MODE_TEXTURE_ARRAYS)
+	{
+		for (size_t i = 0; i < m_arrays.size(); i++)
+		{
+			glActiveTexture(GL_TEXTURE0 + (GLenum)i);
+			glBindTexture(GL_TEXTURE_2D_ARRAY, m_arrays[i].arrayID);
+			bindCount++;
+		}
+		glActiveTexture(GL_TEXTURE0);
+	}
+
+	return(bindCount);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the texture handles,
+ *  deleting the texture arrays and every registered texture
+ *  and freeing the entry buffer.
+ ***********************************************************/
+void TextureRegistry::Destroy()
+{
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		TEXTURE_ENTRY& entry = m_entries[i];
+		if ((m_mode == MODE_BINDLESS) && entry.bPublished)
+		{
+			glMakeTextureHandleNonResidentARB(entry.handle);
+		}
+		if (0 != entry.textureID)
+		{
+			glDeleteTextures(1, &entry.textureID);
+		}
+	}
+	m_entries.clear();
+
+	for (size_t i = 0; i < m_arrays.size(); i++)
+	{
+		glDeleteTextures(1, &m_arrays[i].arrayID);
+	}
+	m_arrays.clear();
+
+	if (0 != m_placeholderTextureID)
+	{
+		glMakeTextureHandleNonResidentARB(m_placeholderHandle);
+		glDeleteTextures(1, &m_placeholderTextureID);
+		m_placeholderTextureID = 0;
+		m_placeholderHandle = 0;
+	}
+
+	if (0 != m_entryBufferID)
+	{
+		glDeleteBuffers(1, &m_entryBufferID);
+		m_entryBufferID = 0;
+	}
+}
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureregistry.h
+// ============
+// select any number of scene textures by index from the shaders
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureRegistry
+ *
+ *  This class contains every texture of the scene with no
+ *  fixed limit.  Each texture has an entry in a shader
+ *  storage buffer that the shaders index, so draws select
+ *  their texture without any rebinding.  When bindless
+ *  textures are supported an entry holds the texture handle,
+ *  otherwise the texture is copied into a layer of a texture
+ *  array shared by the images of the same size and format.
+ *  An array holds the whole mip chain of its size, and each
+ *  layer keeps the range of levels its image filled, so an
+ *  image with a shorter chain or a demoted image half the
+ *  size or smaller shares the array from its base level on.
+ *  Only the distinct sizes and formats of the images take
+ *  one of the array samplers, and an image is left showing
+ *  the placeholder when it fits no array and all of them
+ *  are used.
+ ***********************************************************/
+class TextureRegistry
+{
+public:
+	// constructor
+	TextureRegistry();
+	// destructor
+	~TextureRegistry();
+
+	// identifiers for the ways textures are selected by index
+	enum REGISTRY_MODE
+	{
+		MODE_BINDLESS = 0,
+		MODE_TEXTURE_ARRAYS
+	};
+
+	// pick the registry mode and connect the shader program
+	void Initialize(GLuint programID);
+	// connect a newly linked shader program, which must be in use
+	void ConnectProgram(GLuint programID);
+	// add a texture showing a placeholder until it is published
+	int AddTexture(GLuint textureID);
+	// make the uploaded image of a texture visible to the shaders
+	void PublishTexture(int textureIndex);
+	// delete the texture of an entry and register another in its
+	// place, 0 leaves the entry showing the placeholder
+	void ReplaceTexture(int textureIndex, GLuint textureID);
+	// upload the changed entries and bind the registry, returning
+	// the number of buffer and texture bindings made
+	int Bind();
+	// free the registry and delete all of the registered textures
+	void Destroy();
+
+	// get the registered textures
+	int GetTextureCount() const { return((int)m_entries.size()); }
+	GLuint GetTextureID(int textureIndex) const { return(m_entries[textureIndex].textureID); }
+	bool IsTexturePublished(int textureIndex) const { return(m_entries[textureIndex].bPublished); }
+	int GetMode() const { return(m_mode); }
+
+private:
+	// one registered texture
+	struct TEXTURE_ENTRY
+	{
+		GLuint textureID;
+		bool bPublished;
+		// resident handle of the bindless mode
+		GLuint64 handle;
+		// array and layer of the texture array mode, with the
+		// first and last array levels the image was copied into
+		int arrayIndex;
+		int layer;
+		int baseLevel;
+		int lastLevel;
+	};
+
+	// one texture array of images of one size and format, with
+	// the whole mip chain of that size
+	struct TEXTURE_ARRAY
+	{
+		GLuint arrayID;
+		GLenum internalFormat;
+		int width;
+		int height;
+		int levels;
+		int layerCount;
+		int layerCapacity;
+		// layers freed by replaced textures, reused first
+		std::vector<int> freeLayers;
+	};
+
+	std::vector<TEXTURE_ENTRY> m_entries;
+	std::vector<TEXTURE_ARRAY> m_arrays;
+	int m_mode;
+	// shader storage buffer of the entries read by the shaders
+	GLuint m_entryBufferID;
+	bool m_bEntriesDirty;
+	// texture shown for entries that are not published yet
+	GLuint m_placeholderTextureID;
+	GLuint64 m_placeholderHandle;
+
+	// find or create the array that fits a texture's image and
+	// get the array level the image starts at
+	int FindTextureArray(GLenum internalFormat, int width, int height, int& baseLevel);
+	// create an array with room for the passed in layer count
+	GLuint CreateArrayStorage(const TEXTURE_ARRAY& textureArray, int layerCapacity);
+	// copy a published texture into a new array layer
+	bool CopyIntoArray(TEXTURE_ENTRY& entry);
+};
@@ -0,0 +1,474 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.cpp
+// ============
+// keep the scene textures within a video memory budget
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureResidency.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// video memory the textures may take before any is demoted
+	const size_t DEFAULT_BUDGET_BYTES = 256 * 1024 * 1024;
+	// frames a texture must go undrawn before it can be demoted
+	const unsigned int IDLE_FRAME_COUNT = 120;
+	// most mip levels left out before a texture is evicted
+	const int MAX_MIP_BIAS = 2;
+}
+
+/***********************************************************
+ *  TextureResidency()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureResidency::TextureResidency(TextureLoader* pTextureLoader, TextureRegistry* pTextureRegistry)
+{
+	m_pTextureLoader = pTextureLoader;
+	m_pTextureRegistry = pTextureRegistry;
+	m_budgetBytes = DEFAULT_BUDGET_BYTES;
+	m_frameIndex = 0;
+	m_bBudgetWarningShown = false;
+}
+
+/***********************************************************
+ *  ~TextureResidency()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureResidency::~TextureResidency()
+{
+	Destroy();
+	m_pTextureLoader = NULL;
+	m_pTextureRegistry = NULL;
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for tracking a texture that was just
+ *  registered and requested from the texture loader.  The
+ *  texture is published once its image is uploaded.
+ ***********************************************************/
+void TextureResidency::AddTexture(int textureIndex, GLuint textureID, const std::string& filename)
+{
+	if (textureIndex >= (int)m_entries.size())
+	{
+		m_entries.resize(textureIndex + 1);
+	}
+
+	RESIDENCY_ENTRY& entry = m_entries[textureIndex];
+	entry.filename = filename;
+	entry.state = RESIDENCY_LOADING;
+	entry.mipBias = 0;
+	entry.residentBytes = 0;
+	entry.fullBytes = 0;
+	entry.levelCount = 0;
+	entry.pendingTextureID = textureID;
+	entry.pendingMipBias = 0;
+	entry.lastUsedFrame = m_frameIndex;
+	entry.bFileChanged = false;
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for loading a texture again after its
+ *  image file has changed.  The published texture stays
+ *  visible until the new image is uploaded, and it is
+ *  swapped in by Update() between frames.
+ ***********************************************************/
+void TextureResidency::ReloadTexture(int textureIndex)
+{
+	if ((textureIndex >= 0) && (textureIndex < (int)m_entries.size()))
+	{
+		m_entries[textureIndex].bFileChanged = true;
+	}
+}
+
+/***********************************************************
+ *  MarkTextureUsed()
+ *
+ *  This method is used for recording that the passed in
+ *  texture is drawn in the current frame.
+ ***********************************************************/
+void TextureResidency::MarkTextureUsed(int textureIndex)
+{
+	if ((textureIndex >= 0) && (textureIndex < (int)m_entries.size()))
+	{
+		m_entries[textureIndex].lastUsedFrame = m_frameIndex;
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used once per frame for publishing the
+ *  finished loads, freeing memory when the textures take
+ *  more than the budget and reloading the textures that
+ *  were drawn in the last frame at reduced size.
+ ***********************************************************/
+void TextureResidency::Update()
+{
+	CompleteLoads();
+	ReloadChangedTextures();
+	EnforceBudget();
+	RestoreUsedTextures();
+
+	if (GetResidentBytes() > m_budgetBytes)
+	{
+		if (!m_bBudgetWarningShown)
+		{
+			std::cout << "Drawn textures take more than the texture budget of " << m_budgetBytes << " bytes" << std::endl;
+			m_bBudgetWarningShown = true;
+		}
+	}
+	else
+	{
+		m_bBudgetWarningShown = false;
+	}
+
+	m_frameIndex++;
+}
+
+/***********************************************************
+ *  CompleteLoads()
+ *
+ *  This method is used for replacing the published textures
+ *  with the ones whose loads have finished.  A failed reload
+ *  keeps the texture that is already published.
+ ***********************************************************/
+void TextureResidency::CompleteLoads()
+{
+	for (int i = 0; i < (int)m_entries.size(); i++)
+	{
+		RESIDENCY_ENTRY& entry = m_entries[i];
+		if ((0 == entry.pendingTextureID) ||
+			m_pTextureLoader->IsTexturePending(entry.pendingTextureID))
+		{
+			continue;
+		}
+
+		GLuint textureID = entry.pendingTextureID;
+		entry.pendingTextureID = 0;
+
+		if (!m_pTextureLoader->IsTextureReady(textureID))
+		{
+			if (entry.state == RESIDENCY_LOADING)
+			{
+				// the registry still owns the texture of a first load
+				entry.state = RESIDENCY_FAILED;
+			}
+			else
+			{
+				m_pTextureLoader->ReleaseTexture(textureID);
+				glDeleteTextures(1, &textureID);
+			}
+			continue;
+		}
+
+		GLuint previousID = m_pTextureRegistry->GetTextureID(i);
+		if ((0 != previousID) && (previousID != textureID))
+		{
+			m_pTextureLoader->ReleaseTexture(previousID);
+		}
+		m_pTextureRegistry->ReplaceTexture(i, textureID);
+		m_pTextureRegistry->PublishTexture(i);
+
+		int levelCount = 0;
+		entry.residentBytes = MeasureTextureBytes(textureID, levelCount);
+		entry.mipBias = entry.pendingMipBias;
+		if (0 == entry.mipBias)
+		{
+			entry.fullBytes = entry.residentBytes;
+			entry.levelCount = levelCount;
+		}
+		entry.state = RESIDENCY_RESIDENT;
+	}
+}
+
+/***********************************************************
+ *  ReloadChangedTextures()
+ *
+ *  This method is used for reloading the textures whose
+ *  image files have changed, keeping their mip bias.  A load
+ *  still in flight may have read the old file, so the reload
+ *  waits for it to finish.  An evicted texture reads the new
+ *  file whenever it is restored, and a failed texture gets
+ *  another try at full size.
+ ***********************************************************/
+void TextureResidency::ReloadChangedTextures()
+{
+	for (int i = 0; i < (int)m_entries.size(); i++)
+	{
+		RESIDENCY_ENTRY& entry = m_entries[i];
+		if (!entry.bFileChanged || (0 != entry.pendingTextureID))
+		{
+			continue;
+		}
+
+		entry.bFileChanged = false;
+		if (entry.state == RESIDENCY_RESIDENT)
+		{
+			RequestLoad(i, entry.mipBias);
+		}
+		else if (entry.state == RESIDENCY_FAILED)
+		{
+			RequestLoad(i, 0);
+		}
+	}
+}
+
+/***********************************************************
+ *  EnforceBudget()
+ *
+ *  This method is used for freeing memory while the textures
+ *  take more than the budget.  The least recently used idle
+ *  texture is reloaded with one fewer mip level, or evicted
+ *  when it has no more levels to leave out.  The pending
+ *  load is counted at its reduced size right away, so the
+ *  budget is met as soon as the reloads finish.
+ ***********************************************************/
+void TextureResidency::EnforceBudget()
+{
+	while (GetResidentBytes() > m_budgetBytes)
+	{
+		int leastRecent = -1;
+		for (int i = 0; i < (int)m_entries.size(); i++)
+		{
+			const RESIDENCY_ENTRY& entry = m_entries[i];
+			if ((entry.state != RESIDENCY_RESIDENT) ||
+				(0 != entry.pendingTextureID) ||
+				(entry.lastUsedFrame + IDLE_FRAME_COUNT > m_frameIndex))
+			{
+				continue;
+			}
+			if ((leastRecent < 0) || (entry.lastUsedFrame < m_entries[leastRecent].lastUsedFrame))
+			{
+				leastRecent = i;
+			}
+		}
+
+		if (leastRecent < 0)
+		{
+			// every texture over the budget is in use
+			return;
+		}
+
+		RESIDENCY_ENTRY& entry = m_entries[leastRecent];
+		if ((entry.mipBias < MAX_MIP_BIAS) && (entry.mipBias + 1 < entry.levelCount))
+		{
+			RequestLoad(leastRecent, entry.mipBias + 1);
+		}
+		else
+		{
+			m_pTextureLoader->ReleaseTexture(m_pTextureRegistry->GetTextureID(leastRecent));
+			m_pTextureRegistry->ReplaceTexture(leastRecent, 0);
+			entry.residentBytes = 0;
+			entry.state = RESIDENCY_EVICTED;
+		}
+	}
+}
+
+/***********************************************************
+ *  RestoreUsedTextures()
+ *
+ *  This method is used for reloading the textures that were
+ *  drawn in the last frame but are demoted or evicted.  Each
+ *  texture is reloaded with the smallest mip bias that fits
+ *  in the budget, and an evicted texture is always reloaded
+ *  so that no drawn texture is left showing the placeholder.
+ ***********************************************************/
+void TextureResidency::RestoreUsedTextures()
+{
+	for (int i = 0; i < (int)m_entries.size(); i++)
+	{
+		const RESIDENCY_ENTRY& entry = m_entries[i];
+		if ((0 != entry.pendingTextureID) || (entry.lastUsedFrame != m_frameIndex) ||
+			((entry.state != RESIDENCY_EVICTED) &&
+			((entry.state != RESIDENCY_RESIDENT) || (0 == entry.mipBias))))
+		{
+			continue;
+		}
+
+		size_t otherBytes = GetResidentBytes() - entry.residentBytes;
+		int currentBias = (entry.state == RESIDENCY_EVICTED) ? MAX_MIP_BIAS + 1 : entry.mipBias;
+		int mipBias = 0;
+		while ((mipBias < currentBias) && (otherBytes + EstimateBytes(entry, mipBias) > m_budgetBytes))
+		{
+			mipBias++;
+		}
+
+		if (mipBias < currentBias)
+		{
+			RequestLoad(i, mipBias);
+		}
+		else if (entry.state == RESIDENCY_EVICTED)
+		{
+			RequestLoad(i, MAX_MIP_BIAS);
+		}
+	}
+}
+
+/***********************************************************
+ *  RequestLoad()
+ *
+ *  This method is used for loading a texture again with the
+ *  passed in number of its largest mip levels left out.  The
+ *  published texture stays visible until the load finishes.
+ ***********************************************************/
+void TextureResidency::RequestLoad(int textureIndex, int mipBias)
+{
+	RESIDENCY_ENTRY& entry = m_entries[textureIndex];
+
+	entry.pendingTextureID = m_pTextureLoader->RequestTexture(entry.filename, mipBias);
+	entry.pendingMipBias = mipBias;
+}
+
+/***********************************************************
+ *  GetResidentBytes()
+ *
+ *  This method is used for getting the bytes all of the
+ *  textures take once their pending loads have finished.
+ ***********************************************************/
+size_t TextureResidency::GetResidentBytes() const
+{
+	size_t totalBytes = 0;
+
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		totalBytes += GetExpectedBytes(m_entries[i]);
+	}
+
+	return(totalBytes);
+}
+
+/***********************************************************
+ *  GetMipBias()
+ *
+ *  This method is used for getting the number of mip levels
+ *  left out of the published texture, or -1 when it is not
+ *  in video memory.
+ ***********************************************************/
+int TextureResidency::GetMipBias(int textureIndex) const
+{
+	if ((textureIndex < 0) || (textureIndex >= (int)m_entries.size()) ||
+		(m_entries[textureIndex].state != RESIDENCY_RESIDENT))
+	{
+		return(-1);
+	}
+
+	return(m_entries[textureIndex].mipBias);
+}
+
+/***********************************************************
+ *  GetExpectedBytes()
+ *
+ *  This method is used for getting the bytes a texture takes
+ *  after its pending load, if any, replaces it.
+ ***********************************************************/
+size_t TextureResidency::GetExpectedBytes(const RESIDENCY_ENTRY& entry) const
+{
+	if ((0 != entry.pendingTextureID) && (entry.state != RESIDENCY_LOADING))
+	{
+		return(EstimateBytes(entry, entry.pendingMipBias));
+	}
+
+	return(entry.residentBytes);
+}
+
+/***********************************************************
+ *  EstimateBytes()
+ *
+ *  This method is used for estimating the bytes of a texture
+ *  with the passed in mip bias.  Each left out level divides
+ *  the size of the mip chain by about four.
+ ***********************************************************/
+size_t TextureResidency::EstimateBytes(const RESIDENCY_ENTRY& entry, int mipBias) const
+{
+	size_t bytes = entry.fullBytes;
+
+	for (int i = 0; i < mipBias; i++)
+	{
+		bytes /= 4;
+	}
+
+	return(bytes);
+}
+
+/***********************************************************
+ *  MeasureTextureBytes()
+ *
+ *  This method is used for adding up the bytes of every mip
+ *  level of a texture, using the compressed size of block
+ *  compressed levels and four bytes per texel otherwise.
+ ***********************************************************/
+size_t TextureResidency::MeasureTextureBytes(GLuint textureID, int& levelCount)
+{
+	size_t totalBytes = 0;
+	GLint maxLevel = 0;
+	GLint bCompressed = 0;
+
+	levelCount = 0;
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &bCompressed);
+	for (GLint level = 0; level <= maxLevel; level++)
+	{
+		GLint width = 0;
+		GLint height = 0;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if ((width == 0) || (height == 0))
+		{
+			break;
+		}
+
+		if (bCompressed != GL_FALSE)
+		{
+			GLint levelSize = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &levelSize);
+			totalBytes += (size_t)levelSize;
+		}
+		else
+		{
+			totalBytes += (size_t)width * height * 4;
+		}
+		levelCount++;
+
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	return(totalBytes);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for deleting the textures of reloads
+ *  that never finished.  The published textures belong to
+ *  the texture registry.
+ ***********************************************************/
+void TextureResidency::Destroy()
+{
+	for (size_t i = 0; i < m_entries.size(); i++)
+	{
+		RESIDENCY_ENTRY& entry = m_entries[i];
+		if ((0 != entry.pendingTextureID) && (entry.state != RESIDENCY_LOADING))
+		{
+			m_pTextureLoader->ReleaseTexture(entry.pendingTextureID);
+			glDeleteTextures(1, &entry.pendingTextureID);
+		}
+		entry.pendingTextureID = 0;
+	}
+	m_entries.clear();
+}
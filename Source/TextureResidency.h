@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureresidency.h
+// ============
+// keep the scene textures within a video memory budget
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureLoader.h"
+#include "TextureRegistry.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureResidency
+ *
+ *  This class contains the loading state of every texture in
+ *  the texture registry.  It tracks the bytes each texture
+ *  takes in video memory and the last frame it was drawn in.
+ *  While the textures take more than the budget, the least
+ *  recently used ones are reloaded without their largest mip
+ *  levels and then evicted.  Demoted and evicted textures
+ *  are reloaded at full size as soon as they are drawn again
+ *  and the budget has room for them.
+ ***********************************************************/
+class TextureResidency
+{
+public:
+	// constructor
+	TextureResidency(TextureLoader* pTextureLoader, TextureRegistry* pTextureRegistry);
+	// destructor
+	~TextureResidency();
+
+	// start loading an image file into a registered texture
+	void AddTexture(int textureIndex, GLuint textureID, const std::string& filename);
+	// load a texture again after its image file has changed
+	void ReloadTexture(int textureIndex);
+	// record that a texture is drawn in the current frame
+	void MarkTextureUsed(int textureIndex);
+	// publish the finished loads and enforce the budget
+	void Update();
+	// delete the textures of loads still in flight
+	void Destroy();
+
+	// set the bytes of video memory the textures may take
+	void SetBudget(size_t budgetBytes) { m_budgetBytes = budgetBytes; }
+	size_t GetBudget() const { return(m_budgetBytes); }
+	// get the bytes the textures take after the pending loads
+	size_t GetResidentBytes() const;
+	// get the mip levels left out of a texture, -1 when evicted
+	int GetMipBias(int textureIndex) const;
+
+private:
+	// identifiers for the residency of one texture
+	enum RESIDENCY_STATE
+	{
+		RESIDENCY_LOADING = 0,
+		RESIDENCY_RESIDENT,
+		RESIDENCY_EVICTED,
+		RESIDENCY_FAILED
+	};
+
+	// residency of one registered texture
+	struct RESIDENCY_ENTRY
+	{
+		std::string filename;
+		int state;
+		// largest mip levels left out of the published texture
+		int mipBias;
+		// bytes of the published texture and of the texture at
+		// full size, measured when the textures are published
+		size_t residentBytes;
+		size_t fullBytes;
+		// mip levels of the texture at full size
+		int levelCount;
+		// texture being loaded to replace the published one
+		GLuint pendingTextureID;
+		int pendingMipBias;
+		// last frame the texture was drawn in
+		unsigned int lastUsedFrame;
+		// set when the image file changed after the load began
+		bool bFileChanged;
+	};
+
+	// pointer to the loader that decodes and uploads the images
+	TextureLoader* m_pTextureLoader;
+	// pointer to the registry the shaders select the textures in
+	TextureRegistry* m_pTextureRegistry;
+	std::vector<RESIDENCY_ENTRY> m_entries;
+	size_t m_budgetBytes;
+	unsigned int m_frameIndex;
+	// set when the over budget warning was shown
+	bool m_bBudgetWarningShown;
+
+	// swap in the textures whose loads finished
+	void CompleteLoads();
+	// reload the textures whose image files have changed
+	void ReloadChangedTextures();
+	// demote or evict the least recently used textures
+	void EnforceBudget();
+	// reload the drawn textures that are demoted or evicted
+	void RestoreUsedTextures();
+	// start loading a texture with the passed in mip bias
+	void RequestLoad(int textureIndex, int mipBias);
+	// get the bytes a texture takes once its pending load finishes
+	size_t GetExpectedBytes(const RESIDENCY_ENTRY& entry) const;
+	// estimate the bytes of a texture with the passed in mip bias
+	size_t EstimateBytes(const RESIDENCY_ENTRY& entry, int mipBias) const;
+	// measure the bytes of every mip level of a texture
+	static size_t MeasureTextureBytes(GLuint textureID, int& levelCount);
+};
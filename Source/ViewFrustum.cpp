@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////
+// viewfrustum.cpp
+// ============
+// test bounding volumes against the planes of the camera view
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ViewFrustum.h"
+
+/***********************************************************
+ *  ViewFrustum()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ViewFrustum::ViewFrustum()
+{
+	// an unset frustum keeps everything visible
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		m_planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+/***********************************************************
+ *  ~ViewFrustum()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ViewFrustum::~ViewFrustum()
+{
+}
+
+/***********************************************************
+ *  ExtractPlanes()
+ *
+ *  This method is used for extracting the six planes of the
+ *  view volume from the rows of the passed in projection *
+ *  view matrix.  The planes are normalized so that the sphere
+ *  tests can compare distances against a radius.
+ ***********************************************************/
+void ViewFrustum::ExtractPlanes(const glm::mat4& viewProjection)
+{
+	// glm matrices are column major, so gather the rows
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(
+			viewProjection[0][i],
+			viewProjection[1][i],
+			viewProjection[2][i],
+			viewProjection[3][i]);
+	}
+
+	m_planes[PLANE_LEFT] = rows[3] + rows[0];
+	m_planes[PLANE_RIGHT] = rows[3] - rows[0];
+	m_planes[PLANE_BOTTOM] = rows[3] + rows[1];
+	m_planes[PLANE_TOP] = rows[3] - rows[1];
+	m_planes[PLANE_NEAR] = rows[3] + rows[2];
+	m_planes[PLANE_FAR] = rows[3] - rows[2];
+
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		float length = glm::length(glm::vec3(m_planes[i]));
+		if (length > 0.0f)
+		{
+			m_planes[i] /= length;
+		}
+	}
+}
+
+/***********************************************************
+ *  IsSphereVisible()
+ *
+ *  This method is used for checking if the passed in sphere
+ *  is at least partly inside of the view volume.  The test
+ *  is conservative, so a sphere near a corner may pass.
+ ***********************************************************/
+bool ViewFrustum::IsSphereVisible(const glm::vec3& center, float radius) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		if (glm::dot(glm::vec3(m_planes[i]), center) + m_planes[i].w < -radius)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for checking if the passed in axis
+ *  aligned box is at least partly inside of the view volume
+ *  by testing the corner furthest along each plane normal.
+ ***********************************************************/
+bool ViewFrustum::IsBoxVisible(const glm::vec3& minimum, const glm::vec3& maximum) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		glm::vec3 corner(
+			(m_planes[i].x >= 0.0f) ? maximum.x : minimum.x,
+			(m_planes[i].y >= 0.0f) ? maximum.y : minimum.y,
+			(m_planes[i].z >= 0.0f) ? maximum.z : minimum.z);
+
+		if (glm::dot(glm::vec3(m_planes[i]), corner) + m_planes[i].w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  ClassifyBox()
+ *
+ *  This method is used for checking if the passed in axis
+ *  aligned box is outside of the view volume, crossing one
+ *  of its planes or completely inside of it.
+ ***********************************************************/
+int ViewFrustum::ClassifyBox(const glm::vec3& minimum, const glm::vec3& maximum) const
+{
+	int containment = INSIDE;
+
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		glm::vec3 normal(m_planes[i]);
+		glm::vec3 farCorner(
+			(normal.x >= 0.0f) ? maximum.x : minimum.x,
+			(normal.y >= 0.0f) ? maximum.y : minimum.y,
+			(normal.z >= 0.0f) ? maximum.z : minimum.z);
+		glm::vec3 nearCorner(
+			(normal.x >= 0.0f) ? minimum.x : maximum.x,
+			(normal.y >= 0.0f) ? minimum.y : maximum.y,
+			(normal.z >= 0.0f) ? minimum.z : maximum.z);
+
+		if (glm::dot(normal, farCorner) + m_planes[i].w < 0.0f)
+		{
+			return(OUTSIDE);
+		}
+		if (glm::dot(normal, nearCorner) + m_planes[i].w < 0.0f)
+		{
+			containment = INTERSECTS;
+		}
+	}
+
+	return(containment);
+}
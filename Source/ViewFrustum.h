@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// viewfrustum.h
+// ============
+// test bounding volumes against the planes of the camera view
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ViewFrustum
+ *
+ *  This class contains the six planes of a view volume that
+ *  are extracted from a combined projection and view matrix,
+ *  which works for both the perspective and orthographic
+ *  projections.  Each plane normal points into the volume.
+ ***********************************************************/
+class ViewFrustum
+{
+public:
+	// constructor
+	ViewFrustum();
+	// destructor
+	~ViewFrustum();
+
+	// identifiers for the frustum planes
+	enum PLANE_ID
+	{
+		PLANE_LEFT = 0,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_COUNT
+	};
+
+	// results of classifying a volume against the frustum
+	enum CONTAINMENT
+	{
+		OUTSIDE = 0,
+		INTERSECTS,
+		INSIDE
+	};
+
+	// extract the planes from a projection * view matrix
+	void ExtractPlanes(const glm::mat4& viewProjection);
+
+	// check if a bounding volume is at least partly inside
+	bool IsSphereVisible(const glm::vec3& center, float radius) const;
+	bool IsBoxVisible(const glm::vec3& minimum, const glm::vec3& maximum) const;
+	// check if an axis aligned box is outside, crossing or inside
+	int ClassifyBox(const glm::vec3& minimum, const glm::vec3& maximum) const;
+
+	// get a plane as (normal, distance)
+	const glm::vec4& GetPlane(int planeID) const { return(m_planes[planeID]); }
+
+private:
+	// normalized planes of the view volume
+	glm::vec4 m_planes[PLANE_COUNT];
+};
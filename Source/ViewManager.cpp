@@ -17,11 +17,9 @@
 // declaration of the global variables and defines
 namespace
 {
-	// Variables for window width and height
+	// Variables for the initial window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -32,9 +30,33 @@ namespace
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
+	// set when the left mouse button was pressed, along with
+	// the tracked mouse position at the time of the press
+	bool gPickRequested = false;
+	float gPickX = 0.0f;
+	float gPickY = 0.0f;
+
+	// pixel size of the window framebuffer, which differs from
+	// the window size on high DPI displays, and set when it was
+	// changed since the render targets were last rebuilt
+	int gFramebufferWidth = WINDOW_WIDTH;
+	int gFramebufferHeight = WINDOW_HEIGHT;
+	bool gResizeRequested = false;
+
+	// set when F1 was pressed to toggle the profiler overlay or
+	// F2 to export the profiler trace, along with the key states
+	// of the last frame so that a held key only counts once
+	bool gOverlayToggleRequested = false;
+	bool gTraceExportRequested = false;
+	bool gOverlayKeyDown = false;
+	bool gTraceKeyDown = false;
+
+	// set while recorded input drives the camera, so the live
+	// mouse events are ignored
+	bool gInputScripted = false;
+
+	// time the camera moves by in the current update step
 	float gDeltaTime = 0.0f; 
-	float gLastFrame = 0.0f;
 
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
@@ -46,18 +68,22 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-ViewManager::ViewManager(
-	ShaderManager *pShaderManager)
+ViewManager::ViewManager()
 {
 	// initialize the member variables
-	m_pShaderManager = pShaderManager;
 	m_pWindow = NULL;
+	m_pInputScript = NULL;
+	m_scriptFrame = 0;
+	m_presentMode = PRESENT_VSYNC;
+	m_viewWidth = 0;
+	m_viewHeight = 0;
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
 	g_pCamera->Front = glm::vec3(0.0f, -0.5f, -2.0f);
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
+	m_previousCameraPosition = g_pCamera->Position;
 }
 
 /***********************************************************
@@ -68,7 +94,6 @@ ViewManager::ViewManager(
 ViewManager::~ViewManager()
 {
 	// free up allocated memory
-	m_pShaderManager = NULL;
 	m_pWindow = NULL;
 	if (NULL != g_pCamera)
 	{
@@ -110,6 +135,13 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
 
+	// this callback is used to receive mouse button events
+	glfwSetMouseButtonCallback(window, &ViewManager::Mouse_Button_Callback);
+
+	// this callback is used to receive framebuffer resize events
+	glfwGetFramebufferSize(window, &gFramebufferWidth, &gFramebufferHeight);
+	glfwSetFramebufferSizeCallback(window, &ViewManager::Framebuffer_Size_Callback);
+
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -127,6 +159,11 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
 {
+	if (gInputScripted)
+	{
+		return;
+	}
+
 	// when the first mouse move event is received, this needs to be recorded so that
 	// all subsequent mouse moves can correctly calculate the X position offset and Y
 	// position offset for proper operation
@@ -156,10 +193,208 @@ void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos,
  ***********************************************************/
 void ViewManager::Mouse_Wheel_Callback(GLFWwindow* window, double x, double yScrollDistance)
 {
+	if (gInputScripted)
+	{
+		return;
+	}
+
 	// Call the camera method
 	g_pCamera->ProcessMouseScroll(yScrollDistance);
 }
 
+/***********************************************************
+ *  Mouse_Button_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  a mouse button is pressed or released within the active
+ *  GLFW display window.
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	if ((button == GLFW_MOUSE_BUTTON_LEFT) && (action == GLFW_PRESS))
+	{
+		int windowWidth = 0;
+		int windowHeight = 0;
+		glfwGetWindowSize(window, &windowWidth, &windowHeight);
+		if ((windowWidth <= 0) || (windowHeight <= 0))
+		{
+			return;
+		}
+
+		// the cursor is captured, so the tracked position can
+		// run past the window edges and is kept inside of it,
+		// then converted from window to framebuffer pixels
+		float windowX = glm::clamp(gLastX, 0.0f, (float)windowWidth);
+		float windowY = glm::clamp(gLastY, 0.0f, (float)windowHeight);
+		gPickX = windowX * gFramebufferWidth / windowWidth;
+		gPickY = windowY * gFramebufferHeight / windowHeight;
+		gPickRequested = true;
+	}
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the active GLFW display window is
+ *  resized, including when it is minimized to a size of zero.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	gFramebufferWidth = width;
+	gFramebufferHeight = height;
+	gResizeRequested = true;
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the current pixel size
+ *  of the window framebuffer.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height) const
+{
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  GetResizeRequest()
+ *
+ *  This method is used for getting the framebuffer size the
+ *  window was resized to since the last call, if it was.
+ *  Several resizes between two frames are reported once.
+ ***********************************************************/
+bool ViewManager::GetResizeRequest(int& width, int& height)
+{
+	if (gResizeRequested == false)
+	{
+		return(false);
+	}
+
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+	gResizeRequested = false;
+	return(true);
+}
+
+/***********************************************************
+ *  GetPickRequest()
+ *
+ *  This method is used for getting the framebuffer pixel
+ *  position of the last mouse click that has not been
+ *  picked yet.
+ ***********************************************************/
+bool ViewManager::GetPickRequest(float& windowX, float& windowY)
+{
+	if (gPickRequested == false)
+	{
+		return(false);
+	}
+
+	windowX = gPickX;
+	windowY = gPickY;
+	gPickRequested = false;
+	return(true);
+}
+
+/***********************************************************
+ *  GetOverlayToggleRequest()
+ *
+ *  This method is used for checking if the profiler overlay
+ *  key was pressed since the last check.
+ ***********************************************************/
+bool ViewManager::GetOverlayToggleRequest()
+{
+	bool bRequested = gOverlayToggleRequested;
+
+	gOverlayToggleRequested = false;
+	return(bRequested);
+}
+
+/***********************************************************
+ *  GetTraceExportRequest()
+ *
+ *  This method is used for checking if the profiler trace
+ *  export key was pressed since the last check.
+ ***********************************************************/
+bool ViewManager::GetTraceExportRequest()
+{
+	bool bRequested = gTraceExportRequested;
+
+	gTraceExportRequested = false;
+	return(bRequested);
+}
+
+/***********************************************************
+ *  SetInputScript()
+ *
+ *  This method is used for driving the camera with recorded
+ *  input samples instead of the keyboard and mouse.  One
+ *  sample is played back per update step, so the camera
+ *  path does not depend on the frame rate.
+ ***********************************************************/
+void ViewManager::SetInputScript(const std::vector<INPUT_SAMPLE>* pSamples)
+{
+	m_pInputScript = pSamples;
+	m_scriptFrame = 0;
+	gInputScripted = (NULL != pSamples);
+}
+
+/***********************************************************
+ *  IsInputScriptFinished()
+ *
+ *  This method is used for checking if all of the recorded
+ *  input samples have been played back.
+ ***********************************************************/
+bool ViewManager::IsInputScriptFinished() const
+{
+	return((NULL == m_pInputScript) || (m_scriptFrame >= m_pInputScript->size()));
+}
+
+/***********************************************************
+ *  ProcessScriptedInput()
+ *
+ *  This method is used for moving the camera by the recorded
+ *  keys and mouse movement of the next input sample.
+ ***********************************************************/
+void ViewManager::ProcessScriptedInput()
+{
+	if (IsInputScriptFinished())
+	{
+		return;
+	}
+
+	const INPUT_SAMPLE& sample = (*m_pInputScript)[m_scriptFrame];
+	m_scriptFrame++;
+
+	if (sample.keyMask & INPUT_KEY_FORWARD)
+	{
+		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+	}
+	if (sample.keyMask & INPUT_KEY_BACKWARD)
+	{
+		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+	}
+	if (sample.keyMask & INPUT_KEY_LEFT)
+	{
+		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+	}
+	if (sample.keyMask & INPUT_KEY_RIGHT)
+	{
+		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+	}
+	if (sample.keyMask & INPUT_KEY_UP)
+	{
+		g_pCamera->ProcessKeyboard(UP, gDeltaTime);
+	}
+	if (sample.keyMask & INPUT_KEY_DOWN)
+	{
+		g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
+	}
+	g_pCamera->ProcessMouseMovement(sample.mouseDeltaX, sample.mouseDeltaY);
+}
+
 /***********************************************************
  *  ProcessKeyboardEvents()
  *
@@ -226,51 +461,178 @@ void ViewManager::ProcessKeyboardEvents()
 		bOrthographicProjection = false;
 	}
 
+	// toggle the profiler overlay and export the profiler trace
+	bool bKeyDown = (glfwGetKey(m_pWindow, GLFW_KEY_F1) == GLFW_PRESS);
+	if (bKeyDown && !gOverlayKeyDown)
+	{
+		gOverlayToggleRequested = true;
+	}
+	gOverlayKeyDown = bKeyDown;
+	bKeyDown = (glfwGetKey(m_pWindow, GLFW_KEY_F2) == GLFW_PRESS);
+	if (bKeyDown && !gTraceKeyDown)
+	{
+		gTraceExportRequested = true;
+	}
+	gTraceKeyDown = bKeyDown;
+
+}
+
+/***********************************************************
+ *  SetPresentMode()
+ *
+ *  This method is used for choosing how finished frames are
+ *  presented.  Adaptive sync waits for the refresh like vsync
+ *  but lets a late frame tear instead of waiting a whole
+ *  refresh, and falls back to vsync when the driver does not
+ *  support it.
+ ***********************************************************/
+void ViewManager::SetPresentMode(int presentMode)
+{
+	int swapInterval = 1;
+
+	if (presentMode == PRESENT_UNCAPPED)
+	{
+		swapInterval = 0;
+	}
+	else if (presentMode == PRESENT_ADAPTIVE)
+	{
+		if (glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+			glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+		{
+			swapInterval = -1;
+		}
+		else
+		{
+			std::cout << "Adaptive sync is not supported, using vsync" << std::endl;
+			presentMode = PRESENT_VSYNC;
+		}
+	}
+	else
+	{
+		presentMode = PRESENT_VSYNC;
+	}
+
+	glfwSwapInterval(swapInterval);
+	m_presentMode = presentMode;
+}
 
+/***********************************************************
+ *  UpdateCamera()
+ *
+ *  This method is used for moving the camera by one fixed
+ *  update step.  The events must have been polled just
+ *  before, so the held keys are as fresh as possible.  The
+ *  camera position before the step is kept for blending
+ *  the rendered view between the last two steps.
+ ***********************************************************/
+void ViewManager::UpdateCamera(float timeStep)
+{
+	m_previousCameraPosition = g_pCamera->Position;
+	gDeltaTime = timeStep;
+
+	if (NULL != m_pInputScript)
+	{
+		ProcessScriptedInput();
+	}
+	else
+	{
+		// process any keyboard events that may be waiting in the 
+		// event queue
+		ProcessKeyboardEvents();
+	}
+}
+
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used for placing the camera at a pose.  The
+ *  previous position is set to it as well, so the next view
+ *  is not blended in from where the camera was.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const CAMERA_POSE& pose)
+{
+	g_pCamera->Position = pose.position;
+	g_pCamera->Front = pose.front;
+	g_pCamera->Up = pose.up;
+	g_pCamera->Zoom = pose.zoom;
+	m_previousCameraPosition = pose.position;
+}
+
+/***********************************************************
+ *  GetCameraPose()
+ *
+ *  This method is used for getting the current pose of the
+ *  camera.
+ ***********************************************************/
+ViewManager::CAMERA_POSE ViewManager::GetCameraPose() const
+{
+	CAMERA_POSE pose;
+	pose.position = g_pCamera->Position;
+	pose.front = g_pCamera->Front;
+	pose.up = g_pCamera->Up;
+	pose.zoom = g_pCamera->Zoom;
+	return(pose);
+}
+
+/***********************************************************
+ *  SetViewSize()
+ *
+ *  This method is used for taking the aspect of the next
+ *  prepared views from an image size, such as the images of
+ *  an offline render, rather than from the window.
+ ***********************************************************/
+void ViewManager::SetViewSize(int width, int height)
+{
+	m_viewWidth = width;
+	m_viewHeight = height;
 }
 
 /***********************************************************
  *  PrepareSceneView()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for building the view and projection
+ *  of the frame about to be rendered.  The camera position
+ *  is blended between the last two update steps by the
+ *  passed in fraction of a step that has passed since the
+ *  last one.  The mouse turns the camera as soon as its
+ *  events are polled, so the orientation is not blended.
  ***********************************************************/
-void ViewManager::PrepareSceneView()
+void ViewManager::PrepareSceneView(float interpolation)
 {
 	glm::mat4 view;
 	glm::mat4 projection;
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+	// the aspect follows the window framebuffer unless a view
+	// size was set, and is kept at least one pixel in size while
+	// the window is minimized
+	int viewWidth = (m_viewWidth > 0) ? m_viewWidth : gFramebufferWidth;
+	int viewHeight = (m_viewHeight > 0) ? m_viewHeight : gFramebufferHeight;
+	viewWidth = (viewWidth > 0) ? viewWidth : 1;
+	viewHeight = (viewHeight > 0) ? viewHeight : 1;
 
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	glm::vec3 viewPosition = glm::mix(m_previousCameraPosition, g_pCamera->Position, interpolation);
 
 	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	view = glm::lookAt(viewPosition, viewPosition + g_pCamera->Front, g_pCamera->Up);
 	// define the current projection matrix
 	if (bOrthographicProjection == false)
 	{
 		// perspective projection
 		projection = glm::perspective(glm::radians(g_pCamera->Zoom),
-			(GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT, 0.1f, 100.0f);
+			(GLfloat)viewWidth / (GLfloat)viewHeight, 0.1f, 100.0f);
 	}
 	else
 	{
 		// front-view orthographic projection with correct aspect ratio
 		double scale = 0.0;
-		if (WINDOW_WIDTH > WINDOW_HEIGHT)
+		if (viewWidth > viewHeight)
 		{
-			scale = (double)WINDOW_HEIGHT / (double)WINDOW_WIDTH;
+			scale = (double)viewHeight / (double)viewWidth;
 			projection = glm::ortho(-5.0f, 5.0f, -5.0f * (float)scale, 5.0f * (float)scale, 0.1f, 100.0f);
 		}
-		else if (WINDOW_WIDTH < WINDOW_HEIGHT)
+		else if (viewWidth < viewHeight)
 		{
-			scale = (double)WINDOW_WIDTH / (double)WINDOW_HEIGHT;
+			scale = (double)viewWidth / (double)viewHeight;
 			projection = glm::ortho(-5.0f * (float)scale, 5.0f * (float)scale, -5.0f, 5.0f, 0.1f, 100.0f);
 		}
 		else
@@ -279,14 +641,8 @@ void ViewManager::PrepareSceneView()
 		}
 	}
 
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
-	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
-	}
+	// the scene manager sets the view and projection into each
+	// shader program through its uniform cache
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
 }
\ No newline at end of file
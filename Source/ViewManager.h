@@ -12,6 +12,8 @@
 #include "ShaderManager.h"
 #include "camera.h"
 
+#include <vector>
+
 // GLFW library
 #include "GLFW/glfw3.h" 
 
@@ -19,8 +21,7 @@ class ViewManager
 {
 public:
 	// constructor
-	ViewManager(
-		ShaderManager* pShaderManager);
+	ViewManager();
 	// destructor
 	~ViewManager();
 
@@ -30,19 +31,110 @@ public:
 	// mouse wheel interaction
 	static void Mouse_Wheel_Callback(GLFWwindow* window, double x, double yoffset);
 
+	// mouse button interaction for picking objects in the 3D scene
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+
+	// window framebuffer resizing for rebuilding the render targets
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+
+	// camera movement keys held down in a recorded input sample
+	enum INPUT_KEY
+	{
+		INPUT_KEY_FORWARD = 1 << 0,
+		INPUT_KEY_BACKWARD = 1 << 1,
+		INPUT_KEY_LEFT = 1 << 2,
+		INPUT_KEY_RIGHT = 1 << 3,
+		INPUT_KEY_UP = 1 << 4,
+		INPUT_KEY_DOWN = 1 << 5
+	};
+
+	// identifiers for how finished frames are presented
+	enum PRESENT_MODE
+	{
+		PRESENT_VSYNC = 0,
+		PRESENT_ADAPTIVE,
+		PRESENT_UNCAPPED
+	};
+
+	// one update step of recorded camera input
+	struct INPUT_SAMPLE
+	{
+		unsigned int keyMask;
+		float mouseDeltaX;
+		float mouseDeltaY;
+	};
+
+	// placement and field of view of the camera for one frame
+	struct CAMERA_POSE
+	{
+		glm::vec3 position;
+		glm::vec3 front;
+		glm::vec3 up;
+		float zoom;
+	};
+
 private:
-	// pointer to shader manager object
-	ShaderManager* m_pShaderManager;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
+	// view and projection of the last prepared scene view
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// recorded input replacing the keyboard and mouse, NULL for live input
+	const std::vector<INPUT_SAMPLE>* m_pInputScript;
+	size_t m_scriptFrame;
+	// present mode the swap interval was last set for
+	int m_presentMode;
+	// camera position before the last update step
+	glm::vec3 m_previousCameraPosition;
+	// size the projection aspect is taken from instead of the
+	// window framebuffer, zero when it follows the window
+	int m_viewWidth;
+	int m_viewHeight;
 
 	// process keyboard events for interaction with the 3D scene
 	void ProcessKeyboardEvents();
+	// move the camera by the next recorded input sample
+	void ProcessScriptedInput();
 
 public:
 	// create the initial OpenGL display window
 	GLFWwindow* CreateDisplayWindow(const char* windowTitle);
 	
-	// prepare the conversion from 3D object display to 2D scene display
-	void PrepareSceneView();
+	// choose vsync, adaptive sync or uncapped presentation
+	void SetPresentMode(int presentMode);
+	int GetPresentMode() const { return(m_presentMode); }
+
+	// move the camera by one fixed update step of the input
+	void UpdateCamera(float timeStep);
+	// prepare the conversion from 3D object display to 2D scene
+	// display, blended between the last two update steps
+	void PrepareSceneView(float interpolation);
+
+	// place the camera at a pose, with nothing to blend from
+	void SetCameraPose(const CAMERA_POSE& pose);
+	// get the current pose of the camera
+	CAMERA_POSE GetCameraPose() const;
+	// take the projection aspect from an image size rather than
+	// the window, a size of zero follows the window again
+	void SetViewSize(int width, int height);
+
+	// get the matrices of the last prepared scene view
+	const glm::mat4& GetViewMatrix() const { return(m_viewMatrix); }
+	const glm::mat4& GetProjectionMatrix() const { return(m_projectionMatrix); }
+
+	// get the pixel size of the window framebuffer
+	void GetFramebufferSize(int& width, int& height) const;
+	// get and clear the framebuffer size of a pending resize
+	bool GetResizeRequest(int& width, int& height);
+	// get and clear the framebuffer pixel position of a pending pick
+	bool GetPickRequest(float& windowX, float& windowY);
+	// get and clear the pending profiler key presses
+	bool GetOverlayToggleRequest();
+	bool GetTraceExportRequest();
+
+	// replace the live input with recorded samples played back one
+	// per update step, NULL restores the live input
+	void SetInputScript(const std::vector<INPUT_SAMPLE>* pSamples);
+	// check if every recorded input sample has been played back
+	bool IsInputScriptFinished() const;
 };
\ No newline at end of file
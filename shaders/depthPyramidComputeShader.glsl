@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthPyramidComputeShader.glsl
+// ============
+// build the levels of the hierarchical depth pyramid
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+// must match PYRAMID_GROUP_SIZE in OcclusionCuller.cpp
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// PYRAMID_COPY_DEPTH builds the program that copies the depth
+// buffer into the first level, without it each level is the
+// farthest depth of the texels it covers in the level before
+#ifdef PYRAMID_COPY_DEPTH
+uniform sampler2D depthTexture;
+#else
+layout (r32f, binding = 0) uniform readonly image2D sourceLevel;
+#endif
+layout (r32f, binding = 1) uniform writeonly image2D destinationLevel;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 destinationSize = imageSize(destinationLevel);
+	if (any(greaterThanEqual(texel, destinationSize)))
+	{
+		return;
+	}
+
+#ifdef PYRAMID_COPY_DEPTH
+	imageStore(destinationLevel, texel, vec4(texelFetch(depthTexture, texel, 0).r));
+#else
+	// the last texel of a level halved from an odd size also
+	// covers the extra row or column, so no depth is lost
+	ivec2 sourceSize = imageSize(sourceLevel);
+	ivec2 first = texel * 2;
+	ivec2 last = first + 1 + ivec2(equal(texel, destinationSize - 1)) * (sourceSize & 1);
+	last = min(last, sourceSize - 1);
+
+	float depth = 0.0f;
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+		{
+			depth = max(depth, imageLoad(sourceLevel, ivec2(x, y)).r);
+		}
+	}
+	imageStore(destinationLevel, texel, vec4(depth));
+#endif
+}
@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthVertexShader.glsl
+// ============
+// transform the mesh instances of the depth prepass
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+// the position must come out bit for bit the same as in the
+// scene vertex shader, so the scene draws pass the depth test
+// against the prepass depth - the position is built with the
+// same inputs, expressions and branches
+invariant gl_Position;
+
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 3) in mat4 inInstanceModel;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform bool bUseInstancing = false;
+uniform bool bUsePackedVertices = false;
+uniform vec3 packedPositionCenter = vec3(0.0f);
+uniform vec3 packedPositionExtents = vec3(1.0f);
+
+void main()
+{
+	vec3 vertexPosition = inVertexPosition;
+	if (bUsePackedVertices == true)
+	{
+		vertexPosition = packedPositionCenter + packedPositionExtents * inVertexPosition;
+	}
+
+	mat4 objectModel = model;
+	if (bUseInstancing == true)
+	{
+		objectModel = inInstanceModel;
+	}
+
+	gl_Position = projection * view * objectModel * vec4(vertexPosition, 1.0f);
+}
@@ -0,0 +1,298 @@
+///////////////////////////////////////////////////////////////////////////////
+// fragmentShader.glsl
+// ============
+// color the basic mesh fragments with textures, materials and lighting
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+// texture handles are used when the driver supports them,
+// otherwise the textures are read from texture arrays
+#extension GL_ARB_bindless_texture : enable
+
+// must match MAX_MATERIALS in SceneManager.cpp
+#define MAX_MATERIALS 256
+// must match MAX_TEXTURE_ARRAYS in TextureRegistry.cpp
+#define MAX_TEXTURE_ARRAYS 8
+// must match the shadow views in ShadowManager.h
+#define SHADOW_VIEW_COUNT 4
+#define SPOT_SHADOW_LAYER 3
+
+// the scene shader permutations define USE_TEXTURE, USE_LIGHTING
+// and MAX_ACTIVE_LIGHTS at compile time, without them the shader
+// branches on the draw's texture and the lighting uniform - a
+// light limit of 0 loops over every light of the tile
+#ifdef SHADER_PERMUTATION
+#define TEXTURE_ENABLED (USE_TEXTURE != 0)
+#define LIGHTING_ENABLED (USE_LIGHTING != 0)
+#else
+#define TEXTURE_ENABLED (fragmentTextureIndex >= 0)
+#define LIGHTING_ENABLED bUseLighting
+#define MAX_ACTIVE_LIGHTS 0
+#endif
+
+in vec3 fragmentPosition;
+in vec3 fragmentVertexNormal;
+in vec2 fragmentTextureCoordinate;
+flat in vec4 fragmentObjectColor;
+flat in int fragmentMaterialIndex;
+flat in int fragmentTextureIndex;
+
+out vec4 outFragmentColor;
+
+struct Material
+{
+	vec3 ambientColor;
+	float ambientStrength;
+	vec3 diffuseColor;
+	vec3 specularColor;
+	float shininess;
+};
+
+// std140 packing of one material in the material block
+struct MaterialData
+{
+	vec4 ambientColorStrength;
+	vec4 diffuseColor;
+	vec4 specularColorShininess;
+};
+
+// std430 packing of one light in the light block - a light
+// with a non-zero direction is a directional light, otherwise
+// it is a point light at its position that becomes a spotlight
+// when it has a non-zero spot direction
+struct LightData
+{
+	vec4 positionRange;
+	vec4 direction;
+	vec4 spotDirectionFocal;
+	vec4 ambientColor;
+	vec4 diffuseColor;
+	vec4 specularColorIntensity;
+};
+
+// all the defined materials are uploaded once as a block
+layout (std140) uniform MaterialBlock
+{
+	MaterialData materials[MAX_MATERIALS];
+};
+
+// all the scene lights, uploaded only when a light changes
+layout (std430) readonly buffer LightBlock
+{
+	LightData lights[];
+};
+
+// the screen tile grid (tiles x, tiles y, tile size, light count)
+// followed by the offset and count of every tile's light list
+layout (std430) readonly buffer TileRangeBlock
+{
+	uvec4 tileGrid;
+	uvec2 tileRanges[];
+};
+
+// the light indices of every tile stored back to back
+layout (std430) readonly buffer TileIndexBlock
+{
+	uint tileLightIndices[];
+};
+
+// one entry per registered texture, holding the texture handle
+// in the bindless mode or the array and layer of the texture
+layout (std430) readonly buffer TextureBlock
+{
+	uvec4 textureEntries[];
+};
+
+// the light views of the shadow maps, the cascade each view
+// depth falls in, and the shadowed directional light and
+// spotlight (-1 for none), filter radius and cascade count
+layout (std140) uniform ShadowBlock
+{
+	mat4 shadowMatrices[SHADOW_VIEW_COUNT];
+	vec4 cascadeSplits;
+	vec4 shadowTexelSizes;
+	ivec4 shadowLights;
+	vec4 shadowParams;
+	vec4 viewForward;
+};
+
+uniform bool bUseLighting = false;
+uniform vec3 viewPosition;
+uniform bool bUseBindlessTextures = false;
+uniform sampler2DArray textureArrays[MAX_TEXTURE_ARRAYS];
+uniform sampler2DArrayShadow shadowMaps;
+
+vec3 CalculateLightSource(LightData lightSource, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow);
+float GetShadowFactor(uint lightIndex, vec3 position, vec3 normal);
+
+// the texture index is the same for every fragment of an
+// indirect command, so it can select a sampler
+vec4 SampleSceneTexture(int textureIndex, vec2 textureCoordinate)
+{
+	uvec4 entry = textureEntries[textureIndex];
+#ifdef GL_ARB_bindless_texture
+	if (bUseBindlessTextures == true)
+	{
+		return texture(sampler2D(entry.xy), textureCoordinate);
+	}
+#endif
+	// a layer filled from a lower array level, such as a demoted
+	// image, is read from that level
+	return textureLod(textureArrays[entry.x], vec3(textureCoordinate, float(entry.y)), float(entry.z));
+}
+
+void main()
+{
+	vec4 baseColor = fragmentObjectColor;
+	if (TEXTURE_ENABLED)
+	{
+		baseColor = SampleSceneTexture(fragmentTextureIndex, fragmentTextureCoordinate);
+	}
+
+	if (!LIGHTING_ENABLED)
+	{
+		outFragmentColor = baseColor;
+		return;
+	}
+
+	// unpack the selected material from the material block
+	MaterialData data = materials[fragmentMaterialIndex];
+	Material material;
+	material.ambientColor = data.ambientColorStrength.rgb;
+	material.ambientStrength = data.ambientColorStrength.a;
+	material.diffuseColor = data.diffuseColor.rgb;
+	material.specularColor = data.specularColorShininess.rgb;
+	material.shininess = data.specularColorShininess.a;
+
+	vec3 lightNormal = normalize(fragmentVertexNormal);
+	vec3 viewDirection = normalize(viewPosition - fragmentPosition);
+	vec3 phongResult = vec3(0.0f);
+
+	// only the lights listed for this fragment's tile can reach it
+	ivec2 tile = ivec2(gl_FragCoord.xy) / int(tileGrid.z);
+	tile = clamp(tile, ivec2(0), ivec2(tileGrid.xy) - 1);
+	uvec2 tileRange = tileRanges[tile.y * int(tileGrid.x) + tile.x];
+
+	// a fixed light limit bounds the loop so it can be unrolled
+#if MAX_ACTIVE_LIGHTS > 0
+	const uint loopCount = uint(MAX_ACTIVE_LIGHTS);
+#else
+	uint loopCount = tileRange.y;
+#endif
+	for (uint i = 0; i < loopCount; i++)
+	{
+		if (i >= tileRange.y)
+		{
+			break;
+		}
+		uint lightIndex = tileLightIndices[tileRange.x + i];
+		float shadow = GetShadowFactor(lightIndex, fragmentPosition, lightNormal);
+		phongResult += CalculateLightSource(lights[lightIndex], material, lightNormal, fragmentPosition, viewDirection, shadow);
+	}
+
+	outFragmentColor = vec4(phongResult * baseColor.rgb, baseColor.a);
+}
+
+// filter the depth comparisons of a shadow map around the
+// position, which is moved out along the normal by a number
+// of texels first - 1 is fully lit and 0 fully shadowed
+float SampleShadowMap(int layer, float texelSize, vec3 position, vec3 normal)
+{
+	vec4 shadowPosition = shadowMatrices[layer] * vec4(position + normal * (texelSize * shadowParams.y), 1.0f);
+	if (shadowPosition.w <= 0.0f)
+	{
+		return(1.0f);
+	}
+	vec3 mapPosition = shadowPosition.xyz / shadowPosition.w * 0.5f + 0.5f;
+	if (any(lessThan(mapPosition, vec3(0.0f))) || any(greaterThan(mapPosition, vec3(1.0f))))
+	{
+		return(1.0f);
+	}
+
+	float reference = mapPosition.z - shadowParams.x;
+	int radius = shadowLights.z;
+	float lit = 0.0f;
+	for (int y = -radius; y <= radius; y++)
+	{
+		for (int x = -radius; x <= radius; x++)
+		{
+			vec2 offset = vec2(x, y) * shadowParams.z;
+			lit += texture(shadowMaps, vec4(mapPosition.xy + offset, float(layer), reference));
+		}
+	}
+	float width = float(2 * radius + 1);
+	return(lit / (width * width));
+}
+
+// the directional light reads the cascade its view depth falls
+// in and the spotlight its own map, other lights are unshadowed
+float GetShadowFactor(uint lightIndex, vec3 position, vec3 normal)
+{
+	if (int(lightIndex) == shadowLights.x)
+	{
+		float depth = dot(position - viewPosition, viewForward.xyz);
+		for (int c = 0; c < shadowLights.w; c++)
+		{
+			if (depth < cascadeSplits[c])
+			{
+				return(SampleShadowMap(c, shadowTexelSizes[c], position, normal));
+			}
+		}
+	}
+	else if (int(lightIndex) == shadowLights.y)
+	{
+		float lightDistance = length(position - lights[lightIndex].positionRange.xyz);
+		return(SampleShadowMap(SPOT_SHADOW_LAYER, shadowTexelSizes[SPOT_SHADOW_LAYER] * lightDistance, position, normal));
+	}
+
+	return(1.0f);
+}
+
+vec3 CalculateLightSource(LightData lightSource, Material material, vec3 lightNormal, vec3 vertexPosition, vec3 viewDirection, float shadow)
+{
+	vec3 lightDirection;
+	float attenuation = 1.0f;
+	float rangeFade = 1.0f;
+	float range = lightSource.positionRange.w;
+
+	if (dot(lightSource.direction.xyz, lightSource.direction.xyz) > 0.0f)
+	{
+		lightDirection = normalize(-lightSource.direction.xyz);
+	}
+	else
+	{
+		vec3 toLight = lightSource.positionRange.xyz - vertexPosition;
+		lightDirection = normalize(toLight);
+
+		// fade the light out smoothly at the edge of its range
+		// so that it never pops at a tile boundary
+		if (range > 0.0f)
+		{
+			float falloff = clamp(1.0f - dot(toLight, toLight) / (range * range), 0.0f, 1.0f);
+			rangeFade = falloff * falloff;
+		}
+
+		// narrow the light into a cone around the spot direction
+		vec3 spotDirection = lightSource.spotDirectionFocal.xyz;
+		if (dot(spotDirection, spotDirection) > 0.0f)
+		{
+			float spot = max(dot(-lightDirection, normalize(spotDirection)), 0.0f);
+			attenuation = pow(spot, max(lightSource.spotDirectionFocal.w, 1.0f));
+		}
+	}
+
+	// the material ambient color tints the ambient light on top
+	// of the material's base ambient strength
+	vec3 ambient = lightSource.ambientColor.rgb * (vec3(material.ambientStrength) + material.ambientColor);
+
+	float impact = max(dot(lightNormal, lightDirection), 0.0f);
+	vec3 diffuse = impact * lightSource.diffuseColor.rgb * material.diffuseColor;
+
+	vec3 reflectDirection = reflect(-lightDirection, lightNormal);
+	float specularComponent = pow(max(dot(viewDirection, reflectDirection), 0.0f), max(material.shininess, 1.0f));
+	vec3 specular = lightSource.specularColorIntensity.w * specularComponent * lightSource.specularColorIntensity.rgb * material.specularColor;
+
+	// shadows only block the direct light, never the ambient
+	return(rangeFade * (ambient + shadow * attenuation * (diffuse + specular)));
+}
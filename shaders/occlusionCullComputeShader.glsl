@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// occlusionCullComputeShader.glsl
+// ============
+// cull the instances hidden behind the depth pyramid
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+// must match CULL_GROUP_SIZE in OcclusionCuller.cpp
+layout (local_size_x = 64) in;
+
+// world bounding sphere of an instance and the command it is
+// drawn by, must match CULL_RECORD in OcclusionCuller.h
+struct CullRecord
+{
+	vec4 sphere;
+	uvec4 command;
+};
+
+// the instance is copied as raw words, so its integers are
+// never read as floats - must match INSTANCE_DATA in SceneMeshes.h
+struct InstanceData
+{
+	uvec4 words[6];
+};
+
+// layout of one glMultiDrawElementsIndirect command
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int baseVertex;
+	uint baseInstance;
+};
+
+// the records and source instances are read from the frame
+// data buffer, starting at the passed in elements
+layout (std430, binding = 0) readonly buffer CullRecordBlock
+{
+	CullRecord records[];
+};
+layout (std430, binding = 5) readonly buffer SourceInstanceBlock
+{
+	InstanceData sourceInstances[];
+};
+// the commands start out with no instances
+layout (std430, binding = 6) buffer CulledCommandBlock
+{
+	DrawCommand commands[];
+};
+layout (std430, binding = 7) writeonly buffer CulledInstanceBlock
+{
+	InstanceData culledInstances[];
+};
+
+uniform uint firstRecord;
+uniform uint firstSourceInstance;
+uniform uint recordCount;
+// view the pyramid was built with, and the size and level
+// count of the pyramid
+uniform mat4 pyramidViewProjection;
+uniform vec2 pyramidSize;
+uniform int pyramidLevels;
+uniform sampler2D depthPyramid;
+
+// check the box around a bounding sphere against the farthest
+// depth of the pyramid texels it covers, at the level where
+// it spans at most two texels each way
+bool IsSphereVisible(vec4 sphere)
+{
+	vec3 minimum = vec3(1.0f);
+	vec3 maximum = vec3(-1.0f);
+	for (int k = 0; k < 8; k++)
+	{
+		vec3 corner = sphere.xyz + sphere.w * vec3(
+			((k & 1) != 0) ? 1.0f : -1.0f,
+			((k & 2) != 0) ? 1.0f : -1.0f,
+			((k & 4) != 0) ? 1.0f : -1.0f);
+		vec4 clip = pyramidViewProjection * vec4(corner, 1.0f);
+		// a box reaching behind the camera is never culled
+		if (clip.w <= 0.0f)
+		{
+			return(true);
+		}
+		vec3 ndc = clip.xyz / clip.w;
+		if (k == 0)
+		{
+			minimum = ndc;
+			maximum = ndc;
+		}
+		minimum = min(minimum, ndc);
+		maximum = max(maximum, ndc);
+	}
+
+	// a box reaching past the near plane is kept, and only the
+	// part of a box inside of the viewport is tested
+	if (minimum.z < -1.0f)
+	{
+		return(true);
+	}
+	minimum.xy = clamp(minimum.xy, vec2(-1.0f), vec2(1.0f));
+	maximum.xy = clamp(maximum.xy, vec2(-1.0f), vec2(1.0f));
+
+	vec2 pixelMinimum = (minimum.xy * 0.5f + 0.5f) * pyramidSize;
+	vec2 pixelMaximum = (maximum.xy * 0.5f + 0.5f) * pyramidSize;
+	vec2 pixelExtent = pixelMaximum - pixelMinimum;
+	int level = int(ceil(log2(max(max(pixelExtent.x, pixelExtent.y), 1.0f))));
+	level = clamp(level, 0, pyramidLevels - 1);
+
+	// a texel of a level covers the same pixels as a run of
+	// the level's size in the first level, ending at the last
+	ivec2 levelSize = textureSize(depthPyramid, level);
+	ivec2 first = min(ivec2(pixelMinimum) >> level, levelSize - 1);
+	ivec2 last = min(ivec2(pixelMaximum) >> level, levelSize - 1);
+
+	float occluderDepth = 0.0f;
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+		{
+			occluderDepth = max(occluderDepth, texelFetch(depthPyramid, ivec2(x, y), level).r);
+		}
+	}
+
+	float nearestDepth = minimum.z * 0.5f + 0.5f;
+	return(nearestDepth <= occluderDepth);
+}
+
+void main()
+{
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= recordCount)
+	{
+		return;
+	}
+
+	CullRecord record = records[firstRecord + i];
+	if (!IsSphereVisible(record.sphere))
+	{
+		return;
+	}
+
+	uint commandIndex = record.command.x;
+	uint slot = atomicAdd(commands[commandIndex].instanceCount, 1u);
+	culledInstances[commands[commandIndex].baseInstance + slot] = sourceInstances[firstSourceInstance + i];
+}
@@ -0,0 +1,17 @@
+///////////////////////////////////////////////////////////////////////////////
+// overlayFragmentShader.glsl
+// ============
+// color the bars of the frame time overlay graph
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+flat in vec4 overlayColor;
+
+out vec4 outFragmentColor;
+
+void main()
+{
+	outFragmentColor = overlayColor;
+}
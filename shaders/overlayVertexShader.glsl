@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// overlayVertexShader.glsl
+// ============
+// place the bars of the frame time and allocation overlay graph
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+// must match HISTORY_FRAME_COUNT in FrameProfiler.h
+#define OVERLAY_BAR_COUNT 240
+// frame times in milliseconds of a 60 and a 30 hertz frame
+#define TARGET_FRAME_TIME 16.7f
+#define SLOW_FRAME_TIME 33.4f
+
+flat out vec4 overlayColor;
+
+// frame times from the oldest to the newest, four per vector
+uniform vec4 frameTimes[OVERLAY_BAR_COUNT / 4];
+// corner and size of the graph in normalized device coordinates
+uniform vec4 overlayRect;
+// frame time drawn at the full height of the graph
+uniform float graphMaxTime;
+// heap allocations of each frame from the oldest to the newest,
+// four per vector, and the count drawn at the full height
+uniform vec4 frameAllocations[OVERLAY_BAR_COUNT / 4];
+uniform float graphMaxAllocations;
+
+const vec2 quadCorners[6] = vec2[6](
+	vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(1.0f, 1.0f),
+	vec2(0.0f, 0.0f), vec2(1.0f, 1.0f), vec2(0.0f, 1.0f));
+
+void main()
+{
+	// the first quad is the background, followed by the frame
+	// time bar and then the allocation bar of each frame
+	int quad = gl_VertexID / 6;
+	vec2 corner = quadCorners[gl_VertexID % 6];
+	vec2 position = overlayRect.xy + corner * overlayRect.zw;
+	overlayColor = vec4(0.0f, 0.0f, 0.0f, 0.6f);
+
+	if (quad > OVERLAY_BAR_COUNT)
+	{
+		// frames that allocated hang a bar down from the top, so
+		// a steady frame draws nothing
+		int bar = quad - OVERLAY_BAR_COUNT - 1;
+		float allocations = frameAllocations[bar / 4][bar % 4];
+		float barWidth = overlayRect.z / float(OVERLAY_BAR_COUNT);
+		float barHeight = clamp(allocations / graphMaxAllocations, 0.0f, 1.0f) * overlayRect.w;
+		float top = overlayRect.y + overlayRect.w;
+		position = vec2(overlayRect.x + (float(bar) + corner.x) * barWidth, top - corner.y * barHeight);
+
+		overlayColor = vec4(0.9f, 0.2f, 0.9f, 0.9f);
+	}
+	else if (quad > 0)
+	{
+		int bar = quad - 1;
+		float frameTime = frameTimes[bar / 4][bar % 4];
+		float barWidth = overlayRect.z / float(OVERLAY_BAR_COUNT);
+		float barHeight = clamp(frameTime / graphMaxTime, 0.0f, 1.0f) * overlayRect.w;
+		position = overlayRect.xy + vec2((float(bar) + corner.x) * barWidth, corner.y * barHeight);
+
+		overlayColor = vec4(0.2f, 0.9f, 0.2f, 0.9f);
+		if (frameTime > SLOW_FRAME_TIME)
+		{
+			overlayColor = vec4(0.9f, 0.2f, 0.2f, 0.9f);
+		}
+		else if (frameTime > TARGET_FRAME_TIME)
+		{
+			overlayColor = vec4(0.9f, 0.8f, 0.2f, 0.9f);
+		}
+	}
+
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
@@ -0,0 +1,12 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowFragmentShader.glsl
+// ============
+// write only the depth of the shadow and depth prepass fragments
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+void main()
+{
+}
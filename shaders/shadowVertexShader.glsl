@@ -0,0 +1,29 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowVertexShader.glsl
+// ============
+// transform the shadow casting mesh instances into a light view
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+// only the positions and the instance model are read, from the
+// same mesh arena and instance layout as the scene shader
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 3) in mat4 inInstanceModel;
+
+uniform mat4 lightViewProjection;
+uniform bool bUsePackedVertices = false;
+uniform vec3 packedPositionCenter = vec3(0.0f);
+uniform vec3 packedPositionExtents = vec3(1.0f);
+
+void main()
+{
+	vec3 vertexPosition = inVertexPosition;
+	if (bUsePackedVertices == true)
+	{
+		vertexPosition = packedPositionCenter + packedPositionExtents * inVertexPosition;
+	}
+
+	gl_Position = lightViewProjection * inInstanceModel * vec4(vertexPosition, 1.0f);
+}
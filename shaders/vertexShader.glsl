@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////////////////////////
+// vertexShader.glsl
+// ============
+// transform the basic mesh vertices into the 3D scene
+//
+//	Created for CS-330-Computational Graphics and Visualization
+///////////////////////////////////////////////////////////////////////////////
+#version 440 core
+
+// the depth prepass builds the same position, so the depth of
+// the two passes matches exactly
+invariant gl_Position;
+
+// packed vertices store the position relative to the mesh
+// bounds and the normal octahedral encoded in the first two
+// components, both as normalized shorts
+layout (location = 0) in vec3 inVertexPosition;
+layout (location = 1) in vec3 inVertexNormal;
+layout (location = 2) in vec2 inTextureCoordinate;
+
+// per-instance attributes of instanced draws
+layout (location = 3) in mat4 inInstanceModel;
+layout (location = 7) in vec4 inInstanceColor;
+// material index and texture slot of the instance
+layout (location = 8) in ivec2 inInstanceIndices;
+layout (location = 9) in vec2 inInstanceUVScale;
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+flat out vec4 fragmentObjectColor;
+flat out int fragmentMaterialIndex;
+// texture registry index of the draw, -1 for a solid color
+flat out int fragmentTextureIndex;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform bool bUseInstancing = false;
+uniform vec4 objectColor = vec4(1.0f);
+uniform int materialIndex = 0;
+uniform bool bUseTexture = false;
+uniform int objectTexture = 0;
+uniform vec2 UVscale = vec2(1.0f, 1.0f);
+uniform bool bUsePackedVertices = false;
+uniform vec3 packedPositionCenter = vec3(0.0f);
+uniform vec3 packedPositionExtents = vec3(1.0f);
+
+// unfold an octahedral encoded normal back onto the sphere
+vec3 OctahedralDecode(vec2 encoded)
+{
+	vec3 normal = vec3(encoded.xy, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-normal.z, 0.0f);
+	normal.x += (normal.x >= 0.0f) ? -fold : fold;
+	normal.y += (normal.y >= 0.0f) ? -fold : fold;
+	return(normalize(normal));
+}
+
+void main()
+{
+	vec3 vertexPosition = inVertexPosition;
+	vec3 vertexNormal = inVertexNormal;
+	if (bUsePackedVertices == true)
+	{
+		vertexPosition = packedPositionCenter + packedPositionExtents * inVertexPosition;
+		vertexNormal = OctahedralDecode(inVertexNormal.xy);
+	}
+
+	// instanced draws read the per-draw values from the instance
+	mat4 objectModel = model;
+	fragmentObjectColor = objectColor;
+	fragmentMaterialIndex = materialIndex;
+	fragmentTextureIndex = (bUseTexture == true) ? objectTexture : -1;
+	vec2 textureScale = UVscale;
+	if (bUseInstancing == true)
+	{
+		objectModel = inInstanceModel;
+		fragmentObjectColor = inInstanceColor;
+		fragmentMaterialIndex = inInstanceIndices.x;
+		fragmentTextureIndex = inInstanceIndices.y;
+		textureScale = inInstanceUVScale;
+	}
+
+	// transform the vertex from object space into clip space
+	gl_Position = projection * view * objectModel * vec4(vertexPosition, 1.0f);
+
+	// the lighting is calculated in world space
+	fragmentPosition = vec3(objectModel * vec4(vertexPosition, 1.0f));
+	fragmentVertexNormal = mat3(transpose(inverse(objectModel))) * vertexNormal;
+	fragmentTextureCoordinate = inTextureCoordinate * textureScale;
+}